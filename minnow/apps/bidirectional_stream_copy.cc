@@ -1,129 +1,276 @@
 #include "bidirectional_stream_copy.hh"
 
 #include "byte_stream.hh"
-#include "eventloop.hh"
+#include "exception.hh"
 
+#include <functional>
 #include <iostream>
+#include <optional>
+#include <sys/stat.h>
 #include <unistd.h>
 
 using namespace std;
 
-void bidirectional_stream_copy( Socket& socket, string_view peer_name )
+namespace {
+// The state of one bidirectional copy, shared by its four rules (and freed along with the last of them)
+struct StreamCopy
 {
-  constexpr size_t buffer_size = 1048576;
+  static constexpr size_t buffer_size = 1048576;
+  // A reader resumes once a stream has drained to a quarter full. That is no more than one read_into() (of four
+  // 64 KiB slabs) can push, so a read that isn't flushed always leaves a whole batch for the writer.
+  static constexpr size_t low_watermark = 262144;
+
+  reference_wrapper<Socket> socket;
+  reference_wrapper<FileDescriptor> input;
+  reference_wrapper<FileDescriptor> output;
+  function<void( void )> finish_output; // called once the inbound stream has been written to output
+  string peer_name;
+  shared_ptr<void> owner {}; // keeps socket, input and output alive
 
-  EventLoop eventloop {};
-  FileDescriptor input { STDIN_FILENO };
-  FileDescriptor output { STDOUT_FILENO };
   ByteStream outbound { buffer_size };
   ByteStream inbound { buffer_size };
   bool outbound_shutdown { false };
   bool inbound_shutdown { false };
 
-  socket.set_blocking( false );
-  input.set_blocking( false );
-  output.set_blocking( false );
+  void set_error()
+  {
+    outbound.set_error();
+    inbound.set_error();
+  }
+};
+
+// Add rules that copy `input` to the socket, and the socket to `output`, through a ByteStream in each direction
+void add_stream_copy_rules( EventLoop& eventloop,
+                            const array<size_t, 4>& categories,
+                            const shared_ptr<StreamCopy>& copy )
+{
+  Socket& socket = copy->socket;
+  FileDescriptor& input = copy->input;
+  FileDescriptor& output = copy->output;
+  copy->outbound.set_watermarks( StreamCopy::low_watermark, StreamCopy::buffer_size );
+  copy->inbound.set_watermarks( StreamCopy::low_watermark, StreamCopy::buffer_size );
 
-  // rule 1: read from stdin into outbound byte stream
+  // rule 1: read from input into outbound byte stream
   eventloop.add_rule(
-    "read from stdin into outbound byte stream",
+    categories[0],
     input,
     Direction::In,
-    [&] {
-      string data;
-      data.resize( outbound.writer().available_capacity() );
-      input.read( data );
-      outbound.writer().push( move( data ) );
-      if ( input.eof() ) {
-        outbound.writer().close();
+    [c = copy] {
+      read_into( c->outbound.writer(), c->input );
+      if ( c->input.get().eof() ) {
+        c->outbound.writer().close();
       }
     },
-    [&] {
-      return !outbound.has_error() and !inbound.has_error() and ( outbound.writer().available_capacity() > 0 )
-             and !outbound.writer().is_closed();
+    [c = copy] {
+      return !c->outbound.has_error() and !c->inbound.has_error()
+             and not c->outbound.writer().is_paused() and ( c->outbound.writer().available_capacity() > 0 )
+             and !c->outbound.writer().is_closed();
     },
-    [&] { outbound.writer().close(); },
-    [&] {
+    [c = copy] { c->outbound.writer().close(); },
+    [c = copy] {
       cerr << "DEBUG: Outbound stream had error from source.\n";
-      outbound.set_error();
-      inbound.set_error();
+      c->set_error();
     } );
 
   // rule 2: read from outbound byte stream into socket
   eventloop.add_rule(
-    "read from outbound byte stream into socket",
+    categories[1],
     socket,
     Direction::Out,
-    [&] {
-      if ( outbound.reader().bytes_buffered() ) {
-        outbound.reader().pop( socket.write( outbound.reader().peek() ) );
-      }
-      if ( outbound.reader().is_finished() ) {
-        socket.shutdown( SHUT_WR );
-        outbound_shutdown = true;
-        cerr << "DEBUG: Outbound stream to " << peer_name << " finished.\n";
+    [c = copy] {
+      drain( c->outbound.reader(), c->socket );
+      if ( c->outbound.reader().is_finished() ) {
+        c->socket.get().shutdown( SHUT_WR );
+        c->outbound_shutdown = true;
+        cerr << "DEBUG: Outbound stream to " << c->peer_name << " finished.\n";
       }
     },
-    [&] {
-      return outbound.reader().bytes_buffered() or ( outbound.reader().is_finished() and not outbound_shutdown );
+    [c = copy] {
+      return c->outbound.reader().has_batch()
+             or ( c->outbound.reader().is_finished() and not c->outbound_shutdown );
     },
-    [&] { outbound.writer().close(); },
-    [&] {
+    [c = copy] { c->outbound.writer().close(); },
+    [c = copy] {
       cerr << "DEBUG: Outbound stream had error from destination.\n";
-      outbound.set_error();
-      inbound.set_error();
+      c->set_error();
     } );
 
   // rule 3: read from socket into inbound byte stream
   eventloop.add_rule(
-    "read from socket into inbound byte stream",
+    categories[2],
     socket,
     Direction::In,
-    [&] {
-      string data;
-      data.resize( inbound.writer().available_capacity() );
-      socket.read( data );
-      inbound.writer().push( move( data ) );
-      if ( socket.eof() ) {
-        inbound.writer().close();
+    [c = copy] {
+      read_into( c->inbound.writer(), c->socket );
+      if ( c->socket.get().eof() ) {
+        c->inbound.writer().close();
       }
     },
-    [&] {
-      return !inbound.has_error() and !outbound.has_error() and ( inbound.writer().available_capacity() > 0 )
-             and !inbound.writer().is_closed();
+    [c = copy] {
+      return !c->inbound.has_error() and !c->outbound.has_error()
+             and not c->inbound.writer().is_paused() and ( c->inbound.writer().available_capacity() > 0 )
+             and !c->inbound.writer().is_closed();
     },
-    [&] { inbound.writer().close(); },
-    [&] {
+    [c = copy] { c->inbound.writer().close(); },
+    [c = copy] {
       cerr << "DEBUG: Inbound stream had error from source.\n";
-      outbound.set_error();
-      inbound.set_error();
+      c->set_error();
     } );
 
-  // rule 4: read from inbound byte stream into stdout
+  // rule 4: read from inbound byte stream into output
   eventloop.add_rule(
-    "read from inbound byte stream into stdout",
+    categories[3],
     output,
     Direction::Out,
-    [&] {
-      if ( inbound.reader().bytes_buffered() ) {
-        inbound.reader().pop( output.write( inbound.reader().peek() ) );
-      }
-      if ( inbound.reader().is_finished() ) {
-        output.close();
-        inbound_shutdown = true;
-        cerr << "DEBUG: Inbound stream from " << peer_name << " finished"
-             << ( inbound.has_error() ? " uncleanly.\n" : ".\n" );
+    [c = copy] {
+      drain( c->inbound.reader(), c->output );
+      if ( c->inbound.reader().is_finished() ) {
+        c->finish_output();
+        c->inbound_shutdown = true;
+        cerr << "DEBUG: Inbound stream from " << c->peer_name << " finished"
+             << ( c->inbound.has_error() ? " uncleanly.\n" : ".\n" );
       }
     },
-    [&] {
-      return inbound.reader().bytes_buffered() or ( inbound.reader().is_finished() and not inbound_shutdown );
+    [c = copy] {
+      return c->inbound.reader().has_batch()
+             or ( c->inbound.reader().is_finished() and not c->inbound_shutdown );
     },
-    [&] { inbound.writer().close(); },
-    [&] {
+    [c = copy] { c->inbound.writer().close(); },
+    [c = copy] {
       cerr << "DEBUG: Inbound stream had error from destination.\n";
-      outbound.set_error();
-      inbound.set_error();
+      c->set_error();
     } );
+}
+
+// One direction of a splice copy. The bytes move from source to destination inside the kernel: either through
+// a pipe that plays the part of the ByteStream (with the same capacity and accounting), or directly with sendfile
+// if the source is a regular file.
+struct SpliceCopy
+{
+  static constexpr size_t buffer_size = 1048576;
+
+  reference_wrapper<FileDescriptor> source;
+  reference_wrapper<FileDescriptor> destination;
+  function<void( void )> finish; // called once the source's EOF has been passed on
+  optional<pair<FileDescriptor, FileDescriptor>> pipe {};
+  uint64_t capacity { buffer_size };
+  uint64_t bytes_pushed {};
+  uint64_t bytes_popped {};
+  bool closed { false };    // has the source reached EOF?
+  bool finished { false };  // has finish() been called?
+  bool pipe_full { false }; // did the pipe run out of slots before reaching `capacity` bytes?
+  bool error { false };
+
+  uint64_t bytes_buffered() const { return bytes_pushed - bytes_popped; }
+  uint64_t available_capacity() const { return capacity - bytes_buffered(); }
+};
+
+// Add the rules for one direction of a splice copy; an error in either direction stops both
+void add_splice_rules( EventLoop& eventloop, const string& name, SpliceCopy& copy, SpliceCopy& other )
+{
+  const auto set_error = [&copy, &other] { copy.error = other.error = true; };
+
+  if ( copy.source.get().is_regular_file() ) {
+    eventloop.add_rule(
+      "sendfile " + name,
+      copy.destination,
+      Direction::Out,
+      [&copy] {
+        copy.bytes_popped += copy.source.get().send_file( copy.destination, copy.capacity );
+        copy.bytes_pushed = copy.bytes_popped;
+        if ( copy.source.get().eof() ) {
+          copy.closed = copy.finished = true;
+          copy.finish();
+        }
+      },
+      [&copy] { return not copy.error and not copy.finished; },
+      [&copy] { copy.closed = true; },
+      set_error );
+    return;
+  }
+
+  auto& [pipe_read, pipe_write] = copy.pipe.emplace( FileDescriptor::make_pipe() );
+  copy.capacity = min<uint64_t>( copy.capacity, pipe_write.set_pipe_size( copy.capacity ) );
+
+  // rule 1: splice from source into the pipe, as far as its capacity allows
+  eventloop.add_rule(
+    "splice " + name + " into pipe",
+    copy.source,
+    Direction::In,
+    [&copy, &pipe_write] {
+      const size_t moved = copy.source.get().splice( pipe_write, copy.available_capacity() );
+      copy.bytes_pushed += moved;
+      if ( copy.source.get().eof() ) {
+        copy.closed = true;
+      } else if ( moved == 0 and copy.bytes_buffered() > 0 ) {
+        // a pipe holds a limited number of buffers (not bytes), so it can fill up early; wait for it to drain
+        copy.pipe_full = true;
+      }
+    },
+    [&copy] {
+      return not copy.error and copy.available_capacity() > 0 and not copy.pipe_full and not copy.closed;
+    },
+    [&copy] { copy.closed = true; },
+    set_error );
+
+  // rule 2: splice from the pipe into destination, and finish once the source's EOF has gone through
+  eventloop.add_rule(
+    "splice pipe into " + name,
+    copy.destination,
+    Direction::Out,
+    [&copy, &pipe_read] {
+      if ( copy.bytes_buffered() ) {
+        const size_t moved = pipe_read.splice( copy.destination, copy.bytes_buffered() );
+        copy.bytes_popped += moved;
+        copy.pipe_full &= moved == 0;
+      }
+      if ( copy.closed and copy.bytes_buffered() == 0 ) {
+        copy.finished = true;
+        copy.finish();
+      }
+    },
+    [&copy] { return copy.bytes_buffered() or ( copy.closed and not copy.finished ); },
+    [&copy] { copy.closed = true; },
+    set_error );
+}
+
+// Can splice(2) (or sendfile) read or write this fd?
+bool splice_capable( const FileDescriptor& fd )
+{
+  struct stat info {};
+  CheckSystemCall( "fstat", fstat( fd.fd_num(), &info ) );
+  // NOLINTNEXTLINE(*-signed-bitwise)
+  return S_ISREG( info.st_mode ) or S_ISFIFO( info.st_mode ) or S_ISSOCK( info.st_mode );
+}
+} // namespace
+
+void bidirectional_stream_copy( Socket& socket, string_view peer_name )
+{
+  FileDescriptor input { STDIN_FILENO };
+  FileDescriptor output { STDOUT_FILENO };
+  bidirectional_stream_copy( socket, input, output, peer_name );
+}
+
+void bidirectional_stream_copy( Socket& socket,
+                                FileDescriptor& input,
+                                FileDescriptor& output,
+                                string_view peer_name )
+{
+  EventLoop eventloop {};
+
+  socket.set_blocking( false );
+  input.set_blocking( false );
+  output.set_blocking( false );
+
+  const array categories { eventloop.add_category( "read from input into outbound byte stream" ),
+                           eventloop.add_category( "read from outbound byte stream into socket" ),
+                           eventloop.add_category( "read from socket into inbound byte stream" ),
+                           eventloop.add_category( "read from inbound byte stream into output" ) };
+
+  add_stream_copy_rules(
+    eventloop,
+    categories,
+    make_shared<StreamCopy>( socket, input, output, [&output] { output.close(); }, string( peer_name ) ) );
 
   // loop until completion
   while ( true ) {
@@ -132,3 +279,71 @@ void bidirectional_stream_copy( Socket& socket, string_view peer_name )
     }
   }
 }
+
+void bidirectional_splice_copy( Socket& socket, string_view peer_name )
+{
+  FileDescriptor input { STDIN_FILENO };
+  FileDescriptor output { STDOUT_FILENO };
+  bidirectional_splice_copy( socket, input, output, peer_name );
+}
+
+void bidirectional_splice_copy( Socket& socket,
+                                FileDescriptor& input,
+                                FileDescriptor& output,
+                                string_view peer_name )
+{
+  if ( not splice_capable( input ) or not splice_capable( output ) ) {
+    cerr << "DEBUG: input or output can't be spliced; copying through user space instead.\n";
+    bidirectional_stream_copy( socket, input, output, peer_name );
+    return;
+  }
+
+  EventLoop eventloop {};
+
+  socket.set_blocking( false );
+  input.set_blocking( false );
+  output.set_blocking( false );
+
+  SpliceCopy outbound { input, socket, [&] {
+                         socket.shutdown( SHUT_WR );
+                         cerr << "DEBUG: Outbound stream to " << peer_name << " finished.\n";
+                       } };
+  SpliceCopy inbound { socket, output, [&] {
+                        output.close();
+                        cerr << "DEBUG: Inbound stream from " << peer_name << " finished.\n";
+                      } };
+
+  add_splice_rules( eventloop, "input to socket", outbound, inbound );
+  add_splice_rules( eventloop, "socket to output", inbound, outbound );
+
+  // loop until completion
+  while ( true ) {
+    if ( EventLoop::Result::Exit == eventloop.wait_next_event( -1 ) ) {
+      return;
+    }
+  }
+}
+
+SocketRelay::SocketRelay( EventLoop& eventloop )
+  : eventloop_( eventloop )
+  , categories_ { eventloop.add_category( "read from upstream into outbound byte stream" ),
+                  eventloop.add_category( "read from outbound byte stream into client" ),
+                  eventloop.add_category( "read from client into inbound byte stream" ),
+                  eventloop.add_category( "read from inbound byte stream into upstream" ) }
+{}
+
+void SocketRelay::add( TCPSocket&& client, TCPSocket&& upstream )
+{
+  auto sockets = make_shared<pair<TCPSocket, TCPSocket>>( move( client ), move( upstream ) );
+  auto& [client_socket, upstream_socket] = *sockets;
+  client_socket.set_blocking( false );
+  upstream_socket.set_blocking( false );
+
+  auto copy = make_shared<StreamCopy>( client_socket,
+                                       upstream_socket,
+                                       upstream_socket,
+                                       [&upstream_socket] { upstream_socket.shutdown( SHUT_WR ); },
+                                       client_socket.peer_address().to_string() );
+  copy->owner = move( sockets );
+  add_stream_copy_rules( eventloop_, categories_, copy );
+}
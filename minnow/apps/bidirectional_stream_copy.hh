@@ -1,6 +1,41 @@
 #pragma once
 
+#include "eventloop.hh"
 #include "socket.hh"
 
+#include <array>
+#include <functional>
+
 //! Copy socket input/output to stdin/stdout until finished
 void bidirectional_stream_copy( Socket& socket, std::string_view peer_name );
+
+//! Copy `input` to the socket, and the socket to `output`, until finished (`output` is closed at the end)
+void bidirectional_stream_copy( Socket& socket,
+                                FileDescriptor& input,
+                                FileDescriptor& output,
+                                std::string_view peer_name );
+
+//! Copy socket input/output to stdin/stdout until finished, moving the bytes inside the kernel
+//! (with splice(2) through a pipe, or sendfile(2) from a regular file) instead of through user space.
+//! Falls back to bidirectional_stream_copy if stdin or stdout can't be spliced (e.g. a terminal).
+void bidirectional_splice_copy( Socket& socket, std::string_view peer_name );
+
+//! The same, between the socket and `input` and `output`
+void bidirectional_splice_copy( Socket& socket,
+                                FileDescriptor& input,
+                                FileDescriptor& output,
+                                std::string_view peer_name );
+
+//! Relays connections through one EventLoop: each client's input is copied to its upstream, and vice versa,
+//! until both directions finish. Each relayed pair of sockets is released along with its rules.
+class SocketRelay
+{
+  std::reference_wrapper<EventLoop> eventloop_;
+  std::array<size_t, 4> categories_;
+
+public:
+  explicit SocketRelay( EventLoop& eventloop );
+
+  //! Start relaying between a newly accepted `client` and a connected `upstream`
+  void add( TCPSocket&& client, TCPSocket&& upstream );
+};
@@ -0,0 +1,163 @@
+#include "bidirectional_stream_copy.hh"
+#include "exception.hh"
+#include "socket.hh"
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+void show_usage( const char* argv0 )
+{
+  cerr << "Usage: " << argv0 << " [--splice] [<gigabytes>]\n\n"
+       << "  Relays <gigabytes> (default 1) in each direction through bidirectional_stream_copy\n"
+       << "  (or with --splice, bidirectional_splice_copy), between a pair of local sockets (in place of\n"
+       << "  stdin and stdout) and a TCP connection over loopback, and reports the throughput, the relay's\n"
+       << "  system calls per MB, and the relay thread's CPU time.\n";
+}
+
+namespace {
+constexpr size_t chunk_size = 1 << 20;
+
+// Write `bytes` into `fd` (with plain writes, so that only the relay's own calls are counted), then shut it down
+void produce( int fd, uint64_t bytes )
+{
+  const string chunk( chunk_size, 'x' );
+  while ( bytes > 0 ) {
+    const ssize_t written = ::write( fd, chunk.data(), min<uint64_t>( bytes, chunk.size() ) );
+    CheckSystemCall( "write", static_cast<int>( written ) );
+    bytes -= written;
+  }
+  CheckSystemCall( "shutdown", ::shutdown( fd, SHUT_WR ) );
+}
+
+// Read `fd` to the end, returning the number of bytes
+uint64_t consume( int fd )
+{
+  string buffer( chunk_size, 0 );
+  uint64_t total = 0;
+  while ( true ) {
+    const ssize_t received = ::read( fd, buffer.data(), buffer.size() );
+    CheckSystemCall( "read", static_cast<int>( received ) );
+    if ( received == 0 ) {
+      return total;
+    }
+    total += received;
+  }
+}
+
+pair<LocalStreamSocket, LocalStreamSocket> make_socket_pair()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "socketpair", ::socketpair( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds.data() ) );
+  return { LocalStreamSocket { FileDescriptor { fds[0] } }, LocalStreamSocket { FileDescriptor { fds[1] } } };
+}
+
+double seconds( const timeval& tv )
+{
+  return static_cast<double>( tv.tv_sec ) + static_cast<double>( tv.tv_usec ) / 1e6;
+}
+
+void relay_bench( uint64_t bytes, bool splice )
+{
+  // the relay's TCP connection, over loopback, to a far end that sends and receives `bytes`
+  TCPSocket listener;
+  listener.bind( Address { "127.0.0.1", 0 } );
+  listener.listen();
+  TCPSocket relay_socket;
+  relay_socket.connect( listener.local_address() );
+  TCPSocket far_end = listener.accept();
+
+  // what the relay has in place of stdin and stdout
+  auto [input, source] = make_socket_pair();
+  auto [output, sink] = make_socket_pair();
+
+  rusage relay_usage {};
+  const auto start = steady_clock::now();
+  thread relay { [&] {
+    const string peer_name = relay_socket.peer_address().to_string();
+    if ( splice ) {
+      bidirectional_splice_copy( relay_socket, input, output, peer_name );
+    } else {
+      bidirectional_stream_copy( relay_socket, input, output, peer_name );
+    }
+    CheckSystemCall( "getrusage", getrusage( RUSAGE_THREAD, &relay_usage ) );
+  } };
+
+  uint64_t far_received = 0;
+  uint64_t sink_received = 0;
+  thread outbound_source { [&] { produce( source.fd_num(), bytes ); } };
+  thread outbound_sink { [&] { far_received = consume( far_end.fd_num() ); } };
+  thread inbound_source { [&] { produce( far_end.fd_num(), bytes ); } };
+  thread inbound_sink { [&] { sink_received = consume( sink.fd_num() ); } };
+  for ( auto* t : { &outbound_source, &outbound_sink, &inbound_source, &inbound_sink, &relay } ) {
+    t->join();
+  }
+  const double elapsed = duration<double>( steady_clock::now() - start ).count();
+
+  if ( far_received != bytes or sink_received != bytes ) {
+    throw runtime_error( "relayed " + to_string( far_received ) + " and " + to_string( sink_received )
+                         + " bytes, not " + to_string( bytes ) + " each way" );
+  }
+
+  const uint64_t reads = relay_socket.read_count() + input.read_count() + output.read_count();
+  const uint64_t writes = relay_socket.write_count() + input.write_count() + output.write_count();
+  const double megabytes = 2 * static_cast<double>( bytes ) / 1e6;
+  const double cpu_user = seconds( relay_usage.ru_utime );
+  const double cpu_system = seconds( relay_usage.ru_stime );
+
+  cout << fixed << setprecision( 2 ) << ( splice ? "bidirectional_splice_copy" : "bidirectional_stream_copy" )
+       << " relayed 2 x " << static_cast<double>( bytes ) / 1e9 << " GB in " << elapsed << " s: "
+       << 8 * megabytes / 1e3 / elapsed << " Gbit/s\n"
+       << "  " << static_cast<double>( reads + writes ) / megabytes << " syscalls/MB (" << reads << " reads, "
+       << writes << " writes)\n"
+       << "  relay thread CPU: " << cpu_user + cpu_system << " s (user " << cpu_user << ", system " << cpu_system
+       << "), " << ( cpu_user + cpu_system ) / ( megabytes / 1e3 ) << " s/GB\n";
+}
+} // namespace
+
+int main( int argc, char** argv )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort(); // For sticklers: don't try to access argv[0] if argc <= 0.
+    }
+
+    auto args = span( argv, argc );
+    const char* program = args[0];
+
+    const bool splice = argc >= 2 and strcmp( "--splice", args[1] ) == 0;
+    if ( splice ) {
+      args = args.subspan( 1 );
+      argc--;
+    }
+    if ( argc > 2 ) {
+      show_usage( program );
+      return EXIT_FAILURE;
+    }
+
+    const double gigabytes = argc == 2 ? stod( args[1] ) : 1.0;
+    if ( gigabytes <= 0 ) {
+      show_usage( program );
+      return EXIT_FAILURE;
+    }
+
+    relay_bench( static_cast<uint64_t>( gigabytes * 1e9 ), splice );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
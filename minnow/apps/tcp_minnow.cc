@@ -0,0 +1,81 @@
+#include "bidirectional_stream_copy.hh"
+#include "random.hh"
+#include "tcp_minnow_socket.hh"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <span>
+#include <string>
+
+using namespace std;
+
+namespace {
+constexpr uint64_t MAX_RECEIVE_WINDOW = 4 * 1024 * 1024; // how far the receive window may auto-tune
+} // namespace
+
+void show_usage( const char* argv0 )
+{
+  cerr << "Usage: " << argv0 << " [-t <tun>] [-l] <host> <port>\n\n"
+       << "  Like tcp_native, but with this project's own TCP implementation, over a TUN device\n"
+       << "  (default tun144; see scripts/tun.sh).\n"
+       << "  -l specifies listen mode; <host>:<port> is the listening address, which must be on the\n"
+       << "     TUN device's network (e.g. 169.254.144.9).\n";
+}
+
+int main( int argc, char** argv )
+{
+  try {
+    if ( argc <= 0 ) {
+      abort(); // For sticklers: don't try to access argv[0] if argc <= 0.
+    }
+
+    auto args = span( argv, argc );
+    const char* program = args[0];
+
+    string tun_name = "tun144";
+    if ( argc >= 3 and strcmp( "-t", args[1] ) == 0 ) {
+      tun_name = args[2];
+      args = args.subspan( 2 ); // args[0] is now the device's name, and the options follow as usual
+      argc -= 2;
+    }
+
+    bool server_mode = false;
+    // NOLINTNEXTLINE(bugprone-assignment-*)
+    if ( argc < 3 || ( ( server_mode = ( strncmp( "-l", args[1], 3 ) == 0 ) ) && argc < 4 ) ) {
+      show_usage( program );
+      return EXIT_FAILURE;
+    }
+
+    // The stack's own address is on the TUN device's network: 169.254.<n>.9 for tun<n> (the host is .1).
+    const string tun_number = tun_name.substr( tun_name.find_first_of( "0123456789" ) );
+    const string local_ip = "169.254." + tun_number + ".9";
+
+    TCPConfig config;
+    config.recv_max_capacity = MAX_RECEIVE_WINDOW;
+    TCPMinnowSocket socket { TunFD { tun_name }, config };
+    string peer_name;
+    if ( server_mode ) {
+      const Address local { args[2], args[3] };
+      cerr << "DEBUG: Listening for incoming connection on " << local.to_string() << "...\n";
+      socket.listen_and_accept( local );
+      peer_name = "the connection to " + local.to_string();
+    } else {
+      const Address peer { args[1], args[2] };
+      auto rd = get_random_engine();
+      const uint16_t local_port = uniform_int_distribution<uint16_t> { 20000, 30000 }( rd );
+      const Address local { local_ip, local_port };
+      cerr << "DEBUG: Connecting from " << local.to_string() << " to " << peer.to_string() << "...\n";
+      socket.connect( local, peer );
+      peer_name = peer.to_string();
+    }
+
+    bidirectional_stream_copy( socket, peer_name );
+    socket.wait_until_closed();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
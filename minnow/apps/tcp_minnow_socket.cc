@@ -0,0 +1,298 @@
+#include "tcp_minnow_socket.hh"
+
+#include "buffer_pool.hh"
+#include "byte_stream.hh"
+#include "eventloop.hh"
+#include "exception.hh"
+#include "helpers.hh"
+#include "ipv4_datagram.hh"
+#include "tcp_peer.hh"
+
+#include <chrono>
+#include <iostream>
+#include <sys/socket.h>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+constexpr uint16_t ADVERTISED_MSS = 1460; // fits a 1500-byte MTU
+constexpr milliseconds TICK_INTERVAL { 10 };
+constexpr size_t HEADERS_LENGTH = IPv4Header::LENGTH + 20; // IPv4 and TCP headers without options
+
+pair<FileDescriptor, FileDescriptor> make_socket_pair()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "socketpair", ::socketpair( AF_UNIX, SOCK_STREAM, 0, fds.data() ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+// The state of the TCP stack's thread: the peer, its addresses, and the datagrams waiting to be written
+class Stack
+{
+  TunFD tun_;
+  LocalStreamSocket app_;
+  TCPPeer peer_;
+  Address local_;
+  optional<Address> remote_;
+  vector<vector<Slice>> outbox_ {};
+  uint16_t next_id_ {};
+  bool app_shutdown_ {};
+
+  // Window scaling: our SYN offers `window_scale_` (unless it answers a SYN that didn't offer one), and scaling
+  // is in effect once the peer's SYN has offered its own.
+  uint8_t window_scale_;
+  bool peer_syn_received_ {};
+  optional<uint8_t> peer_window_scale_ {};
+
+  TCPPeer::TransmitFunction transmit_ { [this]( const TCPSegment& segment ) { send( segment ); } };
+
+  void send( TCPSegment segment )
+  {
+    segment.source_port = local_.port();
+    segment.destination_port = remote_->port();
+    if ( segment.message.SYN ) {
+      segment.mss = ADVERTISED_MSS;
+      segment.sack_permitted = true;
+      if ( not peer_syn_received_ or peer_window_scale_.has_value() ) {
+        segment.window_scale = window_scale_;
+      }
+    }
+    segment.window_shift = peer_window_scale_.has_value() ? window_scale_ : 0;
+
+    IPv4Datagram datagram;
+    datagram.header.src = local_.ipv4_numeric();
+    datagram.header.dst = remote_->ipv4_numeric();
+    datagram.header.id = next_id_++;
+    datagram.header.len = IPv4Header::LENGTH + segment.header_length() + segment.message.payload.size();
+    datagram.header.compute_checksum();
+    segment.compute_checksum( datagram.header.pseudo_checksum() );
+    datagram.payload = serialize( segment );
+    outbox_.push_back( serialize( datagram ) ); // the payload stays a view of the outbound stream's bytes
+  }
+
+  // Read a batch of datagrams. Each is read with readv() into two buffers, so that (with the usual headers)
+  // the payload begins a buffer of its own. The payload is then copied out of its slab into a right-sized string
+  // (see BufferPool::trim()), so a buffered segment doesn't pin a slab, and the next read takes the same slab back.
+  void read_datagrams()
+  {
+    for ( size_t i = 0; i < TCPMinnowSocket::datagrams_per_read; ++i ) {
+      vector<string> buffers { string( HEADERS_LENGTH, 0 ), BufferPool::take() };
+      tun_.read( buffers );
+      if ( buffers.empty() ) {
+        return; // no more datagrams for now
+      }
+      BufferPool::trim( buffers.back(), buffers.back().size() );
+      receive( buffers );
+    }
+  }
+
+  void receive( vector<string>& buffers )
+  {
+    Parser datagram_parser { std::move( buffers ) };
+    IPv4Datagram datagram;
+    datagram.parse( datagram_parser );
+    if ( datagram_parser.has_error() or datagram.header.proto != IPv4Header::PROTO_TCP
+         or datagram.header.dst != local_.ipv4_numeric()
+         or ( remote_.has_value() and datagram.header.src != remote_->ipv4_numeric() ) ) {
+      return;
+    }
+
+    Parser segment_parser { std::move( datagram.payload ) };
+    TCPSegment segment;
+    segment.window_shift = peer_window_scale_.value_or( 0 );
+    segment.parse( segment_parser, datagram.header.pseudo_checksum() );
+    if ( segment_parser.has_error() or segment.destination_port != local_.port()
+         or ( remote_.has_value() and segment.source_port != remote_->port() ) ) {
+      return;
+    }
+
+    if ( not remote_.has_value() ) {
+      if ( not segment.message.SYN ) {
+        return; // still listening
+      }
+      remote_ = Address::from_ipv4_numeric( datagram.header.src );
+      remote_ = Address { remote_->ip(), segment.source_port };
+      cerr << "DEBUG: New connection from " << remote_->to_string() << ".\n";
+    }
+
+    if ( segment.message.SYN and not peer_syn_received_ ) {
+      peer_syn_received_ = true;
+      if ( segment.window_scale.has_value() ) {
+        peer_window_scale_ = min( *segment.window_scale, TCPSegment::MAX_WINDOW_SCALE );
+      }
+    }
+
+    peer_.receive( std::move( segment ), transmit_ );
+  }
+
+  void write_datagrams()
+  {
+    vector<string_view> views;
+    for ( const auto& datagram : outbox_ ) {
+      views.assign( datagram.begin(), datagram.end() );
+      tun_.write( views );
+    }
+    outbox_.clear();
+  }
+
+public:
+  Stack( TunFD&& tun, LocalStreamSocket&& app, const TCPConfig& config, Address local, optional<Address> remote )
+    : tun_( std::move( tun ) )
+    , app_( std::move( app ) )
+    , peer_( config )
+    , local_( std::move( local ) )
+    , remote_( std::move( remote ) )
+    , window_scale_( TCPSegment::window_scale_for( max( config.recv_capacity, config.recv_max_capacity ) ) )
+  {}
+
+  void run()
+  {
+    tun_.set_blocking( false );
+    app_.set_blocking( false );
+
+    EventLoop loop;
+    if ( remote_.has_value() ) {
+      peer_.connect( transmit_ );
+    }
+
+    // rule 1: read a batch of datagrams from the TUN device
+    loop.add_rule( "read datagrams", tun_, Direction::In, [this] { read_datagrams(); } );
+
+    // rule 2: write the datagrams the peer has sent
+    loop.add_rule(
+      "write datagrams",
+      tun_,
+      Direction::Out,
+      [this] { write_datagrams(); },
+      [this] { return not outbox_.empty(); } );
+
+    // rule 3: read from the application into the outbound stream
+    loop.add_rule(
+      "read from application",
+      app_,
+      Direction::In,
+      [this] {
+        Writer& outbound = peer_.outbound_writer();
+        string data = BufferPool::take( outbound.available_capacity() );
+        app_.read( data );
+        outbound.push( std::move( data ) );
+        if ( app_.eof() ) {
+          outbound.close();
+        }
+        peer_.push( transmit_ );
+      },
+      [this] {
+        return peer_.active() and peer_.outbound_writer().available_capacity() > 0
+               and not peer_.outbound_writer().is_closed();
+      },
+      [this] { peer_.outbound_writer().close(); } );
+
+    // rule 4: write the inbound stream to the application
+    loop.add_rule(
+      "write to application",
+      app_,
+      Direction::Out,
+      [this] {
+        Reader& inbound = peer_.inbound_reader();
+        drain( inbound, app_ );
+        if ( inbound.is_finished() ) {
+          app_.shutdown( SHUT_WR );
+          app_shutdown_ = true;
+        }
+        peer_.push( transmit_ ); // the window may have opened
+      },
+      [this] {
+        const Reader& inbound = peer_.inbound_reader();
+        return inbound.bytes_buffered() > 0 or ( inbound.is_finished() and not app_shutdown_ );
+      } );
+
+    // rule 5: pass the time to the peer (for retransmission, pacing and lingering)
+    auto last_tick = steady_clock::now();
+    loop.add_timer(
+      "tick",
+      TICK_INTERVAL,
+      [this, &last_tick] {
+        const auto now = steady_clock::now();
+        const auto elapsed = duration_cast<milliseconds>( now - last_tick );
+        last_tick += elapsed;
+        peer_.tick( elapsed.count(), transmit_ );
+      },
+      true );
+
+    while ( peer_.active() or not outbox_.empty() or peer_.inbound_reader().bytes_buffered() > 0 ) {
+      if ( loop.wait_next_event( -1 ) == EventLoop::Result::Exit ) {
+        break;
+      }
+    }
+
+    if ( peer_.inbound_reader().has_error() or peer_.outbound_writer().has_error() ) {
+      cerr << "DEBUG: Connection was reset.\n";
+    }
+  }
+};
+} // namespace
+
+TCPMinnowSocket::TCPMinnowSocket( TunFD&& tun, const TCPConfig& config )
+  : TCPMinnowSocket( make_socket_pair(), std::move( tun ), config )
+{}
+
+TCPMinnowSocket::TCPMinnowSocket( pair<FileDescriptor, FileDescriptor> socket_pair,
+                                  TunFD&& tun,
+                                  const TCPConfig& config )
+  : LocalStreamSocket( std::move( socket_pair.first ) )
+  , tun_( std::move( tun ) )
+  , stack_end_( LocalStreamSocket { std::move( socket_pair.second ) } )
+  , config_( config )
+{}
+
+void TCPMinnowSocket::start( const Address& local, const optional<Address>& remote )
+{
+  if ( not tun_.has_value() ) {
+    throw runtime_error( "TCPMinnowSocket: already connected" );
+  }
+
+  thread_ = thread { [stack = make_shared<Stack>( std::move( *tun_ ),
+                                                  std::move( *stack_end_ ),
+                                                  config_,
+                                                  local,
+                                                  remote )] {
+    try {
+      stack->run();
+    } catch ( const exception& e ) {
+      cerr << "TCP stack thread: " << e.what() << "\n";
+    }
+  } };
+  tun_.reset();
+  stack_end_.reset();
+}
+
+void TCPMinnowSocket::connect( const Address& local, const Address& remote )
+{
+  start( local, remote );
+}
+
+void TCPMinnowSocket::listen_and_accept( const Address& local )
+{
+  start( local, nullopt );
+}
+
+void TCPMinnowSocket::wait_until_closed()
+{
+  if ( thread_.joinable() ) {
+    thread_.join();
+  }
+}
+
+TCPMinnowSocket::~TCPMinnowSocket()
+{
+  try {
+    if ( thread_.joinable() ) {
+      shutdown( SHUT_WR ); // (if the application hasn't already) end the outbound stream
+      thread_.join();
+    }
+  } catch ( const exception& e ) {
+    cerr << "TCPMinnowSocket: " << e.what() << "\n";
+  }
+}
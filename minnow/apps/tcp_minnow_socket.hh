@@ -0,0 +1,49 @@
+#pragma once
+
+#include "address.hh"
+#include "socket.hh"
+#include "tcp_config.hh"
+#include "tun.hh"
+
+#include <optional>
+#include <thread>
+#include <utility>
+
+//! A TCP connection implemented by this project's TCPPeer, carried in IPv4 datagrams over a TUN device.
+//! The application's end is a LocalStreamSocket (one end of a socketpair), so it can be used wherever a kernel
+//! socket can, e.g. with bidirectional_stream_copy(). The TCP stack runs on its own EventLoop, in a thread
+//! of its own, until the connection is over.
+class TCPMinnowSocket : public LocalStreamSocket
+{
+public:
+  //! Each loop iteration reads and handles up to this many datagrams from the TUN device
+  static constexpr size_t datagrams_per_read = 64;
+
+  TCPMinnowSocket( TunFD&& tun, const TCPConfig& config );
+
+  //! Active open: connect from `local` (an address on the TUN device's network) to `remote`
+  void connect( const Address& local, const Address& remote );
+
+  //! Passive open: accept the first connection to `local` (without waiting for it to arrive)
+  void listen_and_accept( const Address& local );
+
+  //! Wait for the connection to be over (closed cleanly, reset, or abandoned)
+  void wait_until_closed();
+
+  ~TCPMinnowSocket();
+
+  TCPMinnowSocket( const TCPMinnowSocket& other ) = delete;
+  TCPMinnowSocket& operator=( const TCPMinnowSocket& other ) = delete;
+  TCPMinnowSocket( TCPMinnowSocket&& other ) = delete;
+  TCPMinnowSocket& operator=( TCPMinnowSocket&& other ) = delete;
+
+private:
+  TCPMinnowSocket( std::pair<FileDescriptor, FileDescriptor> socket_pair, TunFD&& tun, const TCPConfig& config );
+
+  void start( const Address& local, const std::optional<Address>& remote );
+
+  std::optional<TunFD> tun_;
+  std::optional<LocalStreamSocket> stack_end_; // the TCP stack's end of the socketpair
+  TCPConfig config_;
+  std::thread thread_ {};
+};
@@ -1,16 +1,90 @@
+#include "async_connect.hh"
 #include "bidirectional_stream_copy.hh"
+#include "eventloop_group.hh"
+#include "resolver.hh"
 
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <span>
+#include <string>
+#include <vector>
 
 using namespace std;
 
 void show_usage( const char* argv0 )
 {
-  cerr << "Usage: " << argv0 << " [-l] <host> <port>\n\n"
-       << "  -l specifies listen mode; <host>:<port> is the listening address.\n";
+  cerr << "Usage: " << argv0 << " [--splice] [-l] <host> <port>\n"
+       << "       " << argv0 << " -r <threads> <host> <port> <upstream host> <upstream port>\n\n"
+       << "  --splice moves the bytes between the socket and stdin/stdout with splice(2)/sendfile(2),\n"
+       << "     without copying them through user space.\n"
+       << "  -l specifies listen mode; <host>:<port> is the listening address.\n"
+       << "  -r specifies relay mode: accept any number of connections on <host>:<port>, spread across\n"
+       << "     <threads> event loops (each with its own SO_REUSEPORT listener), and relay each one\n"
+       << "     to a new connection to <upstream host>:<upstream port>.\n";
+}
+
+// Serve many concurrent sessions, each on the event loop (and thread) whose listener accepted it.
+// The upstream's name is resolved (and cached) by each loop's Resolver, and connected to without blocking.
+void relay_server( size_t threads,
+                   const Address& listen_address,
+                   const string& upstream_host,
+                   const string& upstream_port )
+{
+  EventLoopGroup group { threads };
+  vector<TCPSocket> listeners;
+  vector<SocketRelay> relays;
+  vector<unique_ptr<Resolver>> resolvers; // (destroyed before their loops)
+  listeners.reserve( group.size() ); // the accept rules refer to these
+  relays.reserve( group.size() );
+
+  for ( size_t i = 0; i < group.size(); ++i ) {
+    EventLoop& loop = group.loop( i );
+    auto& listener = listeners.emplace_back();
+    listener.set_reuseaddr();
+    listener.set_reuseport(); // each loop's listener gets its own share of the incoming connections
+    listener.bind( listen_address );
+    listener.listen();
+    listener.set_blocking( false );
+
+    auto& relay = relays.emplace_back( loop );
+    auto& resolver = *resolvers.emplace_back( make_unique<Resolver>( loop ) );
+    const size_t connect_category = loop.add_category( "connect upstream" );
+
+    const auto on_error = []( const exception_ptr& error ) {
+      try {
+        rethrow_exception( error );
+      } catch ( const exception& e ) {
+        cerr << "DEBUG: Could not connect to upstream: " << e.what() << "\n";
+      }
+    };
+
+    // drain the accept queue on each readiness event: accept4 hands back sockets that are already non-blocking
+    loop.add_rule( "accept connection", listener, Direction::In, [&, connect_category, on_error] {
+      listener.accept_many( [&]( TCPSocket&& accepted ) {
+        auto client = make_shared<TCPSocket>( move( accepted ) );
+        resolver.resolve_async(
+          upstream_host,
+          upstream_port,
+          [&loop, &relay, connect_category, client, on_error]( const Address& upstream ) {
+            async_connect(
+              loop,
+              connect_category,
+              upstream,
+              [&relay, client]( TCPSocket&& upstream_socket ) {
+                relay.add( move( *client ), move( upstream_socket ) );
+              },
+              on_error );
+          },
+          on_error );
+      } );
+    } );
+  }
+
+  cerr << "DEBUG: Relaying connections on " << listen_address.to_string() << " to " << upstream_host << ":"
+       << upstream_port << " with " << group.size() << " event loop" << ( group.size() == 1 ? "" : "s" ) << ".\n";
+  group.run();
 }
 
 int main( int argc, char** argv )
@@ -21,11 +95,28 @@ int main( int argc, char** argv )
     }
 
     auto args = span( argv, argc );
+    const char* program = args[0];
+
+    const bool splice_mode = argc >= 2 and strcmp( "--splice", args[1] ) == 0;
+    if ( splice_mode ) {
+      args = args.subspan( 1 ); // args[0] is now "--splice", and the options follow as usual
+      argc--;
+    }
+
+    if ( argc >= 2 and strncmp( "-r", args[1], 3 ) == 0 ) {
+      if ( argc < 7 ) {
+        show_usage( program );
+        return EXIT_FAILURE;
+      }
+      const size_t threads = stoul( args[2] );
+      relay_server( threads, { args[3], args[4] }, args[5], args[6] );
+      return EXIT_SUCCESS;
+    }
 
     bool server_mode = false;
     // NOLINTNEXTLINE(bugprone-assignment-*)
     if ( argc < 3 || ( ( server_mode = ( strncmp( "-l", args[1], 3 ) == 0 ) ) && argc < 4 ) ) {
-      show_usage( args[0] );
+      show_usage( program );
       return EXIT_FAILURE;
     }
 
@@ -49,7 +140,11 @@ int main( int argc, char** argv )
       return connecting_socket;
     }();
 
-    bidirectional_stream_copy( socket, socket.peer_address().to_string() );
+    if ( splice_mode ) {
+      bidirectional_splice_copy( socket, socket.peer_address().to_string() );
+    } else {
+      bidirectional_stream_copy( socket, socket.peer_address().to_string() );
+    }
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
     return EXIT_FAILURE;
@@ -1,18 +1,684 @@
+#include "async_connect.hh"
+#include "buffer_pool.hh"
+#include "byte_stream.hh"
+#include "eventloop.hh"
+#include "resolver.hh"
 #include "socket.hh"
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <cstdlib>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <span>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 using namespace std;
 
+namespace {
+//! One GET request, and the callbacks that its response is streamed to
+struct Request
+{
+  string path;
+  function<void( const string& head )> on_head;     //!< The status line and headers (each ending in CRLF)
+  function<void( string_view body )> on_body;       //!< Each piece of the (de-chunked) body, as it arrives
+  function<void( const string& error )> on_finish;  //!< Called once at the end; `error` is empty on success
+  unsigned attempts {};                             //!< Number of connections the request has been sent on
+  uint64_t id {};                                   //!< Set by HTTPClient::get
+  optional<EventLoop::RuleHandle> deadline {};      //!< The timer that fails the request if it takes too long
+  bool expired {};                                  //!< Has the deadline passed (while the request was in flight)?
+};
+
+string lowercase( string s )
+{
+  ranges::transform( s, s.begin(), []( unsigned char c ) { return tolower( c ); } );
+  return s;
+}
+
+string_view trim( string_view s )
+{
+  while ( not s.empty() and isspace( static_cast<unsigned char>( s.front() ) ) ) {
+    s.remove_prefix( 1 );
+  }
+  while ( not s.empty() and isspace( static_cast<unsigned char>( s.back() ) ) ) {
+    s.remove_suffix( 1 );
+  }
+  return s;
+}
+
+//! Parses a connection's stream of (pipelined) HTTP/1.1 responses, one response at a time.
+//! The body is handed to the request as it is parsed, and popped from the stream, so it is never buffered whole.
+class ResponseParser
+{
+  static constexpr size_t max_line_length = 65536;
+
+  enum class State : uint8_t
+  {
+    Head,           //!< Reading the status line and headers
+    Body,           //!< Reading a body of known length
+    ChunkSize,      //!< Reading the size line of the next chunk
+    ChunkData,      //!< Reading a chunk
+    ChunkEnd,       //!< Reading the CRLF after a chunk
+    Trailers,       //!< Reading the trailers after the last chunk
+    BodyUntilClose, //!< Reading a body that ends when the connection does
+  };
+
+  State state_ { State::Head };
+  string line_ {};
+  string head_ {};
+  uint64_t remaining_ {}; //!< Bytes left in the body or chunk
+  bool keep_alive_ { true };
+
+  // Move bytes up to the next LF into line_; returns true (with the CRLF removed) once the line is complete.
+  bool take_line( Reader& reader )
+  {
+    const string_view data = reader.peek();
+    const size_t end = data.find( '\n' );
+    line_.append( data.substr( 0, end ) );
+    reader.pop( end == string_view::npos ? data.size() : end + 1 );
+
+    if ( line_.size() > max_line_length ) {
+      throw runtime_error( "HTTP response line too long" );
+    }
+    if ( end == string_view::npos ) {
+      return false;
+    }
+    if ( line_.ends_with( '\r' ) ) {
+      line_.pop_back();
+    }
+    return true;
+  }
+
+  // Hand the request up to `remaining_` bytes of the body
+  void deliver_body( Reader& reader, Request& request )
+  {
+    string_view data = reader.peek();
+    data = data.substr( 0, state_ == State::BodyUntilClose ? data.size() : remaining_ );
+    request.on_body( data );
+    reader.pop( data.size() );
+    remaining_ -= min<uint64_t>( remaining_, data.size() );
+  }
+
+  // The head is complete: returns true if it was the whole response (there is no body)
+  bool start_body( Request& request )
+  {
+    istringstream head { head_ };
+    string version;
+    int status = 0;
+    head >> version >> status;
+    if ( not version.starts_with( "HTTP/1." ) or status < 100 ) {
+      throw runtime_error( "malformed HTTP status line" );
+    }
+
+    if ( status < 200 ) { // an interim response (e.g. 100 Continue): the real one follows
+      head_.clear();
+      return false;
+    }
+
+    keep_alive_ = version != "HTTP/1.0";
+    optional<uint64_t> content_length;
+    bool chunked = false;
+    string line;
+    getline( head, line ); // (the rest of the status line)
+    while ( getline( head, line ) ) {
+      const size_t colon = line.find( ':' );
+      if ( colon == string::npos ) {
+        continue;
+      }
+      const string name = lowercase( string { trim( string_view { line }.substr( 0, colon ) ) } );
+      const string value = lowercase( string { trim( string_view { line }.substr( colon + 1 ) ) } );
+      if ( name == "content-length" ) {
+        content_length = stoull( value );
+      } else if ( name == "transfer-encoding" ) {
+        chunked = value.find( "chunked" ) != string::npos;
+      } else if ( name == "connection" ) {
+        keep_alive_ = value.find( "close" ) == string::npos
+                      and ( keep_alive_ or value.find( "keep-alive" ) != string::npos );
+      }
+    }
+
+    request.on_head( head_ + "\r\n" );
+    head_.clear();
+
+    if ( status == 204 or status == 304 ) {
+      return true;
+    }
+    if ( chunked ) {
+      state_ = State::ChunkSize;
+    } else if ( content_length ) {
+      remaining_ = *content_length;
+      state_ = State::Body;
+      return remaining_ == 0;
+    } else {
+      state_ = State::BodyUntilClose;
+      keep_alive_ = false;
+    }
+    return false;
+  }
+
+  bool complete()
+  {
+    state_ = State::Head;
+    return true;
+  }
+
+public:
+  //! Parse as much of `reader` as possible for `request`; returns true once its response is complete
+  //! (and leaves any bytes that follow, which belong to the next response, in `reader`).
+  bool parse( Reader& reader, Request& request )
+  {
+    while ( reader.bytes_buffered() > 0 ) {
+      switch ( state_ ) {
+        case State::Head:
+          if ( take_line( reader ) ) {
+            if ( not line_.empty() ) {
+              head_.append( line_ ).append( "\r\n" );
+              if ( head_.size() > max_line_length ) {
+                throw runtime_error( "HTTP response head too long" );
+              }
+            } else if ( not head_.empty() and start_body( request ) ) {
+              line_.clear();
+              return complete();
+            }
+            line_.clear();
+          }
+          break;
+
+        case State::Body:
+          deliver_body( reader, request );
+          if ( remaining_ == 0 ) {
+            return complete();
+          }
+          break;
+
+        case State::ChunkSize:
+          if ( take_line( reader ) ) {
+            remaining_ = stoull( line_, nullptr, 16 ); // (ignoring any chunk extensions after the size)
+            line_.clear();
+            state_ = remaining_ ? State::ChunkData : State::Trailers;
+          }
+          break;
+
+        case State::ChunkData:
+          deliver_body( reader, request );
+          if ( remaining_ == 0 ) {
+            state_ = State::ChunkEnd;
+          }
+          break;
+
+        case State::ChunkEnd:
+          if ( take_line( reader ) ) {
+            if ( not line_.empty() ) {
+              throw runtime_error( "malformed HTTP chunk" );
+            }
+            state_ = State::ChunkSize;
+          }
+          break;
+
+        case State::Trailers:
+          if ( take_line( reader ) ) {
+            const bool last = line_.empty();
+            line_.clear();
+            if ( last ) {
+              return complete();
+            }
+          }
+          break;
+
+        case State::BodyUntilClose:
+          deliver_body( reader, request );
+          break;
+      }
+    }
+    return false;
+  }
+
+  //! Has any of the current response arrived?
+  bool started() const { return state_ != State::Head or not line_.empty() or not head_.empty(); }
+
+  //! The connection ended: returns true if that completes the current response (whose body ran until the end)
+  bool finish_at_close()
+  {
+    if ( state_ != State::BodyUntilClose ) {
+      return false;
+    }
+    return complete();
+  }
+
+  //! May the connection be reused after the last complete response?
+  bool keep_alive() const { return keep_alive_; }
+};
+
+//! Fetches URLs on one EventLoop, keeping up to `connections_per_host` persistent connections to each host
+//! and pipelining up to `pipeline_depth` requests on each. Requests that a connection closed on before any
+//! of their response arrived are retried on another connection. After `max_connect_failures` connection attempts
+//! to a host have failed in a row, its queued requests fail with the error. A request that hasn't finished within
+//! `request_timeout` of being queued fails, and the connection it was sent on (if any) is closed.
+class HTTPClient
+{
+  static constexpr unsigned max_attempts = 3;
+  static constexpr unsigned max_connect_failures = 3;
+  static constexpr size_t stream_capacity = 65536;
+
+  struct Connection
+  {
+    TCPSocket socket;
+    ByteStream outbound { stream_capacity };
+    ByteStream inbound { stream_capacity };
+    deque<Request> in_flight {}; //!< Requests sent, in order, whose responses haven't finished
+    ResponseParser parser {};
+    vector<EventLoop::RuleHandle> rules {};
+    uint64_t responses {};
+    bool closed {};
+
+    explicit Connection( TCPSocket&& s_socket ) : socket( move( s_socket ) ) {}
+  };
+
+  struct Host
+  {
+    string name;
+    string port;
+    deque<Request> queued {};
+    vector<shared_ptr<Connection>> connections {};
+    size_t connecting {};
+    unsigned connect_failures {}; //!< Consecutive failed connection attempts
+  };
+
+  reference_wrapper<EventLoop> loop_;
+  Resolver resolver_;
+  size_t connections_per_host_;
+  size_t pipeline_depth_;
+  chrono::milliseconds request_timeout_;
+  size_t connect_category_;
+  size_t write_category_;
+  size_t read_category_;
+  size_t timeout_category_;
+  unordered_map<string, Host> hosts_ {};
+  size_t outstanding_ {};
+  uint64_t next_request_id_ {};
+
+  void finish( Request& request, const string& error )
+  {
+    --outstanding_;
+    request.deadline->cancel();
+    request.on_finish( error );
+  }
+
+  // A request's deadline has passed: if it is still queued, it fails; if it has been sent, so does its connection
+  // (whose responses can't be told apart from the late one's)
+  void expire( Host& host, uint64_t id )
+  {
+    const auto queued = ranges::find( host.queued, id, &Request::id );
+    if ( queued != host.queued.end() ) {
+      Request request = move( *queued );
+      host.queued.erase( queued );
+      finish( request, "timed out" );
+      return;
+    }
+
+    for ( const auto& connection : host.connections ) {
+      const auto sent = ranges::find( connection->in_flight, id, &Request::id );
+      if ( sent != connection->in_flight.end() ) {
+        sent->expired = true;
+        const shared_ptr<Connection> expired_connection = connection; // (closing it removes it from the host)
+        close_connection( host, *expired_connection, "timed out" );
+        return;
+      }
+    }
+  }
+
+  // Send queued requests on the connections, and open more connections if the queue is still long
+  void dispatch( Host& host )
+  {
+    for ( const auto& connection : host.connections ) {
+      fill_pipeline( host, *connection );
+    }
+
+    // once connecting keeps failing, make one attempt at a time (and only when nothing else could take the queue)
+    const bool failing = host.connect_failures >= max_connect_failures;
+    while ( host.queued.size() > host.connecting * pipeline_depth_
+            and host.connections.size() + host.connecting < ( failing ? 1 : connections_per_host_ ) ) {
+      open_connection( host );
+    }
+  }
+
+  void fill_pipeline( Host& host, Connection& connection )
+  {
+    // until the server has shown that it keeps connections open, send one request at a time
+    const size_t depth = connection.responses > 0 ? pipeline_depth_ : 1;
+
+    while ( not connection.closed and not host.queued.empty() and connection.in_flight.size() < depth ) {
+      Request& request = host.queued.front();
+      string text = "GET " + request.path + " HTTP/1.1\r\nHost: " + host.name
+                    + ( host.port == "80" or host.port == "http" ? "" : ":" + host.port )
+                    + "\r\nConnection: keep-alive\r\n\r\n";
+      if ( text.size() > connection.outbound.writer().available_capacity() ) {
+        break;
+      }
+
+      connection.outbound.writer().push( move( text ) );
+      ++request.attempts;
+      connection.in_flight.push_back( move( request ) );
+      host.queued.pop_front();
+    }
+  }
+
+  void open_connection( Host& host )
+  {
+    ++host.connecting;
+    const auto on_error = [this, &host]( const exception_ptr& error ) {
+      --host.connecting;
+      connect_failed( host, error );
+    };
+
+    resolver_.resolve_async(
+      host.name,
+      host.port,
+      [this, &host, on_error]( const Address& address ) {
+        try {
+          async_connect(
+            loop_,
+            connect_category_,
+            address,
+            [this, &host]( TCPSocket&& socket ) {
+              --host.connecting;
+              connected( host, move( socket ) );
+            },
+            on_error );
+        } catch ( ... ) {
+          on_error( current_exception() );
+        }
+      },
+      on_error );
+  }
+
+  void connect_failed( Host& host, const exception_ptr& error )
+  {
+    ++host.connect_failures;
+    if ( not host.connections.empty() or ( host.connecting > 0 and host.connect_failures < max_connect_failures ) ) {
+      dispatch( host ); // the other connections (or attempts) can take the queued requests
+      return;
+    }
+
+    string reason = "connection failed";
+    try {
+      rethrow_exception( error );
+    } catch ( const exception& e ) {
+      reason = e.what();
+    }
+
+    deque<Request> failed = move( host.queued );
+    host.queued.clear();
+    for ( auto& request : failed ) {
+      finish( request, reason );
+    }
+  }
+
+  void connected( Host& host, TCPSocket&& socket )
+  {
+    host.connect_failures = 0;
+    auto connection = make_shared<Connection>( move( socket ) );
+    host.connections.push_back( connection );
+    Socket& s = connection->socket;
+
+    connection->rules.push_back( loop_.get().add_rule(
+      write_category_,
+      s,
+      EventLoop::Direction::Out,
+      [c = connection] { drain( c->outbound.reader(), c->socket ); },
+      [c = connection] { return not c->closed and c->outbound.reader().bytes_buffered() > 0; } ) );
+
+    connection->rules.push_back( loop_.get().add_rule(
+      read_category_,
+      s,
+      EventLoop::Direction::In,
+      [this, &host, c = connection] {
+        string data = BufferPool::take( c->inbound.writer().available_capacity() );
+        c->socket.read( data );
+        c->inbound.writer().push( move( data ) );
+        if ( c->socket.eof() ) {
+          c->inbound.writer().close();
+        }
+        handle_input( host, *c );
+      },
+      [c = connection] { return not c->closed and c->inbound.writer().available_capacity() > 0; },
+      [this, &host, c = connection] { close_connection( host, *c, "connection closed" ); },
+      [this, &host, c = connection] { close_connection( host, *c, "connection error" ); } ) );
+
+    fill_pipeline( host, *connection );
+  }
+
+  // Parse the responses that have arrived, and send more requests as they finish
+  void handle_input( Host& host, Connection& connection )
+  {
+    Reader& reader = connection.inbound.reader();
+    try {
+      while ( not connection.closed and reader.bytes_buffered() > 0 ) {
+        if ( connection.in_flight.empty() ) {
+          close_connection( host, connection, "unexpected data from server" );
+          return;
+        }
+        if ( not connection.parser.parse( reader, connection.in_flight.front() ) ) {
+          break;
+        }
+
+        Request request = move( connection.in_flight.front() );
+        connection.in_flight.pop_front();
+        ++connection.responses;
+        finish( request, "" );
+
+        if ( not connection.parser.keep_alive() ) {
+          close_connection( host, connection, "connection closed" );
+          return;
+        }
+        fill_pipeline( host, connection );
+      }
+    } catch ( const exception& e ) {
+      close_connection( host, connection, e.what() );
+      return;
+    }
+
+    if ( reader.is_finished() and not connection.closed ) {
+      if ( not connection.in_flight.empty() and connection.parser.finish_at_close() ) {
+        Request request = move( connection.in_flight.front() );
+        connection.in_flight.pop_front();
+        finish( request, "" );
+      }
+      close_connection( host, connection, "connection closed" );
+    }
+  }
+
+  // Stop using a connection: the response in progress fails, and the requests behind it are retried
+  void close_connection( Host& host, Connection& connection, const string& reason )
+  {
+    if ( connection.closed ) {
+      return;
+    }
+    connection.closed = true;
+    for ( auto& rule : connection.rules ) {
+      rule.cancel();
+    }
+
+    deque<Request> retry;
+    for ( size_t i = 0; i < connection.in_flight.size(); ++i ) {
+      Request& request = connection.in_flight[i];
+      if ( ( i == 0 and connection.parser.started() ) or request.attempts >= max_attempts or request.expired ) {
+        finish( request, reason );
+      } else {
+        retry.push_back( move( request ) );
+      }
+    }
+    connection.in_flight.clear();
+    host.queued.insert(
+      host.queued.begin(), make_move_iterator( retry.begin() ), make_move_iterator( retry.end() ) );
+
+    erase_if( host.connections, [&]( const auto& c ) { return c.get() == &connection; } );
+    dispatch( host );
+  }
+
+public:
+  explicit HTTPClient( EventLoop& loop,
+                       size_t connections_per_host = 4,
+                       size_t pipeline_depth = 8,
+                       chrono::milliseconds request_timeout = chrono::seconds { 30 } )
+    : loop_( loop )
+    , resolver_( loop )
+    , connections_per_host_( connections_per_host )
+    , pipeline_depth_( pipeline_depth )
+    , request_timeout_( request_timeout )
+    , connect_category_( loop.add_category( "HTTP connect" ) )
+    , write_category_( loop.add_category( "HTTP write requests" ) )
+    , read_category_( loop.add_category( "HTTP read responses" ) )
+    , timeout_category_( loop.add_category( "HTTP request timeouts" ) )
+  {}
+
+  //! Queue a GET request to `host`:`port`
+  void get( const string& host, const string& port, Request request )
+  {
+    Host& h = hosts_.try_emplace( host + ":" + port, Host { host, port } ).first->second;
+    request.id = next_request_id_++;
+    request.deadline = loop_.get().add_timer(
+      timeout_category_, request_timeout_, [this, &h, id = request.id] { expire( h, id ); } );
+    h.queued.push_back( move( request ) );
+    ++outstanding_;
+    dispatch( h );
+  }
+
+  //! Number of requests that haven't finished
+  size_t outstanding() const { return outstanding_; }
+
+  //! Run the loop until every request has finished
+  void run()
+  {
+    while ( outstanding_ > 0 ) {
+      if ( loop_.get().wait_next_event( -1 ) == EventLoop::Result::Exit ) {
+        throw runtime_error( "HTTPClient: event loop exited with requests outstanding" );
+      }
+    }
+  }
+};
+
+// Print the whole response (head and body) to stdout
 void get_URL( const string& host, const string& path )
 {
-  cerr << "Function called: get_URL(" << host << ", " << path << ")\n";
-  cerr << "Warning: get_URL() has not been implemented yet.\n";
+  EventLoop loop;
+  HTTPClient client { loop };
+
+  // (the host may include a port, as in a URL)
+  const size_t colon = host.find( ':' );
+  string error;
+  client.get( host.substr( 0, colon ),
+              colon == string::npos ? "http" : host.substr( colon + 1 ),
+              { .path = path,
+                .on_head = []( const string& head ) { cout << head; },
+                .on_body = []( string_view body ) { cout << body; },
+                .on_finish = [&]( const string& e ) { error = e; } } );
+  client.run();
+
+  if ( not error.empty() ) {
+    throw runtime_error( "get_URL(" + host + ", " + path + "): " + error );
+  }
 }
 
+struct URL
+{
+  string host {};
+  string port {};
+  string path {};
+};
+
+// Parse "http://host[:port][/path]", or "host path"
+URL parse_URL( const string& line )
+{
+  istringstream words { line };
+  string first;
+  string second;
+  words >> first >> second;
+  if ( not second.empty() ) {
+    return { first, "http", second };
+  }
+
+  string_view rest { first };
+  if ( rest.starts_with( "http://" ) ) {
+    rest.remove_prefix( 7 );
+  }
+  const size_t slash = rest.find( '/' );
+  const string_view authority = rest.substr( 0, slash );
+  const string path { slash == string_view::npos ? "/" : rest.substr( slash ) };
+  const size_t colon = authority.find( ':' );
+  if ( authority.empty() ) {
+    throw runtime_error( "invalid URL: " + line );
+  }
+  if ( colon == string_view::npos ) {
+    return { string { authority }, "http", path };
+  }
+  return { string { authority.substr( 0, colon ) }, string { authority.substr( colon + 1 ) }, path };
+}
+
+// Fetch each URL listed on stdin concurrently, printing one line per URL (status, body size, time) as each ends
+void get_URLs( size_t connections_per_host, size_t pipeline_depth, chrono::seconds request_timeout )
+{
+  EventLoop loop;
+  HTTPClient client { loop, connections_per_host, pipeline_depth, request_timeout };
+
+  string line;
+  while ( getline( cin, line ) ) {
+    if ( trim( line ).empty() ) {
+      continue;
+    }
+
+    struct Result
+    {
+      string url;
+      string status {};
+      uint64_t body_bytes {};
+      chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    };
+    auto result = make_shared<Result>( string { trim( line ) } );
+
+    URL url;
+    try {
+      url = parse_URL( line );
+    } catch ( const exception& e ) {
+      cout << result->url << " ERROR " << e.what() << "\n";
+      continue;
+    }
+
+    client.get( url.host,
+                url.port,
+                { .path = url.path,
+                  .on_head =
+                    [result]( const string& head ) {
+                      istringstream status_line { head };
+                      string version;
+                      status_line >> version >> result->status;
+                    },
+                  .on_body = [result]( string_view body ) { result->body_bytes += body.size(); },
+                  .on_finish =
+                    [result]( const string& error ) {
+                      const auto elapsed = chrono::duration_cast<chrono::milliseconds>(
+                        chrono::steady_clock::now() - result->start );
+                      cout << result->url << " ";
+                      if ( error.empty() ) {
+                        cout << result->status << " " << result->body_bytes << " bytes";
+                      } else {
+                        cout << "ERROR " << error;
+                      }
+                      cout << " " << elapsed.count() << " ms\n";
+                    } } );
+  }
+
+  client.run();
+}
+} // namespace
+
 int main( int argc, char* argv[] )
 {
   try {
@@ -22,12 +688,24 @@ int main( int argc, char* argv[] )
 
     auto args = span( argv, argc );
 
+    // In batch mode, the URLs come from stdin (one per line), optionally followed by the number of
+    // connections per host, the pipeline depth, and the request timeout in seconds.
+    if ( argc >= 2 and string_view { args[1] } == "--batch" and argc <= 5 ) {
+      get_URLs( argc >= 3 ? stoul( args[2] ) : 4,
+                argc >= 4 ? stoul( args[3] ) : 8,
+                chrono::seconds { argc >= 5 ? stoul( args[4] ) : 30 } );
+      return EXIT_SUCCESS;
+    }
+
     // The program takes two command-line arguments: the hostname and "path" part of the URL.
     // Print the usage message unless there are these two arguments (plus the program name
     // itself, so arg count = 3 in total).
     if ( argc != 3 ) {
       cerr << "Usage: " << args.front() << " HOST PATH\n";
+      cerr << "       " << args.front()
+           << " --batch [CONNECTIONS PER HOST] [PIPELINE DEPTH] [TIMEOUT SECONDS] < URLS\n";
       cerr << "\tExample: " << args.front() << " stanford.edu /class/cs144\n";
+      cerr << "\tIn batch mode, each line of stdin is a URL (http://host[:port]/path) or \"HOST PATH\".\n";
       return EXIT_FAILURE;
     }
 
@@ -13,3 +13,7 @@ set(SANITIZING_FLAGS -fno-sanitize-recover=all -fsanitize=undefined -fsanitize=a
 # ask for more warnings from the compiler
 set (CMAKE_BASE_CXX_FLAGS "${CMAKE_CXX_FLAGS}")
 set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -Wall -Wpedantic -Wextra -Weffc++ -Werror -Wshadow -Wpointer-arith -Wcast-qual -Wformat=2 -Wno-unqualified-std-cast-call -Wno-non-virtual-dtor")
+
+# trace points below this level are compiled out (0: debug, 1: info, 2: warning, 3: none); see util/trace.hh
+set (TRACE_LEVEL 1 CACHE STRING "Lowest level of trace points to compile in")
+add_compile_definitions (MINNOW_TRACE_LEVEL=${TRACE_LEVEL})
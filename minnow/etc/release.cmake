@@ -0,0 +1,38 @@
+# Release builds of the apps: the speed tests' optimizations (-O2 -DNDEBUG), plus link-time optimization
+# and, optionally, profile-guided optimization. The *_release libraries and apps are built on request
+# (e.g. `cmake --build build -t release_apps`).
+#
+# PGO in two passes (or see scripts/pgo.sh):
+#   cmake -B build -DPGO=generate && cmake --build build -t pgo_train   # instrumented build, then training runs
+#   cmake -B build -DPGO=use && cmake --build build -t release_apps      # rebuilt with the recorded profile
+
+set (PGO "off" CACHE STRING "Profile-guided optimization of the release apps: off, generate or use")
+set_property (CACHE PGO PROPERTY STRINGS off generate use)
+set (PGO_PROFILE_DIR "${CMAKE_BINARY_DIR}/pgo-profile" CACHE PATH "Where PGO training runs record their profile")
+
+set (RELEASE_FLAGS -O2 -DNDEBUG)
+set (RELEASE_LINK_FLAGS)
+if (PGO STREQUAL "generate")
+  # (atomic counter updates, since the apps are multithreaded)
+  list (APPEND RELEASE_FLAGS -fprofile-generate=${PGO_PROFILE_DIR} -fprofile-update=prefer-atomic)
+  list (APPEND RELEASE_LINK_FLAGS -fprofile-generate=${PGO_PROFILE_DIR})
+elseif (PGO STREQUAL "use")
+  # code that training didn't reach is optimized as usual, and a stale profile is only a warning
+  list (APPEND RELEASE_FLAGS -fprofile-use=${PGO_PROFILE_DIR} -fprofile-partial-training
+        -Wno-missing-profile -Wno-error=coverage-mismatch)
+elseif (NOT PGO STREQUAL "off")
+  message (FATAL_ERROR "PGO must be off, generate or use (not \"${PGO}\")")
+endif ()
+
+include (CheckIPOSupported)
+check_ipo_supported (RESULT RELEASE_LTO OUTPUT lto_error LANGUAGES CXX)
+if (NOT RELEASE_LTO)
+  message (STATUS "Link-time optimization is not supported, so the release apps are built without it")
+endif ()
+
+macro (add_release_library name)
+  add_library ("${name}" EXCLUDE_FROM_ALL STATIC ${ARGN})
+  target_compile_options ("${name}" PUBLIC ${RELEASE_FLAGS})
+  target_link_options ("${name}" PUBLIC ${RELEASE_LINK_FLAGS})
+  set_property (TARGET "${name}" PROPERTY INTERPROCEDURAL_OPTIMIZATION ${RELEASE_LTO})
+endmacro (add_release_library)
@@ -17,12 +17,22 @@ set_tests_properties(${compile_name} PROPERTIES FIXTURES_SETUP compile)
 add_test(NAME t_webget COMMAND "${PROJECT_SOURCE_DIR}/tests/webget_t.sh" "${PROJECT_BINARY_DIR}")
 set_property(TEST t_webget PROPERTY FIXTURES_REQUIRED compile)
 
+add_test(NAME t_webget_refused COMMAND "${PROJECT_SOURCE_DIR}/tests/webget_refused_t.sh" "${PROJECT_BINARY_DIR}")
+set_property(TEST t_webget_refused PROPERTY FIXTURES_REQUIRED compile)
+
+add_test(NAME t_webget_timeout COMMAND "${PROJECT_SOURCE_DIR}/tests/webget_timeout_t.sh" "${PROJECT_BINARY_DIR}")
+set_property(TEST t_webget_timeout PROPERTY FIXTURES_REQUIRED compile)
+
 ttest(byte_stream_basics)
 ttest(byte_stream_capacity)
 ttest(byte_stream_one_write)
 ttest(byte_stream_two_writes)
 ttest(byte_stream_many_writes)
 ttest(byte_stream_stress_test)
+ttest(byte_stream_refs)
+ttest(byte_stream_concurrent)
+ttest(byte_stream_static)
+ttest(byte_stream_watermarks)
 
 ttest(reassembler_single)
 ttest(reassembler_cap)
@@ -57,6 +67,21 @@ ttest(send_extra)
 ttest(net_interface)
 
 ttest(router)
+ttest(forwarding_pipeline)
+
+ttest(eventloop_backends)
+ttest(eventloop_timers)
+ttest(eventloop_group)
+ttest(file_descriptor_transfer)
+ttest(buffer_pool)
+ttest(datagram_batch)
+ttest(async_connect)
+ttest(parser)
+ttest(checksum)
+ttest(trace)
+ttest(coroutine)
+ttest(mapped_file)
+ttest(tcp_accept)
 
 ttest(no_skip)
 
@@ -76,7 +101,9 @@ add_custom_target (check5 COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --s
 
 ###
 
-add_custom_target (speed COMMAND ${CMAKE_CTEST_COMMAND} --output-on-failure --timeout 15 -R '_speed_test')
+# (the speed tests also save their results as CSV and JSON, in benchmarks/ in the build directory)
+add_custom_target (speed COMMAND ${CMAKE_COMMAND} -E env MINNOW_BENCHMARK_DIR=${CMAKE_BINARY_DIR}/benchmarks
+  ${CMAKE_CTEST_COMMAND} --output-on-failure --timeout 15 -R '_speed_test')
 
 set(compile_name_opt "compile with optimization")
 add_test(NAME ${compile_name_opt}
@@ -91,4 +118,10 @@ set_property(TEST ${compile_name_opt} PROPERTY TIMEOUT 0)
 set_tests_properties(${compile_name_opt} PROPERTIES FIXTURES_SETUP compile_opt)
 
 stest(byte_stream_speed_test)
+stest(checksum_speed_test)
+stest(eventloop_speed_test)
+stest(file_descriptor_speed_test)
+stest(parser_speed_test)
 stest(reassembler_speed_test)
+stest(router_speed_test)
+stest(wrapping_integers_speed_test)
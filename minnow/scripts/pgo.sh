@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# Build the release apps with profile-guided optimization: an instrumented build, training runs
+# (the relay and ByteStream benchmarks), then a rebuild with the recorded profile.
+# Usage: scripts/pgo.sh [build directory (default: build)]
+
+set -e
+
+BUILD_DIR="${1:-build}"
+
+cmake -S "$(dirname "$0")/.." -B "${BUILD_DIR}" -DPGO=generate
+cmake --build "${BUILD_DIR}" --target pgo_train
+
+cmake -B "${BUILD_DIR}" -DPGO=use
+cmake --build "${BUILD_DIR}" --target release_apps
+
+echo "The release apps (*_release) in ${BUILD_DIR}/apps are built with the profile in ${BUILD_DIR}/pgo-profile."
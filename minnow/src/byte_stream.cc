@@ -1,56 +1,250 @@
 #include "byte_stream.hh"
+#include "buffer_pool.hh"
+
+#include <algorithm>
+#include <stdexcept>
 
 using namespace std;
 
 ByteStream::ByteStream( uint64_t capacity ) : capacity_( capacity ) {}
 
+void ByteStream::set_capacity( uint64_t capacity )
+{
+  capacity_ = max( capacity, bytes_pushed_ - bytes_popped_ );
+}
+
+void ByteStream::set_watermarks( uint64_t low, uint64_t high )
+{
+  if ( low > high ) {
+    throw invalid_argument( "ByteStream: low watermark is above the high watermark" );
+  }
+  low_watermark_ = low;
+  high_watermark_ = high;
+  update_pause();
+}
+
+void ByteStream::update_pause()
+{
+  const uint64_t buffered = bytes_pushed_ - bytes_popped_;
+  const bool paused = paused_ ? buffered > low_watermark_ : high_watermark_ > 0 and buffered >= high_watermark_;
+  if ( paused == paused_ ) {
+    return;
+  }
+
+  paused_ = paused;
+  if ( watermark_callback_ ) {
+    watermark_callback_( paused_ );
+  }
+}
+
+string_view ByteStream::view( const Segment& segment )
+{
+  if ( const auto* ref = get_if<Ref<string>>( &segment ) ) {
+    return ref->get();
+  }
+  return get<Slice>( segment );
+}
+
+// Append an empty slot at the tail of the segment ring, doubling the ring if it is full.
+ByteStream::Segment& ByteStream::emplace_segment()
+{
+  if ( segment_count() == segments_.size() ) {
+    vector<Segment> larger( max<size_t>( 2 * segments_.size(), 16 ) );
+    for ( uint64_t i = 0; i < segment_count(); ++i ) {
+      larger[i] = move( segment( head_ + i ) );
+    }
+    tail_ = segment_count();
+    head_ = 0;
+    segments_ = move( larger );
+  }
+
+  return segment( tail_++ );
+}
+
 void Writer::push( string data )
 {
-  (void)data; // Your code here.
+  push( Ref<string> { move( data ) } );
+}
+
+void Writer::push( Ref<string> data )
+{
+  if ( closed_ or error_ ) {
+    return;
+  }
+
+  const uint64_t len = min<uint64_t>( data.get().size(), available_capacity() );
+  if ( len == 0 ) {
+    return;
+  }
+
+  if ( len < data.get().size() ) {
+    if ( data.is_owned() ) {
+      data.get_mut().resize( len ); // truncating never reallocates
+    } else {
+      data = Ref<string> { data.get().substr( 0, len ) };
+    }
+  }
+
+  emplace_segment() = move( data );
+  bytes_pushed_ += len;
+  update_pause();
+}
+
+void Writer::push( vector<Ref<string>> data )
+{
+  for ( auto& segment : data ) {
+    push( move( segment ) );
+  }
+}
+
+void Writer::push( Slice data )
+{
+  if ( closed_ or error_ ) {
+    return;
+  }
+
+  const uint64_t len = min<uint64_t>( data.size(), available_capacity() );
+  if ( len == 0 ) {
+    return;
+  }
+
+  data.remove_suffix( data.size() - len );
+  emplace_segment() = move( data );
+  bytes_pushed_ += len;
+  update_pause();
+}
+
+void Writer::push( vector<Slice> data )
+{
+  for ( auto& segment : data ) {
+    push( move( segment ) );
+  }
 }
 
 void Writer::close()
 {
-  // Your code here.
+  closed_ = true;
 }
 
 bool Writer::is_closed() const
 {
-  return {}; // Your code here.
+  return closed_;
 }
 
 uint64_t Writer::available_capacity() const
 {
-  return {}; // Your code here.
+  return capacity_ - ( bytes_pushed_ - bytes_popped_ );
 }
 
 uint64_t Writer::bytes_pushed() const
 {
-  return {}; // Your code here.
+  return bytes_pushed_;
+}
+
+bool Writer::is_paused() const
+{
+  return paused_;
+}
+
+void Writer::flush()
+{
+  flushed_until_ = bytes_pushed_;
 }
 
 string_view Reader::peek() const
 {
-  return {}; // Your code here.
+  if ( segment_count() == 0 ) {
+    return {};
+  }
+
+  return view( segment( head_ ) ).substr( front_offset_ );
+}
+
+size_t Reader::peek_buffers( span<string_view> out ) const
+{
+  const size_t count = min<uint64_t>( out.size(), segment_count() );
+  if ( count == 0 ) {
+    return 0;
+  }
+
+  out[0] = peek();
+  for ( size_t i = 1; i < count; ++i ) {
+    out[i] = view( segment( head_ + i ) );
+  }
+  return count;
 }
 
 void Reader::pop( uint64_t len )
 {
-  (void)len; // Your code here.
+  len = min( len, bytes_buffered() );
+  if ( low_watermark_ > 0 and bytes_buffered() >= low_watermark_ ) {
+    flushed_until_ = bytes_pushed_; // what's left of a batch stays one, even once popping takes it below the mark
+  }
+  bytes_popped_ += len;
+  update_pause();
+
+  while ( len > 0 ) {
+    Segment& front = segment( head_ );
+    const uint64_t remaining_in_front = view( front ).size() - front_offset_;
+    if ( len < remaining_in_front ) {
+      front_offset_ += len;
+      return;
+    }
+
+    len -= remaining_in_front;
+    auto* ref = get_if<Ref<string>>( &front );
+    if ( ref and ref->is_owned() ) {
+      BufferPool::give_back( move( ref->get_mut() ) ); // recycle a read buffer for the next read
+    }
+    front = Ref<string> {}; // release the segment's storage now rather than when its ring slot is reused
+    front_offset_ = 0;
+    ++head_;
+  }
+}
+
+Slice Reader::pop_slice( uint64_t max_len )
+{
+  const uint64_t len = min( max_len, bytes_buffered() );
+  if ( len == 0 ) {
+    return {};
+  }
+
+  Segment& front = segment( head_ );
+  if ( view( front ).size() - front_offset_ < len ) {
+    string bytes;
+    read( *this, len, bytes );
+    return bytes;
+  }
+
+  // Share the front segment, turning an owned Ref into a Slice of the same string.
+  if ( auto* ref = get_if<Ref<string>>( &front ); ref and ref->is_owned() ) {
+    front = Slice { move( *ref ) };
+  }
+
+  const auto* shared = get_if<Slice>( &front );
+  Slice ret = shared and not shared->is_borrowed() ? shared->substr( front_offset_, len )
+                                                  : string { view( front ).substr( front_offset_, len ) };
+  pop( len );
+  return ret;
 }
 
 bool Reader::is_finished() const
 {
-  return {}; // Your code here.
+  return closed_ and bytes_buffered() == 0;
 }
 
 uint64_t Reader::bytes_buffered() const
 {
-  return {}; // Your code here.
+  return bytes_pushed_ - bytes_popped_;
 }
 
 uint64_t Reader::bytes_popped() const
 {
-  return {}; // Your code here.
+  return bytes_popped_;
 }
 
+bool Reader::has_batch() const
+{
+  return bytes_buffered() > 0
+         and ( bytes_buffered() >= low_watermark_ or bytes_popped_ < flushed_until_ or closed_ );
+}
@@ -1,11 +1,20 @@
 #pragma once
 
+#include "inplace_function.hh"
+#include "ref.hh"
+#include "slice.hh"
+
 #include <cstdint>
+#include <span>
 #include <string>
 #include <string_view>
+#include <variant>
+#include <vector>
 
 class Reader;
 class Writer;
+class FileDescriptor;
+class MappedFile;
 
 class ByteStream
 {
@@ -21,10 +30,53 @@ public:
   void set_error() { error_ = true; };       // Signal that the stream suffered an error.
   bool has_error() const { return error_; }; // Has the stream had an error?
 
+  // The stream's capacity can change (e.g. a receive window that grows with the application's demand).
+  // It never shrinks below bytes_buffered(), so bytes already pushed stay in the stream.
+  uint64_t capacity() const { return capacity_; }
+  void set_capacity( uint64_t capacity );
+
+  // Flow-control watermarks, in bytes buffered (both 0, which turns them off, by default). Once bytes_buffered()
+  // rises to `high`, the Writer is paused until it falls back to `low`, so a producer resumes with room for a
+  // large push rather than topping the stream up a few bytes at a time. The Reader only has a batch ready
+  // once `low` bytes are buffered, or the Writer has flushed or closed, so a consumer takes them in large pieces.
+  void set_watermarks( uint64_t low, uint64_t high );
+  uint64_t low_watermark() const { return low_watermark_; }
+  uint64_t high_watermark() const { return high_watermark_; }
+
+  // Called on each change (an edge, not a level) of the Writer's pause state: with true when it pauses, and with
+  // false when it resumes. The callback runs inside push() or pop(), so it must not push to or pop the stream.
+  using WatermarkCallback = InplaceFunction<void( bool paused )>;
+  void on_watermark( WatermarkCallback callback ) { watermark_callback_ = std::move( callback ); }
+
 protected:
   // Please add any additional state to the ByteStream here, and not to the Writer and Reader interfaces.
   uint64_t capacity_;
   bool error_ {};
+  bool closed_ {};
+  uint64_t bytes_pushed_ {};
+  uint64_t bytes_popped_ {};
+
+  uint64_t low_watermark_ {};
+  uint64_t high_watermark_ {};
+  uint64_t flushed_until_ {}; // the Reader has a batch ready while bytes_popped_ is below this
+  bool paused_ {};
+  WatermarkCallback watermark_callback_ {};
+  void update_pause(); // pause or resume the Writer after bytes_buffered() has changed
+
+  // Buffered data is kept as the segments that were pushed (moved in, borrowed or shared, never copied), in a
+  // ring whose size is a power of two. The ring only grows, so a warmed-up stream does not allocate.
+  using Segment = std::variant<Ref<std::string>, Slice>;
+  static std::string_view view( const Segment& segment );
+
+  std::vector<Segment> segments_ {};
+  uint64_t head_ {};         // index (mod ring size) of the oldest buffered segment
+  uint64_t tail_ {};         // index (mod ring size) one past the newest buffered segment
+  uint64_t front_offset_ {}; // number of bytes of the oldest segment that have already been popped
+
+  uint64_t segment_count() const { return tail_ - head_; }
+  Segment& segment( uint64_t index ) { return segments_[index & ( segments_.size() - 1 )]; }
+  const Segment& segment( uint64_t index ) const { return segments_[index & ( segments_.size() - 1 )]; }
+  Segment& emplace_segment();
 };
 
 class Writer : public ByteStream
@@ -33,9 +85,23 @@ public:
   void push( std::string data ); // Push data to stream, but only as much as available capacity allows.
   void close();                  // Signal that the stream has reached its ending. Nothing more will be written.
 
+  // Push without copying: an owned Ref is moved into the stream, and a borrowed Ref is kept as a reference,
+  // so a borrowed string must stay alive and unmodified until its bytes have been popped.
+  // (If a borrowed string has to be truncated to fit the available capacity, the prefix that fits is copied.)
+  void push( Ref<std::string> data );
+  void push( std::vector<Ref<std::string>> data ); // Push each segment in order, as above.
+
+  // Push a Slice without copying (if it is truncated to fit, only its view shrinks).
+  // Like a borrowed Ref, a borrowed Slice must stay valid until its bytes have been popped.
+  void push( Slice data );
+  void push( std::vector<Slice> data );
+
   bool is_closed() const;              // Has the stream been closed?
   uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
   uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
+
+  bool is_paused() const; // Has the high watermark been reached (and the low watermark not yet)?
+  void flush();           // Make every byte pushed so far a batch for the Reader, even if below the low watermark
 };
 
 class Reader : public ByteStream
@@ -44,9 +110,22 @@ public:
   std::string_view peek() const; // Peek at the next bytes in the buffer
   void pop( uint64_t len );      // Remove `len` bytes from the buffer
 
+  // Remove up to `max_len` bytes and return them as a Slice that stays valid after they are popped.
+  // If they all lie in one pushed segment, the Slice shares that segment's string (which is not copied);
+  // otherwise, or if the segment was borrowed, they are copied into a string of their own.
+  Slice pop_slice( uint64_t max_len );
+
+  // Peek at up to `out.size()` buffered segments in order (the first is the same as peek()).
+  // Returns the number of views filled in; their total length is at most bytes_buffered().
+  size_t peek_buffers( std::span<std::string_view> out ) const;
+
   bool is_finished() const;        // Is the stream finished (closed and fully popped)?
   uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
   uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped from stream
+
+  // Are bytes buffered, and either the low watermark reached, or the bytes flushed, or the stream closed?
+  // (Once the low watermark has been reached, the bytes buffered then remain a batch until they are all popped.)
+  bool has_batch() const;
 };
 
 /*
@@ -54,3 +133,36 @@ public:
  * from a ByteStream Reader into a string;
  */
 void read( Reader& reader, uint64_t max_len, std::string& out );
+
+/*
+ * read_into: A helper function that peeks and pops up to `out.size()` bytes
+ * from a ByteStream Reader into caller-owned memory. Returns the number of bytes read.
+ */
+uint64_t read_into( Reader& reader, std::span<char> out );
+
+/*
+ * drain: A helper function that writes as much of the Reader's buffered data as `out`
+ * will accept with a single writev(), and pops what was written. Returns the number of bytes written.
+ */
+uint64_t drain( Reader& reader, FileDescriptor& out );
+
+/*
+ * read_into: A helper function that reads as much as the Writer has room for from `in` with a single readv(),
+ * straight into read buffers that are then pushed without copying. Returns the number of bytes read
+ * (0 if `in` would block or has reached EOF, or if the Writer is full). A read that gets less than it asked
+ * for has caught up with `in`, so it flushes the Writer rather than leave a partial batch waiting.
+ */
+uint64_t read_into( Writer& writer, FileDescriptor& in );
+
+/*
+ * push_mapped: A helper function that pushes as many of `file`'s bytes (from `offset`) as the Writer has room for,
+ * as a Slice that borrows the mapping, so nothing is copied, and asks the kernel to start reading in the next
+ * window of the file. Returns the number of bytes pushed. The MappedFile must outlive the bytes pushed.
+ */
+uint64_t push_mapped( Writer& writer, const MappedFile& file, uint64_t offset );
+
+/*
+ * drain: A helper function that copies as much of the Reader's buffered data as fits into a writable `file`
+ * (from `offset`), straight into the file's pages, and pops what was copied. Returns the number of bytes copied.
+ */
+uint64_t drain( Reader& reader, MappedFile& out, uint64_t offset );
@@ -1,29 +1,187 @@
 #include "byte_stream.hh"
+#include "buffer_pool.hh"
+#include "concurrent_byte_stream.hh"
+#include "file_descriptor.hh"
+#include "mapped_file.hh"
 
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <stdexcept>
+#include <vector>
 
 using namespace std;
 
+namespace {
+/*
+ * Hand the next `len` buffered bytes (which must be no more than bytes_buffered()) to `consume`,
+ * one segment view at a time, popping them from the Reader as each batch of segments is used up.
+ * The Reader helpers below are templates on the Reader, so they serve a ConcurrentByteStream's as well.
+ */
+void consume_buffered( auto& reader, uint64_t len, auto&& consume )
+{
+  array<string_view, 16> views;
+
+  while ( len > 0 ) {
+    const size_t count = reader.peek_buffers( views );
+    if ( count == 0 or views[0].empty() ) {
+      throw runtime_error( "Reader::peek_buffers() returned no data" );
+    }
+
+    uint64_t batch_len = 0;
+    for ( auto view : span { views.data(), count } ) {
+      view = view.substr( 0, len - batch_len ); // Don't consume more bytes than desired.
+      consume( view );
+      batch_len += view.size();
+      if ( batch_len == len ) {
+        break;
+      }
+    }
+
+    reader.pop( batch_len );
+    len -= batch_len;
+  }
+}
+
+void read_buffered( auto& reader, uint64_t max_len, string& out )
+{
+  const uint64_t len = min( max_len, reader.bytes_buffered() );
+
+  out.clear();
+  out.reserve( len );
+  consume_buffered( reader, len, [&]( string_view view ) { out.append( view ); } );
+}
+
+uint64_t read_buffered_into( auto& reader, span<char> out )
+{
+  const uint64_t len = min<uint64_t>( out.size(), reader.bytes_buffered() );
+
+  auto next = out.begin();
+  consume_buffered( reader, len, [&]( string_view view ) { next = ranges::copy( view, next ).out; } );
+  return len;
+}
+
+uint64_t drain_buffered( auto& reader, FileDescriptor& out )
+{
+  array<string_view, 64> views;
+  const size_t count = reader.peek_buffers( views );
+  if ( count == 0 ) {
+    return 0;
+  }
+
+  const uint64_t bytes_written = out.write( span<const string_view> { views.data(), count } );
+  reader.pop( bytes_written );
+  return bytes_written;
+}
+} // namespace
+
 /*
  * read: A helper function thats peeks and pops up to `max_len` bytes
  * from a ByteStream Reader into a string;
  */
 void read( Reader& reader, uint64_t max_len, string& out )
 {
-  out.clear();
+  read_buffered( reader, max_len, out );
+}
 
-  while ( reader.bytes_buffered() and out.size() < max_len ) {
-    auto view = reader.peek();
+void read( ConcurrentByteStream::Reader& reader, uint64_t max_len, string& out )
+{
+  read_buffered( reader, max_len, out );
+}
 
-    if ( view.empty() ) {
-      throw runtime_error( "Reader::peek() returned empty string_view" );
+/*
+ * read_into: A helper function that peeks and pops up to `out.size()` bytes
+ * from a ByteStream Reader into caller-owned memory, returning the number of bytes read.
+ */
+uint64_t read_into( Reader& reader, span<char> out )
+{
+  return read_buffered_into( reader, out );
+}
+
+uint64_t read_into( ConcurrentByteStream::Reader& reader, span<char> out )
+{
+  return read_buffered_into( reader, out );
+}
+
+/*
+ * drain: A helper function that writes as much of the Reader's buffered data as `out`
+ * will accept with a single writev(), and pops what was written.
+ */
+uint64_t drain( Reader& reader, FileDescriptor& out )
+{
+  return drain_buffered( reader, out );
+}
+
+uint64_t drain( ConcurrentByteStream::Reader& reader, FileDescriptor& out )
+{
+  return drain_buffered( reader, out );
+}
+
+/*
+ * read_into: A helper function that reads as much as the Writer has room for (up to a few BufferPool slabs)
+ * from `in` with a single readv(), and pushes the slabs that were read into without copying them (unless the read
+ * was short: see BufferPool::trim()).
+ */
+uint64_t read_into( Writer& writer, FileDescriptor& in )
+{
+  array<string, 4> slabs;
+  array<iovec, slabs.size()> iovecs {};
+  size_t count = 0;
+  uint64_t requested = 0;
+  for ( uint64_t room = writer.available_capacity(); room > 0 and count < slabs.size(); ++count ) {
+    slabs[count] = BufferPool::take( min<uint64_t>( room, BufferPool::slab_size ) );
+    iovecs[count] = { slabs[count].data(), slabs[count].size() };
+    room -= slabs[count].size();
+    requested += slabs[count].size();
+  }
+  if ( count == 0 ) {
+    return 0;
+  }
+
+  const size_t bytes_read = in.read( span { iovecs.data(), count } );
+
+  uint64_t remaining = bytes_read;
+  for ( auto& slab : span { slabs.data(), count } ) {
+    if ( remaining == 0 ) {
+      BufferPool::give_back( move( slab ) );
+      continue;
     }
+    BufferPool::trim( slab, min<uint64_t>( remaining, slab.size() ) );
+    remaining -= slab.size();
+    writer.push( move( slab ) );
+  }
 
-    view = view.substr( 0, max_len - out.size() ); // Don't return more bytes than desired.
-    out += view;
-    reader.pop( view.size() );
+  if ( bytes_read < requested ) {
+    writer.flush(); // `in` had no more to give, so don't hold back what it did
+  }
+  return bytes_read;
+}
+
+/*
+ * push_mapped: A helper function that pushes as many of `file`'s bytes (from `offset`) as the Writer has room for,
+ * as a borrowed Slice, and hints that the same number of bytes after them will be needed next.
+ */
+uint64_t push_mapped( Writer& writer, const MappedFile& file, uint64_t offset )
+{
+  offset = min<uint64_t>( offset, file.size() );
+  const uint64_t len = min<uint64_t>( writer.available_capacity(), file.size() - offset );
+  if ( len == 0 or writer.is_closed() ) {
+    return 0;
   }
+
+  writer.push( file.borrow( offset, len ) );
+  file.will_need( offset + len, len );
+  return len;
+}
+
+/*
+ * drain: A helper function that copies as much of the Reader's buffered data as fits into a writable `file`
+ * (from `offset`), and pops what was copied.
+ */
+uint64_t drain( Reader& reader, MappedFile& out, uint64_t offset )
+{
+  const span<char> data = out.mutable_data();
+  return read_into( reader, data.subspan( min<uint64_t>( offset, data.size() ) ) );
 }
 
 Reader& ByteStream::reader()
@@ -0,0 +1,214 @@
+#include "concurrent_byte_stream.hh"
+
+#include "exception.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+// The counters use sequentially-consistent stores and loads where one side publishes its progress
+// and then checks whether the other side needs waking (see Writer::push and Reader::pop). Either the
+// publishing side sees that the other side has caught up and signals it, or the other side sees the progress.
+
+ConcurrentByteStream::ConcurrentByteStream( uint64_t capacity, bool with_wakeup )
+  : capacity_( capacity )
+  , mask_( bit_ceil( max<uint64_t>( capacity, 1 ) ) - 1 )
+  , ring_( make_unique_for_overwrite<char[]>( mask_ + 1 ) )
+{
+  if ( with_wakeup ) {
+    data_event_.emplace( CheckSystemCall( "eventfd", eventfd( 0, EFD_CLOEXEC ) ) );
+    space_event_.emplace( CheckSystemCall( "eventfd", eventfd( 0, EFD_CLOEXEC ) ) );
+  }
+}
+
+void ConcurrentByteStream::signal( optional<FileDescriptor>& event )
+{
+  if ( not event.has_value() ) {
+    return;
+  }
+
+  const uint64_t one = 1;
+  CheckSystemCall( "write", static_cast<int>( ::write( event->fd_num(), &one, sizeof( one ) ) ) );
+}
+
+void ConcurrentByteStream::wait( optional<FileDescriptor>& event )
+{
+  if ( not event.has_value() ) {
+    throw runtime_error( "ConcurrentByteStream::wait() requires a stream constructed with_wakeup" );
+  }
+
+  pollfd pfd { event->fd_num(), POLLIN, 0 };
+  CheckSystemCall( "poll", ::poll( &pfd, 1, -1 ) );
+
+  uint64_t count {};
+  const ssize_t ret = ::read( event->fd_num(), &count, sizeof( count ) );
+  if ( ret < 0 and errno != EAGAIN ) {
+    throw unix_error( "read" );
+  }
+}
+
+FileDescriptor& ConcurrentByteStream::data_event()
+{
+  return *notnull( "ConcurrentByteStream::data_event", data_event_ ? &*data_event_ : nullptr );
+}
+
+FileDescriptor& ConcurrentByteStream::space_event()
+{
+  return *notnull( "ConcurrentByteStream::space_event", space_event_ ? &*space_event_ : nullptr );
+}
+
+void ConcurrentByteStream::set_error()
+{
+  error_.store( true );
+  signal( data_event_ );
+  signal( space_event_ );
+}
+
+bool ConcurrentByteStream::has_error() const
+{
+  return error_.load( memory_order_acquire );
+}
+
+void ConcurrentByteStream::Writer::push( string_view data )
+{
+  if ( closed_.load( memory_order_relaxed ) or has_error() ) {
+    return;
+  }
+
+  const uint64_t pushed = bytes_pushed_.load( memory_order_relaxed );
+  data = data.substr( 0, capacity_ - ( pushed - bytes_popped_.load( memory_order_acquire ) ) );
+  if ( data.empty() ) {
+    return;
+  }
+
+  const uint64_t start = pushed & mask_;
+  const uint64_t first_len = min<uint64_t>( data.size(), mask_ + 1 - start );
+  memcpy( ring_.get() + start, data.data(), first_len );
+  memcpy( ring_.get(), data.data() + first_len, data.size() - first_len );
+
+  bytes_pushed_.store( pushed + data.size() );
+  if ( bytes_popped_.load() == pushed ) {
+    signal( data_event_ ); // the Reader may have found the stream empty
+  }
+}
+
+void ConcurrentByteStream::Writer::close()
+{
+  closed_.store( true );
+  signal( data_event_ );
+}
+
+bool ConcurrentByteStream::Writer::is_closed() const
+{
+  return closed_.load( memory_order_relaxed );
+}
+
+uint64_t ConcurrentByteStream::Writer::available_capacity() const
+{
+  return capacity_ - ( bytes_pushed_.load( memory_order_relaxed ) - bytes_popped_.load() );
+}
+
+uint64_t ConcurrentByteStream::Writer::bytes_pushed() const
+{
+  return bytes_pushed_.load( memory_order_relaxed );
+}
+
+void ConcurrentByteStream::Writer::wait()
+{
+  while ( available_capacity() == 0 and not has_error() ) {
+    ConcurrentByteStream::wait( space_event_ );
+  }
+}
+
+string_view ConcurrentByteStream::Reader::peek() const
+{
+  const uint64_t popped = bytes_popped_.load( memory_order_relaxed );
+  const uint64_t start = popped & mask_;
+  const uint64_t len = min( bytes_pushed_.load( memory_order_acquire ) - popped, mask_ + 1 - start );
+  return { ring_.get() + start, len };
+}
+
+size_t ConcurrentByteStream::Reader::peek_buffers( span<string_view> out ) const
+{
+  const uint64_t popped = bytes_popped_.load( memory_order_relaxed );
+  const uint64_t buffered = bytes_pushed_.load( memory_order_acquire ) - popped;
+  const uint64_t start = popped & mask_;
+  const uint64_t first_len = min( buffered, mask_ + 1 - start );
+
+  size_t count = 0;
+  if ( first_len > 0 and count < out.size() ) {
+    out[count++] = { ring_.get() + start, first_len };
+  }
+  if ( buffered > first_len and count < out.size() ) {
+    out[count++] = { ring_.get(), buffered - first_len };
+  }
+  return count;
+}
+
+void ConcurrentByteStream::Reader::pop( uint64_t len )
+{
+  const uint64_t popped = bytes_popped_.load( memory_order_relaxed );
+  len = min( len, bytes_pushed_.load( memory_order_acquire ) - popped );
+  if ( len == 0 ) {
+    return;
+  }
+
+  bytes_popped_.store( popped + len );
+  if ( bytes_pushed_.load() - popped == capacity_ ) {
+    signal( space_event_ ); // the Writer may have found the stream full
+  }
+}
+
+bool ConcurrentByteStream::Reader::is_finished() const
+{
+  return closed_.load( memory_order_acquire ) and bytes_buffered() == 0;
+}
+
+uint64_t ConcurrentByteStream::Reader::bytes_buffered() const
+{
+  return bytes_pushed_.load() - bytes_popped_.load( memory_order_relaxed );
+}
+
+uint64_t ConcurrentByteStream::Reader::bytes_popped() const
+{
+  return bytes_popped_.load( memory_order_relaxed );
+}
+
+void ConcurrentByteStream::Reader::wait()
+{
+  while ( bytes_buffered() == 0 and not closed_.load( memory_order_acquire ) and not has_error() ) {
+    ConcurrentByteStream::wait( data_event_ );
+  }
+}
+
+ConcurrentByteStream::Reader& ConcurrentByteStream::reader()
+{
+  static_assert( sizeof( Reader ) == sizeof( ConcurrentByteStream ),
+                 "Please add member variables to the ConcurrentByteStream base, not the Reader." );
+
+  return static_cast<Reader&>( *this ); // NOLINT(*-downcast)
+}
+
+const ConcurrentByteStream::Reader& ConcurrentByteStream::reader() const
+{
+  return static_cast<const Reader&>( *this ); // NOLINT(*-downcast)
+}
+
+ConcurrentByteStream::Writer& ConcurrentByteStream::writer()
+{
+  static_assert( sizeof( Writer ) == sizeof( ConcurrentByteStream ),
+                 "Please add member variables to the ConcurrentByteStream base, not the Writer." );
+
+  return static_cast<Writer&>( *this ); // NOLINT(*-downcast)
+}
+
+const ConcurrentByteStream::Writer& ConcurrentByteStream::writer() const
+{
+  return static_cast<const Writer&>( *this ); // NOLINT(*-downcast)
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+// A ByteStream that may be written by one thread and read by another (single producer, single consumer).
+// The Writer and Reader interfaces have the same methods as ByteStream's, and none of them lock or block.
+// Bytes are copied into a fixed ring on push; bytes_pushed() and bytes_popped() are the ring's head and tail.
+// The Reader helpers (read, read_into and drain) take its Reader too: see the end of this file.
+class ConcurrentByteStream
+{
+public:
+  class Reader;
+  class Writer;
+
+  // If `with_wakeup` is true, the stream also keeps two eventfds: data_event() becomes readable when data
+  // (or the end of the stream) arrives in an empty stream, and space_event() when space frees up in a full one.
+  // These can be registered with an EventLoop, or waited on with Reader::wait() and Writer::wait().
+  explicit ConcurrentByteStream( uint64_t capacity, bool with_wakeup = false );
+
+  Reader& reader();
+  const Reader& reader() const;
+  Writer& writer();
+  const Writer& writer() const;
+
+  void set_error();       // Signal that the stream suffered an error.
+  bool has_error() const; // Has the stream had an error?
+
+  // The wakeup eventfds (only if constructed `with_wakeup`). A rule that polls one of these
+  // should read() from it to reset it, before checking the stream.
+  FileDescriptor& data_event();
+  FileDescriptor& space_event();
+
+  ConcurrentByteStream( const ConcurrentByteStream& other ) = delete;
+  ConcurrentByteStream& operator=( const ConcurrentByteStream& other ) = delete;
+  ~ConcurrentByteStream() = default;
+
+protected:
+  static constexpr size_t cache_line_size = 64;
+
+  uint64_t capacity_;
+  uint64_t mask_; // the ring's size (a power of two, at least `capacity_`) minus one
+  std::unique_ptr<char[]> ring_;
+  std::optional<FileDescriptor> data_event_ {};
+  std::optional<FileDescriptor> space_event_ {};
+
+  // Each counter is written by only one side, and lives on its own cache line.
+  alignas( cache_line_size ) std::atomic<uint64_t> bytes_pushed_ {}; // written by the Writer
+  alignas( cache_line_size ) std::atomic<uint64_t> bytes_popped_ {}; // written by the Reader
+  alignas( cache_line_size ) std::atomic<bool> closed_ {};
+  std::atomic<bool> error_ {};
+
+  static void signal( std::optional<FileDescriptor>& event );
+  static void wait( std::optional<FileDescriptor>& event );
+};
+
+class ConcurrentByteStream::Writer : public ConcurrentByteStream
+{
+public:
+  void push( std::string_view data ); // Push data to stream, but only as much as available capacity allows.
+  void close();                       // Signal that the stream has reached its ending.
+
+  bool is_closed() const;              // Has the stream been closed?
+  uint64_t available_capacity() const; // How many bytes can be pushed to the stream right now?
+  uint64_t bytes_pushed() const;       // Total number of bytes cumulatively pushed to the stream
+
+  void wait(); // Block until there is available capacity, or the stream has an error (needs `with_wakeup`)
+};
+
+class ConcurrentByteStream::Reader : public ConcurrentByteStream
+{
+public:
+  std::string_view peek() const; // Peek at the next contiguous bytes in the buffer
+  void pop( uint64_t len );      // Remove `len` bytes from the buffer
+
+  // Peek at the buffered bytes as up to two views (the ring's tail, then its start), as Reader::peek_buffers()
+  size_t peek_buffers( std::span<std::string_view> out ) const;
+
+  bool is_finished() const;        // Is the stream finished (closed and fully popped)?
+  uint64_t bytes_buffered() const; // Number of bytes currently buffered (pushed and not popped)
+  uint64_t bytes_popped() const;   // Total number of bytes cumulatively popped from stream
+
+  void wait(); // Block until bytes are buffered, or the stream is closed or has an error (needs `with_wakeup`)
+};
+
+// The ByteStream Reader helpers (see byte_stream.hh), for a ConcurrentByteStream's Reader
+void read( ConcurrentByteStream::Reader& reader, uint64_t max_len, std::string& out );
+uint64_t read_into( ConcurrentByteStream::Reader& reader, std::span<char> out );
+uint64_t drain( ConcurrentByteStream::Reader& reader, FileDescriptor& out );
@@ -0,0 +1,217 @@
+#include "forwarding_pipeline.hh"
+
+#include "exception.hh"
+#include "helpers.hh"
+#include "trace.hh"
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+// A datagram handed to another loop is framed in the ring as a record: its length, the outbound interface,
+// and the next hop's IP address (each a big-endian uint32_t), then the datagram itself.
+constexpr uint64_t record_header_length = 3 * sizeof( uint32_t );
+
+const uint16_t trace_drops = Trace::category( "ForwardingPipeline handoff dropped (from loop, to loop, bytes)" );
+} // namespace
+
+ForwardingPipeline::ForwardingPipeline( EventLoopGroup& loops, uint64_t ring_capacity )
+  : loops_( loops ), lanes_( loops.size() ), rings_( loops.size() * loops.size() )
+{
+  if ( ring_capacity <= record_header_length ) {
+    throw runtime_error( "ForwardingPipeline: ring capacity is too small" );
+  }
+
+  const size_t count = lanes_.size();
+  for ( size_t to = 0; to < count; ++to ) {
+    EventLoop& loop = loops_.loop( to );
+    const size_t handoffs = loop.add_category( "forwarding handoff" );
+    for ( size_t from = 0; from < count; ++from ) {
+      if ( from == to ) {
+        continue;
+      }
+      rings_[from * count + to] = make_unique<ConcurrentByteStream>( ring_capacity, true );
+      loop.add_rule( handoffs, ring( from, to ).data_event(), Direction::In, [this, from, to] {
+        receive_handoffs( from, to );
+      } );
+    }
+    loop.add_timer( "forwarding tick", tick_interval, [this, to] { tick( to ); }, true );
+
+    lanes_[to].outbound.resize( count );
+    lanes_[to].room.resize( count );
+    lanes_[to].inbound.resize( count );
+  }
+}
+
+size_t ForwardingPipeline::add_interface( shared_ptr<NetworkInterface> interface, size_t loop_index )
+{
+  if ( loop_index >= lanes_.size() ) {
+    throw runtime_error( "ForwardingPipeline: no loop " + to_string( loop_index ) );
+  }
+
+  interfaces_.push_back( notnull( "ForwardingPipeline::add_interface", move( interface ) ) );
+  owners_.push_back( loop_index );
+  lanes_[loop_index].interfaces.push_back( interfaces_.size() - 1 );
+  return interfaces_.size() - 1;
+}
+
+void ForwardingPipeline::add_routes( span<const Route> routes )
+{
+  for ( const Route& route : routes ) {
+    if ( route.interface_num >= interfaces_.size() ) {
+      throw runtime_error( "ForwardingPipeline: route to nonexistent interface "
+                           + to_string( route.interface_num ) );
+    }
+  }
+
+  // Copy the published routes and change the copy, while the loops go on using the original
+  const lock_guard update_lock( update_mutex_ );
+  shared_ptr<const ForwardingTable> current;
+  {
+    const lock_guard lock( published_mutex_ );
+    current = published_;
+  }
+  auto next = make_shared<ForwardingTable>( *current );
+  next->add_routes( routes );
+
+  const lock_guard lock( published_mutex_ );
+  published_ = move( next );
+  version_.fetch_add( 1, memory_order_release );
+}
+
+const ForwardingTable& ForwardingPipeline::current_routes( Lane& lane )
+{
+  if ( version_.load( memory_order_acquire ) != lane.routes_version ) {
+    const lock_guard lock( published_mutex_ );
+    lane.routes = published_; // (the lane's old snapshot is freed here if no one else still has it)
+    lane.routes_version = version_.load( memory_order_relaxed );
+  }
+  return *lane.routes;
+}
+
+void ForwardingPipeline::route( size_t interface_num )
+{
+  const size_t here = owners_.at( interface_num );
+  Lane& lane = lanes_[here];
+  const ForwardingTable& routes = current_routes( lane );
+
+  auto& received = interfaces_[interface_num]->datagrams_received();
+  lane.batch.clear();
+  while ( not received.empty() ) {
+    lane.batch.push_back( move( received.front() ) );
+    received.pop();
+  }
+
+  lane.destinations.resize( lane.batch.size() );
+  lane.targets.resize( lane.batch.size() );
+  for ( size_t i = 0; i < lane.batch.size(); ++i ) {
+    lane.destinations[i] = lane.batch[i].header.dst;
+  }
+  routes.lookup( lane.destinations, lane.targets );
+
+  // Room found in each ring now can only grow until this thread (the ring's only writer) pushes to it
+  for ( size_t to = 0; to < lanes_.size(); ++to ) {
+    lane.outbound[to].clear();
+    lane.room[to] = to == here ? 0 : ring( here, to ).writer().available_capacity();
+  }
+
+  for ( size_t i = 0; i < lane.batch.size(); ++i ) {
+    InternetDatagram& dgram = lane.batch[i];
+    if ( lane.targets[i] == RoutingTable::NO_ROUTE or dgram.header.ttl <= 1 ) {
+      continue; // no route, or the TTL has run out: drop the datagram
+    }
+
+    dgram.header.decrement_ttl();
+
+    const ForwardingTable::Target& target = routes.target( lane.targets[i] );
+    const Address next_hop = target.next_hop.value_or( Address::from_ipv4_numeric( dgram.header.dst ) );
+    const size_t to = owners_[target.interface_num];
+    if ( to == here ) {
+      interfaces_[target.interface_num]->send_datagram( dgram, next_hop );
+      continue;
+    }
+
+    const uint64_t length = serialized_length( dgram );
+    if ( record_header_length + length > lane.room[to] ) {
+      Trace::record<TraceLevel::Warning>( trace_drops, here, to, length );
+      lane.dropped++; // the other loop is behind, and its ring is full
+      continue;
+    }
+
+    string& out = lane.outbound[to];
+    const size_t start = out.size();
+    out.resize( start + record_header_length + length );
+    Serializer serializer { span { out }.subspan( start ) };
+    serializer.integer( static_cast<uint32_t>( length ) );
+    serializer.integer( static_cast<uint32_t>( target.interface_num ) );
+    serializer.integer( next_hop.ipv4_numeric() );
+    dgram.serialize( serializer );
+    lane.room[to] -= record_header_length + length;
+  }
+
+  // One push (and at most one wakeup) per ring per batch
+  for ( size_t to = 0; to < lanes_.size(); ++to ) {
+    if ( not lane.outbound[to].empty() ) {
+      ring( here, to ).writer().push( lane.outbound[to] );
+    }
+  }
+}
+
+void ForwardingPipeline::receive_handoffs( size_t from, size_t to )
+{
+  ConcurrentByteStream& handoffs = ring( from, to );
+
+  handoffs.data_event().read_eventfd(); // reset the wakeup (through the FileDescriptor, so the loop sees it)
+
+  // Copy out everything buffered (the ring may wrap mid-record), and send each complete record's datagram
+  string& inbound = lanes_[to].inbound[from];
+  const size_t start = inbound.size();
+  inbound.resize( start + handoffs.reader().bytes_buffered() );
+  read_into( handoffs.reader(), span { inbound }.subspan( start ) );
+
+  size_t offset = 0;
+  while ( inbound.size() - offset >= record_header_length ) {
+    uint32_t length {};
+    uint32_t interface_num {};
+    uint32_t next_hop {};
+    Parser header { Slice { inbound.substr( offset, record_header_length ) } };
+    header.integers( length, interface_num, next_hop );
+    if ( inbound.size() - offset - record_header_length < length ) {
+      break; // the rest of this record hasn't arrived yet
+    }
+
+    InternetDatagram dgram;
+    if ( not parse( dgram, Slice { inbound.substr( offset + record_header_length, length ) } ) ) {
+      throw runtime_error( "ForwardingPipeline: corrupt handoff record" );
+    }
+    interfaces_.at( interface_num )->send_datagram( dgram, Address::from_ipv4_numeric( next_hop ) );
+    offset += record_header_length + length;
+  }
+  inbound.erase( 0, offset );
+}
+
+void ForwardingPipeline::tick( size_t loop_index )
+{
+  Lane& lane = lanes_[loop_index];
+  const auto now = chrono::steady_clock::now();
+  if ( lane.last_tick == chrono::steady_clock::time_point {} ) {
+    lane.last_tick = now;
+    return;
+  }
+
+  const auto elapsed = chrono::duration_cast<chrono::milliseconds>( now - lane.last_tick );
+  lane.last_tick += elapsed; // (keeping the remainder for next time)
+  for ( const size_t interface_num : lane.interfaces ) {
+    interfaces_[interface_num]->tick( elapsed.count() );
+  }
+}
+
+uint64_t ForwardingPipeline::datagrams_dropped() const
+{
+  uint64_t dropped = 0;
+  for ( const Lane& lane : lanes_ ) {
+    dropped += lane.dropped;
+  }
+  return dropped;
+}
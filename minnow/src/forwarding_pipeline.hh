@@ -0,0 +1,99 @@
+#pragma once
+
+#include "concurrent_byte_stream.hh"
+#include "eventloop_group.hh"
+#include "ipv4_datagram.hh"
+#include "network_interface.hh"
+#include "router.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+/*
+ * A router's forwarding plane spread over the loops of an EventLoopGroup, one thread each.
+ *
+ * Each NetworkInterface belongs to one loop, and only that loop's thread ever touches it (receiving frames,
+ * sending datagrams, and ticking its ARP timers). A datagram routed to an interface of another loop is handed
+ * over through a ConcurrentByteStream from the routing loop to the owning loop (one single-producer,
+ * single-consumer ring for each ordered pair of loops), which wakes the owner with the ring's data_event().
+ *
+ * The routes are read-copy-update: the forwarding loops read an immutable snapshot (a ForwardingTable),
+ * and a route change builds a modified copy and publishes it, without holding up any loop. Each loop picks
+ * up the new snapshot at the start of its next batch. The old one is freed when the last loop lets go of it.
+ */
+class ForwardingPipeline
+{
+public:
+  using Route = ForwardingTable::Route;
+
+  static constexpr uint64_t default_ring_capacity = 1 << 20;
+  static constexpr std::chrono::milliseconds tick_interval { 10 };
+
+  // The loops must outlive the pipeline. Interfaces must be added before the group runs.
+  explicit ForwardingPipeline( EventLoopGroup& loops, uint64_t ring_capacity = default_ring_capacity );
+
+  // Give an interface to a loop (and only its thread will touch the interface from now on).
+  // Returns the interface's number, for routes.
+  size_t add_interface( std::shared_ptr<NetworkInterface> interface, size_t loop_index );
+
+  // Change the routes (from any thread, at any time): the loops switch to the new routes at their next batch.
+  void add_route( const Route& route ) { add_routes( std::span { &route, 1 } ); }
+  void add_routes( std::span<const Route> routes );
+
+  // Route the datagrams that an interface has received. This must be called on the interface's own loop
+  // (e.g. from the rule that passes it the frames it received).
+  void route( size_t interface_num );
+
+  // Datagrams dropped because the ring to the loop of their outbound interface was full
+  // (read after the group has stopped)
+  uint64_t datagrams_dropped() const;
+
+  ForwardingPipeline( const ForwardingPipeline& other ) = delete;
+  ForwardingPipeline& operator=( const ForwardingPipeline& other ) = delete;
+  ~ForwardingPipeline() = default;
+
+private:
+  // What one loop keeps for itself (only its own thread touches this)
+  struct Lane
+  {
+    std::vector<size_t> interfaces {};
+    std::shared_ptr<const ForwardingTable> routes {};
+    uint64_t routes_version {};
+    std::chrono::steady_clock::time_point last_tick {};
+    uint64_t dropped {};
+
+    // Scratch space for route(), kept to save allocations
+    std::vector<InternetDatagram> batch {};
+    std::vector<uint32_t> destinations {};
+    std::vector<uint32_t> targets {};
+    std::vector<std::string> outbound {}; // the handoff records for each other loop, this batch
+    std::vector<uint64_t> room {};        // the space left in the ring to each other loop, this batch
+    std::vector<std::string> inbound {};  // records copied out of the ring from each other loop
+  };
+
+  EventLoopGroup& loops_;
+  std::vector<std::shared_ptr<NetworkInterface>> interfaces_ {};
+  std::vector<size_t> owners_ {}; // the loop of each interface
+  std::vector<Lane> lanes_ {};
+  std::vector<std::unique_ptr<ConcurrentByteStream>> rings_ {}; // from * loops + to
+
+  // The published routes: `version_` changes whenever `published_` does, so that the loops check the version
+  // (one atomic load per batch) and take `published_mutex_` only to pick up a new snapshot.
+  std::mutex update_mutex_ {}; // serializes route changes with each other
+  std::mutex published_mutex_ {};
+  std::shared_ptr<const ForwardingTable> published_ { std::make_shared<const ForwardingTable>() };
+  std::atomic<uint64_t> version_ { 1 };
+
+  ConcurrentByteStream& ring( size_t from, size_t to ) { return *rings_[from * lanes_.size() + to]; }
+  const ForwardingTable& current_routes( Lane& lane );
+  void receive_handoffs( size_t from, size_t to );
+  void tick( size_t loop_index );
+};
@@ -0,0 +1,184 @@
+#include "network_interface.hh"
+#include "arp_message.hh"
+#include "exception.hh"
+#include "helpers.hh"
+
+#include <bit>
+#include <iostream>
+#include <utility>
+
+using namespace std;
+
+NetworkInterface::NetworkInterface( string_view name,
+                                    shared_ptr<OutputPort> port,
+                                    const EthernetAddress& ethernet_address,
+                                    const Address& ip_address )
+  : name_( name )
+  , port_( notnull( "OutputPort", move( port ) ) )
+  , ethernet_address_( ethernet_address )
+  , ip_address_( ip_address )
+{
+  cerr << "DEBUG: Network interface has Ethernet address " << to_string( ethernet_address_ ) << " and IP address "
+       << ip_address.ip() << "\n";
+}
+
+void NetworkInterface::send_datagram( const InternetDatagram& dgram, const Address& next_hop )
+{
+  const uint32_t next_hop_ip = next_hop.ipv4_numeric();
+  if ( ARPEntry* entry = arp_cache_.find( next_hop_ip ); entry and entry->ethernet_address.has_value() ) {
+    transmit( make_frame( *entry->ethernet_address, EthernetHeader::TYPE_IPv4, serialize( dgram ) ) );
+    return;
+  }
+
+  ARPEntry& entry = arp_cache_.find_or_insert( next_hop_ip );
+  if ( entry.pending.size() >= MAX_PENDING_DATAGRAMS ) {
+    entry.pending.erase( entry.pending.begin() ); // drop the oldest, which the sender has most likely given up on
+  }
+  entry.pending.push_back( dgram );
+
+  if ( entry.expiry == 0 ) { // a new entry: ask for the address (at most once per ARP_REQUEST_TTL_MS)
+    entry.expiry = expiries_.now() + ARP_REQUEST_TTL_MS;
+    expiries_.schedule( next_hop_ip, entry.expiry );
+    send_arp( ARPMessage::OPCODE_REQUEST, ETHERNET_BROADCAST, next_hop_ip );
+  }
+}
+
+void NetworkInterface::recv_frame( const EthernetFrame& frame )
+{
+  if ( frame.header.dst != ethernet_address_ and frame.header.dst != ETHERNET_BROADCAST ) {
+    return;
+  }
+
+  switch ( frame.header.type ) {
+    case EthernetHeader::TYPE_IPv4: {
+      InternetDatagram dgram;
+      if ( parse( dgram, frame.payload ) ) {
+        datagrams_received_.push( move( dgram ) );
+      }
+      break;
+    }
+
+    case EthernetHeader::TYPE_ARP: {
+      ARPMessage arp;
+      if ( not parse( arp, frame.payload ) ) {
+        break;
+      }
+      learn( arp.sender_ip_address, arp.sender_ethernet_address );
+      if ( arp.opcode == ARPMessage::OPCODE_REQUEST and arp.target_ip_address == ip_address_.ipv4_numeric() ) {
+        send_arp( ARPMessage::OPCODE_REPLY, arp.sender_ethernet_address, arp.sender_ip_address );
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+void NetworkInterface::tick( const size_t ms_since_last_tick )
+{
+  expiries_.advance( expiries_.now() + ms_since_last_tick, [this]( uint32_t ip_address, uint64_t deadline ) {
+    // A mapping that was learned again (or resolved) since this timer was set has a later expiry.
+    if ( const ARPEntry* entry = arp_cache_.find( ip_address ); entry and entry->expiry == deadline ) {
+      arp_cache_.erase( ip_address ); // (and with it, any datagrams still waiting for a reply)
+    }
+  } );
+}
+
+void NetworkInterface::send_arp( uint16_t opcode, const EthernetAddress& destination, uint32_t target_ip_address )
+{
+  ARPMessage arp;
+  arp.opcode = opcode;
+  arp.sender_ethernet_address = ethernet_address_;
+  arp.sender_ip_address = ip_address_.ipv4_numeric();
+  if ( opcode == ARPMessage::OPCODE_REPLY ) {
+    arp.target_ethernet_address = destination;
+  }
+  arp.target_ip_address = target_ip_address;
+  transmit( make_frame( destination, EthernetHeader::TYPE_ARP, serialize( arp ) ) );
+}
+
+void NetworkInterface::learn( uint32_t ip_address, const EthernetAddress& ethernet_address )
+{
+  ARPEntry& entry = arp_cache_.find_or_insert( ip_address );
+  entry.ethernet_address = ethernet_address;
+  entry.expiry = expiries_.now() + ARP_ENTRY_TTL_MS;
+  expiries_.schedule( ip_address, entry.expiry );
+
+  // Send whatever was waiting for this address (taken out first, since transmitting may re-enter the cache)
+  const vector<InternetDatagram> pending = exchange( entry.pending, {} );
+  for ( const InternetDatagram& dgram : pending ) {
+    transmit( make_frame( ethernet_address, EthernetHeader::TYPE_IPv4, serialize( dgram ) ) );
+  }
+}
+
+EthernetFrame NetworkInterface::make_frame( const EthernetAddress& dst, uint16_t type, vector<Slice> payload ) const
+{
+  return { .header = { .dst = dst, .src = ethernet_address_, .type = type }, .payload = move( payload ) };
+}
+
+size_t NetworkInterface::ARPCache::home( uint32_t ip_address ) const
+{
+  // Fibonacci hashing: the top bits of the product mix all the bits of the address (e.g. of hosts in a subnet)
+  constexpr uint64_t golden_ratio = 0x9E3779B97F4A7C15ULL;
+  return ( ip_address * golden_ratio ) >> ( 64 - countr_zero( slots_.size() ) );
+}
+
+size_t NetworkInterface::ARPCache::probe( uint32_t ip_address ) const
+{
+  size_t index = home( ip_address );
+  while ( slots_[index].occupied and slots_[index].ip_address != ip_address ) {
+    index = ( index + 1 ) & mask();
+  }
+  return index;
+}
+
+NetworkInterface::ARPEntry* NetworkInterface::ARPCache::find( uint32_t ip_address )
+{
+  ARPEntry& slot = slots_[probe( ip_address )];
+  return slot.occupied ? &slot : nullptr;
+}
+
+NetworkInterface::ARPEntry& NetworkInterface::ARPCache::find_or_insert( uint32_t ip_address )
+{
+  if ( ARPEntry* entry = find( ip_address ) ) {
+    return *entry;
+  }
+
+  if ( 4 * ( size_ + 1 ) > 3 * slots_.size() ) { // keep the load factor at most 3/4
+    grow();
+  }
+  ARPEntry& slot = slots_[probe( ip_address )];
+  slot.occupied = true;
+  slot.ip_address = ip_address;
+  ++size_;
+  return slot;
+}
+
+void NetworkInterface::ARPCache::erase( uint32_t ip_address )
+{
+  size_t hole = probe( ip_address );
+  if ( not slots_[hole].occupied ) {
+    return;
+  }
+
+  // Shift back each later entry in the run that may fill the hole (one whose home is at or before it).
+  for ( size_t next = ( hole + 1 ) & mask(); slots_[next].occupied; next = ( next + 1 ) & mask() ) {
+    if ( ( ( next - home( slots_[next].ip_address ) ) & mask() ) >= ( ( next - hole ) & mask() ) ) {
+      slots_[hole] = move( slots_[next] );
+      hole = next;
+    }
+  }
+  slots_[hole] = {};
+  --size_;
+}
+
+void NetworkInterface::ARPCache::grow()
+{
+  vector<ARPEntry> old = exchange( slots_, vector<ARPEntry>( 2 * slots_.size() ) );
+  for ( ARPEntry& entry : old ) {
+    if ( entry.occupied ) {
+      slots_[probe( entry.ip_address )] = move( entry );
+    }
+  }
+}
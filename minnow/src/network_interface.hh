@@ -0,0 +1,140 @@
+#pragma once
+
+#include "address.hh"
+#include "ethernet_frame.hh"
+#include "ipv4_datagram.hh"
+#include "timer_wheel.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A "network interface" that connects IP (the internet layer, or network layer)
+// with Ethernet (the network access layer, or link layer).
+
+// This module is the lowest layer of a TCP/IP stack
+// (connecting IP with the lower-layer network protocol,
+// e.g. Ethernet). But the same module is also used repeatedly
+// as part of a router: a router generally has many network
+// interfaces, and the router's job is to route Internet datagrams
+// between the different interfaces.
+
+// The network interface translates datagrams (coming from the
+// "customer," e.g. a TCP/IP stack or router) into Ethernet
+// frames. To fill in the Ethernet destination address, it looks up
+// the Ethernet address of the next IP hop of each datagram, making
+// requests with the [Address Resolution Protocol](\ref rfc::rfc826).
+// In the opposite direction, the network interface accepts Ethernet
+// frames, checks if they are intended for it, and if so, processes
+// the payload depending on its type. If it's an IPv4 datagram,
+// the network interface passes it up the stack. If it's an ARP
+// request or reply, the network interface processes the frame
+// and learns or replies as necessary.
+class NetworkInterface
+{
+public:
+  // An abstraction for the physical output port where the NetworkInterface sends Ethernet frames
+  class OutputPort
+  {
+  public:
+    virtual void transmit( const NetworkInterface& sender, const EthernetFrame& frame ) = 0;
+    virtual ~OutputPort() = default;
+  };
+
+  static constexpr uint64_t ARP_ENTRY_TTL_MS = 30'000;  // How long a learned mapping is remembered
+  static constexpr uint64_t ARP_REQUEST_TTL_MS = 5'000; // How long to wait for a reply before asking again
+  static constexpr size_t MAX_PENDING_DATAGRAMS = 64;   // Per next hop, while its address is being resolved
+
+  // Construct a network interface with given Ethernet (network-access-layer) and IP (internet-layer)
+  // addresses
+  NetworkInterface( std::string_view name,
+                    std::shared_ptr<OutputPort> port,
+                    const EthernetAddress& ethernet_address,
+                    const Address& ip_address );
+
+  // Sends an Internet datagram, encapsulated in an Ethernet frame (if it knows the Ethernet destination
+  // address). Will need to use [ARP](\ref rfc::rfc826) to look up the Ethernet destination address for the next
+  // hop. Sending is accomplished by calling `transmit()` (a member variable) on the frame.
+  void send_datagram( const InternetDatagram& dgram, const Address& next_hop );
+
+  // Receives an Ethernet frame and responds appropriately.
+  // If type is IPv4, pushes the datagram to the datagrams_in queue.
+  // If type is ARP request, learn a mapping from the "sender" fields, and send an ARP reply.
+  // If type is ARP reply, learn a mapping from the "sender" fields.
+  void recv_frame( const EthernetFrame& frame );
+
+  // Called periodically when time elapses
+  void tick( size_t ms_since_last_tick );
+
+  // Accessors
+  const std::string& name() const { return name_; }
+  const OutputPort& output() const { return *port_; }
+  OutputPort& output() { return *port_; }
+  std::queue<InternetDatagram>& datagrams_received() { return datagrams_received_; }
+
+  // Number of next hops the ARP cache holds (resolved, or waiting for a reply)
+  size_t arp_cache_size() const { return arp_cache_.size(); }
+
+private:
+  // What the interface knows about one next hop's IPv4 address
+  struct ARPEntry
+  {
+    bool occupied {};
+    uint32_t ip_address {};
+    uint64_t expiry {}; // when the mapping (or, while unresolved, the outstanding ARP request) lapses
+    std::optional<EthernetAddress> ethernet_address {}; // unset while an ARP request is outstanding
+    std::vector<InternetDatagram> pending {};           // datagrams waiting for the reply (oldest first)
+  };
+
+  // An open-addressing hash table of ARPEntries keyed by IPv4 address (linear probing, with
+  // backward-shift deletion so that lookups never wade through tombstones)
+  class ARPCache
+  {
+  public:
+    ARPEntry* find( uint32_t ip_address );
+    ARPEntry& find_or_insert( uint32_t ip_address ); // (may move other entries)
+    void erase( uint32_t ip_address );                // (may move other entries)
+    size_t size() const { return size_; }
+
+  private:
+    static constexpr size_t initial_capacity = 16;
+
+    std::vector<ARPEntry> slots_ = std::vector<ARPEntry>( initial_capacity );
+    size_t size_ {};
+
+    size_t mask() const { return slots_.size() - 1; }
+    size_t home( uint32_t ip_address ) const;
+    size_t probe( uint32_t ip_address ) const; // the entry's slot, or the empty slot that ends its probe
+    void grow();
+  };
+
+  void transmit( const EthernetFrame& frame ) const { port_->transmit( *this, frame ); }
+  void send_arp( uint16_t opcode, const EthernetAddress& destination, uint32_t target_ip_address );
+  void learn( uint32_t ip_address, const EthernetAddress& ethernet_address );
+  EthernetFrame make_frame( const EthernetAddress& dst, uint16_t type, std::vector<Slice> payload ) const;
+
+  // Human-readable name of the interface
+  std::string name_;
+
+  // The physical output port (+ a helper function `transmit` that uses it to send an Ethernet frame)
+  std::shared_ptr<OutputPort> port_;
+
+  // Ethernet (known as hardware, network-access-layer, or link-layer) address of the interface
+  EthernetAddress ethernet_address_;
+
+  // IP (known as internet-layer or network-layer) address of the interface
+  Address ip_address_;
+
+  // Datagrams that have been received
+  std::queue<InternetDatagram> datagrams_received_ {};
+
+  ARPCache arp_cache_ {};
+
+  // Each entry's expiry is filed here; a timer whose deadline no longer matches its entry's is stale
+  TimerWheel<uint32_t> expiries_ {};
+};
@@ -0,0 +1,115 @@
+#include "reassembler.hh"
+
+#include <algorithm>
+#include <string_view>
+#include <utility>
+
+using namespace std;
+
+void Reassembler::insert( uint64_t first_index, string data, bool is_last_substring )
+{
+  if ( is_last_substring ) {
+    end_index_ = first_index + data.size();
+  }
+
+  // Keep only the bytes that are new and within the available capacity.
+  const uint64_t first_unassembled = writer().bytes_pushed();
+  const uint64_t first_unacceptable = first_unassembled + writer().available_capacity();
+  const uint64_t begin = max( first_index, first_unassembled );
+  const uint64_t end = min( first_index + data.size(), first_unacceptable );
+
+  if ( begin < end ) {
+    if ( end < first_index + data.size() ) {
+      data.resize( end - first_index );
+    }
+    if ( begin > first_index ) {
+      data.erase( 0, begin - first_index );
+    }
+
+    if ( begin == first_unassembled ) {
+      output_.writer().push( move( data ) );
+      write_ready();
+    } else {
+      store( begin, move( data ) );
+    }
+  }
+
+  if ( end_index_.has_value() and writer().bytes_pushed() == *end_index_ ) {
+    output_.writer().close();
+  }
+}
+
+// Merge a substring (which starts after the next byte needed) into the sorted runs of stored bytes.
+void Reassembler::store( uint64_t first_index, string data )
+{
+  const uint64_t end_index = first_index + data.size();
+
+  // the runs that overlap or touch [first_index, end_index) are [first, last)
+  const auto first = ranges::partition_point( pending_, [&]( const Pending& p ) {
+    return p.end_index() < first_index;
+  } );
+  const auto last = ranges::partition_point( first, pending_.end(), [&]( const Pending& p ) {
+    return p.first_index <= end_index;
+  } );
+
+  if ( first == last ) {
+    bytes_pending_ += data.size();
+    pending_.insert( first, { first_index, move( data ) } );
+    return;
+  }
+
+  if ( last - first == 1 and first->first_index <= first_index and first->end_index() >= end_index ) {
+    return; // a duplicate of bytes already stored
+  }
+
+  // Merge into the first run when the new bytes start inside it (or just after it, the usual case of a gap's later
+  // segments arriving in order): its string grows in place, so an insert copies only the bytes it adds.
+  // Otherwise the new bytes become the run. Either way, the later runs' bytes past its end are appended.
+  for ( auto it = first; it != last; ++it ) {
+    bytes_pending_ -= it->data.size();
+  }
+
+  Pending& merged = *first;
+  const auto extend = [&merged]( uint64_t index, string_view bytes ) {
+    const uint64_t merged_end = merged.end_index();
+    if ( index + bytes.size() > merged_end ) {
+      merged.data.append( bytes.substr( merged_end - index ) );
+    }
+  };
+
+  if ( first_index < merged.first_index ) {
+    Pending old = exchange( merged, { first_index, move( data ) } );
+    extend( old.first_index, old.data );
+  } else {
+    extend( first_index, data );
+  }
+  for ( auto it = first + 1; it != last; ++it ) {
+    extend( it->first_index, it->data );
+  }
+
+  bytes_pending_ += merged.data.size();
+  pending_.erase( first + 1, last );
+}
+
+// Write the stored runs that the stream has caught up with.
+void Reassembler::write_ready()
+{
+  auto it = pending_.begin();
+  for ( ; it != pending_.end() and it->first_index <= writer().bytes_pushed(); ++it ) {
+    bytes_pending_ -= it->data.size();
+    if ( it->end_index() > writer().bytes_pushed() ) {
+      it->data.erase( 0, writer().bytes_pushed() - it->first_index );
+      output_.writer().push( move( it->data ) );
+    }
+  }
+  pending_.erase( pending_.begin(), it );
+}
+
+size_t Reassembler::pending_ranges( span<pair<uint64_t, uint64_t>> out ) const
+{
+  const size_t count = min( out.size(), pending_.size() );
+  for ( size_t i = 0; i < count; ++i ) {
+    out[i] = { pending_[i].first_index, pending_[i].end_index() };
+  }
+  return count;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "byte_stream.hh"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Reassembler
+{
+public:
+  // Construct Reassembler to write into given ByteStream.
+  explicit Reassembler( ByteStream&& output ) : output_( std::move( output ) ) {}
+
+  /*
+   * Insert a new substring to be reassembled into a ByteStream.
+   *   `first_index`: the index of the first byte of the substring
+   *   `data`: the substring itself
+   *   `is_last_substring`: this substring represents the end of the stream
+   *
+   * The Reassembler's job is to reassemble the indexed substrings (possibly out-of-order
+   * and possibly overlapping) back into the original ByteStream. As soon as the Reassembler
+   * learns the next byte in the stream, it writes it to the output.
+   *
+   * If the Reassembler learns about bytes that fit within the stream's available capacity
+   * but can't yet be written (because earlier bytes remain unknown), it stores them
+   * internally until the gaps are filled in.
+   *
+   * The Reassembler discards any bytes that lie beyond the stream's available capacity
+   * (i.e., bytes that couldn't be written even if earlier gaps get filled in).
+   *
+   * The Reassembler closes the stream after writing the last byte.
+   */
+  void insert( uint64_t first_index, std::string data, bool is_last_substring );
+
+  // How many bytes are stored in the Reassembler itself?
+  uint64_t count_bytes_pending() const { return bytes_pending_; }
+
+  // Fill in up to `out.size()` of the index ranges [first, end) of the stored bytes, in order.
+  // (These are what a TCP receiver reports as SACK blocks.) Returns the number of ranges filled in.
+  size_t pending_ranges( std::span<std::pair<uint64_t, uint64_t>> out ) const;
+
+  // Access output stream reader
+  Reader& reader() { return output_.reader(); }
+  const Reader& reader() const { return output_.reader(); }
+
+  // Access output stream writer, but const-only (can't write from outside)
+  const Writer& writer() const { return output_.writer(); }
+
+private:
+  // A run of stored bytes. The runs are kept sorted by index, and never overlap or touch:
+  // a substring that overlaps or abuts stored runs is merged with them as it is inserted.
+  struct Pending
+  {
+    uint64_t first_index {};
+    std::string data {};
+
+    uint64_t end_index() const { return first_index + data.size(); }
+  };
+
+  ByteStream output_;
+  std::vector<Pending> pending_ {};
+  uint64_t bytes_pending_ {};
+  std::optional<uint64_t> end_index_ {}; // index one past the last byte of the stream, once known
+
+  void store( uint64_t first_index, std::string data );
+  void write_ready();
+};
@@ -0,0 +1,108 @@
+#include "router.hh"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+void ForwardingTable::add_route( const Route& route )
+{
+  table_.insert( route.route_prefix, route.prefix_length, target_index( route.next_hop, route.interface_num ) );
+}
+
+void ForwardingTable::add_routes( span<const Route> routes )
+{
+  vector<RoutingTable::Route> entries;
+  entries.reserve( routes.size() );
+  for ( const Route& route : routes ) {
+    entries.push_back(
+      { route.route_prefix, route.prefix_length, target_index( route.next_hop, route.interface_num ) } );
+  }
+  table_.insert( entries );
+}
+
+uint32_t ForwardingTable::target_index( const optional<Address>& next_hop, size_t interface_num )
+{
+  const optional<uint32_t> next_hop_ip
+    = next_hop.has_value() ? optional { next_hop->ipv4_numeric() } : optional<uint32_t> {};
+  const auto [it, inserted] = target_indices_.try_emplace( { next_hop_ip, interface_num }, targets_.size() );
+  if ( inserted ) {
+    if ( targets_.size() > RoutingTable::MAX_TARGET ) {
+      throw runtime_error( "ForwardingTable: too many distinct next hops" );
+    }
+    targets_.push_back( { next_hop, interface_num } );
+  }
+  return it->second;
+}
+
+// route_prefix: The "up-to-32-bit" IPv4 address prefix to match the datagram's destination address against
+// prefix_length: For this route to be applicable, how many high-order (most-significant) bits of
+//    the route_prefix will need to match the corresponding bits of the datagram's destination address?
+// next_hop: The IP address of the next hop. Will be empty if the network is directly attached to the router (in
+//    which case, the next hop address should be the datagram's final destination).
+// interface_num: The index of the interface to send the datagram out on.
+void Router::add_route( const uint32_t route_prefix,
+                        const uint8_t prefix_length,
+                        const optional<Address> next_hop,
+                        const size_t interface_num )
+{
+  cerr << "DEBUG: adding route " << Address::from_ipv4_numeric( route_prefix ).ip() << "/"
+       << static_cast<int>( prefix_length ) << " => " << ( next_hop.has_value() ? next_hop->ip() : "(direct)" )
+       << " on interface " << interface_num << "\n";
+
+  const Route route { route_prefix, prefix_length, next_hop, interface_num };
+  check_interface( route );
+  routes_.add_route( route );
+}
+
+void Router::add_routes( span<const Route> routes )
+{
+  for ( const Route& route : routes ) {
+    check_interface( route );
+  }
+  routes_.add_routes( routes );
+}
+
+void Router::check_interface( const Route& route ) const
+{
+  if ( route.interface_num >= interfaces_.size() ) {
+    throw runtime_error( "Router: route to nonexistent interface " + to_string( route.interface_num ) );
+  }
+}
+
+void Router::route()
+{
+  for ( const auto& interface : interfaces_ ) {
+    auto& received = interface->datagrams_received();
+    batch_.clear();
+    while ( not received.empty() ) {
+      batch_.push_back( move( received.front() ) );
+      received.pop();
+    }
+    route( batch_ );
+  }
+}
+
+void Router::route( span<InternetDatagram> datagrams )
+{
+  destinations_.resize( datagrams.size() );
+  route_targets_.resize( datagrams.size() );
+  for ( size_t i = 0; i < datagrams.size(); ++i ) {
+    destinations_[i] = datagrams[i].header.dst;
+  }
+  routes_.lookup( destinations_, route_targets_ );
+
+  for ( size_t i = 0; i < datagrams.size(); ++i ) {
+    InternetDatagram& dgram = datagrams[i];
+    if ( route_targets_[i] == RoutingTable::NO_ROUTE or dgram.header.ttl <= 1 ) {
+      continue; // no route, or the TTL has run out: drop the datagram
+    }
+
+    dgram.header.decrement_ttl();
+
+    const ForwardingTable::Target& target = routes_.target( route_targets_[i] );
+    interfaces_[target.interface_num]->send_datagram(
+      dgram, target.next_hop.value_or( Address::from_ipv4_numeric( dgram.header.dst ) ) );
+  }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "address.hh"
+#include "exception.hh"
+#include "ipv4_datagram.hh"
+#include "network_interface.hh"
+#include "routing_table.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+// A router's routes: a RoutingTable, whose targets are indices into the list of distinct places that the
+// routes send datagrams (a next hop and an interface). It can be copied, e.g. to build a new set of routes
+// while the old set stays in use.
+class ForwardingTable
+{
+public:
+  struct Route
+  {
+    uint32_t route_prefix;
+    uint8_t prefix_length;
+    std::optional<Address> next_hop; // none if the network is directly attached to the interface
+    size_t interface_num;
+  };
+
+  // Where a route sends datagrams (many routes usually share one)
+  struct Target
+  {
+    std::optional<Address> next_hop;
+    size_t interface_num;
+  };
+
+  void add_route( const Route& route );
+  void add_routes( std::span<const Route> routes );
+
+  // Look up a batch of destination addresses, writing the index of each one's Target (or NO_ROUTE)
+  void lookup( std::span<const uint32_t> destinations, std::span<uint32_t> targets ) const
+  {
+    table_.lookup( destinations, targets );
+  }
+
+  const Target& target( uint32_t index ) const { return targets_[index]; }
+
+private:
+  // The index of a target (adding it if it is new), to store in the routing table
+  uint32_t target_index( const std::optional<Address>& next_hop, size_t interface_num );
+
+  RoutingTable table_ {};
+  std::vector<Target> targets_ {};
+  std::map<std::pair<std::optional<uint32_t>, size_t>, uint32_t> target_indices_ {};
+};
+
+// A router that has multiple network interfaces and
+// performs longest-prefix-match routing between them.
+class Router
+{
+public:
+  using Route = ForwardingTable::Route;
+
+  // Add an interface to the router
+  // \param[in] interface an already-constructed network interface
+  // \returns The index of the interface after it has been added to the router
+  size_t add_interface( std::shared_ptr<NetworkInterface> interface )
+  {
+    interfaces_.push_back( notnull( "add_interface", std::move( interface ) ) );
+    return interfaces_.size() - 1;
+  }
+
+  // Access an interface by index
+  std::shared_ptr<NetworkInterface> interface( const size_t N ) { return interfaces_.at( N ); }
+
+  // Add a route (a forwarding rule)
+  void add_route( uint32_t route_prefix,
+                  uint8_t prefix_length,
+                  std::optional<Address> next_hop,
+                  size_t interface_num );
+
+  // Add many routes at once (e.g. a full table)
+  void add_routes( std::span<const Route> routes );
+
+  // Route packets between the interfaces: everything each interface has received, a batch per interface
+  void route();
+
+  // Route a batch of datagrams, looking up all their destinations at once. Each datagram whose TTL allows
+  // is sent (with its TTL decremented) on the interface of the longest prefix matching its destination;
+  // the rest are dropped.
+  void route( std::span<InternetDatagram> datagrams );
+
+private:
+  void check_interface( const Route& route ) const;
+
+  // The router's collection of network interfaces
+  std::vector<std::shared_ptr<NetworkInterface>> interfaces_ {};
+
+  ForwardingTable routes_ {};
+
+  // Scratch space for route(), kept to save allocations
+  std::vector<InternetDatagram> batch_ {};
+  std::vector<uint32_t> destinations_ {};
+  std::vector<uint32_t> route_targets_ {};
+};
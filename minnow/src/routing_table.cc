@@ -0,0 +1,104 @@
+#include "routing_table.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+RoutingTable::RoutingTable() : tbl24_( size_t { 1 } << 24 ) {}
+
+void RoutingTable::fill( span<uint32_t> entries, uint32_t entry )
+{
+  for ( uint32_t& existing : entries ) {
+    if ( ( existing & length_mask ) <= ( entry & length_mask ) ) {
+      existing = entry;
+    }
+  }
+}
+
+uint32_t RoutingTable::add_group( uint32_t covering_entry )
+{
+  const size_t group = tbl8_groups();
+  if ( group > value_mask ) {
+    throw runtime_error( "RoutingTable: too many prefixes longer than /24" );
+  }
+  tbl8_.resize( tbl8_.size() + group_size, covering_entry );
+  return static_cast<uint32_t>( group );
+}
+
+void RoutingTable::insert( uint32_t prefix, uint8_t prefix_length, uint32_t target )
+{
+  if ( prefix_length > 32 ) {
+    throw runtime_error( "RoutingTable: invalid prefix length " + to_string( prefix_length ) );
+  }
+  if ( target > MAX_TARGET ) {
+    throw runtime_error( "RoutingTable: invalid target " + to_string( target ) );
+  }
+
+  if ( prefix_length < 32 ) {
+    prefix &= ~( UINT32_MAX >> prefix_length ); // ignore any bits past the prefix
+  }
+  const uint32_t entry = make_entry( prefix_length, target );
+
+  if ( prefix_length <= 24 ) {
+    const size_t first = prefix >> 8;
+    const size_t count = size_t { 1 } << ( 24 - prefix_length );
+    for ( size_t i = first; i < first + count; ) {
+      // Runs of plain entries are filled in one go; a /24 with longer prefixes is filled in its group.
+      const auto run_end = find_if(
+        tbl24_.begin() + i, tbl24_.begin() + first + count, []( uint32_t e ) { return e & extended; } );
+      const size_t end = run_end - tbl24_.begin();
+      fill( span { tbl24_ }.subspan( i, end - i ), entry );
+      if ( end < first + count ) {
+        fill( span { tbl8_ }.subspan( ( tbl24_[end] & value_mask ) * group_size, group_size ), entry );
+      }
+      i = end + 1;
+    }
+    return;
+  }
+
+  uint32_t& covering = tbl24_[prefix >> 8];
+  if ( not( covering & extended ) ) {
+    // The /24's first longer prefix: its entries start out as the shorter prefix that covered it (if any).
+    covering = valid | extended | add_group( covering );
+  }
+  const size_t group = covering & value_mask;
+  const size_t count = size_t { 1 } << ( 32 - prefix_length );
+  fill( span { tbl8_ }.subspan( group * group_size + ( prefix & 0xff ), count ), entry );
+}
+
+void RoutingTable::insert( span<const Route> routes )
+{
+  vector<Route> sorted { routes.begin(), routes.end() };
+  ranges::stable_sort( sorted, {}, &Route::prefix_length );
+
+  const size_t long_prefixes = ranges::count_if( sorted, []( const Route& r ) { return r.prefix_length > 24; } );
+  tbl8_.reserve( tbl8_.size() + long_prefixes * group_size );
+
+  for ( const Route& route : sorted ) {
+    insert( route.prefix, route.prefix_length, route.target );
+  }
+}
+
+void RoutingTable::lookup( span<const uint32_t> addresses, span<uint32_t> targets ) const
+{
+  if ( targets.size() < addresses.size() ) {
+    throw runtime_error( "RoutingTable::lookup: not enough room for the targets" );
+  }
+
+  for ( size_t i = 0; i < addresses.size(); ++i ) {
+    targets[i] = tbl24_[addresses[i] >> 8];
+    if ( targets[i] & extended ) {
+      __builtin_prefetch( &tbl8_[( ( targets[i] & value_mask ) << 8 ) | ( addresses[i] & 0xff )] );
+    }
+  }
+
+  for ( size_t i = 0; i < addresses.size(); ++i ) {
+    uint32_t entry = targets[i];
+    if ( entry & extended ) {
+      entry = tbl8_[( ( entry & value_mask ) << 8 ) | ( addresses[i] & 0xff )];
+    }
+    targets[i] = ( entry & valid ) ? entry & value_mask : NO_ROUTE;
+  }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/*
+ * A longest-prefix-match table of IPv4 routes, in the DIR-24-8 layout (Gupta, Lin and McKeown, "Routing
+ * Lookups in Hardware at Memory Access Speeds"): a lookup reads one entry of a 2^24-entry table indexed
+ * by the top 24 bits of the address, and, only for a /24 that holds longer prefixes, one more entry of a
+ * 256-entry group indexed by the low 8 bits. So a lookup costs at most two memory reads, however many
+ * routes there are.
+ *
+ * Each entry remembers the length of the prefix that set it, so that inserting a shorter prefix never
+ * overwrites a longer one: routes may be inserted in any order. (Routes can't be removed.)
+ *
+ * A route's target is an arbitrary number below 2^24 (e.g. an index into the caller's list of next hops).
+ */
+class RoutingTable
+{
+public:
+  static constexpr uint32_t NO_ROUTE = UINT32_MAX;
+  static constexpr uint32_t MAX_TARGET = ( 1U << 24 ) - 1;
+
+  struct Route
+  {
+    uint32_t prefix;
+    uint8_t prefix_length;
+    uint32_t target;
+  };
+
+  RoutingTable();
+
+  // Add a route (replacing any route with the same prefix and length).
+  void insert( uint32_t prefix, uint8_t prefix_length, uint32_t target );
+
+  // Add many routes at once: shortest prefixes first, so that each group for longer prefixes starts out as a
+  // copy of the shorter prefixes that cover it (instead of being filled again by each of them), and with room
+  // for the groups reserved up front.
+  void insert( std::span<const Route> routes );
+
+  // The target of the longest prefix that matches `address`, or NO_ROUTE
+  uint32_t lookup( uint32_t address ) const
+  {
+    uint32_t entry = tbl24_[address >> 8];
+    if ( entry & extended ) {
+      entry = tbl8_[( ( entry & value_mask ) << 8 ) | ( address & 0xff )];
+    }
+    return ( entry & valid ) ? entry & value_mask : NO_ROUTE;
+  }
+
+  // Look up a batch of addresses, writing each one's target (or NO_ROUTE) to the corresponding `targets`.
+  // All the first-level reads are issued before any result is needed, so their cache misses overlap.
+  void lookup( std::span<const uint32_t> addresses, std::span<uint32_t> targets ) const;
+
+  size_t tbl8_groups() const { return tbl8_.size() / group_size; }
+
+private:
+  // An entry: valid bit, extended bit (the value is a tbl8 group), the prefix length, and the value (target)
+  static constexpr uint32_t valid = 1U << 31;
+  static constexpr uint32_t extended = 1U << 30;
+  static constexpr uint32_t length_shift = 24;
+  static constexpr uint32_t length_mask = 0x3fU << length_shift;
+  static constexpr uint32_t value_mask = MAX_TARGET;
+  static constexpr size_t group_size = 256;
+
+  std::vector<uint32_t> tbl24_;
+  std::vector<uint32_t> tbl8_ {};
+
+  static uint32_t make_entry( uint8_t prefix_length, uint32_t target )
+  {
+    return valid | ( static_cast<uint32_t>( prefix_length ) << length_shift ) | target;
+  }
+
+  // Set each of `entries` to `entry`, unless it was set by a longer prefix
+  static void fill( std::span<uint32_t> entries, uint32_t entry );
+
+  uint32_t add_group( uint32_t covering_entry );
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// A ByteStream whose capacity N is fixed at compile time and whose storage is inline (no allocation).
+// Bytes are copied into a ring of std::bit_ceil(N) bytes, so wrap-around is a constant mask.
+// The Writer and Reader interfaces have the same methods as ByteStream's.
+template<uint64_t N>
+class StaticByteStream
+{
+public:
+  class Reader;
+  class Writer;
+
+  StaticByteStream() = default;
+
+  Reader& reader() { return static_cast<Reader&>( *this ); }                   // NOLINT(*-downcast)
+  const Reader& reader() const { return static_cast<const Reader&>( *this ); } // NOLINT(*-downcast)
+  Writer& writer() { return static_cast<Writer&>( *this ); }                   // NOLINT(*-downcast)
+  const Writer& writer() const { return static_cast<const Writer&>( *this ); } // NOLINT(*-downcast)
+
+  void set_error() { error_ = true; };       // Signal that the stream suffered an error.
+  bool has_error() const { return error_; }; // Has the stream had an error?
+
+  static constexpr uint64_t capacity() { return N; }
+
+protected:
+  static constexpr uint64_t ring_size = std::bit_ceil( std::max<uint64_t>( N, 1 ) );
+  static constexpr uint64_t mask = ring_size - 1;
+
+  std::array<char, ring_size> ring_ {};
+  uint64_t bytes_pushed_ {};
+  uint64_t bytes_popped_ {};
+  bool closed_ {};
+  bool error_ {};
+};
+
+template<uint64_t N>
+class StaticByteStream<N>::Writer : public StaticByteStream<N>
+{
+public:
+  // Push data to stream, but only as much as available capacity allows.
+  void push( std::string_view data )
+  {
+    if ( this->closed_ or this->error_ ) {
+      return;
+    }
+
+    data = data.substr( 0, available_capacity() );
+    const uint64_t start = this->bytes_pushed_ & mask;
+    const uint64_t first_len = std::min<uint64_t>( data.size(), ring_size - start );
+    std::ranges::copy( data.substr( 0, first_len ), this->ring_.begin() + start );
+    std::ranges::copy( data.substr( first_len ), this->ring_.begin() );
+    this->bytes_pushed_ += data.size();
+  }
+
+  // Signal that the stream has reached its ending. Nothing more will be written.
+  void close() { this->closed_ = true; }
+
+  // Has the stream been closed?
+  bool is_closed() const { return this->closed_; }
+
+  // How many bytes can be pushed to the stream right now?
+  uint64_t available_capacity() const { return N - ( this->bytes_pushed_ - this->bytes_popped_ ); }
+
+  // Total number of bytes cumulatively pushed to the stream
+  uint64_t bytes_pushed() const { return this->bytes_pushed_; }
+};
+
+template<uint64_t N>
+class StaticByteStream<N>::Reader : public StaticByteStream<N>
+{
+public:
+  // Peek at the next contiguous bytes in the buffer
+  std::string_view peek() const
+  {
+    const uint64_t start = this->bytes_popped_ & mask;
+    return { this->ring_.data() + start, std::min( bytes_buffered(), ring_size - start ) };
+  }
+
+  // Peek at up to `out.size()` contiguous runs of buffered bytes (at most two, since the ring wraps once)
+  size_t peek_buffers( std::span<std::string_view> out ) const
+  {
+    size_t count = 0;
+    for ( uint64_t offset = 0; count < out.size() and offset < bytes_buffered(); ++count ) {
+      const uint64_t start = ( this->bytes_popped_ + offset ) & mask;
+      out[count] = { this->ring_.data() + start, std::min( bytes_buffered() - offset, ring_size - start ) };
+      offset += out[count].size();
+    }
+    return count;
+  }
+
+  // Remove `len` bytes from the buffer
+  void pop( uint64_t len ) { this->bytes_popped_ += std::min( len, bytes_buffered() ); }
+
+  // Is the stream finished (closed and fully popped)?
+  bool is_finished() const { return this->closed_ and bytes_buffered() == 0; }
+
+  // Number of bytes currently buffered (pushed and not popped)
+  uint64_t bytes_buffered() const { return this->bytes_pushed_ - this->bytes_popped_; }
+
+  // Total number of bytes cumulatively popped from stream
+  uint64_t bytes_popped() const { return this->bytes_popped_; }
+};
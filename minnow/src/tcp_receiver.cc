@@ -0,0 +1,74 @@
+#include "tcp_receiver.hh"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <utility>
+
+using namespace std;
+
+void TCPReceiver::receive( TCPSenderMessage message )
+{
+  if ( message.RST ) {
+    reader().set_error();
+    return;
+  }
+
+  if ( not zero_point_.has_value() ) {
+    if ( not message.SYN ) {
+      return;
+    }
+    zero_point_ = message.seqno;
+  }
+
+  // The SYN has absolute sequence number 0, so stream index i has absolute sequence number i + 1.
+  const uint64_t abs_seqno = message.seqno.unwrap( *zero_point_, writer().bytes_pushed() + 1 );
+  if ( abs_seqno == 0 and not message.SYN ) {
+    return; // a payload can't begin at the SYN's sequence number
+  }
+
+  const uint64_t first_index = abs_seqno + message.SYN - 1;
+  autotune( first_index + message.payload.size() );
+  reassembler_.insert( first_index, std::move( message.payload ).release(), message.FIN );
+}
+
+TCPReceiverMessage TCPReceiver::send() const
+{
+  TCPReceiverMessage message {
+    .window_size = static_cast<uint32_t>(
+      min<uint64_t>( writer().available_capacity(), TCPReceiverMessage::MAX_WINDOW_SIZE ) ),
+    .RST = writer().has_error() };
+  if ( not zero_point_.has_value() ) {
+    return message;
+  }
+
+  message.ackno = Wrap32::wrap( writer().bytes_pushed() + 1 + writer().is_closed(), *zero_point_ );
+
+  // Report the bytes held beyond the ackno as SACK blocks.
+  array<pair<uint64_t, uint64_t>, TCPReceiverMessage::MAX_SACK_BLOCKS> ranges {};
+  const size_t count = reassembler_.pending_ranges( ranges );
+  message.sack_blocks.reserve( count );
+  for ( size_t i = 0; i < count; ++i ) {
+    message.sack_blocks.push_back(
+      { Wrap32::wrap( ranges[i].first + 1, *zero_point_ ), Wrap32::wrap( ranges[i].second + 1, *zero_point_ ) } );
+  }
+  return message;
+}
+
+// Grow the capacity when a segment reaches the edge of the window (so the sender is limited by the window)
+// and the application has read at least a full window since the capacity last grew (so the application
+// isn't what limits the transfer).
+void TCPReceiver::autotune( uint64_t end_index )
+{
+  const uint64_t capacity = reader().capacity();
+  if ( capacity >= autotune_max_capacity_ ) {
+    return;
+  }
+
+  const bool window_limited = end_index >= reader().bytes_popped() + capacity;
+  const bool read_a_window = reader().bytes_popped() - autotune_checkpoint_ >= capacity;
+  if ( window_limited and read_a_window ) {
+    reader().set_capacity( min( 2 * capacity, autotune_max_capacity_ ) );
+    autotune_checkpoint_ = reader().bytes_popped();
+  }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "reassembler.hh"
+#include "tcp_receiver_message.hh"
+#include "tcp_sender_message.hh"
+
+#include <cstdint>
+#include <optional>
+
+class TCPReceiver
+{
+public:
+  // Construct with given Reassembler
+  explicit TCPReceiver( Reassembler&& reassembler ) : reassembler_( std::move( reassembler ) ) {}
+
+  /*
+   * The TCPReceiver receives TCPSenderMessages, inserting their payload into the Reassembler
+   * at the correct stream index.
+   */
+  void receive( TCPSenderMessage message );
+
+  // The TCPReceiver sends TCPReceiverMessages to the peer's TCPSender.
+  TCPReceiverMessage send() const;
+
+  /*
+   * Receive-window auto-tuning (optional, off by default): when the sender fills the window, and the
+   * application has read a full window's worth of bytes since the last change, double the stream's
+   * capacity (and so the window), up to `max_capacity`. Zero turns it off.
+   * (A window beyond UINT16_MAX only reaches the peer if the connection negotiated window scaling.)
+   */
+  void set_window_autotuning( uint64_t max_capacity ) { autotune_max_capacity_ = max_capacity; }
+
+  // Access the output (only Reader is accessible non-const)
+  const Reassembler& reassembler() const { return reassembler_; }
+  Reader& reader() { return reassembler_.reader(); }
+  const Reader& reader() const { return reassembler_.reader(); }
+  const Writer& writer() const { return reassembler_.writer(); }
+
+private:
+  Reassembler reassembler_;
+  std::optional<Wrap32> zero_point_ {}; // the ISN, once the SYN has arrived
+
+  uint64_t autotune_max_capacity_ {};
+  uint64_t autotune_checkpoint_ {}; // bytes popped when the capacity last grew
+
+  void autotune( uint64_t end_index );
+};
@@ -0,0 +1,202 @@
+#include "tcp_sender.hh"
+#include "tcp_config.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+uint64_t TCPSender::sequence_numbers_in_flight() const
+{
+  return next_seqno_ - acked_seqno_;
+}
+
+uint64_t TCPSender::consecutive_retransmissions() const
+{
+  return consecutive_retransmissions_;
+}
+
+uint64_t TCPSender::sequence_numbers_sacked() const
+{
+  return sacked_;
+}
+
+void TCPSender::set_pacing_rate( uint64_t bytes_per_second, uint64_t burst_bytes )
+{
+  pacing_rate_ = bytes_per_second;
+  pacing_burst_ = max( burst_bytes, TCPConfig::MAX_PAYLOAD_SIZE + 2 ); // room for a full segment with SYN/FIN
+  pacing_budget_ = pacing_burst_ * 1000;
+}
+
+void TCPSender::push( const TransmitFunction& transmit )
+{
+  // A zero window is probed as if it were one sequence number wide.
+  const uint64_t window = max<uint64_t>( window_size_, 1 );
+
+  while ( not FIN_sent_ and sequence_numbers_in_flight() < window ) {
+    const uint64_t room = window - sequence_numbers_in_flight();
+
+    TCPSenderMessage message = make_empty_message();
+    message.SYN = next_seqno_ == 0;
+    const uint64_t payload_len
+      = min( { room - message.SYN, TCPConfig::MAX_PAYLOAD_SIZE, reader().bytes_buffered() } );
+    message.FIN = writer().is_closed() and payload_len == reader().bytes_buffered()
+                  and room > message.SYN + payload_len;
+
+    const uint64_t length = message.SYN + payload_len + message.FIN;
+    if ( length == 0 ) {
+      break;
+    }
+    if ( pacing_rate_ > 0 ) {
+      if ( pacing_budget_ < length * 1000 ) {
+        break; // wait for tick() to replenish the budget
+      }
+      pacing_budget_ -= length * 1000;
+    }
+
+    message.payload = input_.reader().pop_slice( payload_len );
+    keep_outstanding( next_seqno_, message );
+    next_seqno_ += length;
+    FIN_sent_ = message.FIN;
+    if ( not timer_running_ ) {
+      timer_running_ = true;
+      timer_elapsed_ms_ = 0;
+    }
+    transmit( message );
+  }
+}
+
+TCPSenderMessage TCPSender::make_empty_message() const
+{
+  return { .seqno = Wrap32::wrap( next_seqno_, isn_ ), .RST = input_.has_error() };
+}
+
+void TCPSender::receive( const TCPReceiverMessage& msg )
+{
+  if ( msg.RST ) {
+    input_.set_error();
+    return;
+  }
+
+  window_size_ = msg.window_size;
+  if ( not msg.ackno.has_value() ) {
+    return;
+  }
+
+  const uint64_t ackno = msg.ackno->unwrap( isn_, next_seqno_ );
+  if ( ackno > next_seqno_ ) {
+    return; // acknowledges something not yet sent
+  }
+
+  for ( const auto& block : msg.sack_blocks ) {
+    mark_sacked( block );
+  }
+
+  if ( ackno <= acked_seqno_ ) {
+    return;
+  }
+  acked_seqno_ = ackno;
+
+  // Retire the segments that are now fully acknowledged (all of them at the front of the ring).
+  for ( ; outstanding_count() > 0 and outstanding( head_ ).end_seqno() <= acked_seqno_; ++head_ ) {
+    Outstanding& retired = outstanding( head_ );
+    if ( retired.sacked ) {
+      sacked_ -= retired.message.sequence_length();
+    }
+    retired = {}; // release the segment's payload
+  }
+
+  RTO_ms_ = initial_RTO_ms_;
+  consecutive_retransmissions_ = 0;
+  timer_running_ = outstanding_count() > 0;
+  timer_elapsed_ms_ = 0;
+}
+
+void TCPSender::tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit )
+{
+  if ( timer_running_ ) {
+    timer_elapsed_ms_ += ms_since_last_tick;
+    if ( timer_elapsed_ms_ >= RTO_ms_ ) {
+      // Retransmit the earliest segment the receiver is missing (the earliest of all, if it has every one).
+      uint64_t index = head_;
+      while ( index < tail_ and outstanding( index ).sacked ) {
+        ++index;
+      }
+      transmit( unacknowledged_part( outstanding( index == tail_ ? head_ : index ) ) );
+
+      if ( window_size_ > 0 ) {
+        ++consecutive_retransmissions_;
+        RTO_ms_ *= 2; // exponential backoff (but not while probing a zero window)
+      }
+      timer_elapsed_ms_ = 0;
+    }
+  }
+
+  if ( pacing_rate_ > 0 ) {
+    pacing_budget_ = min( pacing_budget_ + pacing_rate_ * ms_since_last_tick, pacing_burst_ * 1000 );
+    push( transmit );
+  }
+}
+
+void TCPSender::keep_outstanding( uint64_t first_seqno, const TCPSenderMessage& message )
+{
+  if ( outstanding_count() == outstanding_.size() ) {
+    vector<Outstanding> larger( max<size_t>( 2 * outstanding_.size(), 16 ) );
+    for ( uint64_t i = 0; i < outstanding_count(); ++i ) {
+      larger[i] = move( outstanding( head_ + i ) );
+    }
+    tail_ = outstanding_count();
+    head_ = 0;
+    outstanding_ = move( larger );
+  }
+
+  outstanding( tail_++ ) = { first_seqno, message };
+}
+
+// Mark the outstanding segments that lie entirely within a SACK block.
+void TCPSender::mark_sacked( const TCPReceiverMessage::SackBlock& block )
+{
+  const uint64_t begin = block.begin.unwrap( isn_, acked_seqno_ );
+  const uint64_t end = block.end.unwrap( isn_, begin );
+  if ( begin >= end or end > next_seqno_ ) {
+    return;
+  }
+
+  // the first segment beginning at or after `begin`
+  uint64_t lo = head_;
+  uint64_t hi = tail_;
+  while ( lo < hi ) {
+    const uint64_t mid = lo + ( hi - lo ) / 2;
+    if ( outstanding( mid ).first_seqno < begin ) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  for ( ; lo < tail_ and outstanding( lo ).end_seqno() <= end; ++lo ) {
+    Outstanding& segment = outstanding( lo );
+    if ( not segment.sacked ) {
+      segment.sacked = true;
+      sacked_ += segment.message.sequence_length();
+    }
+  }
+}
+
+// A segment as it should be retransmitted: without whatever has since been acknowledged
+TCPSenderMessage TCPSender::unacknowledged_part( const Outstanding& segment ) const
+{
+  TCPSenderMessage message = segment.message;
+  message.RST = input_.has_error();
+  if ( acked_seqno_ <= segment.first_seqno ) {
+    return message;
+  }
+
+  uint64_t acked = acked_seqno_ - segment.first_seqno;
+  if ( message.SYN ) {
+    message.SYN = false;
+    --acked;
+  }
+  message.payload.remove_prefix( acked );
+  message.seqno = Wrap32::wrap( acked_seqno_, isn_ );
+  return message;
+}
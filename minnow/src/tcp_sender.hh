@@ -0,0 +1,103 @@
+#pragma once
+
+#include "byte_stream.hh"
+#include "tcp_receiver_message.hh"
+#include "tcp_sender_message.hh"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class TCPSender
+{
+public:
+  /* Construct TCP sender with given default Retransmission Timeout and possible ISN */
+  TCPSender( ByteStream&& input, Wrap32 isn, uint64_t initial_RTO_ms )
+    : input_( std::move( input ) ), isn_( isn ), initial_RTO_ms_( initial_RTO_ms ), RTO_ms_( initial_RTO_ms )
+  {}
+
+  /* Generate an empty TCPSenderMessage */
+  TCPSenderMessage make_empty_message() const;
+
+  /* Receive and process a TCPReceiverMessage from the peer's receiver */
+  void receive( const TCPReceiverMessage& msg );
+
+  /* Type of the `transmit` function that the push and tick methods can use to send messages */
+  using TransmitFunction = std::function<void( const TCPSenderMessage& )>;
+
+  /* Push bytes from the outbound stream */
+  void push( const TransmitFunction& transmit );
+
+  /*
+   * Time has passed by the given # of milliseconds since the last time the tick() method was called.
+   * (An application drives this from a periodic EventLoop timer.) If the retransmission timer has expired,
+   * the earliest outstanding segment that the receiver hasn't selectively acknowledged is retransmitted;
+   * if pacing is on, segments that the pacing budget now allows are sent too.
+   */
+  void tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit );
+
+  /*
+   * Pace transmissions to `bytes_per_second`, allowing bursts of up to `burst_bytes` (at least one full
+   * segment); a rate of zero turns pacing off. Paced segments that don't fit the budget wait for a later tick().
+   */
+  void set_pacing_rate( uint64_t bytes_per_second, uint64_t burst_bytes );
+
+  // Accessors
+  uint64_t sequence_numbers_in_flight() const;  // How many sequence numbers are outstanding?
+  uint64_t consecutive_retransmissions() const; // How many consecutive *re*transmissions have happened?
+  uint64_t sequence_numbers_sacked() const;     // How many outstanding sequence numbers has the receiver SACKed?
+  Writer& writer() { return input_.writer(); }
+  const Writer& writer() const { return input_.writer(); }
+
+  // Access input stream reader, but const-only (can't read from outside)
+  const Reader& reader() const { return input_.reader(); }
+
+private:
+  // A segment that has been sent but not acknowledged
+  struct Outstanding
+  {
+    uint64_t first_seqno {}; // absolute sequence number of the segment's beginning
+    TCPSenderMessage message {};
+    bool sacked {}; // has the receiver selectively acknowledged all of it?
+
+    uint64_t end_seqno() const { return first_seqno + message.sequence_length(); }
+  };
+
+  // Variables initialized in constructor
+  ByteStream input_;
+  Wrap32 isn_;
+  uint64_t initial_RTO_ms_;
+  uint64_t RTO_ms_;
+
+  uint64_t next_seqno_ {};   // absolute sequence number of the next new byte to send
+  uint64_t acked_seqno_ {};  // absolute sequence number of the first unacknowledged one
+  uint32_t window_size_ { 1 };
+  bool FIN_sent_ {};
+
+  // The outstanding segments, in order, in a ring whose size is a power of two (as in ByteStream).
+  // Their sequence numbers are increasing, so a segment is found by binary search, and an ACK
+  // only looks at the segments it retires.
+  std::vector<Outstanding> outstanding_ {};
+  uint64_t head_ {};
+  uint64_t tail_ {};
+  uint64_t sacked_ {};
+
+  bool timer_running_ {};
+  uint64_t timer_elapsed_ms_ {};
+  uint64_t consecutive_retransmissions_ {};
+
+  uint64_t pacing_rate_ {};   // bytes per second, or zero if not pacing
+  uint64_t pacing_burst_ {};  // bytes
+  uint64_t pacing_budget_ {}; // in thousandths of a byte, so that short ticks still add up
+
+  uint64_t outstanding_count() const { return tail_ - head_; }
+  Outstanding& outstanding( uint64_t index ) { return outstanding_[index & ( outstanding_.size() - 1 )]; }
+  const Outstanding& outstanding( uint64_t index ) const
+  {
+    return outstanding_[index & ( outstanding_.size() - 1 )];
+  }
+  void keep_outstanding( uint64_t first_seqno, const TCPSenderMessage& message );
+
+  void mark_sacked( const TCPReceiverMessage::SackBlock& block );
+  TCPSenderMessage unacknowledged_part( const Outstanding& segment ) const;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * The Wrap32 type represents a 32-bit unsigned integer that:
+ *    - starts at an arbitrary "zero point" (initial value), and
+ *    - wraps back to zero when it reaches 2^32 - 1.
+ *
+ * wrap() and unwrap() are constexpr, and unwrap() is a handful of ALU operations with no branches
+ * (it runs for every segment received), so neither needs a translation unit of its own.
+ */
+
+class Wrap32
+{
+public:
+  explicit constexpr Wrap32( uint32_t raw_value ) : raw_value_( raw_value ) {}
+
+  /* Construct a Wrap32 given an absolute sequence number n and the zero point. */
+  static constexpr Wrap32 wrap( uint64_t n, Wrap32 zero_point )
+  {
+    return zero_point + static_cast<uint32_t>( n );
+  }
+
+  /*
+   * The unwrap method returns an absolute sequence number that wraps to this Wrap32, given the zero point
+   * and a "checkpoint": another absolute sequence number near the desired answer.
+   *
+   * There are many possible absolute sequence numbers that all wrap to the same Wrap32.
+   * The unwrap method returns the one that is closest to the checkpoint (or the lower one, if two are).
+   */
+  constexpr uint64_t unwrap( Wrap32 zero_point, uint64_t checkpoint ) const
+  {
+    // how far the answer is from the checkpoint, in [-2^31, 2^31): the difference of the low 32 bits
+    const uint32_t offset = raw_value_ - zero_point.raw_value_;
+    const auto delta = static_cast<int32_t>( offset - static_cast<uint32_t>( checkpoint ) );
+    const uint64_t answer = checkpoint + static_cast<uint64_t>( int64_t { delta } );
+
+    // ... unless that would be before zero (or past 2^64 - 1), in which case the next candidate in is closest
+    const bool underflowed = delta < 0 and answer > checkpoint;
+    const bool overflowed = delta > 0 and answer < checkpoint;
+    return answer + ( static_cast<uint64_t>( underflowed ) << 32 ) - ( static_cast<uint64_t>( overflowed ) << 32 );
+  }
+
+  // The raw 32-bit value (as it appears on the wire)
+  constexpr uint32_t raw() const { return raw_value_; }
+
+  constexpr Wrap32 operator+( uint32_t n ) const { return Wrap32 { raw_value_ + n }; }
+  constexpr bool operator==( const Wrap32& other ) const { return raw_value_ == other.raw_value_; }
+
+protected:
+  uint32_t raw_value_ {};
+};
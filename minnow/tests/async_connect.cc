@@ -0,0 +1,145 @@
+#include "async_connect.hh"
+#include "exception.hh"
+#include "resolver.hh"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+void run_until( EventLoop& loop, const bool& done )
+{
+  for ( int i = 0; not done and i < 1000; ++i ) {
+    loop.wait_next_event( 10 );
+  }
+  expect( done, "the loop should have finished" );
+}
+
+// a connection completes on the loop; a refused one reports its error
+void connect( EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  const size_t category = loop.add_category( "connect" );
+
+  TCPSocket listener;
+  listener.bind( Address { "127.0.0.1", 0 } );
+  listener.listen();
+
+  bool done = false;
+  optional<TCPSocket> connected;
+  async_connect(
+    loop,
+    category,
+    listener.local_address(),
+    [&]( TCPSocket&& socket ) {
+      connected.emplace( move( socket ) );
+      done = true;
+    },
+    []( const exception_ptr& ) { throw runtime_error( "connection should succeed" ); } );
+  run_until( loop, done );
+
+  TCPSocket accepted = listener.accept();
+  expect( accepted.peer_address() == connected->local_address(), "should connect to the listener" );
+  connected->write( "hello" );
+  string buf;
+  accepted.read( buf );
+  expect( buf == "hello", "connected socket should work" );
+
+  // a port that nothing is listening on
+  Address closed_port = [] {
+    TCPSocket unused;
+    unused.bind( Address { "127.0.0.1", 0 } );
+    return unused.local_address();
+  }();
+
+  done = false;
+  int error_code = 0;
+  async_connect(
+    loop,
+    category,
+    closed_port,
+    []( TCPSocket&& ) { throw runtime_error( "connection should be refused" ); },
+    [&]( const exception_ptr& error ) {
+      done = true;
+      try {
+        rethrow_exception( error );
+      } catch ( const unix_error& e ) {
+        error_code = e.error_code();
+      }
+    } );
+  run_until( loop, done );
+  expect( error_code == ECONNREFUSED, "a refused connection should report ECONNREFUSED" );
+
+  expect( loop.wait_next_event( 0 ) == EventLoop::Result::Exit, "finished connects should leave no rules" );
+}
+
+// answers (and errors) are cached, and asynchronous lookups don't block the loop
+void resolve()
+{
+  EventLoop loop;
+  Resolver resolver { loop, chrono::milliseconds { 200 }, chrono::milliseconds { 50 } };
+
+  const Address first = resolver.resolve( "localhost", "80" );
+  expect( first.port() == 80, "should resolve the service" );
+  expect( resolver.resolve( "localhost", "80" ) == first and resolver.lookups() == 1, "answer should be cached" );
+
+  const auto expect_error = [&] {
+    bool threw = false;
+    try {
+      resolver.resolve( "localhost", "no-such-service" );
+    } catch ( const exception& ) {
+      threw = true;
+    }
+    expect( threw, "unknown service should fail" );
+  };
+  expect_error();
+  expect_error();
+  expect( resolver.lookups() == 2, "error should be cached" );
+  this_thread::sleep_for( chrono::milliseconds { 60 } );
+  expect_error();
+  expect( resolver.lookups() == 3, "cached error should expire" );
+
+  size_t answers = 0;
+  const auto on_error = []( const exception_ptr& ) { throw runtime_error( "lookup should succeed" ); };
+  resolver.resolve_async( "localhost", "80", [&]( const Address& a ) { answers += a == first; }, on_error );
+  expect( answers == 1 and resolver.lookups() == 3, "cached answer should be delivered right away" );
+
+  bool done = false;
+  for ( int i = 0; i < 2; ++i ) {
+    resolver.resolve_async(
+      "127.0.0.1",
+      "8080",
+      [&]( const Address& a ) {
+        answers += a.port() == 8080;
+        done = answers == 3;
+      },
+      on_error );
+  }
+  expect( answers == 1, "uncached answer should arrive later" );
+  run_until( loop, done );
+  expect( resolver.lookups() == 4, "concurrent lookups of a name should be shared" );
+  expect( loop.wait_next_event( 0 ) == EventLoop::Result::Exit, "an idle resolver should not keep the loop going" );
+}
+
+int main()
+{
+  try {
+    connect( EventLoop::Backend::Poll );
+    connect( EventLoop::Backend::Epoll );
+    resolve();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
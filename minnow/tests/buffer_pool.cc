@@ -0,0 +1,131 @@
+#include "buffer_pool.hh"
+#include "byte_stream.hh"
+#include "file_descriptor.hh"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+void drain_pool()
+{
+  while ( BufferPool::free_slabs() > 0 ) {
+    BufferPool::take();
+  }
+}
+
+// a slab given back is handed out again, with its contents, and only whole slabs are kept
+void take_and_give_back()
+{
+  drain_pool();
+
+  string slab = BufferPool::take( 100 );
+  expect( slab.size() == 100 and slab.capacity() >= BufferPool::slab_size, "take() should reserve a whole slab" );
+  expect( BufferPool::take( 2 * BufferPool::slab_size ).size() == BufferPool::slab_size, "take() is capped" );
+
+  slab.assign( BufferPool::slab_size, 'x' );
+  const char* storage = slab.data();
+  BufferPool::give_back( move( slab ) );
+  expect( BufferPool::free_slabs() == 1, "slab should be pooled" );
+
+  string again = BufferPool::take();
+  expect( again.data() == storage, "pooled slab should be reused" );
+  expect( again == string( BufferPool::slab_size, 'x' ), "reused slab should not be zeroed again" );
+  expect( BufferPool::free_slabs() == 0, "slab should have left the pool" );
+
+  BufferPool::give_back( "too small" );
+  BufferPool::give_back( string( 4 * BufferPool::slab_size, 'y' ) );
+  expect( BufferPool::free_slabs() == 0, "buffers that aren't slabs should not be pooled" );
+
+  for ( size_t i = 0; i < 2 * BufferPool::max_free_slabs; ++i ) {
+    BufferPool::give_back( BufferPool::take() );
+    string extra;
+    extra.reserve( BufferPool::slab_size );
+    BufferPool::give_back( move( extra ) );
+  }
+  expect( BufferPool::free_slabs() == BufferPool::max_free_slabs, "pool should be bounded" );
+}
+
+// a buffer read by FileDescriptor::read() returns to the pool once a ByteStream has popped it
+void read_into_stream()
+{
+  drain_pool();
+
+  auto [read_end, write_end] = FileDescriptor::make_pipe();
+  const string data( BufferPool::copy_below, 'x' );
+  write_end.write( data );
+
+  string buffer;
+  read_end.read( buffer );
+  expect( buffer == data, "read() should read into a pooled buffer" );
+  expect( buffer.capacity() >= BufferPool::slab_size, "a long read should keep its slab" );
+  const char* storage = buffer.data();
+
+  ByteStream stream { 2 * data.size() };
+  stream.writer().push( move( buffer ) );
+  stream.reader().pop( 5 );
+  expect( BufferPool::free_slabs() == 0, "partly popped segment should stay in the stream" );
+  stream.reader().pop( data.size() - 5 );
+  expect( BufferPool::free_slabs() == 1, "popped segment should return to the pool" );
+  expect( BufferPool::take().data() == storage, "popped segment should be reused" );
+}
+
+// a short read is copied out of its slab, which goes straight back to the pool
+void short_read()
+{
+  drain_pool();
+
+  auto [read_end, write_end] = FileDescriptor::make_pipe();
+  write_end.write( "hello, pool" );
+
+  string buffer;
+  read_end.read( buffer );
+  expect( buffer == "hello, pool", "read() should read the bytes written" );
+  expect( buffer.capacity() < BufferPool::copy_below, "a short read should not pin a slab" );
+  expect( BufferPool::free_slabs() == 1, "the slab should return to the pool" );
+
+  string slab = BufferPool::take( 100 );
+  slab.assign( 100, 'z' );
+  BufferPool::trim( slab, BufferPool::slab_size );
+  expect( slab.size() == 100, "trim() should not grow a buffer" );
+  BufferPool::trim( slab, 8 );
+  expect( slab == "zzzzzzzz", "trim() should keep the bytes read" );
+  expect( BufferPool::free_slabs() == 1, "trim() should give the slab back" );
+}
+
+// each thread has its own pool
+void per_thread()
+{
+  drain_pool();
+  BufferPool::give_back( BufferPool::take() );
+
+  size_t other_thread_slabs = 1;
+  thread other { [&] { other_thread_slabs = BufferPool::free_slabs(); } };
+  other.join();
+  expect( other_thread_slabs == 0, "another thread should not see this thread's slabs" );
+  expect( BufferPool::free_slabs() == 1, "this thread should keep its slab" );
+}
+
+int main()
+{
+  try {
+    take_and_give_back();
+    read_into_stream();
+    short_read();
+    per_thread();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
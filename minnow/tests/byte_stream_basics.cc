@@ -5,7 +5,8 @@
 
 using namespace std;
 
-void all_zeroes( ByteStreamTestHarness& test )
+template<class Harness>
+void all_zeroes( Harness& test )
 {
   test.execute( BytesBuffered { 0 } );
   test.execute( AvailableCapacity { 15 } );
@@ -13,82 +14,89 @@ void all_zeroes( ByteStreamTestHarness& test )
   test.execute( BytesPopped { 0 } );
 }
 
-int main()
+template<class Harness>
+void program_body()
 {
-  try {
-    {
-      ByteStreamTestHarness test { "construction", 15 };
-      test.execute( IsClosed { false } );
-      test.execute( IsFinished { false } );
-      test.execute( HasError { false } );
-      all_zeroes( test );
-    }
+  {
+    Harness test { "construction", 15 };
+    test.execute( IsClosed { false } );
+    test.execute( IsFinished { false } );
+    test.execute( HasError { false } );
+    all_zeroes( test );
+  }
 
-    {
-      ByteStreamTestHarness test { "close", 15 };
-      test.execute( Close {} );
-      test.execute( IsClosed { true } );
-      test.execute( IsFinished { true } );
-      test.execute( HasError { false } );
-      all_zeroes( test );
-    }
+  {
+    Harness test { "close", 15 };
+    test.execute( Close {} );
+    test.execute( IsClosed { true } );
+    test.execute( IsFinished { true } );
+    test.execute( HasError { false } );
+    all_zeroes( test );
+  }
 
-    {
-      ByteStreamTestHarness test { "set-error", 15 };
-      test.execute( SetError {} );
-      test.execute( IsClosed { false } );
-      test.execute( IsFinished { false } );
-      test.execute( HasError { true } );
-      all_zeroes( test );
-    }
+  {
+    Harness test { "set-error", 15 };
+    test.execute( SetError {} );
+    test.execute( IsClosed { false } );
+    test.execute( IsFinished { false } );
+    test.execute( HasError { true } );
+    all_zeroes( test );
+  }
 
-    {
-      ByteStreamTestHarness test { "first-peek", 15 };
-      test.execute( Peek { "" } );
-    }
+  {
+    Harness test { "first-peek", 15 };
+    test.execute( Peek { "" } );
+  }
 
-    {
-      ByteStreamTestHarness test { "write, close, read", 15 };
-      test.execute( Push { "hello" } );
-      test.execute( Close {} );
-      test.execute( IsClosed { true } );
-      test.execute( IsFinished { false } );
-      test.execute( Peek { "hello" } );
-      test.execute( Pop { 4 } );
-      test.execute( IsClosed { true } );
-      test.execute( IsFinished { false } );
-      test.execute( ReadAll { "o" } );
-      test.execute( IsClosed { true } );
-      test.execute( IsFinished { true } );
-      test.execute( HasError { false } );
-      test.execute( BytesBuffered { 0 } );
-      test.execute( AvailableCapacity { 15 } );
-      test.execute( BytesPushed { 5 } );
-      test.execute( BytesPopped { 5 } );
-    }
+  {
+    Harness test { "write, close, read", 15 };
+    test.execute( Push { "hello" } );
+    test.execute( Close {} );
+    test.execute( IsClosed { true } );
+    test.execute( IsFinished { false } );
+    test.execute( Peek { "hello" } );
+    test.execute( Pop { 4 } );
+    test.execute( IsClosed { true } );
+    test.execute( IsFinished { false } );
+    test.execute( ReadAll { "o" } );
+    test.execute( IsClosed { true } );
+    test.execute( IsFinished { true } );
+    test.execute( HasError { false } );
+    test.execute( BytesBuffered { 0 } );
+    test.execute( AvailableCapacity { 15 } );
+    test.execute( BytesPushed { 5 } );
+    test.execute( BytesPopped { 5 } );
+  }
 
-    {
-      ByteStreamTestHarness test { "okay to call close more than once", 15 };
-      test.execute( Push { "hello" } );
-      test.execute( Close {} );
-      test.execute( Close {} );
-      test.execute( Close {} );
-      test.execute( IsClosed { true } );
-      test.execute( IsFinished { false } );
-      test.execute( Peek { "hello" } );
-      test.execute( Pop { 4 } );
-      test.execute( IsClosed { true } );
-      test.execute( IsFinished { false } );
-      test.execute( Close {} );
-      test.execute( ReadAll { "o" } );
-      test.execute( IsClosed { true } );
-      test.execute( IsFinished { true } );
-      test.execute( HasError { false } );
-      test.execute( BytesBuffered { 0 } );
-      test.execute( AvailableCapacity { 15 } );
-      test.execute( BytesPushed { 5 } );
-      test.execute( BytesPopped { 5 } );
-    }
+  {
+    Harness test { "okay to call close more than once", 15 };
+    test.execute( Push { "hello" } );
+    test.execute( Close {} );
+    test.execute( Close {} );
+    test.execute( Close {} );
+    test.execute( IsClosed { true } );
+    test.execute( IsFinished { false } );
+    test.execute( Peek { "hello" } );
+    test.execute( Pop { 4 } );
+    test.execute( IsClosed { true } );
+    test.execute( IsFinished { false } );
+    test.execute( Close {} );
+    test.execute( ReadAll { "o" } );
+    test.execute( IsClosed { true } );
+    test.execute( IsFinished { true } );
+    test.execute( HasError { false } );
+    test.execute( BytesBuffered { 0 } );
+    test.execute( AvailableCapacity { 15 } );
+    test.execute( BytesPushed { 5 } );
+    test.execute( BytesPopped { 5 } );
+  }
+}
+
+int main()
+{
+  try {
+    program_body<ByteStreamTestHarness>();
+    program_body<StaticByteStreamTestHarness>();
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
     return EXIT_FAILURE;
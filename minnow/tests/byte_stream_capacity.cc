@@ -5,97 +5,103 @@
 
 using namespace std;
 
-int main()
+template<class Harness>
+void program_body()
 {
-  try {
-    {
-      ByteStreamTestHarness test { "overwrite", 2 };
+  {
+    Harness test { "overwrite", 2 };
 
-      test.execute( Push { "cat" } );
-      test.execute( IsClosed { false } );
-      test.execute( BufferEmpty { false } );
-      test.execute( IsFinished { false } );
-      test.execute( BytesPopped { 0 } );
-      test.execute( BytesPushed { 2 } );
-      test.execute( AvailableCapacity { 0 } );
-      test.execute( BytesBuffered { 2 } );
-      test.execute( Peek { "ca" } );
+    test.execute( Push { "cat" } );
+    test.execute( IsClosed { false } );
+    test.execute( BufferEmpty { false } );
+    test.execute( IsFinished { false } );
+    test.execute( BytesPopped { 0 } );
+    test.execute( BytesPushed { 2 } );
+    test.execute( AvailableCapacity { 0 } );
+    test.execute( BytesBuffered { 2 } );
+    test.execute( Peek { "ca" } );
 
-      test.execute( Push { "t" } );
+    test.execute( Push { "t" } );
 
-      test.execute( IsClosed { false } );
-      test.execute( BufferEmpty { false } );
-      test.execute( IsFinished { false } );
-      test.execute( BytesPopped { 0 } );
-      test.execute( BytesPushed { 2 } );
-      test.execute( AvailableCapacity { 0 } );
-      test.execute( BytesBuffered { 2 } );
-      test.execute( Peek { "ca" } );
-    }
+    test.execute( IsClosed { false } );
+    test.execute( BufferEmpty { false } );
+    test.execute( IsFinished { false } );
+    test.execute( BytesPopped { 0 } );
+    test.execute( BytesPushed { 2 } );
+    test.execute( AvailableCapacity { 0 } );
+    test.execute( BytesBuffered { 2 } );
+    test.execute( Peek { "ca" } );
+  }
 
-    {
-      ByteStreamTestHarness test { "overwrite-clear-overwrite", 2 };
+  {
+    Harness test { "overwrite-clear-overwrite", 2 };
 
-      test.execute( Push { "cat" } );
-      test.execute( BytesPushed { 2 } );
-      test.execute( Pop { 2 } );
-      test.execute( Push { "tac" } );
+    test.execute( Push { "cat" } );
+    test.execute( BytesPushed { 2 } );
+    test.execute( Pop { 2 } );
+    test.execute( Push { "tac" } );
 
-      test.execute( IsClosed { false } );
-      test.execute( BufferEmpty { false } );
-      test.execute( IsFinished { false } );
-      test.execute( BytesPopped { 2 } );
-      test.execute( BytesPushed { 4 } );
-      test.execute( AvailableCapacity { 0 } );
-      test.execute( BytesBuffered { 2 } );
-      test.execute( Peek { "ta" } );
-    }
+    test.execute( IsClosed { false } );
+    test.execute( BufferEmpty { false } );
+    test.execute( IsFinished { false } );
+    test.execute( BytesPopped { 2 } );
+    test.execute( BytesPushed { 4 } );
+    test.execute( AvailableCapacity { 0 } );
+    test.execute( BytesBuffered { 2 } );
+    test.execute( Peek { "ta" } );
+  }
 
-    {
-      ByteStreamTestHarness test { "overwrite-pop-overwrite", 2 };
+  {
+    Harness test { "overwrite-pop-overwrite", 2 };
 
-      test.execute( Push { "cat" } );
-      test.execute( BytesPushed { 2 } );
-      test.execute( Pop { 1 } );
-      test.execute( Push { "tac" } );
+    test.execute( Push { "cat" } );
+    test.execute( BytesPushed { 2 } );
+    test.execute( Pop { 1 } );
+    test.execute( Push { "tac" } );
 
-      test.execute( IsClosed { false } );
-      test.execute( BufferEmpty { false } );
-      test.execute( IsFinished { false } );
-      test.execute( BytesPopped { 1 } );
-      test.execute( BytesPushed { 3 } );
-      test.execute( AvailableCapacity { 0 } );
-      test.execute( BytesBuffered { 2 } );
-      test.execute( Peek { "at" } );
-    }
+    test.execute( IsClosed { false } );
+    test.execute( BufferEmpty { false } );
+    test.execute( IsFinished { false } );
+    test.execute( BytesPopped { 1 } );
+    test.execute( BytesPushed { 3 } );
+    test.execute( AvailableCapacity { 0 } );
+    test.execute( BytesBuffered { 2 } );
+    test.execute( Peek { "at" } );
+  }
 
-    {
-      ByteStreamTestHarness test { "peeks", 2 };
-      test.execute( Push { "" } );
-      test.execute( Push { "" } );
-      test.execute( Push { "" } );
-      test.execute( Push { "" } );
-      test.execute( Push { "" } );
-      test.execute( Push { "cat" } );
-      test.execute( Push { "" } );
-      test.execute( Push { "" } );
-      test.execute( Push { "" } );
-      test.execute( Push { "" } );
-      test.execute( Push { "" } );
-      test.execute( Peek { "ca" } );
-      test.execute( Peek { "ca" } );
-      test.execute( BytesBuffered { 2 } );
-      test.execute( Peek { "ca" } );
-      test.execute( Peek { "ca" } );
-      test.execute( Pop { 1 } );
-      test.execute( Push { "" } );
-      test.execute( Push { "" } );
-      test.execute( Push { "" } );
-      test.execute( Peek { "a" } );
-      test.execute( Peek { "a" } );
-      test.execute( BytesBuffered { 1 } );
-    }
+  {
+    Harness test { "peeks", 2 };
+    test.execute( Push { "" } );
+    test.execute( Push { "" } );
+    test.execute( Push { "" } );
+    test.execute( Push { "" } );
+    test.execute( Push { "" } );
+    test.execute( Push { "cat" } );
+    test.execute( Push { "" } );
+    test.execute( Push { "" } );
+    test.execute( Push { "" } );
+    test.execute( Push { "" } );
+    test.execute( Push { "" } );
+    test.execute( Peek { "ca" } );
+    test.execute( Peek { "ca" } );
+    test.execute( BytesBuffered { 2 } );
+    test.execute( Peek { "ca" } );
+    test.execute( Peek { "ca" } );
+    test.execute( Pop { 1 } );
+    test.execute( Push { "" } );
+    test.execute( Push { "" } );
+    test.execute( Push { "" } );
+    test.execute( Peek { "a" } );
+    test.execute( Peek { "a" } );
+    test.execute( BytesBuffered { 1 } );
+  }
+}
 
+int main()
+{
+  try {
+    program_body<ByteStreamTestHarness>();
+    program_body<StaticByteStreamTestHarness>();
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
     return EXIT_FAILURE;
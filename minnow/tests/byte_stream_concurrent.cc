@@ -0,0 +1,136 @@
+#include "concurrent_byte_stream.hh"
+
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "ConcurrentByteStream: " + what );
+  }
+}
+
+// Exercise the single-threaded semantics, which should match ByteStream's
+void basics()
+{
+  ConcurrentByteStream bs { 5 };
+
+  bs.writer().push( "hello world" );
+  expect( bs.writer().bytes_pushed() == 5, "push should be limited by capacity" );
+  expect( bs.writer().available_capacity() == 0, "stream should be full" );
+  expect( bs.reader().peek() == "hello", "peek should return the pushed bytes" );
+
+  bs.reader().pop( 3 );
+  bs.writer().push( "abc" );
+  expect( bs.reader().bytes_buffered() == 5, "bytes_buffered after wrap-around" );
+
+  string got;
+  while ( bs.reader().bytes_buffered() ) {
+    const auto view = bs.reader().peek();
+    expect( not view.empty(), "peek returned empty view with bytes buffered" );
+    got += view;
+    bs.reader().pop( view.size() );
+  }
+  expect( got == "loabc", "wrapped data should read back in order" );
+
+  bs.writer().close();
+  bs.writer().push( "x" );
+  expect( bs.reader().is_finished(), "closed, empty stream should be finished" );
+  expect( bs.reader().bytes_popped() == 8, "bytes_popped" );
+}
+
+// The ByteStream Reader helpers take a ConcurrentByteStream's Reader, and see past the ring's wrap-around
+void helpers()
+{
+  ConcurrentByteStream bs { 8 };
+  bs.writer().push( "abcdef" );
+  bs.reader().pop( 4 );
+  bs.writer().push( "ghijkl" ); // wraps around: "efgh" at the ring's end, "ijkl" at its start
+
+  array<string_view, 4> views;
+  expect( bs.reader().peek_buffers( views ) == 2 and views[0] == "efgh" and views[1] == "ijkl",
+          "peek_buffers should return both sides of the wrap-around" );
+
+  string out;
+  read( bs.reader(), 3, out );
+  expect( out == "efg", "read() should pop from the front" );
+
+  array<char, 4> buffer {};
+  expect( read_into( bs.reader(), buffer ) == 4 and string_view { buffer.data(), 4 } == "hijk",
+          "read_into() should copy across the wrap-around" );
+
+  bs.writer().push( "mnopqrs" );
+  auto [from, to] = FileDescriptor::make_pipe();
+  expect( drain( bs.reader(), to ) == 8, "drain() should write everything buffered" );
+  string written;
+  from.read( written );
+  expect( written == "lmnopqrs" and bs.reader().bytes_buffered() == 0, "drain() should write in order" );
+}
+
+// One thread pushes random-sized segments while another pops random-sized pieces
+void threaded( size_t input_len, size_t capacity, bool with_wakeup )
+{
+  default_random_engine rd { 144 };
+  const string data = [&] {
+    uniform_int_distribution<char> ud;
+    string ret;
+    for ( size_t i = 0; i < input_len; ++i ) {
+      ret += ud( rd );
+    }
+    return ret;
+  }();
+
+  ConcurrentByteStream bs { capacity, with_wakeup };
+
+  thread producer { [&] {
+    default_random_engine prd { 789 };
+    uniform_int_distribution<size_t> len_dist { 1, 2 * capacity };
+    size_t pushed = 0;
+    while ( pushed < data.size() ) {
+      if ( with_wakeup ) {
+        bs.writer().wait();
+      }
+      bs.writer().push( string_view { data }.substr( pushed, len_dist( prd ) ) );
+      pushed = bs.writer().bytes_pushed();
+    }
+    bs.writer().close();
+  } };
+
+  string output;
+  output.reserve( data.size() );
+  uniform_int_distribution<size_t> read_dist { 1, capacity };
+  while ( not bs.reader().is_finished() ) {
+    if ( with_wakeup ) {
+      bs.reader().wait();
+    }
+    const auto view = bs.reader().peek().substr( 0, read_dist( rd ) );
+    output += view;
+    bs.reader().pop( view.size() );
+  }
+
+  producer.join();
+  expect( output == data, "data read in the consumer thread should match data written in the producer" );
+}
+
+int main()
+{
+  try {
+    basics();
+    helpers();
+    threaded( 1 << 18, 1500, false );
+    threaded( 1 << 20, 4096, true );
+    threaded( 1 << 16, 7, true );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
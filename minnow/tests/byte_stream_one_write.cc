@@ -5,127 +5,133 @@
 
 using namespace std;
 
+template<class Harness>
+void program_body()
+{
+  {
+    Harness test { "write-end-pop", 15 };
+
+    test.execute( Push { "cat" } );
+
+    test.execute( IsClosed { false } );
+    test.execute( BufferEmpty { false } );
+    test.execute( IsFinished { false } );
+    test.execute( BytesPopped { 0 } );
+    test.execute( BytesPushed { 3 } );
+    test.execute( AvailableCapacity { 12 } );
+    test.execute( BytesBuffered { 3 } );
+    test.execute( Peek { "cat" } );
+
+    test.execute( Close {} );
+
+    test.execute( IsClosed { true } );
+    test.execute( BufferEmpty { false } );
+    test.execute( IsFinished { false } );
+    test.execute( BytesPopped { 0 } );
+    test.execute( BytesPushed { 3 } );
+    test.execute( AvailableCapacity { 12 } );
+    test.execute( BytesBuffered { 3 } );
+    test.execute( Peek { "cat" } );
+
+    test.execute( Pop { 3 } );
+
+    test.execute( IsClosed { true } );
+    test.execute( BufferEmpty { true } );
+    test.execute( IsFinished { true } );
+    test.execute( BytesPopped { 3 } );
+    test.execute( BytesPushed { 3 } );
+    test.execute( AvailableCapacity { 15 } );
+    test.execute( BytesBuffered { 0 } );
+  }
+
+  {
+    Harness test { "write-pop-end", 15 };
+
+    test.execute( Push { "cat" } );
+
+    test.execute( IsClosed { false } );
+    test.execute( BufferEmpty { false } );
+    test.execute( IsFinished { false } );
+    test.execute( BytesPopped { 0 } );
+    test.execute( BytesPushed { 3 } );
+    test.execute( AvailableCapacity { 12 } );
+    test.execute( BytesBuffered { 3 } );
+    test.execute( Peek { "cat" } );
+
+    test.execute( Pop { 3 } );
+
+    test.execute( IsClosed { false } );
+    test.execute( BufferEmpty { true } );
+    test.execute( IsFinished { false } );
+    test.execute( BytesPopped { 3 } );
+    test.execute( BytesPushed { 3 } );
+    test.execute( AvailableCapacity { 15 } );
+    test.execute( BytesBuffered { 0 } );
+
+    test.execute( Close {} );
+
+    test.execute( IsClosed { true } );
+    test.execute( BufferEmpty { true } );
+    test.execute( IsFinished { true } );
+    test.execute( BytesPopped { 3 } );
+    test.execute( BytesPushed { 3 } );
+    test.execute( AvailableCapacity { 15 } );
+    test.execute( BytesBuffered { 0 } );
+    test.execute( Peek { "" } );
+  }
+
+  {
+    Harness test { "write-pop2-end", 15 };
+
+    test.execute( Push { "cat" } );
+
+    test.execute( IsClosed { false } );
+    test.execute( BufferEmpty { false } );
+    test.execute( IsFinished { false } );
+    test.execute( BytesPopped { 0 } );
+    test.execute( BytesPushed { 3 } );
+    test.execute( AvailableCapacity { 12 } );
+    test.execute( BytesBuffered { 3 } );
+    test.execute( Peek { "cat" } );
+
+    test.execute( Pop { 1 } );
+
+    test.execute( IsClosed { false } );
+    test.execute( BufferEmpty { false } );
+    test.execute( IsFinished { false } );
+    test.execute( BytesPopped { 1 } );
+    test.execute( BytesPushed { 3 } );
+    test.execute( AvailableCapacity { 13 } );
+    test.execute( BytesBuffered { 2 } );
+    test.execute( Peek { "at" } );
+
+    test.execute( Pop { 2 } );
+
+    test.execute( IsClosed { false } );
+    test.execute( BufferEmpty { true } );
+    test.execute( IsFinished { false } );
+    test.execute( BytesPopped { 3 } );
+    test.execute( BytesPushed { 3 } );
+    test.execute( AvailableCapacity { 15 } );
+    test.execute( BytesBuffered { 0 } );
+
+    test.execute( Close {} );
+
+    test.execute( IsClosed { true } );
+    test.execute( BufferEmpty { true } );
+    test.execute( IsFinished { true } );
+    test.execute( BytesPopped { 3 } );
+    test.execute( BytesPushed { 3 } );
+    test.execute( AvailableCapacity { 15 } );
+    test.execute( BytesBuffered { 0 } );
+  }
+}
+
 int main()
 {
   try {
-    {
-      ByteStreamTestHarness test { "write-end-pop", 15 };
-
-      test.execute( Push { "cat" } );
-
-      test.execute( IsClosed { false } );
-      test.execute( BufferEmpty { false } );
-      test.execute( IsFinished { false } );
-      test.execute( BytesPopped { 0 } );
-      test.execute( BytesPushed { 3 } );
-      test.execute( AvailableCapacity { 12 } );
-      test.execute( BytesBuffered { 3 } );
-      test.execute( Peek { "cat" } );
-
-      test.execute( Close {} );
-
-      test.execute( IsClosed { true } );
-      test.execute( BufferEmpty { false } );
-      test.execute( IsFinished { false } );
-      test.execute( BytesPopped { 0 } );
-      test.execute( BytesPushed { 3 } );
-      test.execute( AvailableCapacity { 12 } );
-      test.execute( BytesBuffered { 3 } );
-      test.execute( Peek { "cat" } );
-
-      test.execute( Pop { 3 } );
-
-      test.execute( IsClosed { true } );
-      test.execute( BufferEmpty { true } );
-      test.execute( IsFinished { true } );
-      test.execute( BytesPopped { 3 } );
-      test.execute( BytesPushed { 3 } );
-      test.execute( AvailableCapacity { 15 } );
-      test.execute( BytesBuffered { 0 } );
-    }
-
-    {
-      ByteStreamTestHarness test { "write-pop-end", 15 };
-
-      test.execute( Push { "cat" } );
-
-      test.execute( IsClosed { false } );
-      test.execute( BufferEmpty { false } );
-      test.execute( IsFinished { false } );
-      test.execute( BytesPopped { 0 } );
-      test.execute( BytesPushed { 3 } );
-      test.execute( AvailableCapacity { 12 } );
-      test.execute( BytesBuffered { 3 } );
-      test.execute( Peek { "cat" } );
-
-      test.execute( Pop { 3 } );
-
-      test.execute( IsClosed { false } );
-      test.execute( BufferEmpty { true } );
-      test.execute( IsFinished { false } );
-      test.execute( BytesPopped { 3 } );
-      test.execute( BytesPushed { 3 } );
-      test.execute( AvailableCapacity { 15 } );
-      test.execute( BytesBuffered { 0 } );
-
-      test.execute( Close {} );
-
-      test.execute( IsClosed { true } );
-      test.execute( BufferEmpty { true } );
-      test.execute( IsFinished { true } );
-      test.execute( BytesPopped { 3 } );
-      test.execute( BytesPushed { 3 } );
-      test.execute( AvailableCapacity { 15 } );
-      test.execute( BytesBuffered { 0 } );
-      test.execute( Peek { "" } );
-    }
-
-    {
-      ByteStreamTestHarness test { "write-pop2-end", 15 };
-
-      test.execute( Push { "cat" } );
-
-      test.execute( IsClosed { false } );
-      test.execute( BufferEmpty { false } );
-      test.execute( IsFinished { false } );
-      test.execute( BytesPopped { 0 } );
-      test.execute( BytesPushed { 3 } );
-      test.execute( AvailableCapacity { 12 } );
-      test.execute( BytesBuffered { 3 } );
-      test.execute( Peek { "cat" } );
-
-      test.execute( Pop { 1 } );
-
-      test.execute( IsClosed { false } );
-      test.execute( BufferEmpty { false } );
-      test.execute( IsFinished { false } );
-      test.execute( BytesPopped { 1 } );
-      test.execute( BytesPushed { 3 } );
-      test.execute( AvailableCapacity { 13 } );
-      test.execute( BytesBuffered { 2 } );
-      test.execute( Peek { "at" } );
-
-      test.execute( Pop { 2 } );
-
-      test.execute( IsClosed { false } );
-      test.execute( BufferEmpty { true } );
-      test.execute( IsFinished { false } );
-      test.execute( BytesPopped { 3 } );
-      test.execute( BytesPushed { 3 } );
-      test.execute( AvailableCapacity { 15 } );
-      test.execute( BytesBuffered { 0 } );
-
-      test.execute( Close {} );
-
-      test.execute( IsClosed { true } );
-      test.execute( BufferEmpty { true } );
-      test.execute( IsFinished { true } );
-      test.execute( BytesPopped { 3 } );
-      test.execute( BytesPushed { 3 } );
-      test.execute( AvailableCapacity { 15 } );
-      test.execute( BytesBuffered { 0 } );
-    }
-
+    program_body<ByteStreamTestHarness>();
+    program_body<StaticByteStreamTestHarness>();
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
     return EXIT_FAILURE;
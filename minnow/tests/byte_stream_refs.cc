@@ -0,0 +1,110 @@
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      const string cat = "cat";
+      const string tac = "tac";
+      ByteStreamTestHarness test { "borrowed", 15 };
+
+      test.execute( PushBorrowed { cat } );
+      test.execute( PushBorrowed { tac } );
+      test.execute( BytesPushed { 6 } );
+      test.execute( AvailableCapacity { 9 } );
+      test.execute( PeekOnce { "cat" } );
+      test.execute( Peek { "cattac" } );
+      test.execute( Pop { 4 } );
+      test.execute( PeekOnce { "ac" } );
+      test.execute( Close {} );
+      test.execute( Pop { 2 } );
+      test.execute( IsFinished { true } );
+      test.execute( BytesPopped { 6 } );
+    }
+
+    {
+      const string cat = "cat";
+      ByteStreamTestHarness test { "borrowed-truncated", 2 };
+
+      test.execute( PushBorrowed { cat } );
+      test.execute( BytesPushed { 2 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Peek { "ca" } );
+      test.execute( Pop { 2 } );
+      test.execute( PushBorrowed { cat } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( Peek { "ca" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "batch", 8 };
+
+      test.execute( PushBatch { { "cat", "", "tac" } } );
+      test.execute( BytesPushed { 6 } );
+      test.execute( AvailableCapacity { 2 } );
+      test.execute( PeekOnce { "cat" } );
+      test.execute( Pop { 3 } );
+      test.execute( PeekOnce { "tac" } );
+      test.execute( PushBatch { { "abc", "def", "ghi" } } );
+      test.execute( BytesPushed { 11 } );
+      test.execute( AvailableCapacity { 0 } );
+      test.execute( Peek { "tacabcde" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "peek_buffers", 20 };
+
+      test.execute( PeekBuffers { {}, 4 } );
+      test.execute( PushBatch { { "cat", "tac", "abc" } } );
+      test.execute( PeekBuffers { { "cat", "tac", "abc" }, 4 } );
+      test.execute( PeekBuffers { { "cat", "tac" }, 2 } );
+      test.execute( PeekBuffers { {}, 0 } );
+      test.execute( Pop { 1 } );
+      test.execute( PeekBuffers { { "at", "tac", "abc" }, 3 } );
+      test.execute( Pop { 4 } );
+      test.execute( PeekBuffers { { "c", "abc" }, 3 } );
+      test.execute( Push { "defghijklmnopqrstu" } );
+      test.execute( PeekBuffers { { "c", "abc", "defghijklmnopqrs" }, 3 } );
+    }
+
+    {
+      const string world = "world";
+      ByteStreamTestHarness test { "mixed", 20 };
+
+      test.execute( Push { "hello " } );
+      test.execute( PushBorrowed { world } );
+      test.execute( PushBatch { { "!", "?" } } );
+      test.execute( BytesBuffered { 13 } );
+      test.execute( Peek { "hello world!?" } );
+      test.execute( ReadAll { "hello world!?" } );
+      test.execute( BytesPopped { 13 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "read_into", 20 };
+
+      test.execute( ReadInto { "", 4 } );
+      test.execute( PushBatch { { "cat", "tac", "abc" } } );
+      test.execute( ReadInto { "catt", 4 } );
+      test.execute( BytesPopped { 4 } );
+      test.execute( ReadInto { "", 0 } );
+      test.execute( PeekOnce { "ac" } );
+      test.execute( ReadInto { "acabc", 10 } );
+      test.execute( BufferEmpty { true } );
+      test.execute( Push { "x" } );
+      test.execute( PushBatch { { "y", "z" } } );
+      test.execute( ReadAll { "xyz" } );
+      test.execute( BytesPopped { 12 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -1,34 +1,21 @@
 #include "byte_stream.hh"
+#include "speed_harness.hh"
 
-#include <chrono>
 #include <cstddef>
-#include <fstream>
-#include <iomanip>
 #include <iostream>
 #include <queue>
 #include <random>
+#include <stdexcept>
+#include <string>
 
 using namespace std;
-using namespace std::chrono;
 
-double speed_test( fstream& debug_output,
-                   const size_t input_len,   // NOLINT(bugprone-easily-swappable-parameters)
-                   const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
-                   const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
-                   const size_t write_size,  // NOLINT(bugprone-easily-swappable-parameters)
-                   const size_t read_size )  // NOLINT(bugprone-easily-swappable-parameters)
+void speed_test( BenchmarkSuite& suite,
+                 const string& data,
+                 const size_t capacity,   // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t write_size, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t read_size ) // NOLINT(bugprone-easily-swappable-parameters)
 {
-  // Generate the data to be written
-  const string data = [&random_seed, &input_len] {
-    default_random_engine rd { random_seed };
-    uniform_int_distribution<char> ud;
-    string ret;
-    for ( size_t i = 0; i < input_len; ++i ) {
-      ret += ud( rd );
-    }
-    return ret;
-  }();
-
   // Split the data into segments before writing
   queue<string> split_data;
   for ( size_t i = 0; i < data.size(); i += write_size ) {
@@ -39,7 +26,11 @@ double speed_test( fstream& debug_output,
   string output_data;
   output_data.reserve( data.size() );
 
-  const auto start_time = steady_clock::now();
+  Benchmark benchmark { "ByteStream",
+                        { { "capacity", to_string( capacity ) },
+                          { "write_size", to_string( write_size ) },
+                          { "read_size", to_string( read_size ) } } };
+  benchmark.start();
   while ( not bs.reader().is_finished() ) {
     if ( split_data.empty() ) {
       if ( not bs.writer().is_closed() ) {
@@ -59,49 +50,47 @@ double speed_test( fstream& debug_output,
       }
       output_data += peeked;
       bs.reader().pop( peeked.size() );
+      benchmark.op( peeked.size() );
     }
   }
-
-  const auto stop_time = steady_clock::now();
+  const BenchmarkResult& result = suite.record( benchmark.finish() );
 
   if ( data != output_data ) {
     throw runtime_error( "Mismatch between data written and read" );
   }
 
-  auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
-  auto bytes_per_second = static_cast<double>( input_len ) / test_duration.count();
-  auto bits_per_second = 8 * bytes_per_second;
-  auto gigabits_per_second = bits_per_second / 1e9;
-
-  cout << "ByteStream with capacity=" << capacity << ", write_size=" << write_size << ", read_size=" << read_size
-       << " reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
-
-  auto read_s = to_string( read_size );
-  string fill( 5 - read_s.size(), ' ' );
-  debug_output << "        ByteStream throughput (pop length " << read_s << "):" << fill << fixed
-               << setprecision( 2 ) << setw( 5 ) << gigabits_per_second << " Gbit/s\n";
-
-  if ( gigabits_per_second < 0.1 ) {
+  if ( result.gigabits_per_second() < 0.1 ) {
     throw runtime_error( "ByteStream did not meet minimum speed of 0.1 Gbit/s" );
   }
-
-  return gigabits_per_second;
 }
 
-void program_body()
+void program_body( BenchmarkSuite& suite )
 {
-  fstream debug_output;
-  debug_output.open( "/dev/tty" );
+  // Generate the data to be written
+  default_random_engine rd { 789 };
+  string data( 10'000'000, 0 );
+  for ( auto& c : data ) {
+    c = static_cast<char>( rd() );
+  }
 
-  speed_test( debug_output, 1e7, 32768, 789, 1500, 4096 );
-  speed_test( debug_output, 1e7, 32768, 789, 1500, 128 );
-  speed_test( debug_output, 1e7, 32768, 789, 1500, 32 );
+  for ( const size_t capacity : { 4096, 32768, 262144 } ) {
+    for ( const size_t write_size : { 128, 1500, 16384 } ) {
+      if ( write_size > capacity ) {
+        continue; // each write is pushed whole, so it has to fit
+      }
+      for ( const size_t read_size : { 32, 128, 4096 } ) {
+        speed_test( suite, data, capacity, write_size, read_size );
+      }
+    }
+  }
 }
 
-int main()
+int main( int argc, char* argv[] )
 {
   try {
-    program_body();
+    BenchmarkSuite suite { "byte_stream", argc, argv };
+    program_body( suite );
+    suite.report();
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
     return EXIT_FAILURE;
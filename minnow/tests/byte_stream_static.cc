@@ -0,0 +1,100 @@
+#include "byte_stream.hh"
+#include "helpers.hh"
+#include "static_byte_stream.hh"
+
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// Drive a ByteStream and a StaticByteStream<N> with the same random operations,
+// and check that every observable property of the two matches after each step.
+template<uint64_t N>
+void differential_test( const size_t steps, const size_t random_seed )
+{
+  default_random_engine rd { random_seed };
+  ByteStream reference { N };
+  StaticByteStream<N> bs;
+
+  auto check = [&]( const string& what ) {
+    const string where = "StaticByteStream<" + to_string( N ) + "> after " + what + ": ";
+    if ( bs.writer().bytes_pushed() != reference.writer().bytes_pushed() ) {
+      throw runtime_error( where + "bytes_pushed mismatch" );
+    }
+    if ( bs.writer().available_capacity() != reference.writer().available_capacity() ) {
+      throw runtime_error( where + "available_capacity mismatch" );
+    }
+    if ( bs.reader().bytes_buffered() != reference.reader().bytes_buffered() ) {
+      throw runtime_error( where + "bytes_buffered mismatch" );
+    }
+    if ( bs.reader().bytes_popped() != reference.reader().bytes_popped() ) {
+      throw runtime_error( where + "bytes_popped mismatch" );
+    }
+    if ( bs.writer().is_closed() != reference.writer().is_closed()
+         or bs.reader().is_finished() != reference.reader().is_finished() ) {
+      throw runtime_error( where + "is_closed/is_finished mismatch" );
+    }
+    if ( bs.reader().bytes_buffered() and bs.reader().peek().empty() ) {
+      throw runtime_error( where + "peek() returned an empty view" );
+    }
+
+    // the whole buffered contents (through peek_buffers) must match
+    array<string_view, 4> views;
+    const auto count = bs.reader().peek_buffers( views );
+    if ( count > 2 or views[0] != bs.reader().peek() ) {
+      throw runtime_error( where + "peek_buffers() disagrees with peek()" );
+    }
+    ByteStream copy = reference;
+    string expected;
+    read( copy.reader(), copy.reader().bytes_buffered(), expected );
+    if ( concat( span { views.data(), count } ) != expected ) {
+      throw runtime_error( where + "buffered contents mismatch" );
+    }
+  };
+
+  uniform_int_distribution<size_t> len_dist { 0, 2 * N + 1 };
+  uniform_int_distribution<char> char_dist;
+  for ( size_t i = 0; i < steps; ++i ) {
+    string data( len_dist( rd ), 0 );
+    for ( auto& ch : data ) {
+      ch = char_dist( rd );
+    }
+    bs.writer().push( data );
+    reference.writer().push( data );
+    check( "push of " + to_string( data.size() ) );
+
+    const size_t len = len_dist( rd );
+    bs.reader().pop( len );
+    reference.reader().pop( len );
+    check( "pop of " + to_string( len ) );
+  }
+
+  bs.writer().close();
+  reference.writer().close();
+  bs.writer().push( "x" );
+  reference.writer().push( "x" );
+  check( "close" );
+  bs.reader().pop( N );
+  reference.reader().pop( N );
+  check( "final pop" );
+}
+
+int main()
+{
+  try {
+    differential_test<1>( 1000, 1 );
+    differential_test<2>( 1000, 2 );
+    differential_test<15>( 1000, 15 );
+    differential_test<16>( 1000, 16 );
+    differential_test<4096>( 200, 4096 );
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
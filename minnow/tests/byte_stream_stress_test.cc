@@ -5,6 +5,7 @@
 
 using namespace std;
 
+template<class Harness>
 void stress_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable-parameters)
                   const size_t capacity,     // NOLINT(bugprone-easily-swappable-parameters)
                   const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
@@ -20,8 +21,7 @@ void stress_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable
     return ret;
   }();
 
-  ByteStreamTestHarness bs { "stress test input=" + to_string( input_len ) + ", capacity=" + to_string( capacity ),
-                             capacity };
+  Harness bs { "stress test input=" + to_string( input_len ) + ", capacity=" + to_string( capacity ), capacity };
   if ( bs.skipped() ) {
     return;
   }
@@ -73,18 +73,20 @@ void stress_test( const size_t input_len,    // NOLINT(bugprone-easily-swappable
   bs.execute( IsFinished { true } );
 }
 
+template<class Harness>
 void program_body()
 {
-  stress_test( 19, 3, 10110 );
-  stress_test( 18, 17, 12345 );
-  stress_test( 1111, 17, 98765 );
-  stress_test( 4097, 4096, 11101 );
+  stress_test<Harness>( 19, 3, 10110 );
+  stress_test<Harness>( 18, 17, 12345 );
+  stress_test<Harness>( 1111, 17, 98765 );
+  stress_test<Harness>( 4097, 4096, 11101 );
 }
 
 int main()
 {
   try {
-    program_body();
+    program_body<ByteStreamTestHarness>();
+    program_body<StaticByteStreamTestHarness>();
   } catch ( const exception& e ) {
     cerr << "Exception: " << e.what() << "\n";
     return EXIT_FAILURE;
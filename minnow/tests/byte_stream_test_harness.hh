@@ -3,8 +3,14 @@
 #include "byte_stream.hh"
 #include "common.hh"
 #include "helpers.hh"
+#include "static_byte_stream.hh"
 
+#include <algorithm>
+#include <concepts>
+#include <functional>
+#include <stdexcept>
 #include <utility>
+#include <variant>
 
 static_assert( sizeof( Reader ) == sizeof( ByteStream ),
                "Please add member variables to the ByteStream base, not the ByteStream Reader." );
@@ -22,6 +28,73 @@ public:
   size_t peek_size() { return object().reader().peek().size(); }
 };
 
+// A StaticByteStream at each capacity the byte_stream tests use (its capacity is a template parameter, so the
+// harness picks the instantiation at run time)
+struct AnyStaticByteStream
+{
+  std::variant<StaticByteStream<2>,
+               StaticByteStream<3>,
+               StaticByteStream<15>,
+               StaticByteStream<17>,
+               StaticByteStream<4096>,
+               StaticByteStream<200000>>
+    stream;
+};
+
+template<size_t I = 0>
+AnyStaticByteStream make_static_byte_stream( uint64_t capacity )
+{
+  using Streams = decltype( AnyStaticByteStream::stream );
+  if constexpr ( I == std::variant_size_v<Streams> ) {
+    throw std::runtime_error( "no StaticByteStream with capacity " + std::to_string( capacity ) + " is tested" );
+  } else {
+    using Stream = std::variant_alternative_t<I, Streams>;
+    if ( Stream::capacity() == capacity ) {
+      return AnyStaticByteStream { Stream {} };
+    }
+    return make_static_byte_stream<I + 1>( capacity );
+  }
+}
+
+// A ByteStream test step, run against a StaticByteStream (through the step's apply(), which takes either stream)
+template<class T>
+struct StaticByteStreamTestStep : public TestStep<AnyStaticByteStream>
+{
+  T step_;
+
+  explicit StaticByteStreamTestStep( T step ) : step_( std::move( step ) ) {}
+  std::string str() const override { return step_.str(); }
+  uint8_t color() const override { return step_.color(); }
+  void execute( AnyStaticByteStream& bs ) const override
+  {
+    std::visit( [this]( auto& stream ) { step_.apply( stream ); }, bs.stream );
+  }
+  constexpr std::string obj() const override { return step_.obj(); }
+};
+
+// Runs the same steps as ByteStreamTestHarness (all but the ByteStream-only ones: refs, batches and watermarks),
+// so the two streams are held to the same behaviour.
+class StaticByteStreamTestHarness : public TestHarness<AnyStaticByteStream>
+{
+public:
+  StaticByteStreamTestHarness( std::string test_name, uint64_t capacity )
+    : TestHarness( move( test_name ),
+                   "StaticByteStream<" + std::to_string( capacity ) + ">",
+                   make_static_byte_stream( capacity ) )
+  {}
+
+  template<std::derived_from<TestStep<ByteStream>> T>
+  void execute( const T& step )
+  {
+    TestHarness::execute( StaticByteStreamTestStep<T> { step } );
+  }
+
+  size_t peek_size()
+  {
+    return std::visit( []( const auto& bs ) { return bs.reader().peek().size(); }, object().stream );
+  }
+};
+
 /* actions */
 
 struct Push : public Action<ByteStream>
@@ -30,21 +103,79 @@ struct Push : public Action<ByteStream>
 
   explicit Push( std::string data ) : data_( move( data ) ) {}
   std::string description() const override { return "push \"" + pretty_print( data_ ) + "\" to the stream"; }
-  void execute( ByteStream& bs ) const override { bs.writer().push( data_ ); }
+  void execute( ByteStream& bs ) const override { apply( bs ); }
+  void apply( auto& bs ) const { bs.writer().push( data_ ); }
+  constexpr std::string obj() const override { return "Writer"; }
+};
+
+// The borrowed string is not owned by the action, and must outlive the test.
+struct PushBorrowed : public Action<ByteStream>
+{
+  std::reference_wrapper<const std::string> data_;
+
+  explicit PushBorrowed( const std::string& data ) : data_( data ) {}
+  std::string description() const override { return "push borrowed \"" + pretty_print( data_.get() ) + "\""; }
+  void execute( ByteStream& bs ) const override { bs.writer().push( Ref<std::string>::borrow( data_ ) ); }
+  constexpr std::string obj() const override { return "Writer"; }
+};
+
+struct PushBatch : public Action<ByteStream>
+{
+  std::vector<std::string> data_;
+
+  explicit PushBatch( std::vector<std::string> data ) : data_( move( data ) ) {}
+  std::string description() const override
+  {
+    std::string ret = "push batch [";
+    for ( const auto& x : data_ ) {
+      ret += " \"" + pretty_print( x ) + "\"";
+    }
+    return ret + " ]";
+  }
+  void execute( ByteStream& bs ) const override
+  {
+    std::vector<Ref<std::string>> batch;
+    for ( auto x : data_ ) {
+      batch.emplace_back( move( x ) );
+    }
+    bs.writer().push( move( batch ) );
+  }
   constexpr std::string obj() const override { return "Writer"; }
 };
 
 struct Close : public Action<ByteStream>
 {
   std::string description() const override { return "close"; }
-  void execute( ByteStream& bs ) const override { bs.writer().close(); }
+  void execute( ByteStream& bs ) const override { apply( bs ); }
+  void apply( auto& bs ) const { bs.writer().close(); }
   constexpr std::string obj() const override { return "Writer"; }
 };
 
 struct SetError : public Action<ByteStream>
 {
   std::string description() const override { return "set_error"; }
-  void execute( ByteStream& bs ) const override { bs.set_error(); }
+  void execute( ByteStream& bs ) const override { apply( bs ); }
+  void apply( auto& bs ) const { bs.set_error(); }
+};
+
+struct SetWatermarks : public Action<ByteStream>
+{
+  uint64_t low_;
+  uint64_t high_;
+
+  SetWatermarks( uint64_t low, uint64_t high ) : low_( low ), high_( high ) {}
+  std::string description() const override
+  {
+    return "set_watermarks( " + std::to_string( low_ ) + ", " + std::to_string( high_ ) + " )";
+  }
+  void execute( ByteStream& bs ) const override { bs.set_watermarks( low_, high_ ); }
+};
+
+struct Flush : public Action<ByteStream>
+{
+  std::string description() const override { return "flush"; }
+  void execute( ByteStream& bs ) const override { bs.writer().flush(); }
+  constexpr std::string obj() const override { return "Writer"; }
 };
 
 struct Pop : public Action<ByteStream>
@@ -53,12 +184,29 @@ struct Pop : public Action<ByteStream>
 
   explicit Pop( size_t len ) : len_( len ) {}
   std::string description() const override { return "pop( " + std::to_string( len_ ) + " )"; }
-  void execute( ByteStream& bs ) const override { bs.reader().pop( len_ ); }
+  void execute( ByteStream& bs ) const override { apply( bs ); }
+  void apply( auto& bs ) const { bs.reader().pop( len_ ); }
   constexpr std::string obj() const override { return "Reader"; }
 };
 
 /* expectations */
 
+// An ExpectNumber that either stream can meet: Step::get() reads the property from a ByteStream or StaticByteStream
+template<class Step, typename Num>
+struct ExpectStreamNumber : public ExpectNumber<ByteStream, Num>
+{
+  using ExpectNumber<ByteStream, Num>::ExpectNumber;
+  Num value( const ByteStream& bs ) const override { return Step::get( bs ); }
+
+  void apply( const auto& bs ) const
+  {
+    const Num result { Step::get( bs ) };
+    if ( result != this->value_ ) {
+      throw ExpectationViolation { this->name(), this->value_, result };
+    }
+  }
+};
+
 struct Peek : public Expectation<ByteStream>
 {
   std::string output_;
@@ -70,9 +218,11 @@ struct Peek : public Expectation<ByteStream>
     return "peeking (+popping) produces \"" + pretty_print( output_ ) + "\"";
   }
 
-  void execute( const ByteStream& bs ) const override
+  void execute( const ByteStream& bs ) const override { apply( bs ); }
+
+  void apply( const auto& bs ) const
   {
-    ByteStream local_copy = bs;
+    auto local_copy = bs;
     std::string got;
 
     while ( auto bytes_buffered = local_copy.reader().bytes_buffered() ) {
@@ -109,7 +259,9 @@ struct PeekOnce : public Peek
 
   std::string description() const override { return "peek() gives exactly \"" + pretty_print( output_ ) + "\""; }
 
-  void execute( const ByteStream& bs ) const override
+  void execute( const ByteStream& bs ) const override { apply( bs ); }
+
+  void apply( const auto& bs ) const
   {
     auto peeked = bs.reader().peek();
     if ( peeked != output_ ) {
@@ -119,66 +271,121 @@ struct PeekOnce : public Peek
   }
 };
 
-struct IsClosed : public ExpectBool<ByteStream>
+struct PeekBuffers : public Expectation<ByteStream>
 {
-  using ExpectBool::ExpectBool;
+  std::vector<std::string> output_;
+  size_t max_count_;
+
+  PeekBuffers( std::vector<std::string> output, size_t max_count )
+    : output_( move( output ) ), max_count_( max_count )
+  {}
+
+  std::string description() const override
+  {
+    std::string ret = "peek_buffers(" + std::to_string( max_count_ ) + ") gives [";
+    for ( const auto& x : output_ ) {
+      ret += " \"" + pretty_print( x ) + "\"";
+    }
+    return ret + " ]";
+  }
+
+  void execute( const ByteStream& bs ) const override { apply( bs ); }
+
+  void apply( const auto& bs ) const
+  {
+    std::vector<std::string_view> views( max_count_ );
+    const size_t count = bs.reader().peek_buffers( views );
+    if ( count > max_count_ ) {
+      throw ExpectationViolation { "peek_buffers() filled in more views than it was given" };
+    }
+    views.resize( count );
+    if ( not std::ranges::equal( views, output_ ) ) {
+      throw ExpectationViolation { "peek_buffers() should have returned " + std::to_string( output_.size() )
+                                   + " segments totalling \"" + pretty_print( concat( output_ ) )
+                                   + "\", but instead returned " + std::to_string( count )
+                                   + " segments totalling \"" + pretty_print( concat( views ) ) + "\"" };
+    }
+  }
+
+  constexpr std::string obj() const override { return "Reader"; }
+};
+
+struct IsClosed : public ExpectStreamNumber<IsClosed, bool>
+{
+  using ExpectStreamNumber::ExpectStreamNumber;
   std::string name() const override { return "is_closed"; }
-  bool value( const ByteStream& bs ) const override { return bs.writer().is_closed(); }
+  static bool get( const auto& bs ) { return bs.writer().is_closed(); }
   constexpr std::string obj() const override { return "Writer"; }
 };
 
-struct IsFinished : public ExpectBool<ByteStream>
+struct IsFinished : public ExpectStreamNumber<IsFinished, bool>
 {
-  using ExpectBool::ExpectBool;
+  using ExpectStreamNumber::ExpectStreamNumber;
   std::string name() const override { return "is_finished"; }
-  bool value( const ByteStream& bs ) const override { return bs.reader().is_finished(); }
+  static bool get( const auto& bs ) { return bs.reader().is_finished(); }
   constexpr std::string obj() const override { return "Reader"; }
 };
 
-struct HasError : public ExpectBool<ByteStream>
+struct IsPaused : public ExpectBool<ByteStream>
 {
   using ExpectBool::ExpectBool;
+  std::string name() const override { return "is_paused"; }
+  bool value( const ByteStream& bs ) const override { return bs.writer().is_paused(); }
+  constexpr std::string obj() const override { return "Writer"; }
+};
+
+struct HasBatch : public ExpectBool<ByteStream>
+{
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "has_batch"; }
+  bool value( const ByteStream& bs ) const override { return bs.reader().has_batch(); }
+  constexpr std::string obj() const override { return "Reader"; }
+};
+
+struct HasError : public ExpectStreamNumber<HasError, bool>
+{
+  using ExpectStreamNumber::ExpectStreamNumber;
   std::string name() const override { return "has_error"; }
-  bool value( const ByteStream& bs ) const override { return bs.has_error(); }
+  static bool get( const auto& bs ) { return bs.has_error(); }
 };
 
-struct BytesBuffered : public ExpectNumber<ByteStream, uint64_t>
+struct BytesBuffered : public ExpectStreamNumber<BytesBuffered, uint64_t>
 {
-  using ExpectNumber::ExpectNumber;
+  using ExpectStreamNumber::ExpectStreamNumber;
   std::string name() const override { return "bytes_buffered"; }
-  size_t value( const ByteStream& bs ) const override { return bs.reader().bytes_buffered(); }
+  static uint64_t get( const auto& bs ) { return bs.reader().bytes_buffered(); }
   constexpr std::string obj() const override { return "Reader"; }
 };
 
-struct BufferEmpty : public ExpectBool<ByteStream>
+struct BufferEmpty : public ExpectStreamNumber<BufferEmpty, bool>
 {
-  using ExpectBool::ExpectBool;
+  using ExpectStreamNumber::ExpectStreamNumber;
   std::string name() const override { return "bytes_buffered() == 0 [buffer empty]"; }
-  bool value( const ByteStream& bs ) const override { return bs.reader().bytes_buffered() == 0; }
+  static bool get( const auto& bs ) { return bs.reader().bytes_buffered() == 0; }
   constexpr std::string obj() const override { return "Reader"; }
 };
 
-struct AvailableCapacity : public ExpectNumber<ByteStream, uint64_t>
+struct AvailableCapacity : public ExpectStreamNumber<AvailableCapacity, uint64_t>
 {
-  using ExpectNumber::ExpectNumber;
+  using ExpectStreamNumber::ExpectStreamNumber;
   std::string name() const override { return "available_capacity"; }
-  size_t value( const ByteStream& bs ) const override { return bs.writer().available_capacity(); }
+  static uint64_t get( const auto& bs ) { return bs.writer().available_capacity(); }
   constexpr std::string obj() const override { return "Writer"; }
 };
 
-struct BytesPushed : public ExpectNumber<ByteStream, uint64_t>
+struct BytesPushed : public ExpectStreamNumber<BytesPushed, uint64_t>
 {
-  using ExpectNumber::ExpectNumber;
+  using ExpectStreamNumber::ExpectStreamNumber;
   std::string name() const override { return "bytes_pushed"; }
-  size_t value( const ByteStream& bs ) const override { return bs.writer().bytes_pushed(); }
+  static uint64_t get( const auto& bs ) { return bs.writer().bytes_pushed(); }
   constexpr std::string obj() const override { return "Writer"; }
 };
 
-struct BytesPopped : public ExpectNumber<ByteStream, uint64_t>
+struct BytesPopped : public ExpectStreamNumber<BytesPopped, uint64_t>
 {
-  using ExpectNumber::ExpectNumber;
+  using ExpectStreamNumber::ExpectStreamNumber;
   std::string name() const override { return "bytes_popped"; }
-  size_t value( const ByteStream& bs ) const override { return bs.reader().bytes_popped(); }
+  static uint64_t get( const auto& bs ) { return bs.reader().bytes_popped(); }
   constexpr std::string obj() const override { return "Reader"; }
 };
 
@@ -197,15 +404,55 @@ struct ReadAll : public Action<ByteStream>
     return "read \"" + pretty_print( output_ ) + "\" and expect empty buffer after";
   }
 
-  void execute( ByteStream& bs ) const override
+  void execute( ByteStream& bs ) const override { apply( bs ); }
+
+  void apply( auto& bs ) const
   {
     std::string got;
-    read( bs.reader(), output_.size(), got );
+    if constexpr ( std::derived_from<std::remove_cvref_t<decltype( bs )>, ByteStream> ) {
+      read( bs.reader(), output_.size(), got );
+    } else {
+      while ( got.size() < output_.size() and bs.reader().bytes_buffered() > 0 ) {
+        const std::string_view peeked = bs.reader().peek().substr( 0, output_.size() - got.size() );
+        got += peeked;
+        bs.reader().pop( peeked.size() );
+      }
+    }
     if ( got != output_ ) {
       throw ExpectationViolation { "should have read \"" + pretty_print( output_ ) + "\", but found \""
                                    + pretty_print( got ) + "\"" };
     }
-    empty_.execute( bs );
+    empty_.apply( bs );
+  }
+
+  constexpr std::string obj() const override { return "Reader"; }
+};
+
+struct ReadInto : public Action<ByteStream>
+{
+  std::string output_;
+  size_t buffer_size_;
+
+  ReadInto( std::string output, size_t buffer_size ) : output_( move( output ) ), buffer_size_( buffer_size ) {}
+
+  std::string description() const override
+  {
+    return "read_into(" + std::to_string( buffer_size_ ) + "-byte buffer) gives \"" + pretty_print( output_ )
+           + "\"";
+  }
+
+  void execute( ByteStream& bs ) const override
+  {
+    std::string buffer( buffer_size_, '\0' );
+    const uint64_t len = read_into( bs.reader(), buffer );
+    if ( len > buffer_size_ ) {
+      throw ExpectationViolation { "read_into() claimed to read more bytes than fit in the buffer" };
+    }
+    buffer.resize( len );
+    if ( buffer != output_ ) {
+      throw ExpectationViolation { "should have read \"" + pretty_print( output_ ) + "\", but found \""
+                                   + pretty_print( buffer ) + "\"" };
+    }
   }
 
   constexpr std::string obj() const override { return "Reader"; }
@@ -0,0 +1,118 @@
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ByteStreamTestHarness test { "no watermarks", 10 };
+
+      test.execute( Push { "a" } );
+      test.execute( HasBatch { true } );
+      test.execute( Push { "bcdefghij" } );
+      test.execute( IsPaused { false } );
+      test.execute( AvailableCapacity { 0 } );
+    }
+
+    {
+      ByteStreamTestHarness test { "pause between watermarks", 20 };
+
+      test.execute( SetWatermarks { 4, 10 } );
+      test.execute( Push { "abcdefghi" } );
+      test.execute( IsPaused { false } );
+      test.execute( Push { "j" } );
+      test.execute( IsPaused { true } );
+      test.execute( AvailableCapacity { 10 } );
+      test.execute( Pop { 5 } );
+      test.execute( IsPaused { true } );
+      test.execute( Pop { 1 } );
+      test.execute( IsPaused { false } );
+      test.execute( Push { "klmnop" } );
+      test.execute( IsPaused { true } );
+      test.execute( Peek { "ghijklmnop" } );
+    }
+
+    {
+      ByteStreamTestHarness test { "batches", 20 };
+
+      test.execute( SetWatermarks { 4, 10 } );
+      test.execute( HasBatch { false } );
+      test.execute( Push { "abc" } );
+      test.execute( HasBatch { false } );
+      test.execute( Push { "d" } );
+      test.execute( HasBatch { true } );
+      test.execute( Pop { 2 } );
+      test.execute( HasBatch { true } );
+      test.execute( Push { "e" } );
+      test.execute( Pop { 2 } );
+      test.execute( HasBatch { false } );
+      test.execute( Flush {} );
+      test.execute( HasBatch { true } );
+      test.execute( Push { "f" } );
+      test.execute( Pop { 1 } );
+      test.execute( HasBatch { false } );
+      test.execute( Close {} );
+      test.execute( HasBatch { true } );
+      test.execute( Pop { 1 } );
+      test.execute( HasBatch { false } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      // a batch that was never flushed, drained in part (as by a short write), must not strand the rest
+      ByteStreamTestHarness test { "partial drain of a batch", 1 << 20 };
+
+      test.execute( SetWatermarks { 1 << 18, 1 << 20 } );
+      test.execute( Push { string( 1 << 18, 'x' ) } );
+      test.execute( HasBatch { true } );
+      test.execute( Pop { 1 << 16 } );
+      test.execute( BytesBuffered { 3 << 16 } );
+      test.execute( HasBatch { true } );
+      test.execute( IsPaused { false } );
+      test.execute( Pop { 3 << 16 } );
+      test.execute( HasBatch { false } );
+      test.execute( Push { "y" } );
+      test.execute( HasBatch { false } );
+    }
+
+    {
+      ByteStream stream { 100 };
+      vector<bool> edges;
+      stream.on_watermark( [&]( bool paused ) { edges.push_back( paused ); } );
+      stream.set_watermarks( 10, 50 );
+
+      for ( int i = 0; i < 8; ++i ) {
+        stream.writer().push( string( 10, 'x' ) );
+      }
+      while ( stream.reader().bytes_buffered() > 0 ) {
+        stream.reader().pop( 5 );
+      }
+      stream.writer().push( string( 60, 'y' ) );
+
+      if ( edges != vector<bool> { true, false, true } ) {
+        throw runtime_error( "watermark callback should be called once on each edge" );
+      }
+
+      bool threw = false;
+      try {
+        stream.set_watermarks( 20, 10 );
+      } catch ( const invalid_argument& ) {
+        threw = true;
+      }
+      if ( not threw ) {
+        throw runtime_error( "set_watermarks() should reject a low watermark above the high one" );
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+#include "checksum.hh"
+#include "ipv4_header.hh"
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+using Kernel = InternetChecksum::Kernel;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+// RFC 1071's definition, one big-endian word at a time
+uint16_t reference_checksum( string_view data )
+{
+  uint32_t sum = 0;
+  for ( size_t i = 0; i < data.size(); i += 2 ) {
+    const auto hi = static_cast<uint8_t>( data[i] );
+    const auto lo = i + 1 < data.size() ? static_cast<uint8_t>( data[i + 1] ) : uint8_t { 0 };
+    sum += ( hi << 8 ) | lo;
+    sum = ( sum & 0xffff ) + ( sum >> 16 );
+  }
+  return ~static_cast<uint16_t>( sum );
+}
+
+vector<Kernel> supported_kernels()
+{
+  vector<Kernel> kernels;
+  for ( const Kernel k : { Kernel::Scalar, Kernel::SSE2, Kernel::AVX2, Kernel::NEON } ) {
+    if ( InternetChecksum::supported( k ) ) {
+      kernels.push_back( k );
+    }
+  }
+  return kernels;
+}
+
+// the worked example from RFC 1071, section 3
+void known_values()
+{
+  const string data { "\x00\x01\xf2\x03\xf4\xf5\xf6\xf7", 8 };
+  for ( const Kernel k : supported_kernels() ) {
+    InternetChecksum sum { 0, k };
+    sum.add( data );
+    expect( sum.value() == 0x220d, "RFC 1071 example should sum to 0xddf2" );
+  }
+
+  expect( InternetChecksum().value() == 0xffff, "checksum of nothing" );
+
+  // an IPv4 header whose checksum field (0xb861) is right sums to zero
+  const string header { "\x45\x00\x00\x73\x00\x00\x40\x00\x40\x11\xb8\x61\xc0\xa8\x00\x01\xc0\xa8\x00\xc7", 20 };
+  InternetChecksum ip;
+  ip.add( header );
+  expect( ip.value() == 0, "valid IPv4 header should verify" );
+}
+
+// every kernel agrees with the reference, at every length and alignment, however the data is split
+void kernels_agree()
+{
+  default_random_engine rd { 144 };
+  string buffer( 4096 + 64, 0 );
+  for ( auto& c : buffer ) {
+    c = static_cast<char>( rd() );
+  }
+
+  for ( const Kernel k : supported_kernels() ) {
+    for ( size_t offset = 0; offset < 33; ++offset ) {
+      for ( size_t len = 0; len < 300; ++len ) {
+        const string_view data = string_view { buffer }.substr( offset, len );
+        InternetChecksum sum { 0, k };
+        sum.add( data );
+        expect( sum.value() == reference_checksum( data ), "kernel disagrees with reference" );
+      }
+    }
+
+    for ( size_t trial = 0; trial < 500; ++trial ) {
+      const string_view data = string_view { buffer }.substr( rd() % 64, rd() % 4096 );
+      vector<string_view> pieces;
+      vector<Ref<string>> owned;
+      for ( size_t pos = 0; pos < data.size(); ) {
+        const size_t len = min<size_t>( data.size() - pos, rd() % 200 );
+        pieces.push_back( data.substr( pos, len ) );
+        owned.emplace_back( string { data.substr( pos, len ) } );
+        pos += len;
+      }
+
+      InternetChecksum from_views { 0, k };
+      from_views.add( pieces );
+      InternetChecksum from_refs { 0, k };
+      from_refs.add( owned );
+      expect( from_views.value() == reference_checksum( data ), "split views disagree with reference" );
+      expect( from_refs.value() == reference_checksum( data ), "split refs disagree with reference" );
+    }
+  }
+}
+
+// RFC 1624 updates match recomputing from scratch, including the 0x0000/0xffff corner cases
+void incremental_update()
+{
+  default_random_engine rd { 1624 };
+  string header( 20, 0 );
+  for ( size_t trial = 0; trial < 10000; ++trial ) {
+    for ( auto& c : header ) {
+      c = static_cast<char>( rd() );
+    }
+    if ( trial % 4 == 0 ) {
+      header[8] = header[9] = 0; // words that are all zeros or all ones
+    } else if ( trial % 4 == 1 ) {
+      header[8] = header[9] = static_cast<char>( 0xff );
+    }
+
+    const uint16_t before = reference_checksum( header );
+    const auto old_word = static_cast<uint16_t>( ( uint8_t( header[8] ) << 8 ) | uint8_t( header[9] ) );
+    const auto new_word = static_cast<uint16_t>( trial % 3 == 0 ? ~old_word : rd() );
+    header[8] = static_cast<char>( new_word >> 8 );
+    header[9] = static_cast<char>( new_word );
+
+    const uint16_t updated = InternetChecksum::update( before, old_word, new_word );
+    const uint16_t recomputed = reference_checksum( header );
+    // 0x0000 and 0xffff are both zero in ones' complement; anything else must match exactly
+    expect( updated == recomputed or ( updated ^ recomputed ) == 0xffff, "16-bit update mismatch" );
+
+    const uint32_t old_address = rd();
+    const uint32_t new_address = rd();
+    for ( size_t i = 0; i < 4; ++i ) {
+      header[12 + i] = static_cast<char>( old_address >> ( 24 - 8 * i ) );
+    }
+    const uint16_t with_old = reference_checksum( header );
+    for ( size_t i = 0; i < 4; ++i ) {
+      header[12 + i] = static_cast<char>( new_address >> ( 24 - 8 * i ) );
+    }
+    const uint16_t updated32 = InternetChecksum::update( with_old, old_address, new_address );
+    const uint16_t recomputed32 = reference_checksum( header );
+    expect( updated32 == recomputed32 or ( updated32 ^ recomputed32 ) == 0xffff, "32-bit update mismatch" );
+  }
+}
+
+// Decrementing an IPv4 header's TTL updates its checksum as recomputing it would
+void ttl_decrement()
+{
+  default_random_engine rd { 791 };
+  for ( size_t trial = 0; trial < 1000; ++trial ) {
+    IPv4Header header;
+    header.ttl = static_cast<uint8_t>( trial % 255 + 1 );
+    header.proto = static_cast<uint8_t>( rd() );
+    header.id = static_cast<uint16_t>( rd() );
+    header.len = static_cast<uint16_t>( rd() );
+    header.src = rd();
+    header.dst = rd();
+    header.compute_checksum();
+
+    header.decrement_ttl();
+    const uint16_t updated = header.cksum;
+    header.compute_checksum();
+    expect( updated == header.cksum or ( updated ^ header.cksum ) == 0xffff, "TTL decrement checksum mismatch" );
+  }
+}
+
+int main()
+{
+  try {
+    known_values();
+    kernels_agree();
+    incremental_update();
+    ttl_decrement();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
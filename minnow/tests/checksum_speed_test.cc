@@ -0,0 +1,82 @@
+#include "checksum.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+string_view kernel_name( InternetChecksum::Kernel kernel )
+{
+  switch ( kernel ) {
+    case InternetChecksum::Kernel::Scalar:
+      return "scalar";
+    case InternetChecksum::Kernel::SSE2:
+      return "SSE2";
+    case InternetChecksum::Kernel::AVX2:
+      return "AVX2";
+    case InternetChecksum::Kernel::NEON:
+      return "NEON";
+  }
+  return "unknown";
+}
+} // namespace
+
+void speed_test( InternetChecksum::Kernel kernel, const size_t packet_len, const size_t total_len )
+{
+  default_random_engine rd { 1071 };
+  string packet( packet_len, 0 );
+  for ( auto& c : packet ) {
+    c = static_cast<char>( rd() );
+  }
+
+  uint16_t result = 0;
+  const auto start_time = steady_clock::now();
+  for ( size_t done = 0; done < total_len; done += packet_len ) {
+    InternetChecksum sum { 0, kernel };
+    sum.add( packet );
+    result ^= sum.value();
+    packet[0] = static_cast<char>( result ); // keep the compiler from hoisting the sum out of the loop
+  }
+  const auto stop_time = steady_clock::now();
+
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  const auto gigabits_per_second = 8 * static_cast<double>( total_len ) / test_duration.count() / 1e9;
+
+  cout << "InternetChecksum (" << kernel_name( kernel ) << ") over " << packet_len << "-byte packets reached "
+       << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+
+  if ( gigabits_per_second < 1 ) {
+    throw runtime_error( "InternetChecksum did not meet minimum speed of 1 Gbit/s" );
+  }
+}
+
+void program_body()
+{
+  for ( const auto kernel : { InternetChecksum::Kernel::Scalar,
+                              InternetChecksum::Kernel::SSE2,
+                              InternetChecksum::Kernel::AVX2,
+                              InternetChecksum::Kernel::NEON } ) {
+    if ( InternetChecksum::supported( kernel ) ) {
+      speed_test( kernel, 1500, 1e9 );
+      speed_test( kernel, 65536, 1e9 );
+    }
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
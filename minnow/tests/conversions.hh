@@ -1,6 +1,9 @@
 #pragma once
 
 #include "helpers.hh"
+#include "tcp_receiver_message.hh"
+#include "tcp_sender_message.hh"
+#include "wrapping_integers.hh"
 
 #include <optional>
 #include <string>
@@ -30,6 +33,49 @@ inline std::string to_string( const std::string& str )
 {
   return pretty_print( str );
 }
+
+class DebugWrap32 : public Wrap32
+{
+public:
+  uint32_t debug_get_raw_value() const { return raw_value_; }
+};
+
+inline std::string to_string( Wrap32 i )
+{
+  return "Wrap32<" + std::to_string( DebugWrap32 { i }.debug_get_raw_value() ) + ">";
+}
+
+inline std::string to_string( const TCPSenderMessage& msg )
+{
+  std::string ret = "(" + to_string( msg.seqno ) + ")";
+  if ( msg.SYN ) {
+    ret += " +SYN";
+  }
+  if ( not msg.payload.empty() ) {
+    ret += " payload=\"" + pretty_print( msg.payload ) + "\"";
+  }
+  if ( msg.FIN ) {
+    ret += " +FIN";
+  }
+  if ( msg.RST ) {
+    ret += " +RST";
+  }
+  return ret;
+}
+
+inline std::string to_string( const TCPReceiverMessage& msg )
+{
+  std::string ret = "(";
+  ret += msg.ackno.has_value() ? "ackno=" + to_string( *msg.ackno ) : "no ackno";
+  ret += ", window_size=" + std::to_string( msg.window_size );
+  for ( const auto& block : msg.sack_blocks ) {
+    ret += ", SACK [" + to_string( block.begin ) + ", " + to_string( block.end ) + ")";
+  }
+  if ( msg.RST ) {
+    ret += ", +RST";
+  }
+  return ret + ")";
+}
 } // namespace minnow_conversions
 
 template<typename T>
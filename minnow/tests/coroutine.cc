@@ -0,0 +1,243 @@
+#include "coroutine.hh"
+#include "exception.hh"
+
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono_literals;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+void run_until( EventLoop& loop, const bool& done )
+{
+  for ( int i = 0; not done and i < 1000; ++i ) {
+    loop.wait_next_event( 10 );
+  }
+  expect( done, "the loop should have finished" );
+}
+
+// Echo everything read from `socket` back to it, until the peer shuts down its side
+Task<> echo( EventLoop& loop, TCPSocket socket )
+{
+  string buffer;
+  while ( co_await async_read( loop, socket, buffer ) ) {
+    co_await async_write_all( loop, socket, buffer );
+  }
+  socket.shutdown( SHUT_WR );
+}
+
+Task<> serve( EventLoop& loop, TCPSocket& listener, size_t connections )
+{
+  for ( size_t i = 0; i < connections; ++i ) {
+    spawn( echo( loop, co_await async_accept( loop, listener ) ) );
+  }
+}
+
+// Returns what the server echoed
+Task<string> exchange( EventLoop& loop, Address server, string message )
+{
+  TCPSocket socket = co_await async_connect( loop, server );
+  co_await async_write_all( loop, socket, message );
+  socket.shutdown( SHUT_WR );
+
+  string reply;
+  string buffer;
+  while ( co_await async_read( loop, socket, buffer ) ) {
+    reply += buffer;
+  }
+  co_return reply;
+}
+
+Task<> client( EventLoop& loop, Address server, size_t id, size_t& finished )
+{
+  const string message = "message " + to_string( id ) + string( id * 1000, 'm' );
+  expect( co_await exchange( loop, server, message ) == message, "echo should match" );
+  ++finished;
+}
+
+// many concurrent connections, each a straight-line coroutine, on one loop
+void echo_clients( EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  TCPSocket listener;
+  listener.bind( Address { "127.0.0.1", 0 } );
+  listener.listen( 64 );
+
+  constexpr size_t connections = 40;
+  spawn( serve( loop, listener, connections ) );
+
+  size_t finished = 0;
+  for ( size_t i = 0; i < connections; ++i ) {
+    spawn( client( loop, listener.local_address(), i, finished ) );
+  }
+
+  for ( int i = 0; finished < connections and i < 1000; ++i ) {
+    loop.wait_next_event( 10 );
+  }
+  expect( finished == connections, "every client should get its echo" );
+  expect( FramePool::free_frames() > 0, "finished coroutines' frames should be kept for reuse" );
+}
+
+// (These are functions, not lambdas: a lambda's captures would be gone once the coroutine had been spawned.)
+Task<> sleeper( EventLoop& loop, int ms, vector<int>& order )
+{
+  co_await sleep_for( loop, chrono::milliseconds { ms } );
+  order.push_back( ms );
+}
+
+Task<int> fail_later( EventLoop& loop )
+{
+  co_await sleep_for( loop, 1ms );
+  throw runtime_error( "failed" );
+}
+
+Task<> catch_failure( EventLoop& loop, bool& caught )
+{
+  try {
+    co_await fail_later( loop );
+  } catch ( const runtime_error& ) {
+    caught = true;
+  }
+}
+
+Task<> fail_uncaught( EventLoop& loop )
+{
+  co_await fail_later( loop );
+}
+
+Task<> connect_to( EventLoop& loop, Address address, bool& refused )
+{
+  try {
+    co_await async_connect( loop, address );
+  } catch ( const exception& ) {
+    refused = true;
+  }
+}
+
+// timers resume coroutines in deadline order, and exceptions reach the awaiter (or else the resumer)
+void sleeps_and_errors()
+{
+  EventLoop loop;
+  vector<int> order;
+  spawn( sleeper( loop, 30, order ) );
+  spawn( sleeper( loop, 5, order ) );
+  spawn( sleeper( loop, 15, order ) );
+  while ( loop.wait_next_event( -1 ) != EventLoop::Result::Exit ) {}
+  expect( order == vector<int> { 5, 15, 30 }, "sleepers should wake in deadline order" );
+
+  bool caught = false;
+  spawn( catch_failure( loop, caught ) );
+  run_until( loop, caught );
+
+  bool propagated = false;
+  spawn( fail_uncaught( loop ) );
+  try {
+    while ( loop.wait_next_event( -1 ) != EventLoop::Result::Exit ) {}
+  } catch ( const runtime_error& e ) {
+    propagated = string( e.what() ) == "failed";
+  }
+  expect( propagated, "a spawned coroutine's uncaught exception should propagate from wait_next_event" );
+
+  TCPSocket closed_listener;
+  closed_listener.bind( Address { "127.0.0.1", 0 } );
+  const Address nobody = closed_listener.local_address();
+  closed_listener.close();
+  bool refused = false;
+  spawn( connect_to( loop, nobody, refused ) );
+  run_until( loop, refused );
+}
+
+Task<> send_all( EventLoop& loop, TCPSocket& listener, const string& data, bool& sent )
+{
+  TCPSocket socket = co_await async_accept( loop, listener );
+  expect( socket.non_blocking(), "an accepted socket should be non-blocking" );
+  co_await async_write_all( loop, socket, data );
+  socket.shutdown( SHUT_WR );
+  sent = true;
+}
+
+Task<> tick( EventLoop& loop, const bool& sent, size_t& ticks, bool& ticking )
+{
+  while ( not sent ) {
+    co_await sleep_for( loop, 1ms );
+    ++ticks;
+  }
+  ticking = false;
+}
+
+// a write much bigger than the socket buffers, to a peer that reads slowly, doesn't hold up the loop's other
+// coroutines: it is done a socket buffer at a time
+void slow_reader()
+{
+  EventLoop loop;
+  TCPSocket listener;
+  listener.bind( Address { "127.0.0.1", 0 } );
+  listener.listen();
+
+  string data( 8 << 20, 0 );
+  for ( size_t i = 0; i < data.size(); ++i ) {
+    data[i] = static_cast<char>( i % 251 );
+  }
+
+  bool sent = false;
+  bool ticking = true;
+  size_t ticks = 0;
+  spawn( send_all( loop, listener, data, sent ) );
+  spawn( tick( loop, sent, ticks, ticking ) );
+
+  // (the connection waits in the listener's queue until the loop accepts it)
+  TCPSocket client;
+  const int receive_buffer = 16384;
+  CheckSystemCall(
+    "setsockopt", ::setsockopt( client.fd_num(), SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof( receive_buffer ) ) );
+  client.connect( listener.local_address() );
+
+  string received;
+  thread reader { [&] {
+    while ( not client.eof() ) {
+      string buffer;
+      client.read( buffer );
+      received += buffer;
+      this_thread::sleep_for( 1ms );
+    }
+  } };
+
+  const auto give_up = chrono::steady_clock::now() + 30s;
+  while ( ( not sent or ticking ) and chrono::steady_clock::now() < give_up ) {
+    loop.wait_next_event( 10 );
+  }
+  if ( not sent ) {
+    ::shutdown( client.fd_num(), SHUT_RDWR ); // so that the reader sees EOF anyway
+  }
+  reader.join(); // (once sent, the sender has shut down its side, so the reader sees EOF)
+
+  expect( sent and not ticking, "the write should have finished" );
+  expect( ticks >= 50, "the loop should have run other coroutines while the write waited for the peer" );
+  expect( received == data, "the peer should have read all of the data" );
+}
+
+int main()
+{
+  try {
+    echo_clients( EventLoop::Backend::Epoll );
+    echo_clients( EventLoop::Backend::Poll );
+    sleeps_and_errors();
+    slow_reader();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
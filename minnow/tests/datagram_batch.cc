@@ -0,0 +1,125 @@
+#include "exception.hh"
+#include "socket.hh"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+UDPSocket bound_socket()
+{
+  UDPSocket socket;
+  socket.bind( Address { "127.0.0.1", 0 } );
+  return socket;
+}
+
+// several datagrams each way in one call, with each datagram keeping its own address
+void send_and_recv()
+{
+  UDPSocket receiver = bound_socket();
+  UDPSocket first = bound_socket();
+  UDPSocket second = bound_socket();
+
+  DatagramBatch out { 4, 100 };
+  out.push( receiver.local_address(), "one" );
+  out.push( receiver.local_address(), "two" );
+  expect( first.send_batch( out ) == 2, "sendmmsg should send the whole batch" );
+  expect( first.send_batch( out, 2 ) == 0, "nothing is left to send" );
+
+  out.clear();
+  second.connect( receiver.local_address() );
+  out.push( "three" );
+  out.push( "" );
+  expect( second.send_batch( out, 1 ) == 1, "send_batch should start at `first`" );
+  expect( second.send_batch( out ) == 2, "sendmmsg should send to the connected address" );
+  expect( first.write_count() == 1 and second.write_count() == 2, "each send_batch should count as a write" );
+
+  DatagramBatch in { 8, 100 };
+  expect( receiver.recv_batch( in ) == 5 and in.size() == 5, "recvmmsg should return what has arrived" );
+  const string expected[] = { "one", "two", "", "three", "" };
+  for ( size_t i = 0; i < in.size(); ++i ) {
+    expect( in.payload( i ) == expected[i], "payload " + to_string( i ) + " is " + string( in.payload( i ) ) );
+    expect( in.address( i ) == ( i < 2 ? first : second ).local_address(), "wrong source address" );
+    expect( in.segment_size( i ) == 0, "datagram should not be coalesced" );
+  }
+
+  receiver.set_blocking( false );
+  expect( receiver.recv_batch( in ) == 0 and in.size() == 0, "a non-blocking socket should return no datagrams" );
+
+  out.clear();
+  out.push( receiver.local_address(), string( 100, 'x' ) );
+  bool threw = false;
+  try {
+    out.push( receiver.local_address(), string( 101, 'x' ) );
+  } catch ( const runtime_error& ) {
+    threw = true;
+  }
+  expect( threw, "push() should reject a datagram larger than the buffers" );
+
+  DatagramBatch tiny { 2, 10 };
+  first.send_batch( out );
+  threw = false;
+  try {
+    receiver.recv_batch( tiny );
+  } catch ( const runtime_error& ) {
+    threw = true;
+  }
+  expect( threw, "recv_batch() should reject a datagram larger than the buffers" );
+}
+
+// with UDP_SEGMENT, one large send arrives as several datagrams (or one coalesced one with UDP_GRO)
+void segmentation()
+{
+  UDPSocket receiver = bound_socket();
+  UDPSocket sender = bound_socket();
+
+  DatagramBatch out { 1 };
+  out.push( receiver.local_address(), string( 2500, 'g' ), 1000 );
+  try {
+    sender.send_batch( out );
+  } catch ( const unix_error& e ) {
+    cerr << "Skipping GSO test: " << e.what() << "\n";
+    return;
+  }
+
+  DatagramBatch in { 8 };
+  expect( receiver.recv_batch( in ) == 3, "GSO send should arrive as three datagrams" );
+  expect( in.payload( 0 ).size() == 1000 and in.payload( 2 ).size() == 500, "wrong segment sizes" );
+
+  receiver.set_gro();
+  sender.set_gso_segment_size( 1000 );
+  out.clear();
+  out.push( receiver.local_address(), string( 3000, 'h' ) );
+  sender.send_batch( out );
+
+  size_t bytes = 0;
+  while ( bytes < 3000 ) {
+    receiver.recv_batch( in );
+    for ( size_t i = 0; i < in.size(); ++i ) {
+      bytes += in.payload( i ).size();
+      expect( in.segment_size( i ) == 0 or in.segment_size( i ) == 1000, "wrong GRO segment size" );
+    }
+  }
+  expect( bytes == 3000, "GRO should deliver every byte" );
+}
+
+int main()
+{
+  try {
+    send_and_recv();
+    segmentation();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
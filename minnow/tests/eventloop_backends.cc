@@ -0,0 +1,262 @@
+#include "eventloop.hh"
+#include "exception.hh"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <string>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+pair<FileDescriptor, FileDescriptor> make_pipe()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "pipe", ::pipe( fds.data() ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+// Copy a string through a pipe, with a rule on each end, until both rules finish
+void pipe_transfer( EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  auto [read_end, write_end] = make_pipe();
+  read_end.set_blocking( false );
+  write_end.set_blocking( false );
+
+  const string data( 300000, 'x' ); // more than a pipe holds
+  string_view to_write = data;
+  string received;
+  bool read_cancelled = false;
+
+  loop.add_rule(
+    "write to pipe",
+    write_end,
+    Direction::Out,
+    [&] {
+      to_write.remove_prefix( write_end.write( to_write ) );
+      if ( to_write.empty() ) {
+        write_end.close();
+      }
+    },
+    [&] { return not to_write.empty(); } );
+
+  loop.add_rule(
+    "read from pipe",
+    read_end,
+    Direction::In,
+    [&] {
+      string buf;
+      read_end.read( buf );
+      received += buf;
+    },
+    [] { return true; },
+    [&] { read_cancelled = true; } );
+
+  size_t iterations = 0;
+  while ( loop.wait_next_event( 1000 ) != EventLoop::Result::Exit ) {
+    expect( ++iterations < 100000, "event loop did not finish" );
+  }
+
+  expect( received == data, "data read from the pipe should match data written" );
+  expect( read_cancelled, "reaching EOF should cancel the read rule" );
+}
+
+// Timeouts, uninterested rules, and cancellation through a RuleHandle
+void timeout_and_cancel( EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  auto [read_end, write_end] = make_pipe();
+  bool interested = true;
+  size_t callbacks = 0;
+
+  auto handle = loop.add_rule(
+    "read from idle pipe",
+    read_end,
+    Direction::In,
+    [&] {
+      string buf;
+      read_end.read( buf );
+      ++callbacks;
+    },
+    [&] { return interested; } );
+
+  expect( loop.wait_next_event( 10 ) == EventLoop::Result::Timeout, "idle pipe should time out" );
+
+  write_end.write( "hello" );
+  expect( loop.wait_next_event( 10 ) == EventLoop::Result::Success, "readable pipe should fire" );
+  expect( callbacks == 1, "callback should run once" );
+
+  write_end.write( "again" );
+  interested = false;
+  expect( loop.wait_next_event( 10 ) == EventLoop::Result::Exit, "uninterested rule should mean exit" );
+  interested = true;
+  expect( loop.wait_next_event( 10 ) == EventLoop::Result::Success, "re-interested rule should fire" );
+  expect( callbacks == 2, "callback should run twice" );
+
+  handle.cancel();
+  write_end.write( "more" );
+  expect( loop.wait_next_event( 10 ) == EventLoop::Result::Exit, "cancelled rule should not fire" );
+  expect( callbacks == 2, "cancelled rule's callback should not run" );
+}
+
+// A regular file can't be added to an epoll set, but should still be serviced
+void regular_file( EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  FILE* tmp = notnull( "tmpfile", tmpfile() );
+  FileDescriptor file { CheckSystemCall( "dup", dup( fileno( tmp ) ) ) };
+  fclose( tmp ); // NOLINT(*-owning-memory)
+  file.write( "some file contents" );
+  CheckSystemCall( "lseek", static_cast<int>( lseek( file.fd_num(), 0, SEEK_SET ) ) );
+
+  string contents;
+  loop.add_rule( "read from file", file, Direction::In, [&] {
+    string buf;
+    file.read( buf );
+    contents += buf;
+  } );
+
+  while ( loop.wait_next_event( 1000 ) != EventLoop::Result::Exit ) {}
+  expect( contents == "some file contents", "file contents should be read" );
+}
+
+// A stale RuleHandle can't cancel the rule that reuses its slot, and rules added by a callback (growing the table)
+// don't disturb the running rule, and a handle may outlive its loop
+void handles( EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  auto [read_end, write_end] = make_pipe();
+  write_end.write( "x" );
+
+  size_t first_calls = 0;
+  auto first = loop.add_rule( "first", [&] { ++first_calls; }, [] { return false; } );
+  first.cancel();
+  expect( loop.wait_next_event( 0 ) == EventLoop::Result::Exit, "cancelled rule should be removed" );
+
+  size_t second_calls = 0;
+  bool second_interested = true;
+  loop.add_rule(
+    "second",
+    [&] {
+      ++second_calls;
+      second_interested = false;
+    },
+    [&] { return second_interested; } );
+  first.cancel(); // stale: the second rule has probably taken the first's slot
+  expect( loop.wait_next_event( 0 ) == EventLoop::Result::Success, "second rule should fire" );
+  expect( first_calls == 0 and second_calls == 1, "stale handle should not cancel the second rule" );
+
+  size_t added = 0;
+  size_t idle_calls = 0;
+  string received;
+  const size_t idle = loop.add_category( "idle" );
+  loop.add_rule( "reader", read_end, Direction::In, [&] {
+    for ( ; added < 100; ++added ) {
+      loop.add_rule( idle, [&] { ++idle_calls; }, [] { return false; } );
+    }
+    read_end.read( received ); // still reachable after the table grew
+  } );
+
+  expect( loop.wait_next_event( 0 ) == EventLoop::Result::Success, "reader should fire" );
+  expect( received == "x" and added == 100 and idle_calls == 0, "callback should survive adding rules" );
+
+  // A handle that outlives its loop can still be cancelled (which does nothing)
+  optional<EventLoop::RuleHandle> orphan;
+  {
+    EventLoop short_lived { backend };
+    orphan = short_lived.add_rule( "orphan", [] {} );
+  }
+  orphan->cancel();
+}
+
+// Callbacks, spurious wakeups, and waits are counted for each category
+void stats( EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  auto [read_end, write_end] = make_pipe();
+  bool skip_read = false;
+  bool interested = true;
+
+  const size_t category = loop.add_category( "reader" );
+  loop.add_rule(
+    category,
+    read_end,
+    Direction::In,
+    [&] {
+      if ( skip_read ) {
+        interested = false; // not reading, so stop asking (or else it's a busy wait)
+        return;
+      }
+      string buf;
+      read_end.read( buf );
+    },
+    [&] { return interested; } );
+  loop.add_rule( "never", [] {}, [] { return false; } );
+
+  expect( loop.wait_next_event( 0 ) == EventLoop::Result::Timeout, "idle pipe should time out" );
+  write_end.write( "x" );
+  expect( loop.wait_next_event( 0 ) == EventLoop::Result::Success, "readable pipe should fire" );
+
+  auto snapshot = loop.stats();
+  expect( snapshot.categories.size() == 2, "there should be two categories" );
+  expect( snapshot.categories.at( category ).name == "reader", "category should be named" );
+  expect( snapshot.categories.at( category ).callbacks == 1, "callback should be counted" );
+  expect( snapshot.categories.at( category ).spurious_wakeups == 0, "callback read the fd" );
+  expect( snapshot.categories.at( 1 ).callbacks == 0, "uninterested rule never runs" );
+  expect( snapshot.waits == 2, "both waits should be counted" );
+
+  size_t dumps = 0;
+  uint64_t dumped_spurious = 0;
+  loop.dump_stats_every( chrono::milliseconds { 1 }, [&]( const EventLoop::Stats& s ) {
+    ++dumps;
+    dumped_spurious = s.categories.at( category ).spurious_wakeups;
+  } );
+
+  write_end.write( "y" );
+  skip_read = true;
+  expect( loop.wait_next_event( 0 ) == EventLoop::Result::Success, "readable pipe should fire" );
+  expect( loop.stats().categories.at( category ).spurious_wakeups == 1, "callback that didn't read is spurious" );
+  expect( dumps == 0, "stats should not be dumped early" );
+
+  this_thread::sleep_for( chrono::milliseconds { 2 } );
+  expect( loop.wait_next_event( 0 ) == EventLoop::Result::Exit, "uninterested rules mean exit" );
+  expect( dumps == 1 and dumped_spurious == 1, "stats should be dumped once the interval passes" );
+  loop.dump_stats_every( chrono::milliseconds { 0 } );
+
+  loop.reset_stats();
+  snapshot = loop.stats();
+  expect( snapshot.categories.at( category ).callbacks == 0 and snapshot.waits == 0, "reset should zero counters" );
+  expect( snapshot.categories.at( category ).name == "reader", "reset should keep names" );
+  expect( snapshot.to_string().find( "reader" ) != string::npos, "report should list categories" );
+}
+
+int main()
+{
+  try {
+    for ( const auto backend : { EventLoop::Backend::Poll, EventLoop::Backend::Epoll } ) {
+      pipe_transfer( backend );
+      timeout_and_cancel( backend );
+      regular_file( backend );
+      handles( backend );
+      stats( backend );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+#include "eventloop_group.hh"
+#include "exception.hh"
+#include "socket.hh"
+
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+// Each loop services its own rules on its own thread, until one of them stops the group
+void run_and_stop()
+{
+  constexpr size_t loops = 3;
+  EventLoopGroup group { loops, EventLoop::Backend::Epoll };
+  expect( group.size() == loops, "group should have the requested number of loops" );
+
+  vector<FileDescriptor> read_ends;
+  vector<FileDescriptor> write_ends;
+  read_ends.reserve( loops );
+  write_ends.reserve( loops );
+  array<string, loops> received;
+  atomic<size_t> finished = 0;
+
+  for ( size_t i = 0; i < loops; ++i ) {
+    array<int, 2> fds {};
+    CheckSystemCall( "pipe", ::pipe( fds.data() ) );
+    auto& read_end = read_ends.emplace_back( fds[0] );
+    write_ends.emplace_back( fds[1] ).write( "loop " + to_string( i ) );
+
+    group.loop( i ).add_rule( "read", read_end, Direction::In, [&, i] {
+      read_ends[i].read( received.at( i ) );
+      read_ends[i].close();
+      if ( ++finished == loops ) {
+        group.stop();
+      }
+    } );
+  }
+
+  group.run( false );
+  for ( size_t i = 0; i < loops; ++i ) {
+    expect( received.at( i ) == "loop " + to_string( i ), "each loop should read its own pipe" );
+  }
+}
+
+// An exception on one loop's thread stops the others, and comes out of run()
+void exception_propagates()
+{
+  EventLoopGroup group { 2 };
+  array<int, 2> fds {};
+  CheckSystemCall( "pipe", ::pipe( fds.data() ) );
+  FileDescriptor read_end { fds[0] };
+  FileDescriptor write_end { fds[1] };
+  write_end.write( "x" );
+
+  group.loop( 1 ).add_rule( "throw", read_end, Direction::In, [&] {
+    string buf;
+    read_end.read( buf );
+    throw runtime_error( "from loop" );
+  } );
+
+  bool caught = false;
+  try {
+    group.run();
+  } catch ( const runtime_error& e ) {
+    caught = string( e.what() ) == "from loop";
+  }
+  expect( caught, "run should rethrow the loop's exception" );
+}
+
+// Two listeners can share a port with SO_REUSEPORT
+void reuseport()
+{
+  TCPSocket first;
+  first.set_reuseport();
+  first.bind( Address { "127.0.0.1", 0 } );
+  first.listen();
+
+  TCPSocket second;
+  second.set_reuseport();
+  second.bind( first.local_address() );
+  second.listen();
+  expect( second.local_address().port() == first.local_address().port(), "listeners should share a port" );
+}
+
+int main()
+{
+  try {
+    run_and_stop();
+    exception_propagates();
+    reuseport();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "speed_harness.hh"
+
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+constexpr size_t callbacks_per_test = 100'000;
+
+string_view backend_name( EventLoop::Backend backend )
+{
+  return backend == EventLoop::Backend::Epoll ? "epoll" : "poll";
+}
+
+// Dispatch to the rules of `pipes` pipes that are always readable: each callback reads its pipe and refills it
+void dispatch_test( BenchmarkSuite& suite, EventLoop::Backend backend, size_t pipes )
+{
+  EventLoop loop { backend };
+  vector<pair<FileDescriptor, FileDescriptor>> ends;
+  ends.reserve( pipes );
+  string buffer;
+  buffer.reserve( 65536 );
+
+  Benchmark benchmark { "EventLoop dispatch",
+                        { { "backend", string( backend_name( backend ) ) }, { "pipes", to_string( pipes ) } } };
+  const size_t category = loop.add_category( "pipe" );
+  for ( size_t i = 0; i < pipes; ++i ) {
+    auto& [read_end, write_end] = ends.emplace_back( FileDescriptor::make_pipe() );
+    write_end.write( "x" );
+    loop.add_rule( category, read_end, Direction::In, [&read_end, &write_end, &buffer, &benchmark] {
+      read_end.read( buffer );
+      write_end.write( buffer );
+      benchmark.op();
+    } );
+  }
+
+  benchmark.start();
+  for ( size_t i = 0; i < callbacks_per_test; ++i ) {
+    if ( loop.wait_next_event( -1 ) != EventLoop::Result::Success ) {
+      throw runtime_error( "EventLoop stopped dispatching" );
+    }
+  }
+  const BenchmarkResult& result = suite.record( benchmark.finish() );
+
+  if ( result.ops_per_second() < 1e4 ) {
+    throw runtime_error( "EventLoop did not meet minimum speed of 10000 callbacks/s" );
+  }
+}
+
+void program_body( BenchmarkSuite& suite )
+{
+  for ( const auto backend : { EventLoop::Backend::Poll, EventLoop::Backend::Epoll } ) {
+    for ( const size_t pipes : { 1, 16, 256 } ) {
+      dispatch_test( suite, backend, pipes );
+    }
+  }
+}
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  try {
+    BenchmarkSuite suite { "eventloop", argc, argv };
+    program_body( suite );
+    suite.report();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
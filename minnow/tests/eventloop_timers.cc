@@ -0,0 +1,115 @@
+#include "eventloop.hh"
+#include "exception.hh"
+
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono_literals;
+using Clock = chrono::steady_clock;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+// One-shot timers fire once, in deadline order, and the loop exits when none are left
+void one_shot( EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  vector<int> order;
+  const auto start = Clock::now();
+
+  loop.add_timer( "second", 30ms, [&] { order.push_back( 2 ); } );
+  loop.add_timer( "first", 10ms, [&] { order.push_back( 1 ); } );
+  loop.add_timer( "also second", 30ms, [&] { order.push_back( 3 ); } );
+
+  size_t iterations = 0;
+  while ( loop.wait_next_event( -1 ) != EventLoop::Result::Exit ) {
+    expect( ++iterations < 100, "event loop did not finish" );
+  }
+
+  expect( order == vector<int> { 1, 2, 3 }, "timers should fire once each, in deadline order" );
+  expect( Clock::now() - start >= 30ms, "timers should not fire early" );
+}
+
+// A periodic timer keeps firing until it is cancelled, and a timer wakes up a loop waiting on an idle fd
+void periodic_and_cancel( EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  array<int, 2> fds {};
+  CheckSystemCall( "pipe", ::pipe( fds.data() ) );
+  FileDescriptor read_end { fds[0] };
+  FileDescriptor write_end { fds[1] };
+
+  size_t ticks = 0;
+  bool never_fired = true;
+  string received;
+
+  loop.add_rule( "read from pipe", read_end, Direction::In, [&] {
+    string buf;
+    read_end.read( buf );
+    received += buf;
+  } );
+
+  auto never = loop.add_timer( "never", 20ms, [&] { never_fired = false; } );
+  never.cancel();
+
+  EventLoop::RuleHandle ticker = loop.add_timer(
+    "tick",
+    5ms,
+    [&] {
+      if ( ++ticks == 4 ) {
+        ticker.cancel();
+        write_end.close();
+      }
+    },
+    true );
+
+  size_t iterations = 0;
+  while ( loop.wait_next_event( -1 ) != EventLoop::Result::Exit ) {
+    expect( ++iterations < 100, "event loop did not finish" );
+  }
+
+  expect( ticks == 4, "periodic timer should fire until cancelled" );
+  expect( never_fired, "cancelled timer should not fire" );
+  expect( received.empty(), "nothing was written to the pipe" );
+}
+
+// A timer due before the caller's timeout ends the wait early
+void timeout_capped( EventLoop::Backend backend )
+{
+  EventLoop loop { backend };
+  bool fired = false;
+  loop.add_timer( "soon", 5ms, [&] { fired = true; } );
+
+  const auto start = Clock::now();
+  expect( loop.wait_next_event( 10000 ) == EventLoop::Result::Success, "timer should fire" );
+  expect( fired, "timer callback should run" );
+  expect( Clock::now() - start < 5s, "timer should end the wait early" );
+  expect( loop.wait_next_event( 0 ) == EventLoop::Result::Exit, "nothing should be left" );
+}
+
+int main()
+{
+  try {
+    for ( const auto backend : { EventLoop::Backend::Poll, EventLoop::Backend::Epoll } ) {
+      one_shot( backend );
+      periodic_and_cancel( backend );
+      timeout_capped( backend );
+    }
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
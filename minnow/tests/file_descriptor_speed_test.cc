@@ -0,0 +1,111 @@
+#include "file_descriptor.hh"
+#include "speed_harness.hh"
+
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+constexpr size_t bytes_per_test = 50'000'000;
+
+// With small buffers, each op (a writev and a readv) is bound by the cost of the two syscalls rather than by how
+// many bytes they move, so an op counts as fast enough if it meets either floor.
+void check_speed( const BenchmarkResult& result )
+{
+  if ( result.gigabits_per_second() < 0.1 and result.ops_per_second() < 1e4 ) {
+    throw runtime_error( "FileDescriptor did not meet minimum speed of 0.1 Gbit/s or 10,000 writev+readv/s" );
+  }
+}
+
+// Write `buffer_count` buffers of `buffer_size` bytes into a pipe with one writev, and read them back with one
+// readv into as many buffers
+void vectored_test( BenchmarkSuite& suite, size_t buffer_count, size_t buffer_size )
+{
+  auto [read_end, write_end] = FileDescriptor::make_pipe();
+  const string data( buffer_size, 'x' );
+  const vector<string_view> out( buffer_count, data );
+  vector<string> in( buffer_count );
+  for ( auto& buffer : in ) {
+    buffer.reserve( 65536 );
+  }
+
+  Benchmark benchmark { "FileDescriptor writev+readv",
+                        { { "buffers", to_string( buffer_count ) }, { "buffer_size", to_string( buffer_size ) } } };
+  benchmark.start();
+  for ( size_t done = 0; done < bytes_per_test; done += buffer_count * buffer_size ) {
+    if ( write_end.write( out ) != buffer_count * buffer_size ) {
+      throw runtime_error( "short write" );
+    }
+    for ( auto& buffer : in ) {
+      buffer.resize( buffer_size );
+    }
+    read_end.read( in );
+    size_t received = 0;
+    for ( const auto& buffer : in ) {
+      received += buffer.size();
+    }
+    if ( received != buffer_count * buffer_size ) {
+      throw runtime_error( "short read" );
+    }
+    benchmark.op( received );
+  }
+  check_speed( suite.record( benchmark.finish() ) );
+}
+
+// The same, but writing a span of views and reading into caller-owned iovecs (neither of which allocates)
+void span_test( BenchmarkSuite& suite, size_t buffer_count, size_t buffer_size )
+{
+  auto [read_end, write_end] = FileDescriptor::make_pipe();
+  const string data( buffer_size, 'x' );
+  const vector<string_view> out( buffer_count, data );
+  vector<string> in( buffer_count, string( buffer_size, 0 ) );
+  vector<iovec> iovecs;
+  for ( auto& buffer : in ) {
+    iovecs.push_back( { buffer.data(), buffer.size() } );
+  }
+
+  Benchmark benchmark { "FileDescriptor writev+readv (spans)",
+                        { { "buffers", to_string( buffer_count ) }, { "buffer_size", to_string( buffer_size ) } } };
+  benchmark.start();
+  for ( size_t done = 0; done < bytes_per_test; done += buffer_count * buffer_size ) {
+    if ( write_end.write( span { out } ) != buffer_count * buffer_size ) {
+      throw runtime_error( "short write" );
+    }
+    const size_t received = read_end.read( span { iovecs } );
+    if ( received != buffer_count * buffer_size ) {
+      throw runtime_error( "short read" );
+    }
+    benchmark.op( received );
+  }
+  check_speed( suite.record( benchmark.finish() ) );
+}
+
+void program_body( BenchmarkSuite& suite )
+{
+  for ( const size_t buffer_count : { 1, 4, 16 } ) {
+    for ( const size_t buffer_size : { 64, 1500 } ) {
+      vectored_test( suite, buffer_count, buffer_size );
+      span_test( suite, buffer_count, buffer_size );
+    }
+  }
+}
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  try {
+    BenchmarkSuite suite { "file_descriptor", argc, argv };
+    program_body( suite );
+    suite.report();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
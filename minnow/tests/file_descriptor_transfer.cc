@@ -0,0 +1,131 @@
+#include "byte_stream.hh"
+#include "exception.hh"
+#include "file_descriptor.hh"
+
+#include <array>
+#include <climits>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+FileDescriptor temporary_file( const string& contents )
+{
+  FILE* tmp = notnull( "tmpfile", tmpfile() );
+  FileDescriptor file { CheckSystemCall( "dup", dup( fileno( tmp ) ) ) };
+  fclose( tmp ); // NOLINT(*-owning-memory)
+  file.write( contents );
+  CheckSystemCall( "lseek", static_cast<int>( lseek( file.fd_num(), 0, SEEK_SET ) ) );
+  return file;
+}
+
+string read_all( FileDescriptor& fd )
+{
+  string all;
+  while ( not fd.eof() ) {
+    string buf;
+    fd.read( buf );
+    all += buf;
+  }
+  return all;
+}
+
+// splice between pipes, with the counters and EOF kept as for read() and write()
+void splice_pipes()
+{
+  auto [first_read, first_write] = FileDescriptor::make_pipe();
+  auto [second_read, second_write] = FileDescriptor::make_pipe();
+  expect( first_read.is_pipe() and not first_read.is_regular_file(), "pipe should be a pipe" );
+
+  first_write.write( "hello, splice" );
+  expect( first_read.splice( second_write, 5 ) == 5, "splice should move what was asked" );
+  expect( first_read.read_count() == 1 and second_write.write_count() == 1, "splice should count as read/write" );
+  expect( first_read.splice( second_write, 100 ) == 8, "splice should move what is there" );
+  expect( first_read.splice( second_write, 100 ) == 0 and not first_read.eof(), "empty pipe should not be EOF" );
+
+  first_write.close();
+  expect( first_read.splice( second_write, 100 ) == 0 and first_read.eof(), "closed pipe should be EOF" );
+
+  second_write.close();
+  expect( read_all( second_read ) == "hello, splice", "bytes should arrive in order" );
+  expect( first_read.set_pipe_size( 1 << 16 ) >= 4096, "pipe size should be at least a page" );
+}
+
+// send_file from a regular file, to a pipe (sendfile) or another file (copy_file_range)
+void send_file()
+{
+  const string contents( 100000, 'f' );
+  FileDescriptor source = temporary_file( contents );
+  expect( source.is_regular_file() and source.size() == static_cast<off_t>( contents.size() ), "file size" );
+
+  FileDescriptor destination = temporary_file( "" );
+  size_t total = 0;
+  while ( not source.eof() ) {
+    total += source.send_file( destination, 30000 );
+  }
+  expect( total == contents.size(), "copy_file_range should copy the whole file" );
+  CheckSystemCall( "lseek", static_cast<int>( lseek( destination.fd_num(), 0, SEEK_SET ) ) );
+  expect( read_all( destination ) == contents, "copied file should match" );
+
+  FileDescriptor small = temporary_file( "to a pipe" );
+  auto [pipe_read, pipe_write] = FileDescriptor::make_pipe();
+  expect( small.send_file( pipe_write, 1000 ) == 9, "sendfile should send the file" );
+  pipe_write.close();
+  expect( read_all( pipe_read ) == "to a pipe", "sendfile should send the whole file" );
+}
+
+// writev from spans of views, readv into caller-owned iovecs, and read_into() a ByteStream
+void vectored()
+{
+  auto [read_end, write_end] = FileDescriptor::make_pipe();
+  const array<string_view, 3> out { "vec", "tor", "ed" };
+  expect( write_end.write( span { out } ) == 8, "writev should write every view" );
+
+  array<char, 5> first {};
+  array<char, 5> second {};
+  array<iovec, 2> in { { { first.data(), first.size() }, { second.data(), second.size() } } };
+  expect( read_end.read( span { in } ) == 8, "readv should read what is there" );
+  expect( string_view { first.data(), 5 } == "vecto" and string_view { second.data(), 3 } == "red", "readv order" );
+
+  const string one_byte = "x";
+  const vector<string_view> too_many( IOV_MAX + 10, one_byte );
+  expect( write_end.write( too_many ) == IOV_MAX, "writev should write at most IOV_MAX views" );
+  string rest;
+  read_end.read( rest );
+  expect( rest.size() == IOV_MAX, "readv should read the IOV_MAX bytes" );
+
+  write_end.write( string( 10000, 'r' ) );
+  write_end.close();
+  ByteStream stream { 6000 };
+  expect( read_into( stream.writer(), read_end ) == 6000, "read_into() should fill the Writer's capacity" );
+  expect( read_into( stream.writer(), read_end ) == 0 and not read_end.eof(), "a full Writer should read nothing" );
+  stream.reader().pop( 6000 );
+  expect( read_into( stream.writer(), read_end ) == 4000, "read_into() should read the rest" );
+  expect( read_into( stream.writer(), read_end ) == 0 and read_end.eof(), "read_into() should see EOF" );
+  expect( stream.reader().peek() == string( 4000, 'r' ), "read_into() should push the bytes read" );
+}
+
+int main()
+{
+  try {
+    splice_pipes();
+    send_file();
+    vectored();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
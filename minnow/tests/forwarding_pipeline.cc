@@ -0,0 +1,207 @@
+#include "arp_message.hh"
+#include "eventloop_group.hh"
+#include "forwarding_pipeline.hh"
+#include "helpers.hh"
+#include "network_interface_test_harness.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono_literals;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+InternetDatagram make_datagram( const string& src_ip, const string& dst_ip, size_t payload_length = 0 )
+{
+  InternetDatagram dgram;
+  dgram.header.src = Address( src_ip, 0 ).ipv4_numeric();
+  dgram.header.dst = Address( dst_ip, 0 ).ipv4_numeric();
+  dgram.payload.emplace_back( "payload for " + dst_ip + string( payload_length, 'x' ) );
+  dgram.header.len = static_cast<uint64_t>( dgram.header.hlen ) * 4 + dgram.payload.front().size();
+  dgram.header.compute_checksum();
+  return dgram;
+}
+
+EthernetAddress ethernet_address( uint8_t n )
+{
+  return { 0x02, 0, 0, 0, 0, n };
+}
+
+// A pipeline's interfaces, each with a neighbor whose Ethernet address it has already learned
+struct TestNetwork
+{
+  EventLoopGroup loops;
+  ForwardingPipeline pipeline;
+  vector<shared_ptr<NetworkInterface>> interfaces {};
+  vector<shared_ptr<FramesOut>> outputs {};
+
+  explicit TestNetwork( size_t loop_count, uint64_t ring_capacity = ForwardingPipeline::default_ring_capacity )
+    : loops( loop_count ), pipeline( loops, ring_capacity )
+  {}
+
+  void add_interface( uint8_t n, const string& ip, const string& neighbor_ip, size_t loop_index )
+  {
+    outputs.push_back( make_shared<FramesOut>() );
+    interfaces.push_back( make_shared<NetworkInterface>(
+      "eth" + to_string( n ), outputs.back(), ethernet_address( n ), Address( ip ) ) );
+    pipeline.add_interface( interfaces.back(), loop_index );
+
+    ARPMessage arp;
+    arp.opcode = ARPMessage::OPCODE_REPLY;
+    arp.sender_ethernet_address = ethernet_address( 100 + n );
+    arp.sender_ip_address = Address( neighbor_ip ).ipv4_numeric();
+    arp.target_ethernet_address = ethernet_address( n );
+    arp.target_ip_address = Address( ip ).ipv4_numeric();
+    interfaces.back()->recv_frame(
+      { { ethernet_address( n ), ethernet_address( 100 + n ), EthernetHeader::TYPE_ARP }, serialize( arp ) } );
+  }
+
+  // (on the interface's own loop)
+  void arrive( uint8_t interface_num, const InternetDatagram& dgram )
+  {
+    interfaces.at( interface_num )
+      ->recv_frame(
+        { { ethernet_address( interface_num ), ethernet_address( 200 ), EthernetHeader::TYPE_IPv4 },
+          serialize( dgram ) } );
+  }
+
+  // The destinations of the datagrams that `interface_num` has sent (to its neighbor), in order
+  vector<string> sent( size_t interface_num )
+  {
+    vector<string> destinations;
+    auto& frames = outputs.at( interface_num )->frames;
+    for ( ; not frames.empty(); frames.pop() ) {
+      const EthernetFrame& frame = frames.front();
+      expect( frame.header.dst == ethernet_address( 100 + interface_num ), "frame to the wrong neighbor" );
+      InternetDatagram dgram;
+      expect( parse( dgram, frame.payload ), "bad datagram sent: " + summary( frame ) );
+      expect( dgram.header.ttl + 1 == IPv4Header::DEFAULT_TTL, "TTL should have been decremented" );
+      expect( concat( dgram.payload ).starts_with( "payload for " ), "payload should be unchanged" );
+      destinations.push_back( Address::from_ipv4_numeric( dgram.header.dst ).ip() );
+    }
+    return destinations;
+  }
+};
+
+// Datagrams cross between the loops that own their interfaces, and the loops pick up a route change mid-run
+void forwarding_across_loops()
+{
+  TestNetwork net { 2 };
+  net.add_interface( 0, "10.0.0.1", "10.0.0.2", 0 );
+  net.add_interface( 1, "172.16.0.1", "172.16.0.2", 1 );
+  net.add_interface( 2, "192.168.0.1", "192.168.0.77", 1 );
+  net.pipeline.add_routes( vector<ForwardingPipeline::Route> {
+    { 0, 0, Address( "10.0.0.2" ), 0 },
+    { Address( "172.16.0.0" ).ipv4_numeric(), 12, Address( "172.16.0.2" ), 1 },
+    { Address( "192.168.0.0" ).ipv4_numeric(), 24, {}, 2 } } );
+
+  vector<string> sent_on_0;
+  vector<string> sent_on_1;
+  vector<string> sent_on_2;
+  atomic<bool> rerouted = false;
+  atomic<bool> timed_out = false;
+
+  // Loop 0 routes a burst from eth0: to itself (by the default route), and across to loop 1's interfaces
+  net.loops.loop( 0 ).add_timer( "first burst", 1ms, [&] {
+    net.arrive( 0, make_datagram( "10.0.0.2", "1.2.3.4" ) );
+    net.arrive( 0, make_datagram( "10.0.0.2", "172.16.5.5" ) );
+    net.arrive( 0, make_datagram( "10.0.0.2", "192.168.0.77" ) );
+    net.arrive( 0, make_datagram( "10.0.0.2", "172.20.1.1" ) );
+    net.pipeline.route( 0 );
+  } );
+
+  // Once loop 1 has sent them, it changes the routes and routes a second burst, from eth2
+  net.loops.loop( 1 ).add_timer(
+    "second burst",
+    1ms,
+    [&] {
+      if ( rerouted or net.outputs[1]->frames.size() + net.outputs[2]->frames.size() < 3 ) {
+        return;
+      }
+      sent_on_1 = net.sent( 1 );
+      sent_on_2 = net.sent( 2 );
+      net.pipeline.add_route( { Address( "172.16.5.0" ).ipv4_numeric(), 24, Address( "10.0.0.2" ), 0 } );
+      rerouted = true;
+      net.arrive( 2, make_datagram( "192.168.0.77", "172.16.5.6" ) );
+      net.arrive( 2, make_datagram( "192.168.0.77", "172.16.6.6" ) );
+      net.pipeline.route( 2 );
+    },
+    true );
+
+  // Loop 0 stops the group once the second burst's datagram for eth0 has arrived
+  net.loops.loop( 0 ).add_timer(
+    "check",
+    1ms,
+    [&] {
+      if ( rerouted and net.outputs[0]->frames.size() >= 2 ) {
+        sent_on_0 = net.sent( 0 );
+        net.loops.stop();
+      }
+    },
+    true );
+
+  net.loops.loop( 0 ).add_timer( "timeout", 10s, [&] {
+    timed_out = true;
+    net.loops.stop();
+  } );
+
+  net.loops.run( false );
+  expect( not timed_out, "the datagrams should all have been forwarded" );
+
+  expect( sent_on_0 == vector<string> { "1.2.3.4", "172.16.5.6" }, "wrong datagrams sent on eth0" );
+  expect( sent_on_1 == vector<string> { "172.16.5.5", "172.20.1.1" }, "wrong datagrams handed over to eth1" );
+  expect( sent_on_2 == vector<string> { "192.168.0.77" }, "wrong datagram handed over to eth2" );
+  expect( net.sent( 1 ) == vector<string> { "172.16.6.6" }, "eth1 should still have the wider route" );
+  expect( net.pipeline.datagrams_dropped() == 0, "nothing should have been dropped" );
+}
+
+// A datagram that doesn't fit in the ring to its interface's loop is dropped (and counted), not blocked on
+void handoff_overflow()
+{
+  TestNetwork net { 2, 256 };
+  net.add_interface( 0, "10.0.0.1", "10.0.0.2", 0 );
+  net.add_interface( 1, "172.16.0.1", "172.16.0.2", 1 );
+  net.pipeline.add_route( { 0, 0, Address( "172.16.0.2" ), 1 } );
+
+  // loop 1 isn't running, so the ring fills up
+  for ( int i = 0; i < 3; ++i ) {
+    net.arrive( 0, make_datagram( "10.0.0.2", "8.8.8.8", 60 ) );
+  }
+  net.pipeline.route( 0 );
+  expect( net.pipeline.datagrams_dropped() == 1, "the third datagram should have been dropped" );
+
+  bool exception_thrown = false;
+  try {
+    net.pipeline.add_route( { 0, 0, {}, 2 } );
+  } catch ( const runtime_error& ) {
+    exception_thrown = true;
+  }
+  expect( exception_thrown, "a route to a nonexistent interface should be rejected" );
+}
+
+int main()
+{
+  try {
+    forwarding_across_loops();
+    handoff_overflow();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
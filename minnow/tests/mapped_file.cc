@@ -0,0 +1,98 @@
+#include "byte_stream.hh"
+#include "exception.hh"
+#include "mapped_file.hh"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+FileDescriptor temporary_file( const string& contents )
+{
+  FILE* tmp = notnull( "tmpfile", tmpfile() );
+  FileDescriptor file { CheckSystemCall( "dup", dup( fileno( tmp ) ) ) };
+  fclose( tmp ); // NOLINT(*-owning-memory)
+  file.write( contents );
+  return file;
+}
+
+// A read-only mapping, its bounds, and an empty file
+void read_only()
+{
+  const MappedFile file { temporary_file( "mapped bytes" ) };
+  expect( file.size() == 12 and not file.writable(), "mapping should have the file's size" );
+  expect( file.view() == "mapped bytes", "mapping should hold the file's bytes" );
+
+  const Slice slice = file.borrow( 7 );
+  expect( slice.view() == "bytes" and slice.is_borrowed(), "borrow() should borrow the mapping" );
+  expect( slice.data() == file.view().data() + 7, "borrow() should not copy" );
+  file.advise_sequential();
+  file.will_need( 3, 100 );
+  file.dont_need( 0, 12 );
+  expect( file.view() == "mapped bytes", "dropped pages should be reloaded from the file" );
+
+  bool threw = false;
+  try {
+    (void)file.borrow( 13 );
+  } catch ( const out_of_range& ) {
+    threw = true;
+  }
+  expect( threw, "borrow() past the end should throw" );
+
+  const MappedFile empty { temporary_file( "" ) };
+  expect( empty.size() == 0 and empty.view().empty(), "an empty file should map to nothing" );
+}
+
+// Stream a file through a ByteStream from one mapping into another, with no reads or writes
+void stream_between_files()
+{
+  string contents( 300000, 0 );
+  for ( size_t i = 0; i < contents.size(); ++i ) {
+    contents[i] = static_cast<char>( i * 7 % 251 );
+  }
+  MappedFile source { temporary_file( contents ) };
+  source.advise_sequential();
+
+  FileDescriptor destination_file = temporary_file( "" );
+  MappedFile destination { destination_file, contents.size() };
+  expect( destination_file.size() == static_cast<off_t>( contents.size() ), "sink should resize the file" );
+
+  ByteStream stream { 100000 };
+  uint64_t pushed = 0;
+  uint64_t written = 0;
+  while ( written < contents.size() ) {
+    pushed += push_mapped( stream.writer(), source, pushed );
+    expect( stream.reader().peek().data() == source.view().data() + written, "segments should borrow the file" );
+    written += drain( stream.reader(), destination, written );
+  }
+  expect( push_mapped( stream.writer(), source, pushed ) == 0, "nothing should be left to push" );
+  destination.sync();
+
+  expect( destination.view() == contents, "sink mapping should hold the bytes" );
+  string copy( contents.size(), 0 );
+  CheckSystemCall( "pread", static_cast<int>( pread( destination_file.fd_num(), copy.data(), copy.size(), 0 ) ) );
+  expect( copy == contents, "bytes stored in the mapping should reach the file" );
+}
+
+int main()
+{
+  try {
+    read_only();
+    stream_between_files();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
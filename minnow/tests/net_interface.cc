@@ -0,0 +1,373 @@
+#include "arp_message.hh"
+#include "network_interface_test_harness.hh"
+#include "random.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+EthernetAddress random_private_ethernet_address()
+{
+  static auto rd = get_random_engine();
+  EthernetAddress addr;
+  for ( auto& i : addr ) {
+    i = rd(); // NOLINT(*-narrowing-conversions)
+  }
+  addr.at( 0 ) |= 0x02;  // "10" in last two binary digits marks a private Ethernet address
+  addr.at( 0 ) &= 0xfe;
+  return addr;
+}
+
+InternetDatagram make_datagram( const string& src_ip, const string& dst_ip ) // NOLINT(*-swappable-*)
+{
+  InternetDatagram dgram;
+  dgram.header.src = Address( src_ip, 0 ).ipv4_numeric();
+  dgram.header.dst = Address( dst_ip, 0 ).ipv4_numeric();
+  dgram.payload.emplace_back( "hello" + src_ip + dst_ip );
+  dgram.header.len = static_cast<uint64_t>( dgram.header.hlen ) * 4 + dgram.payload.front().size();
+  dgram.header.compute_checksum();
+  return dgram;
+}
+
+ARPMessage make_arp( const uint16_t opcode,
+                     const EthernetAddress& sender_ethernet_address,
+                     const string& sender_ip_address,
+                     const EthernetAddress& target_ethernet_address,
+                     const string& target_ip_address )
+{
+  ARPMessage arp;
+  arp.opcode = opcode;
+  arp.sender_ethernet_address = sender_ethernet_address;
+  arp.sender_ip_address = Address( sender_ip_address, 0 ).ipv4_numeric();
+  arp.target_ethernet_address = target_ethernet_address;
+  arp.target_ip_address = Address( target_ip_address, 0 ).ipv4_numeric();
+  return arp;
+}
+
+EthernetFrame make_frame( const EthernetAddress& src,
+                          const EthernetAddress& dst,
+                          const uint16_t type,
+                          vector<Slice> payload )
+{
+  EthernetFrame frame;
+  frame.header.src = src;
+  frame.header.dst = dst;
+  frame.header.type = type;
+  frame.payload = std::move( payload );
+  return frame;
+}
+
+// The address of the `n`th host in 10.0.0.0/16 (skipping 10.0.0.0)
+string host_ip( uint32_t n )
+{
+  return Address::from_ipv4_numeric( ( 10U << 24 ) + 1 + n ).ip();
+}
+
+int main()
+{
+  try {
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "typical ARP workflow", local_eth, Address( "4.3.2.1", 0 ) };
+
+      const auto datagram = make_datagram( "5.6.7.8", "13.12.11.10" );
+      test.execute( SendDatagram { datagram, Address( "192.168.0.1", 0 ) } );
+
+      // outgoing datagram should result in an ARP request
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "4.3.2.1", {}, "192.168.0.1" ) ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      const EthernetAddress target_eth = random_private_ethernet_address();
+
+      test.execute( Tick { 800 } );
+      test.execute( ExpectNoFrame {} );
+
+      // ARP reply should result in the queued datagram getting sent
+      test.execute( ReceiveFrame { make_frame(
+        target_eth,
+        local_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REPLY, target_eth, "192.168.0.1", local_eth, "4.3.2.1" ) ) ) } );
+
+      test.execute(
+        ExpectFrame { make_frame( local_eth, target_eth, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectNoDatagram {} );
+
+      // any IP reply directed for our Ethernet address should be passed up the stack
+      const auto reply_datagram = make_datagram( "13.12.11.10", "5.6.7.8" );
+      test.execute( ReceiveFrame(
+        make_frame( target_eth, local_eth, EthernetHeader::TYPE_IPv4, serialize( reply_datagram ) ) ) );
+      test.execute( ExpectDatagram { reply_datagram } );
+      test.execute( ExpectNoFrame {} );
+
+      // incoming frames to another Ethernet address (not our own) should be ignored
+      const EthernetAddress another_eth = { 1, 1, 1, 1, 1, 1 };
+      test.execute( ReceiveFrame(
+        make_frame( target_eth, another_eth, EthernetHeader::TYPE_IPv4, serialize( reply_datagram ) ) ) );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectNoDatagram {} );
+
+      // a mapping that was learned is used right away
+      const auto second_datagram = make_datagram( "5.6.7.8", "19.18.17.16" );
+      test.execute( SendDatagram { second_datagram, Address( "192.168.0.1", 0 ) } );
+      test.execute( ExpectFrame {
+        make_frame( local_eth, target_eth, EthernetHeader::TYPE_IPv4, serialize( second_datagram ) ) } );
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "reply to ARP request", local_eth, Address( "5.5.5.5", 0 ) };
+      test.execute( ReceiveFrame { make_frame(
+        remote_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, remote_eth, "10.0.1.1", {}, "7.7.7.7" ) ) ) } );
+      test.execute( ExpectNoFrame {} ); // not for us
+      test.execute( ReceiveFrame { make_frame(
+        remote_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, remote_eth, "10.0.1.1", {}, "5.5.5.5" ) ) ) } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        remote_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REPLY, local_eth, "5.5.5.5", remote_eth, "10.0.1.1" ) ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // the requester's mapping was learned from its request
+      const auto datagram = make_datagram( "5.5.5.5", "10.0.1.1" );
+      test.execute( SendDatagram { datagram, Address( "10.0.1.1", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test {
+        "ignore unsupported and truncated frames", local_eth, Address( "5.5.5.5", 0 ) };
+      const auto arp_request
+        = serialize( make_arp( ARPMessage::OPCODE_REQUEST, remote_eth, "10.0.1.1", {}, "5.5.5.5" ) );
+
+      // an ARP message with an unknown opcode
+      string bad_opcode = concat( arp_request );
+      bad_opcode.at( 7 ) = 9;
+      test.execute( ReceiveFrame { make_frame(
+        remote_eth, ETHERNET_BROADCAST, EthernetHeader::TYPE_ARP, { Slice { std::move( bad_opcode ) } } ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // a truncated ARP message
+      string truncated = concat( arp_request ).substr( 0, ARPMessage::LENGTH - 1 );
+      test.execute( ReceiveFrame { make_frame(
+        remote_eth, ETHERNET_BROADCAST, EthernetHeader::TYPE_ARP, { Slice { std::move( truncated ) } } ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectCacheSize { 0 } );
+
+      // an IPv4 datagram with a bad checksum
+      auto datagram = make_datagram( "10.0.1.1", "5.5.5.5" );
+      datagram.header.cksum++;
+      test.execute(
+        ReceiveFrame { make_frame( remote_eth, local_eth, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      test.execute( ExpectNoDatagram {} );
+
+      // a frame of an unknown type
+      test.execute( ReceiveFrame { make_frame( remote_eth, local_eth, 0x86dd, { Slice { "xyzzy"s } } ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectNoDatagram {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "pending mappings last five seconds", local_eth, Address( "1.2.3.4", 0 ) };
+
+      const auto arp_request = make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "1.2.3.4", {}, "10.0.0.1" ) ) );
+
+      const auto first = make_datagram( "5.6.7.8", "13.12.11.10" );
+      test.execute( SendDatagram { first, Address( "10.0.0.1", 0 ) } );
+      test.execute( ExpectFrame { arp_request } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( Tick { 4990 } );
+
+      // a second datagram to the same next hop doesn't repeat the request
+      test.execute( SendDatagram { make_datagram( "17.17.17.17", "18.18.18.18" ), Address( "10.0.0.1", 0 ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( Tick { 20 } );
+
+      // the request lapsed unanswered (and the datagrams waiting on it with it), so the next one asks again
+      test.execute( ExpectCacheSize { 0 } );
+      const auto third = make_datagram( "42.41.40.39", "13.12.11.10" );
+      test.execute( SendDatagram { third, Address( "10.0.0.1", 0 ) } );
+      test.execute( ExpectFrame { arp_request } );
+      test.execute( ExpectNoFrame {} );
+
+      const EthernetAddress target_eth = random_private_ethernet_address();
+      test.execute( ReceiveFrame { make_frame(
+        target_eth,
+        local_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REPLY, target_eth, "10.0.0.1", local_eth, "1.2.3.4" ) ) ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, target_eth, EthernetHeader::TYPE_IPv4, serialize( third ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // once resolved, the mapping outlives the request's five seconds
+      test.execute( Tick { 6000 } );
+      test.execute( SendDatagram { first, Address( "10.0.0.1", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, target_eth, EthernetHeader::TYPE_IPv4, serialize( first ) ) } );
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "active mappings last 30 seconds", local_eth, Address( "4.3.2.1", 0 ) };
+
+      const auto datagram = make_datagram( "5.6.7.8", "13.12.11.10" );
+      test.execute( ReceiveFrame { make_frame(
+        remote_eth,
+        local_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth, "10.0.0.1", local_eth, "4.3.2.1" ) ) ) } );
+      test.execute( Tick { 29999 } );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.1", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // after 30 seconds, the mapping is forgotten
+      test.execute( Tick { 1 } );
+      test.execute( ExpectCacheSize { 0 } );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.1", 0 ) } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "4.3.2.1", {}, "10.0.0.1" ) ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // hearing from a host again refreshes its mapping
+      test.execute( ReceiveFrame { make_frame(
+        remote_eth,
+        local_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth, "10.0.0.1", local_eth, "4.3.2.1" ) ) ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      test.execute( Tick { 20000 } );
+      test.execute( ReceiveFrame { make_frame(
+        remote_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, remote_eth, "10.0.0.1", {}, "10.0.0.2" ) ) ) } );
+      test.execute( Tick { 20000 } );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.1", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "pending datagrams are bounded", local_eth, Address( "4.3.2.1", 0 ) };
+
+      const size_t extra = 3;
+      vector<InternetDatagram> datagrams;
+      for ( size_t i = 0; i < NetworkInterface::MAX_PENDING_DATAGRAMS + extra; ++i ) {
+        datagrams.push_back( make_datagram( "5.6.7.8", host_ip( i ) ) );
+        test.execute( SendDatagram { datagrams.back(), Address( "10.0.0.1", 0 ) } );
+      }
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "4.3.2.1", {}, "10.0.0.1" ) ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // only the newest datagrams were kept, in order
+      test.execute( ReceiveFrame { make_frame(
+        remote_eth,
+        local_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth, "10.0.0.1", local_eth, "4.3.2.1" ) ) ) } );
+      for ( size_t i = extra; i < datagrams.size(); ++i ) {
+        test.execute( ExpectFrame {
+          make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagrams.at( i ) ) ) } );
+      }
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "thousands of hosts", local_eth, Address( "10.0.255.254", 0 ) };
+
+      // Learn the addresses of many hosts, in two waves 15 seconds apart.
+      const uint32_t wave = 3000;
+      vector<EthernetAddress> host_eths;
+      for ( uint32_t i = 0; i < 2 * wave; ++i ) {
+        if ( i == wave ) {
+          test.execute( Tick { 15000 } );
+        }
+        host_eths.push_back( random_private_ethernet_address() );
+        test.execute( ReceiveFrame { make_frame(
+          host_eths.back(),
+          ETHERNET_BROADCAST,
+          EthernetHeader::TYPE_ARP,
+          serialize( make_arp( ARPMessage::OPCODE_REQUEST, host_eths.back(), host_ip( i ), {}, "10.0.0.0" ) ) ) } );
+      }
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectCacheSize { 2 * wave } );
+
+      // every host's datagrams go straight out
+      for ( uint32_t i = 0; i < 2 * wave; i += 7 ) {
+        const auto datagram = make_datagram( "10.0.255.254", host_ip( i ) );
+        test.execute( SendDatagram { datagram, Address( host_ip( i ), 0 ) } );
+        test.execute( ExpectFrame {
+          make_frame( local_eth, host_eths.at( i ), EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      }
+
+      // The first wave expires (with the second wave's entries moved around in the table to fill the gaps).
+      test.execute( Tick { 15000 } );
+      test.execute( ExpectCacheSize { wave } );
+      for ( uint32_t i = 0; i < 2 * wave; i += 7 ) {
+        const auto datagram = make_datagram( "10.0.255.254", host_ip( i ) );
+        test.execute( SendDatagram { datagram, Address( host_ip( i ), 0 ) } );
+        if ( i < wave ) {
+          test.execute( ExpectFrame { make_frame(
+            local_eth,
+            ETHERNET_BROADCAST,
+            EthernetHeader::TYPE_ARP,
+            serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.255.254", {}, host_ip( i ) ) ) ) } );
+        } else {
+          test.execute( ExpectFrame {
+            make_frame( local_eth, host_eths.at( i ), EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+        }
+      }
+      test.execute( ExpectNoFrame {} );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
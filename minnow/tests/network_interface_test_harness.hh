@@ -0,0 +1,210 @@
+#pragma once
+
+#include "arp_message.hh"
+#include "common.hh"
+#include "helpers.hh"
+#include "network_interface.hh"
+
+#include <memory>
+#include <queue>
+#include <string>
+#include <utility>
+
+// The frames a NetworkInterface has transmitted (that the test hasn't checked yet)
+class FramesOut : public NetworkInterface::OutputPort
+{
+public:
+  std::queue<EthernetFrame> frames {};
+
+  void transmit( const NetworkInterface& /* unused */, const EthernetFrame& frame ) override
+  {
+    frames.push( frame );
+  }
+};
+
+inline FramesOut& frames_out( NetworkInterface& interface )
+{
+  return dynamic_cast<FramesOut&>( interface.output() );
+}
+
+inline const FramesOut& frames_out( const NetworkInterface& interface )
+{
+  return dynamic_cast<const FramesOut&>( interface.output() );
+}
+
+inline std::string summary( const EthernetFrame& frame )
+{
+  std::string out = frame.header.to_string() + ", payload: ";
+  switch ( frame.header.type ) {
+    case EthernetHeader::TYPE_IPv4: {
+      InternetDatagram dgram;
+      if ( parse( dgram, frame.payload ) ) {
+        out += "IPv4: " + dgram.header.to_string() + " payload=\"" + pretty_print( concat( dgram.payload ) ) + "\"";
+      } else {
+        out += "bad IPv4 datagram";
+      }
+    } break;
+    case EthernetHeader::TYPE_ARP: {
+      ARPMessage arp;
+      if ( parse( arp, frame.payload ) ) {
+        out += "ARP: " + arp.to_string();
+      } else {
+        out += "bad ARP message";
+      }
+    } break;
+    default:
+      out += "unknown frame type";
+      break;
+  }
+  return out;
+}
+
+class NetworkInterfaceTestHarness : public TestHarness<NetworkInterface>
+{
+public:
+  NetworkInterfaceTestHarness( std::string test_name,
+                               const EthernetAddress& ethernet_address,
+                               const Address& ip_address )
+    : TestHarness( test_name,
+                   "eth=" + to_string( ethernet_address ) + ", ip=" + ip_address.ip(),
+                   NetworkInterface { test_name, std::make_shared<FramesOut>(), ethernet_address, ip_address } )
+  {}
+};
+
+/* actions */
+
+struct SendDatagram : public Action<NetworkInterface>
+{
+  InternetDatagram dgram;
+  Address next_hop;
+
+  SendDatagram( InternetDatagram d, Address n ) : dgram( std::move( d ) ), next_hop( std::move( n ) ) {}
+
+  std::string description() const override
+  {
+    return "request to send datagram (to next hop " + next_hop.ip() + "): " + dgram.header.to_string();
+  }
+
+  void execute( NetworkInterface& interface ) const override { interface.send_datagram( dgram, next_hop ); }
+};
+
+struct ReceiveFrame : public Action<NetworkInterface>
+{
+  EthernetFrame frame;
+
+  explicit ReceiveFrame( EthernetFrame f ) : frame( std::move( f ) ) {}
+
+  std::string description() const override { return "frame arrives (" + summary( frame ) + ")"; }
+
+  void execute( NetworkInterface& interface ) const override { interface.recv_frame( frame ); }
+};
+
+struct Tick : public Action<NetworkInterface>
+{
+  size_t ms;
+
+  explicit Tick( size_t milliseconds ) : ms( milliseconds ) {}
+
+  std::string description() const override { return std::to_string( ms ) + " ms pass"; }
+
+  void execute( NetworkInterface& interface ) const override { interface.tick( ms ); }
+};
+
+/* expectations */
+
+struct ExpectFrame : public Expectation<NetworkInterface>
+{
+  EthernetFrame expected;
+
+  explicit ExpectFrame( EthernetFrame e ) : expected( std::move( e ) ) {}
+
+  std::string description() const override { return "frame transmitted (" + summary( expected ) + ")"; }
+
+  // Checking a frame takes it from the queue, so this expectation needs the non-const object.
+  void execute( NetworkInterface& interface ) const override
+  {
+    std::queue<EthernetFrame>& frames = frames_out( interface ).frames;
+    if ( frames.empty() ) {
+      throw ExpectationViolation( "NetworkInterface should have sent an Ethernet frame, but it didn't" );
+    }
+    const EthernetFrame frame = std::move( frames.front() );
+    frames.pop();
+
+    if ( concat( serialize( frame ) ) != concat( serialize( expected ) ) ) {
+      throw ExpectationViolation( "NetworkInterface sent a different Ethernet frame than was expected: actual={"
+                                  + summary( frame ) + "}" );
+    }
+  }
+
+  void execute( const NetworkInterface& /* unused */ ) const override
+  {
+    throw std::logic_error( "ExpectFrame must be able to take the frame it checks" );
+  }
+};
+
+struct ExpectNoFrame : public Expectation<NetworkInterface>
+{
+  std::string description() const override { return "no frame transmitted"; }
+
+  void execute( const NetworkInterface& interface ) const override
+  {
+    if ( not frames_out( interface ).frames.empty() ) {
+      throw ExpectationViolation( "NetworkInterface sent an unexpected Ethernet frame: "
+                                  + summary( frames_out( interface ).frames.front() ) );
+    }
+  }
+};
+
+struct ExpectDatagram : public Expectation<NetworkInterface>
+{
+  InternetDatagram expected;
+
+  explicit ExpectDatagram( InternetDatagram d ) : expected( std::move( d ) ) {}
+
+  std::string description() const override { return "datagram received: " + expected.header.to_string(); }
+
+  void execute( NetworkInterface& interface ) const override
+  {
+    std::queue<InternetDatagram>& datagrams = interface.datagrams_received();
+    if ( datagrams.empty() ) {
+      throw ExpectationViolation( "NetworkInterface should have received a datagram, but it didn't" );
+    }
+    const InternetDatagram dgram = std::move( datagrams.front() );
+    datagrams.pop();
+
+    if ( concat( serialize( dgram ) ) != concat( serialize( expected ) ) ) {
+      throw ExpectationViolation( "NetworkInterface received a different datagram than was expected: actual={"
+                                  + dgram.header.to_string() + "}" );
+    }
+  }
+
+  void execute( const NetworkInterface& /* unused */ ) const override
+  {
+    throw std::logic_error( "ExpectDatagram must be able to take the datagram it checks" );
+  }
+};
+
+struct ExpectNoDatagram : public Expectation<NetworkInterface>
+{
+  std::string description() const override { return "no datagram received"; }
+
+  void execute( NetworkInterface& interface ) const override
+  {
+    if ( not interface.datagrams_received().empty() ) {
+      throw ExpectationViolation( "NetworkInterface received an unexpected datagram: "
+                                  + interface.datagrams_received().front().header.to_string() );
+    }
+  }
+
+  void execute( const NetworkInterface& /* unused */ ) const override
+  {
+    throw std::logic_error( "ExpectNoDatagram needs the non-const NetworkInterface" );
+  }
+};
+
+struct ExpectCacheSize : public ExpectNumber<NetworkInterface, size_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "arp_cache_size"; }
+  size_t value( const NetworkInterface& interface ) const override { return interface.arp_cache_size(); }
+};
@@ -0,0 +1,299 @@
+#include "arp_message.hh"
+#include "buffer_pool.hh"
+#include "byte_stream.hh"
+#include "ethernet_frame.hh"
+#include "helpers.hh"
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "tcp_segment.hh"
+
+#include <array>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+const string header = "\x45\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f"s;
+
+// Split `data` into segments at each of `cuts`
+vector<string> split( const string& data, const vector<size_t>& cuts )
+{
+  vector<string> segments;
+  size_t start = 0;
+  for ( const size_t cut : cuts ) {
+    segments.push_back( data.substr( start, cut - start ) );
+    start = cut;
+  }
+  segments.push_back( data.substr( start ) );
+  return segments;
+}
+
+// integers parse the same whether they sit in one segment (the fast path) or straddle segments
+void integers_across_segments()
+{
+  const vector<vector<size_t>> splits { {}, { 1 }, { 2, 3 }, { 0, 5, 5, 9 }, { 1, 2, 3, 4, 5, 6, 7 } };
+  for ( const auto& cuts : splits ) {
+    Parser p { split( header, cuts ) };
+    uint8_t a {};
+    uint16_t b {};
+    uint32_t c {};
+    uint64_t d {};
+    p.integer( a );
+    p.integer( b );
+    p.integer( c );
+    p.integer( d );
+    expect( not p.has_error(), "parse should succeed" );
+    expect( a == 0x45 and b == 0x0001 and c == 0x02030405 and d == 0x060708090a0b0c0d, "wrong integer values" );
+
+    array<char, 2> rest {};
+    p.string( rest );
+    expect( not p.has_error() and string( rest.data(), rest.size() ) == "\x0e\x0f", "wrong remaining bytes" );
+  }
+}
+
+// a whole header in one bounds check; too-short input leaves the outputs alone and sets the error
+void whole_header()
+{
+  for ( const auto& cuts : vector<vector<size_t>> { {}, { 3 } } ) {
+    Parser p { split( header, cuts ) };
+    uint8_t version_and_length {};
+    uint8_t tos {};
+    uint16_t total_length {};
+    uint32_t rest {};
+    p.integers( version_and_length, tos, total_length, rest );
+    expect( not p.has_error(), "header parse should succeed" );
+    expect( version_and_length == 0x45 and tos == 0 and total_length == 0x0102 and rest == 0x03040506,
+            "wrong header fields" );
+  }
+
+  Parser p { vector<string> { "\x01\x02\x03"s } };
+  uint16_t first = 7;
+  uint16_t second = 7;
+  p.integers( first, second );
+  expect( p.has_error() and first == 7 and second == 7, "short header should fail without parsing anything" );
+
+  Parser q { vector<string> { "\x01"s } };
+  uint32_t value = 7;
+  q.integer( value );
+  expect( q.has_error() and value == 7, "short integer should fail" );
+}
+
+// the other accessors keep track of the segments and the offset into the first
+void remaining()
+{
+  Parser p { vector<string> { "ab"s, ""s, "cdef"s, "g"s } };
+  p.remove_prefix( 3 );
+  p.truncate( 3 );
+  string all;
+  p.concatenate_all_remaining( all );
+  expect( all == "def", "wrong remaining bytes: " + all );
+
+  Parser q { vector<string> { "ab"s, "cdef"s } };
+  q.remove_prefix( 1 );
+  vector<Ref<string>> out;
+  q.all_remaining( out );
+  expect( out.size() == 2 and out[0].get() == "b" and out[1].get() == "cdef", "wrong remaining segments" );
+}
+
+// A header followed by a payload, as the network objects serialize themselves
+struct Message
+{
+  uint8_t type {};
+  uint16_t length {};
+  uint32_t sequence {};
+  uint64_t timestamp {};
+  string payload {};
+
+  void serialize( Serializer& s ) const
+  {
+    s.integer( type );
+    s.integer( length );
+    s.integer( sequence );
+    s.integer( timestamp );
+    s.buffer( Ref<string>::borrow( payload ) );
+  }
+};
+
+// the three ways to serialize give the same bytes, and the counts are known in advance
+void serializer()
+{
+  const Message message { 0x45, 0x0001, 0x02030405, 0x060708090a0b0c0d, "payload" };
+  const string expected = header.substr( 0, 15 ) + "payload";
+
+  expect( serialized_length( message ) == expected.size(), "wrong serialized length" );
+
+  const auto segments = serialize( message );
+  expect( segments.size() == 2, "the payload should be kept as its own segment" );
+  expect( segments[0].size() == 15, "the header should be one segment" );
+  expect( segments[1].is_borrowed(), "the payload should not be copied" );
+  expect( concat( segments ) == expected, "wrong serialized bytes" );
+
+  array<char, 32> out {};
+  expect( serialize_into( message, out ) == expected.size(), "wrong length written to span" );
+  expect( string( out.data(), expected.size() ) == expected, "wrong bytes written to span" );
+
+  array<char, 10> too_small {};
+  bool threw = false;
+  try {
+    serialize_into( message, too_small );
+  } catch ( const runtime_error& ) {
+    threw = true;
+  }
+  expect( threw, "serializing past the end of a span should throw" );
+
+  string pooled = BufferPool::take();
+  const char* storage = pooled.data();
+  Serializer s { move( pooled ) };
+  message.serialize( s );
+  const auto reused = s.finish();
+  expect( reused[0].data() == storage and reused[0].size() == 15, "storage should be reused" );
+
+  Parser p { vector<string> { concat( segments ) } };
+  Message parsed;
+  p.integers( parsed.type, parsed.length, parsed.sequence, parsed.timestamp );
+  p.concatenate_all_remaining( parsed.payload );
+  expect( not p.has_error() and parsed.timestamp == message.timestamp and parsed.payload == message.payload,
+          "serialized message should parse back" );
+}
+
+// serialize() reserves a type's copied_length() up front: it must be what serializing actually copies
+template<class T>
+void expect_copied_length( const T& obj, const string& name )
+{
+  Serializer counter { Serializer::CountOnly {} };
+  obj.serialize( counter );
+  expect( copied_length_hint( obj ) == counter.copied_length(), name + ": copied_length() should match" );
+}
+
+void copied_lengths()
+{
+  IPv4Datagram dgram;
+  dgram.payload.emplace_back( "payload"s );
+  expect_copied_length( dgram, "IPv4Datagram" );
+  expect_copied_length( EthernetFrame { {}, serialize( dgram ) }, "EthernetFrame" );
+  expect_copied_length( ARPMessage { .opcode = ARPMessage::OPCODE_REQUEST }, "ARPMessage" );
+
+  TCPSegment segment;
+  segment.message.payload = "payload"s;
+  expect_copied_length( segment, "TCPSegment" );
+  segment.mss = 1460;
+  segment.sack_permitted = true;
+  segment.window_scale = 7;
+  expect_copied_length( segment, "TCPSegment with options" );
+}
+
+// Parse a serialized segment, with the given window shift
+TCPSegment reparse( const TCPSegment& segment, uint8_t window_shift )
+{
+  Parser p { serialize( segment ) };
+  TCPSegment parsed;
+  parsed.window_shift = window_shift;
+  parsed.parse( p, 0 );
+  expect( not p.has_error(), "serialized TCPSegment should parse back" );
+  return parsed;
+}
+
+// A window is scaled on the wire (except on a SYN), and saturates at what the field can carry
+void window_scaling()
+{
+  TCPSegment segment;
+  segment.reply.window_size = 1000000;
+  segment.window_shift = 7;
+  segment.compute_checksum( 0 );
+  expect( reparse( segment, 7 ).reply.window_size == ( 1000000 >> 7 << 7 ), "window should be scaled" );
+
+  segment.window_shift = 0;
+  segment.compute_checksum( 0 );
+  expect( reparse( segment, 0 ).reply.window_size == UINT16_MAX, "unscaled window should saturate" );
+
+  segment.message.SYN = true;
+  segment.window_shift = 7;
+  segment.window_scale = 7;
+  segment.compute_checksum( 0 );
+  const TCPSegment syn = reparse( segment, 7 );
+  expect( syn.reply.window_size == UINT16_MAX, "a SYN's window should not be scaled" );
+  expect( syn.window_scale == 7, "window scale option should parse back" );
+
+  expect( TCPSegment::window_scale_for( UINT16_MAX ) == 0 and TCPSegment::window_scale_for( 1 << 20 ) == 5
+            and TCPSegment::window_scale_for( UINT64_MAX ) == TCPSegment::MAX_WINDOW_SCALE,
+          "wrong window scale" );
+}
+
+// Slices share their string: splitting one never copies, and releasing the last one moves the string out
+void slices()
+{
+  Slice whole { "hello, world, at some length"s };
+  const char* storage = whole.data();
+  Slice hello = whole.split_prefix( 5 );
+  expect( hello.view() == "hello" and whole.view() == ", world, at some length", "wrong split" );
+  expect( hello.data() == storage and whole.substr( 2 ).data() == storage + 7, "Slices should share their string" );
+
+  expect( string { move( hello ).release() } == "hello", "a shared Slice should release a copy" );
+  whole.remove_suffix( 16 );
+  const string released = move( whole ).release();
+  expect( released == ", world" and released.data() == storage, "the last Slice should release its string" );
+
+  const string owner = "borrowed";
+  const Slice borrowed { Ref<string>::borrow( owner ) };
+  expect( borrowed.is_borrowed() and borrowed.data() == owner.data(), "a borrowed Ref should stay borrowed" );
+
+  ByteStream stream { 6 };
+  stream.writer().push( Slice { "abcd"s }.substr( 1 ) );
+  stream.writer().push( Slice { "efgh"s } );
+  expect( stream.reader().bytes_buffered() == 6, "a Slice should be truncated to fit" );
+  string out;
+  read( stream.reader(), 6, out );
+  expect( out == "bcdefg", "wrong bytes read from Slices: " + out );
+}
+
+// a payload parsed out of a frame is a view of the frame's bytes, and its own payload likewise
+void nested_payloads()
+{
+  const Message inner { 1, 2, 3, 4, "the innermost payload" };
+  Message outer { 5, 6, 7, 8, concat( serialize( inner ) ) };
+  const string frame = concat( serialize( outer ) );
+
+  const vector<Slice> segments { Slice { string { frame.substr( 0, 10 ) } }, Slice::borrow( frame ).substr( 10 ) };
+  Parser p { segments };
+  Message parsed;
+  p.integers( parsed.type, parsed.length, parsed.sequence, parsed.timestamp );
+  vector<Slice> payload;
+  p.all_remaining( payload );
+  expect( not p.has_error() and parsed.timestamp == 8, "outer header should parse" );
+  expect( payload.size() == 1 and payload[0].data() == frame.data() + 15, "outer payload should not be copied" );
+
+  Parser q { payload };
+  q.integers( parsed.type, parsed.length, parsed.sequence, parsed.timestamp );
+  q.truncate( 9 );
+  expect( not q.has_error() and q.slices().size() == 1 and q.slices()[0].data() == frame.data() + 30
+            and q.slices()[0].view() == "the inner",
+          "inner payload should be a view of the frame" );
+}
+
+int main()
+{
+  try {
+    integers_across_segments();
+    whole_header();
+    remaining();
+    serializer();
+    copied_lengths();
+    window_scaling();
+    slices();
+    nested_payloads();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+#include "helpers.hh"
+#include "ipv4_datagram.hh"
+#include "speed_harness.hh"
+
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+constexpr size_t datagrams_per_test = 1'000'000;
+
+InternetDatagram make_datagram( size_t payload_length )
+{
+  default_random_engine rd { 144 };
+  string payload( payload_length, 0 );
+  for ( auto& c : payload ) {
+    c = static_cast<char>( rd() );
+  }
+
+  InternetDatagram dgram;
+  dgram.header.src = 0x0a000001;
+  dgram.header.dst = 0xc0a80001;
+  dgram.header.len = IPv4Header::LENGTH + payload_length;
+  dgram.header.compute_checksum();
+  dgram.payload.emplace_back( move( payload ) );
+  return dgram;
+}
+
+Benchmark::Parameters parameters( size_t payload_length, size_t segments )
+{
+  return { { "payload_length", to_string( payload_length ) }, { "segments", to_string( segments ) } };
+}
+
+void check_speed( const BenchmarkResult& result, double minimum_ops_per_second )
+{
+  if ( result.ops_per_second() < minimum_ops_per_second ) {
+    throw runtime_error( result.name + " did not meet minimum speed of " + to_string( minimum_ops_per_second )
+                         + " op/s" );
+  }
+}
+
+// Parse a datagram whose bytes arrive in `segments` pieces (the header split across the first two)
+void parse_test( BenchmarkSuite& suite, size_t payload_length, size_t segments )
+{
+  const string bytes = concat( serialize( make_datagram( payload_length ) ) );
+  vector<Slice> input;
+  for ( size_t i = 0, start = 0; i < segments; ++i ) {
+    const size_t end = i + 1 == segments ? bytes.size() : min( bytes.size(), start + IPv4Header::LENGTH / 2 );
+    input.emplace_back( bytes.substr( start, end - start ) );
+    start = end;
+  }
+
+  Benchmark benchmark { "Parser (IPv4 datagram)", parameters( payload_length, segments ) };
+  uint64_t checksums = 0;
+  benchmark.start();
+  for ( size_t i = 0; i < datagrams_per_test; ++i ) {
+    InternetDatagram dgram;
+    if ( not parse( dgram, span<const Slice> { input } ) ) { // (copying the Slices, not moving them out)
+      throw runtime_error( "datagram did not parse" );
+    }
+    checksums += dgram.header.cksum;
+    benchmark.op( bytes.size() );
+  }
+  const BenchmarkResult& result = suite.record( benchmark.finish() );
+
+  if ( checksums == 0 ) {
+    throw runtime_error( "parsed datagrams have no checksum" );
+  }
+  check_speed( result, 1e5 );
+}
+
+// Serialize a datagram into segments (the header copied, and the payload shared) or into a buffer
+void serialize_test( BenchmarkSuite& suite, size_t payload_length, bool into_buffer )
+{
+  const InternetDatagram dgram = make_datagram( payload_length );
+  string buffer( serialized_length( dgram ), 0 );
+
+  Benchmark benchmark { into_buffer ? "Serializer (IPv4 datagram, into a buffer)" : "Serializer (IPv4 datagram)",
+                        { { "payload_length", to_string( payload_length ) } } };
+  uint64_t length = 0;
+  benchmark.start();
+  for ( size_t i = 0; i < datagrams_per_test; ++i ) {
+    const uint64_t serialized = into_buffer ? serialize_into( dgram, span { buffer } ) : serialize( dgram ).size();
+    length += serialized;
+    benchmark.op( buffer.size() );
+  }
+  const BenchmarkResult& result = suite.record( benchmark.finish() );
+
+  if ( length == 0 ) {
+    throw runtime_error( "nothing serialized" );
+  }
+  check_speed( result, 1e5 );
+}
+
+void program_body( BenchmarkSuite& suite )
+{
+  for ( const size_t payload_length : { 0, 1460 } ) {
+    for ( const size_t segments : { 1, 3 } ) {
+      parse_test( suite, payload_length, segments );
+    }
+    serialize_test( suite, payload_length, false );
+    serialize_test( suite, payload_length, true );
+  }
+}
+} // namespace
+
+int main( int argc, char* argv[] )
+{
+  try {
+    BenchmarkSuite suite { "parser", argc, argv };
+    program_body( suite );
+    suite.report();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ReassemblerTestHarness test { "all within capacity", 2 };
+
+      test.execute( Insert { "ab", 0 } );
+      test.execute( BytesPushed { 2 } );
+      test.execute( ReadAll { "ab" } );
+
+      test.execute( Insert { "cd", 2 } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( ReadAll { "cd" } );
+
+      test.execute( Insert { "ef", 4 } );
+      test.execute( BytesPushed { 6 } );
+      test.execute( ReadAll { "ef" } );
+    }
+
+    {
+      ReassemblerTestHarness test { "insert beyond capacity", 2 };
+
+      test.execute( Insert { "ab", 0 } );
+      test.execute( BytesPushed { 2 } );
+
+      test.execute( Insert { "cd", 2 } );
+      test.execute( BytesPushed { 2 } );
+      test.execute( BytesPending { 0 } );
+
+      test.execute( ReadAll { "ab" } );
+      test.execute( BytesPushed { 2 } );
+
+      test.execute( Insert { "cd", 2 } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( ReadAll { "cd" } );
+    }
+
+    {
+      ReassemblerTestHarness test { "overflow discards the tail", 1 };
+
+      test.execute( Insert { "ab", 0 } );
+      test.execute( BytesPushed { 1 } );
+      test.execute( Insert { "ab", 0 } );
+      test.execute( BytesPushed { 1 } );
+      test.execute( ReadAll { "a" } );
+
+      test.execute( Insert { "abc", 0 } );
+      test.execute( BytesPushed { 2 } );
+      test.execute( ReadAll { "b" } );
+    }
+
+    {
+      ReassemblerTestHarness test { "stored bytes are clipped to the window", 3 };
+
+      test.execute( Insert { "bcdef", 1 } );
+      test.execute( BytesPending { 2 } );
+      test.execute( BytesPushed { 0 } );
+
+      test.execute( Insert { "a", 0 } );
+      test.execute( BytesPending { 0 } );
+      test.execute( ReadAll { "abc" } );
+
+      test.execute( Insert { "def", 3 }.is_last() );
+      test.execute( ReadAll { "def" } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ReassemblerTestHarness test { "last substring beyond capacity", 4 };
+
+      test.execute( Insert { "abcdefgh", 0 }.is_last() );
+      test.execute( BytesPushed { 4 } );
+      test.execute( IsClosed { false } );
+      test.execute( ReadAll { "abcd" } );
+
+      test.execute( Insert { "efgh", 4 } );
+      test.execute( ReadAll { "efgh" } );
+      test.execute( IsFinished { true } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
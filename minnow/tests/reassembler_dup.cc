@@ -0,0 +1,103 @@
+#include "random.hh"
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      ReassemblerTestHarness test { "dup 1", 65000 };
+
+      test.execute( Insert { "abcd", 0 } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( ReadAll { "abcd" } );
+      test.execute( IsFinished { false } );
+
+      test.execute( Insert { "abcd", 0 } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( ReadAll { "" } );
+      test.execute( IsFinished { false } );
+    }
+
+    {
+      ReassemblerTestHarness test { "dup 2", 65000 };
+
+      test.execute( Insert { "abcd", 0 } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( ReadAll { "abcd" } );
+      test.execute( IsFinished { false } );
+
+      test.execute( Insert { "abcd", 4 } );
+      test.execute( BytesPushed { 8 } );
+      test.execute( ReadAll { "abcd" } );
+      test.execute( IsFinished { false } );
+
+      test.execute( Insert { "abcd", 0 } );
+      test.execute( BytesPushed { 8 } );
+      test.execute( ReadAll { "" } );
+      test.execute( IsFinished { false } );
+
+      test.execute( Insert { "abcd", 4 } );
+      test.execute( BytesPushed { 8 } );
+      test.execute( ReadAll { "" } );
+      test.execute( IsFinished { false } );
+    }
+
+    {
+      ReassemblerTestHarness test { "dup stored", 65000 };
+
+      test.execute( Insert { "cd", 2 } );
+      test.execute( Insert { "cd", 2 } );
+      test.execute( Insert { "d", 3 } );
+      test.execute( BytesPending { 2 } );
+      test.execute( BytesPushed { 0 } );
+
+      test.execute( Insert { "ab", 0 } );
+      test.execute( BytesPending { 0 } );
+      test.execute( ReadAll { "abcd" } );
+    }
+
+    {
+      ReassemblerTestHarness test { "dup 3", 65000 };
+
+      const string data = "abcdefgh";
+      test.execute( Insert { data, 0 } );
+      test.execute( BytesPushed { 8 } );
+      test.execute( ReadAll { data } );
+      test.execute( IsFinished { false } );
+
+      for ( size_t i = 0; i < 1000; ++i ) {
+        const size_t start_i = uniform_int_distribution<size_t> { 0, 8 }( rd );
+        const size_t end_i = uniform_int_distribution<size_t> { start_i, 8 }( rd );
+        test.execute( Insert { data.substr( start_i, end_i - start_i ), start_i } );
+        test.execute( BytesPushed { 8 } );
+        test.execute( ReadAll { "" } );
+        test.execute( IsFinished { false } );
+      }
+    }
+
+    {
+      ReassemblerTestHarness test { "dup 4", 65000 };
+
+      test.execute( Insert { "abcd", 0 } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( ReadAll { "abcd" } );
+
+      test.execute( Insert { "abcdef", 0 } );
+      test.execute( BytesPushed { 6 } );
+      test.execute( ReadAll { "ef" } );
+      test.execute( IsFinished { false } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
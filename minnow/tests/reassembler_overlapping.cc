@@ -0,0 +1,118 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ReassemblerTestHarness test { "overlapping assembled (unread) section", 1000 };
+
+      test.execute( Insert { "a", 0 } );
+      test.execute( Insert { "ab", 0 } );
+      test.execute( BytesPushed { 2 } );
+      test.execute( ReadAll { "ab" } );
+    }
+
+    {
+      ReassemblerTestHarness test { "overlapping assembled (read) section", 1000 };
+
+      test.execute( Insert { "a", 0 } );
+      test.execute( ReadAll { "a" } );
+      test.execute( Insert { "ab", 0 } );
+      test.execute( BytesPushed { 2 } );
+      test.execute( ReadAll { "b" } );
+    }
+
+    {
+      ReassemblerTestHarness test { "overlapping unassembled section, to fill hole", 1000 };
+
+      test.execute( Insert { "b", 1 } );
+      test.execute( BytesPending { 1 } );
+      test.execute( Insert { "ab", 0 } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 2 } );
+      test.execute( ReadAll { "ab" } );
+    }
+
+    {
+      ReassemblerTestHarness test { "overlapping unassembled section", 1000 };
+
+      test.execute( Insert { "b", 1 } );
+      test.execute( Insert { "bc", 1 } );
+      test.execute( BytesPending { 2 } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( ReadAll { "" } );
+    }
+
+    {
+      ReassemblerTestHarness test { "overlapping unassembled section 2", 1000 };
+
+      test.execute( Insert { "c", 2 } );
+      test.execute( Insert { "bcd", 1 } );
+      test.execute( BytesPending { 3 } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( ReadAll { "" } );
+    }
+
+    {
+      ReassemblerTestHarness test { "overlapping multiple unassembled sections", 1000 };
+
+      test.execute( Insert { "b", 1 } );
+      test.execute( Insert { "d", 3 } );
+      test.execute( Insert { "f", 5 } );
+      test.execute( BytesPending { 3 } );
+      test.execute( Insert { "bcdefg", 1 } );
+      test.execute( BytesPending { 6 } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( Insert { "a", 0 } );
+      test.execute( BytesPending { 0 } );
+      test.execute( ReadAll { "abcdefg" } );
+    }
+
+    {
+      ReassemblerTestHarness test { "adjacent unassembled sections merge", 1000 };
+
+      test.execute( Insert { "c", 2 } );
+      test.execute( Insert { "b", 1 } );
+      test.execute( Insert { "de", 3 } );
+      test.execute( BytesPending { 4 } );
+      test.execute( Insert { "bcd", 1 } );
+      test.execute( BytesPending { 4 } );
+      test.execute( Insert { "a", 0 } );
+      test.execute( ReadAll { "abcde" } );
+    }
+
+    {
+      ReassemblerTestHarness test { "insert over existing section", 1000 };
+
+      test.execute( Insert { "c", 2 } );
+      test.execute( Insert { "de", 3 } );
+      test.execute( BytesPending { 3 } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( Insert { "abc", 0 } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 5 } );
+      test.execute( ReadAll { "abcde" } );
+    }
+
+    {
+      ReassemblerTestHarness test { "insert within existing section", 1000 };
+
+      test.execute( Insert { "bcdef", 1 } );
+      test.execute( Insert { "cd", 2 } );
+      test.execute( Insert { "xbcdefy", 0 } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 7 } );
+      test.execute( ReadAll { "xbcdefy" } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ReassemblerTestHarness test { "seq 1", 65000 };
+
+      test.execute( Insert { "abcd", 0 } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( ReadAll { "abcd" } );
+      test.execute( IsFinished { false } );
+
+      test.execute( Insert { "efgh", 4 } );
+      test.execute( BytesPushed { 8 } );
+      test.execute( ReadAll { "efgh" } );
+      test.execute( IsFinished { false } );
+    }
+
+    {
+      ReassemblerTestHarness test { "seq 2", 65000 };
+
+      test.execute( Insert { "abcd", 0 } );
+      test.execute( BytesPushed { 4 } );
+      test.execute( IsFinished { false } );
+      test.execute( Insert { "efgh", 4 } );
+      test.execute( BytesPushed { 8 } );
+      test.execute( ReadAll { "abcdefgh" } );
+      test.execute( IsFinished { false } );
+    }
+
+    {
+      ReassemblerTestHarness test { "seq 3", 65000 };
+
+      ostringstream ss;
+      for ( size_t i = 0; i < 100; ++i ) {
+        test.execute( BytesPushed { 4 * i } );
+        test.execute( Insert { "abcd", 4 * i } );
+        test.execute( IsFinished { false } );
+        ss << "abcd";
+      }
+
+      test.execute( ReadAll { ss.str() } );
+      test.execute( IsFinished { false } );
+    }
+
+    {
+      ReassemblerTestHarness test { "seq 4", 65000 };
+
+      for ( size_t i = 0; i < 100; ++i ) {
+        test.execute( BytesPushed { 4 * i } );
+        test.execute( Insert { "abcd", 4 * i } );
+        test.execute( IsFinished { false } );
+        test.execute( ReadAll { "abcd" } );
+      }
+    }
+
+    {
+      ReassemblerTestHarness test { "seq 5", 65000 };
+
+      test.execute( Insert { "abcd", 0 } );
+      test.execute( Insert { "efgh", 4 }.is_last() );
+      test.execute( IsClosed { true } );
+      test.execute( ReadAll { "abcdefgh" } );
+      test.execute( IsFinished { true } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,70 @@
+#include "reassembler_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    {
+      ReassemblerTestHarness test { "construction", 65000 };
+
+      test.execute( BytesPushed { 0 } );
+      test.execute( IsFinished { false } );
+    }
+
+    {
+      ReassemblerTestHarness test { "insert last fully", 65000 };
+
+      test.execute( Insert { "", 0 }.is_last() );
+      test.execute( BytesPushed { 0 } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ReassemblerTestHarness test { "insert a", 65000 };
+
+      test.execute( Insert { "a", 0 } );
+      test.execute( BytesPushed { 1 } );
+      test.execute( ReadAll { "a" } );
+      test.execute( BytesPending { 0 } );
+      test.execute( IsFinished { false } );
+    }
+
+    {
+      ReassemblerTestHarness test { "insert a last", 65000 };
+
+      test.execute( Insert { "a", 0 }.is_last() );
+      test.execute( BytesPushed { 1 } );
+      test.execute( IsClosed { true } );
+      test.execute( ReadAll { "a" } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      ReassemblerTestHarness test { "empty stream", 65000 };
+
+      test.execute( Insert { "", 0 } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( BytesPending { 0 } );
+      test.execute( IsFinished { false } );
+    }
+
+    {
+      ReassemblerTestHarness test { "empty last after data", 65000 };
+
+      test.execute( Insert { "b", 0 } );
+      test.execute( ReadAll { "b" } );
+      test.execute( Insert { "", 1 }.is_last() );
+      test.execute( BytesPushed { 1 } );
+      test.execute( IsFinished { true } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
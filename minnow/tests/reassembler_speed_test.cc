@@ -0,0 +1,151 @@
+#include "reassembler.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// Where each segment starts, relative to the segments before it
+enum class Pattern : uint8_t
+{
+  Reordered,  // every segment once, in random order within a window (a lossy, reordering link)
+  Duplicated, // every segment several times, shuffled likewise (spurious retransmissions)
+  Overlapping, // segments that overlap their neighbours heavily (repacketized retransmissions)
+  FirstLost    // the first segment lost and retransmitted after all the rest, which arrive in order
+};
+
+string_view pattern_name( Pattern pattern )
+{
+  switch ( pattern ) {
+    case Pattern::Reordered:
+      return "reordered";
+    case Pattern::Duplicated:
+      return "duplicated";
+    case Pattern::Overlapping:
+      return "overlapping";
+    case Pattern::FirstLost:
+      return "first lost";
+  }
+  return "unknown";
+}
+
+void speed_test( const Pattern pattern,
+                 const size_t num_chunks,  // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t capacity,    // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t random_seed, // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t chunk_size,  // NOLINT(bugprone-easily-swappable-parameters)
+                 const size_t window )     // NOLINT(bugprone-easily-swappable-parameters)
+{
+  default_random_engine rd { random_seed };
+
+  // Generate the data to be reassembled
+  string data( num_chunks * chunk_size, 0 );
+  generate( data.begin(), data.end(), [&] { return rd(); } );
+
+  // Cut it into segments: (index, length, is_last)
+  vector<tuple<uint64_t, uint64_t, bool>> segments;
+  for ( size_t i = 0; i < num_chunks; ++i ) {
+    const uint64_t index = i * chunk_size;
+    const bool is_last = i + 1 == num_chunks;
+    switch ( pattern ) {
+      case Pattern::Reordered:
+      case Pattern::FirstLost:
+        segments.emplace_back( index, chunk_size, is_last );
+        break;
+      case Pattern::Duplicated:
+        for ( size_t copy = 0; copy < 3; ++copy ) {
+          segments.emplace_back( index, chunk_size, is_last );
+        }
+        break;
+      case Pattern::Overlapping: {
+        const uint64_t back = min<uint64_t>( index, rd() % ( 2 * chunk_size ) );
+        segments.emplace_back( index - back, chunk_size + back, is_last );
+        segments.emplace_back( index + chunk_size / 2, ( chunk_size + 1 ) / 2, is_last );
+        break;
+      }
+    }
+  }
+
+  if ( pattern == Pattern::FirstLost ) {
+    ranges::rotate( segments, segments.begin() + 1 );
+  }
+
+  // Shuffle within a sliding window, so the reorder queue stays deep but the window stays bounded
+  for ( size_t i = 0; i < segments.size(); i += window ) {
+    const auto end = segments.begin() + static_cast<ptrdiff_t>( min( segments.size(), i + window ) );
+    shuffle( segments.begin() + static_cast<ptrdiff_t>( i ), end, rd );
+  }
+
+  // Slice the segments out of the data before starting the clock
+  vector<string> payloads;
+  payloads.reserve( segments.size() );
+  for ( const auto& [index, length, is_last] : segments ) {
+    payloads.emplace_back( data.substr( index, length ) );
+  }
+
+  Reassembler reassembler { ByteStream { capacity } };
+  string output_data;
+  output_data.reserve( data.size() );
+
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < segments.size(); ++i ) {
+    const auto& [index, length, is_last] = segments[i];
+    reassembler.insert( index, move( payloads[i] ), is_last );
+
+    while ( reassembler.reader().bytes_buffered() ) {
+      const auto peeked = reassembler.reader().peek();
+      output_data += peeked;
+      reassembler.reader().pop( peeked.size() );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( not reassembler.reader().is_finished() ) {
+    throw runtime_error( "Reassembler did not close ByteStream when finished" );
+  }
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read" );
+  }
+
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  const auto bytes_per_second = static_cast<double>( num_chunks * chunk_size ) / test_duration.count();
+  const auto gigabits_per_second = 8 * bytes_per_second / 1e9;
+
+  cout << "Reassembler (" << pattern_name( pattern ) << ", chunk_size=" << chunk_size << ", window=" << window
+       << ") reached " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s.\n";
+
+  if ( gigabits_per_second < 0.1 ) {
+    throw runtime_error( "Reassembler did not meet minimum speed of 0.1 Gbit/s" );
+  }
+}
+
+void program_body()
+{
+  speed_test( Pattern::Reordered, 10000, 1500 * 10000, 1370, 1500, 8 );
+  speed_test( Pattern::Reordered, 10000, 1500 * 10000, 1371, 1500, 1000 );
+  speed_test( Pattern::Duplicated, 10000, 1500 * 10000, 1372, 1500, 1000 );
+  speed_test( Pattern::Overlapping, 10000, 1500 * 10000, 1373, 1500, 1000 );
+  speed_test( Pattern::Reordered, 100000, 64 * 100000, 1374, 64, 1000 );
+  speed_test( Pattern::FirstLost, 10000, 1460 * 10000, 1375, 1460, 1 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
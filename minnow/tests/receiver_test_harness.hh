@@ -0,0 +1,163 @@
+#pragma once
+
+#include "byte_stream_test_harness.hh"
+#include "tcp_receiver.hh"
+
+#include <concepts>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// A ByteStream test step, run against the TCPReceiver's output stream
+template<class T>
+struct ReceiverTestStep : public TestStep<TCPReceiver>
+{
+  T step_;
+
+  explicit ReceiverTestStep( T step ) : step_( std::move( step ) ) {}
+  std::string str() const override { return step_.str(); }
+  uint8_t color() const override { return step_.color(); }
+  void execute( TCPReceiver& r ) const override { step_.execute( r.reader() ); }
+  constexpr std::string obj() const override { return step_.obj(); }
+};
+
+class TCPReceiverTestHarness : public TestHarness<TCPReceiver>
+{
+public:
+  TCPReceiverTestHarness( std::string test_name, uint64_t capacity )
+    : TestHarness( move( test_name ),
+                   "capacity=" + std::to_string( capacity ),
+                   TCPReceiver { Reassembler { ByteStream { capacity } } } )
+  {}
+
+  using TestHarness::execute;
+
+  template<std::derived_from<TestStep<ByteStream>> T>
+  void execute( const T& step )
+  {
+    TestHarness::execute( ReceiverTestStep<T> { step } );
+  }
+};
+
+/* actions */
+
+struct SegmentArrives : public Action<TCPReceiver>
+{
+  TCPSenderMessage msg_ {};
+
+  SegmentArrives& with_syn()
+  {
+    msg_.SYN = true;
+    return *this;
+  }
+
+  SegmentArrives& with_fin()
+  {
+    msg_.FIN = true;
+    return *this;
+  }
+
+  SegmentArrives& with_rst()
+  {
+    msg_.RST = true;
+    return *this;
+  }
+
+  SegmentArrives& with_seqno( Wrap32 seqno )
+  {
+    msg_.seqno = seqno;
+    return *this;
+  }
+
+  SegmentArrives& with_seqno( uint32_t seqno ) { return with_seqno( Wrap32 { seqno } ); }
+
+  SegmentArrives& with_data( std::string data )
+  {
+    msg_.payload = std::move( data );
+    return *this;
+  }
+
+  std::string description() const override { return "receive segment: " + to_string( msg_ ); }
+
+  void execute( TCPReceiver& r ) const override { r.receive( msg_ ); }
+};
+
+struct SetAutotuning : public Action<TCPReceiver>
+{
+  uint64_t max_capacity_;
+
+  explicit SetAutotuning( uint64_t max_capacity ) : max_capacity_( max_capacity ) {}
+  std::string description() const override
+  {
+    return "auto-tune the window up to a capacity of " + std::to_string( max_capacity_ );
+  }
+  void execute( TCPReceiver& r ) const override { r.set_window_autotuning( max_capacity_ ); }
+};
+
+/* expectations */
+
+struct ExpectAckno : public ExpectNumber<TCPReceiver, std::optional<Wrap32>>
+{
+  using ExpectNumber::ExpectNumber;
+  explicit ExpectAckno( Wrap32 ackno ) : ExpectNumber( ackno ) {}
+  explicit ExpectAckno( uint32_t ackno ) : ExpectNumber( Wrap32 { ackno } ) {}
+  std::string name() const override { return "ackno"; }
+  std::optional<Wrap32> value( const TCPReceiver& r ) const override { return r.send().ackno; }
+};
+
+struct ExpectWindow : public ExpectNumber<TCPReceiver, uint32_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "window_size"; }
+  uint32_t value( const TCPReceiver& r ) const override { return r.send().window_size; }
+};
+
+struct ExpectReset : public ExpectBool<TCPReceiver>
+{
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "send().RST"; }
+  bool value( const TCPReceiver& r ) const override { return r.send().RST; }
+};
+
+struct BytesPending : public ExpectNumber<TCPReceiver, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "count_bytes_pending"; }
+  uint64_t value( const TCPReceiver& r ) const override { return r.reassembler().count_bytes_pending(); }
+};
+
+struct ExpectCapacity : public ExpectNumber<TCPReceiver, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "capacity"; }
+  uint64_t value( const TCPReceiver& r ) const override { return r.reader().capacity(); }
+};
+
+struct ExpectSackBlocks : public Expectation<TCPReceiver>
+{
+  std::vector<TCPReceiverMessage::SackBlock> blocks_;
+
+  explicit ExpectSackBlocks( std::vector<TCPReceiverMessage::SackBlock> blocks ) : blocks_( std::move( blocks ) )
+  {}
+
+  static std::string describe( const std::vector<TCPReceiverMessage::SackBlock>& blocks )
+  {
+    std::string ret = "{";
+    for ( const auto& block : blocks ) {
+      ret += " [" + to_string( block.begin ) + ", " + to_string( block.end ) + ")";
+    }
+    return ret + " }";
+  }
+
+  std::string description() const override { return "SACK blocks = " + describe( blocks_ ); }
+
+  void execute( const TCPReceiver& r ) const override
+  {
+    const auto got = r.send().sack_blocks;
+    const auto same = []( const auto& a, const auto& b ) { return a.begin == b.begin and a.end == b.end; };
+    if ( not std::ranges::equal( got, blocks_, same ) ) {
+      throw ExpectationViolation( "should have had SACK blocks " + describe( blocks_ ) + ", but instead had "
+                                  + describe( got ) );
+    }
+  }
+};
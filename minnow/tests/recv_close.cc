@@ -0,0 +1,73 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "close 1", 4000 };
+      test.execute( ExpectAckno { optional<Wrap32> {} } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( IsClosed { false } );
+      test.execute( SegmentArrives {}.with_fin().with_seqno( isn + 1 ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 2 } } );
+      test.execute( BytesPending { 0 } );
+      test.execute( ReadAll { "" } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "close 2", 4000 };
+      test.execute( ExpectAckno { optional<Wrap32> {} } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( IsClosed { false } );
+      test.execute( SegmentArrives {}.with_fin().with_seqno( isn + 1 ).with_data( "a" ) );
+      test.execute( IsClosed { true } );
+      test.execute( ExpectAckno { Wrap32 { isn + 3 } } );
+      test.execute( BytesPending { 0 } );
+      test.execute( ReadAll { "a" } );
+      test.execute( BytesPushed { 1 } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "FIN before the data it ends", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_fin().with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( IsClosed { false } );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( IsClosed { true } );
+      test.execute( ExpectAckno { Wrap32 { isn + 10 } } );
+      test.execute( ReadAll { "abcdefgh" } );
+      test.execute( IsFinished { true } );
+    }
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "SYN, data and FIN in one segment", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_fin().with_seqno( isn ).with_data( "Hello, world." ) );
+      test.execute( IsClosed { true } );
+      test.execute( ExpectAckno { Wrap32 { isn + 15 } } );
+      test.execute( ReadAll { "Hello, world." } );
+      test.execute( IsFinished { true } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
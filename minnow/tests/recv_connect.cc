@@ -0,0 +1,87 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPReceiverTestHarness test { "connect 1", 4000 };
+      test.execute( ExpectWindow { 4000 } );
+      test.execute( ExpectAckno { optional<Wrap32> {} } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( 0 ) );
+      test.execute( ExpectAckno { Wrap32 { 1 } } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 0 } );
+    }
+
+    {
+      TCPReceiverTestHarness test { "connect 2", 5435 };
+      test.execute( ExpectAckno { optional<Wrap32> {} } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( 89347598 ) );
+      test.execute( ExpectAckno { Wrap32 { 89347599 } } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 0 } );
+    }
+
+    {
+      TCPReceiverTestHarness test { "connect 3", 5435 };
+      test.execute( ExpectAckno { optional<Wrap32> {} } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( SegmentArrives {}.with_seqno( 893475 ) );
+      test.execute( ExpectAckno { optional<Wrap32> {} } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 0 } );
+    }
+
+    {
+      TCPReceiverTestHarness test { "connect 4", 5435 };
+      test.execute( ExpectAckno { optional<Wrap32> {} } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( SegmentArrives {}.with_fin().with_seqno( 893475 ) );
+      test.execute( ExpectAckno { optional<Wrap32> {} } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( 89347598 ) );
+      test.execute( ExpectAckno { Wrap32 { 89347599 } } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 0 } );
+    }
+
+    {
+      TCPReceiverTestHarness test { "connect 5", 5435 };
+      test.execute( SegmentArrives {}.with_syn().with_fin().with_seqno( 89347598 ) );
+      test.execute( ExpectAckno { Wrap32 { 89347600 } } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( IsClosed { true } );
+    }
+
+    {
+      // Window overflows the 16-bit field: the whole window is advertised (for the wire to scale).
+      TCPReceiverTestHarness test { "window overflow", 4000000 };
+      const uint32_t isn = rd();
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectWindow { 4000000 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "in-window, later segment", 2358 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 10 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ReadAll { "" } );
+      test.execute( BytesPending { 4 } );
+      test.execute( BytesPushed { 0 } );
+    }
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "in-window, later segment, then hole filled", 2358 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ReadAll { "" } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 9 } } );
+      test.execute( ReadAll { "abcdefgh" } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 8 } );
+    }
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "hole filled bit-by-bit", 2358 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ReadAll { "" } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "ab" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 3 } } );
+      test.execute( ReadAll { "ab" } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "cd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 9 } } );
+      test.execute( ReadAll { "cdefgh" } );
+      test.execute( BytesPending { 0 } );
+      test.execute( BytesPushed { 8 } );
+    }
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "many gaps, filled bit-by-bit", 2358 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "e" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ReadAll { "" } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 7 ).with_data( "g" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ReadAll { "" } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "c" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ReadAll { "" } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "ab" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+      test.execute( ReadAll { "abc" } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 6 ).with_data( "f" ) );
+      test.execute( BytesPending { 3 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+      test.execute( ReadAll { "" } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 ).with_data( "d" ) );
+      test.execute( BytesPending { 0 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 8 } } );
+      test.execute( ReadAll { "defg" } );
+    }
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "many gaps, then subsumed", 2358 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "e" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ReadAll { "" } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 7 ).with_data( "g" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ReadAll { "" } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "c" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ReadAll { "" } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcdefgh" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 9 } } );
+      test.execute( ReadAll { "abcdefgh" } );
+      test.execute( BytesPending { 0 } );
+    }
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "SACK blocks report the stored runs", 2358 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectSackBlocks { {} } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "ef" ) );
+      test.execute( ExpectSackBlocks { { { Wrap32 { isn + 5 }, Wrap32 { isn + 7 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 10 ).with_data( "jk" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 7 ).with_data( "g" ) );
+      test.execute( ExpectSackBlocks {
+        { { Wrap32 { isn + 5 }, Wrap32 { isn + 8 } }, { Wrap32 { isn + 10 }, Wrap32 { isn + 12 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 8 } } );
+      test.execute( ExpectSackBlocks { { { Wrap32 { isn + 10 }, Wrap32 { isn + 12 } } } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 8 ).with_data( "hi" ) );
+      test.execute( ExpectSackBlocks { {} } );
+      test.execute( ReadAll { "abcdefghijk" } );
+    }
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "at most MAX_SACK_BLOCKS SACK blocks", 2358 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      vector<TCPReceiverMessage::SackBlock> expected;
+      for ( uint32_t i = 0; i < 2 * TCPReceiverMessage::MAX_SACK_BLOCKS; ++i ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 3 + 2 * i ).with_data( "x" ) );
+        if ( i < TCPReceiverMessage::MAX_SACK_BLOCKS ) {
+          expected.push_back( { Wrap32 { isn + 3 + 2 * i }, Wrap32 { isn + 4 + 2 * i } } );
+        }
+      }
+      test.execute( ExpectSackBlocks { expected } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,57 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    // An in-window stream of segments, shuffled and duplicated, arrives at a receiver with a random ISN.
+    for ( unsigned int trial = 0; trial < 64; ++trial ) {
+      const uint32_t isn = rd();
+      const uint64_t capacity = uniform_int_distribution<uint64_t> { 1000, 20000 }( rd );
+      TCPReceiverTestHarness test { "reorder more (trial #" + to_string( trial ) + ")", capacity };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+
+      string data;
+      vector<pair<uint64_t, uint64_t>> segments; // [first, end) stream indices
+      while ( data.size() < capacity ) {
+        const uint64_t len = min( uniform_int_distribution<uint64_t> { 1, 100 }( rd ), capacity - data.size() );
+        segments.emplace_back( data.size(), data.size() + len );
+        for ( uint64_t i = 0; i < len; ++i ) {
+          data.push_back( static_cast<char>( 'a' + rd() % 26 ) );
+        }
+      }
+      const size_t count = segments.size();
+      for ( size_t i = 0; i < count / 4; ++i ) {
+        segments.push_back( segments[rd() % count] );
+      }
+      shuffle( segments.begin(), segments.end(), rd );
+
+      for ( const auto& [first, end] : segments ) {
+        test.execute( SegmentArrives {}
+                        .with_seqno( isn + 1 + static_cast<uint32_t>( first ) )
+                        .with_data( data.substr( first, end - first ) ) );
+      }
+
+      test.execute( ExpectAckno { Wrap32 { isn + 1 + static_cast<uint32_t>( capacity ) } } );
+      test.execute( ExpectWindow { 0 } );
+      test.execute( BytesPending { 0 } );
+      test.execute( ExpectSackBlocks { {} } );
+      test.execute( ReadAll { data } );
+      test.execute( ExpectWindow { static_cast<uint32_t>( capacity ) } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
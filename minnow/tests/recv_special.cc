@@ -0,0 +1,88 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "segment before SYN is ignored", 4000 };
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "hello" ) );
+      test.execute( ExpectAckno { optional<Wrap32> {} } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( BytesPushed { 0 } );
+    }
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "data at the ISN (without SYN) is ignored", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn ).with_data( "hello" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( BytesPushed { 0 } );
+      test.execute( BytesPending { 0 } );
+    }
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "repeated SYN is harmless", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_data( "abc" ) );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ).with_data( "abc" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+      test.execute( ReadAll { "abc" } );
+    }
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "segment far outside the window is ignored", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abc" ) );
+      test.execute( ReadAll { "abc" } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4 + ( 1U << 31 ) ).with_data( "late" ) );
+      test.execute( BytesPending { 0 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 4 } } );
+    }
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "RST sets the stream's error", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectReset { false } );
+      test.execute( SegmentArrives {}.with_rst().with_seqno( isn + 1 ) );
+      test.execute( HasError { true } );
+      test.execute( ExpectReset { true } );
+    }
+
+    {
+      TCPReceiverTestHarness test { "RST before SYN", 4000 };
+      test.execute( SegmentArrives {}.with_rst().with_seqno( 0 ) );
+      test.execute( HasError { true } );
+      test.execute( ExpectReset { true } );
+      test.execute( ExpectAckno { optional<Wrap32> {} } );
+    }
+
+    {
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "an error in the stream is reported with RST", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SetError {} );
+      test.execute( ExpectReset { true } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+#include "random.hh"
+#include "receiver_test_harness.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+// Send a window's worth of 1000-byte segments, starting from stream index `first_index`, and read them all.
+static uint64_t send_and_read( TCPReceiverTestHarness& test, uint32_t isn, uint64_t first_index, uint64_t len )
+{
+  string all;
+  for ( uint64_t index = first_index; index < first_index + len; index += 1000 ) {
+    const string data( 1000, static_cast<char>( 'a' + index / 1000 % 26 ) );
+    test.execute( SegmentArrives {}.with_seqno( isn + 1 + static_cast<uint32_t>( index ) ).with_data( data ) );
+    all += data;
+  }
+  test.execute( ReadAll { all } );
+  return first_index + len;
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      // Window size decreases appropriately
+      const uint16_t cap = 4000;
+      const uint32_t isn = 23452;
+      TCPReceiverTestHarness test { "window size decreases appropriately", cap };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectWindow { cap } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectWindow { cap - 4 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 9 ).with_data( "ijkl" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectWindow { cap - 4 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 5 ).with_data( "efgh" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 13 } } );
+      test.execute( ExpectWindow { cap - 12 } );
+    }
+
+    {
+      // Window size expands upon read
+      const uint16_t cap = 4000;
+      const uint32_t isn = 23452;
+      TCPReceiverTestHarness test { "window size expands upon read", cap };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 } } );
+      test.execute( ExpectWindow { cap } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "abcd" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectWindow { cap - 4 } );
+      test.execute( ReadAll { "abcd" } );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectWindow { cap } );
+    }
+
+    {
+      // High-seqno segment is rejected
+      const uint16_t cap = 2;
+      const uint32_t isn = 23452;
+      TCPReceiverTestHarness test { "arriving segment with high seqno", cap };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 2 ).with_data( "bc" ) );
+      test.execute( BytesPending { 1 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "a" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 3 } } );
+      test.execute( ExpectWindow { 0 } );
+      test.execute( BytesPending { 0 } );
+      test.execute( ReadAll { "ab" } );
+      test.execute( ExpectWindow { 2 } );
+    }
+
+    {
+      // Segment overflowing the window on the left side is acceptable
+      const uint16_t cap = 4;
+      const uint32_t isn = 23452;
+      TCPReceiverTestHarness test { "arriving segment with low seqno", cap };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 1 ).with_data( "ab" ) );
+      test.execute( SegmentArrives {}.with_seqno( isn + 3 ).with_data( "cdef" ) );
+      test.execute( ExpectAckno { Wrap32 { isn + 5 } } );
+      test.execute( ExpectWindow { 0 } );
+      test.execute( ReadAll { "abcd" } );
+      test.execute( ExpectWindow { cap } );
+    }
+
+    {
+      // Window auto-tuning: the capacity doubles once a fast reader drains full windows, up to the cap
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "window auto-tuning grows the capacity", 4000 };
+      test.execute( SetAutotuning { 10000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      uint64_t next = send_and_read( test, isn, 0, 4000 );
+      test.execute( ExpectCapacity { 4000 } );
+      next = send_and_read( test, isn, next, 4000 );
+      test.execute( ExpectCapacity { 8000 } );
+      test.execute( ExpectWindow { 8000 } );
+      next = send_and_read( test, isn, next, 8000 );
+      test.execute( ExpectCapacity { 8000 } );
+      next = send_and_read( test, isn, next, 8000 );
+      test.execute( ExpectCapacity { 10000 } );
+      next = send_and_read( test, isn, next, 10000 );
+      next = send_and_read( test, isn, next, 10000 );
+      test.execute( ExpectCapacity { 10000 } );
+      test.execute( ExpectWindow { 10000 } );
+      test.execute( ExpectAckno { Wrap32 { isn + 1 + static_cast<uint32_t>( next ) } } );
+    }
+
+    {
+      // ... but not when the application doesn't read
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "window auto-tuning waits for the reader", 4000 };
+      test.execute( SetAutotuning { 10000 } );
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      for ( uint32_t index = 0; index < 4000; index += 1000 ) {
+        test.execute( SegmentArrives {}.with_seqno( isn + 1 + index ).with_data( string( 1000, 'x' ) ) );
+      }
+      test.execute( ExpectWindow { 0 } );
+      test.execute( SegmentArrives {}.with_seqno( isn + 4001 ).with_data( string( 1000, 'y' ) ) );
+      test.execute( ExpectCapacity { 4000 } );
+      test.execute( ExpectWindow { 0 } );
+    }
+
+    {
+      // ... nor when it is off
+      const uint32_t isn = rd();
+      TCPReceiverTestHarness test { "window auto-tuning is off by default", 4000 };
+      test.execute( SegmentArrives {}.with_syn().with_seqno( isn ) );
+      uint64_t next = 0;
+      for ( int round = 0; round < 4; ++round ) {
+        next = send_and_read( test, isn, next, 4000 );
+      }
+      test.execute( ExpectCapacity { 4000 } );
+      test.execute( ExpectWindow { 4000 } );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,302 @@
+#include "arp_message.hh"
+#include "checksum.hh"
+#include "helpers.hh"
+#include "network_interface_test_harness.hh"
+#include "router.hh"
+#include "routing_table.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+// The longest-prefix match, the slow way: the longest (and, among equals, the last added) matching route
+uint32_t reference_lookup( const vector<RoutingTable::Route>& routes, uint32_t address )
+{
+  uint32_t target = RoutingTable::NO_ROUTE;
+  int longest = -1;
+  for ( const auto& route : routes ) {
+    const uint32_t mask = route.prefix_length == 0 ? 0 : UINT32_MAX << ( 32 - route.prefix_length );
+    if ( ( address & mask ) == ( route.prefix & mask ) and route.prefix_length >= longest ) {
+      longest = route.prefix_length;
+      target = route.target;
+    }
+  }
+  return target;
+}
+
+vector<RoutingTable::Route> random_routes( default_random_engine& rd, size_t count )
+{
+  // Prefixes cluster in a few /8s (so that they nest), with lengths from /8 to /32 (and a few shorter ones).
+  uniform_int_distribution<uint32_t> top_byte { 1, 4 };
+  uniform_int_distribution<uint32_t> length { 8, 32 };
+  vector<RoutingTable::Route> routes;
+  for ( size_t i = 0; i < count; ++i ) {
+    const uint32_t prefix = ( top_byte( rd ) << 24 ) | ( rd() & 0x0f0f0fff );
+    const uint32_t prefix_length = i % 100 == 50 ? 4 + rd() % 4 : length( rd );
+    routes.push_back( { prefix, static_cast<uint8_t>( prefix_length ), static_cast<uint32_t>( i ) } );
+  }
+  return routes;
+}
+
+// A random address, usually inside one of the routes' prefixes
+uint32_t random_address( default_random_engine& rd, const vector<RoutingTable::Route>& routes )
+{
+  if ( rd() % 4 == 0 ) {
+    return rd();
+  }
+  const auto& route = routes.at( rd() % routes.size() );
+  const uint32_t host_mask = route.prefix_length == 32 ? 0 : UINT32_MAX >> route.prefix_length;
+  return ( route.prefix & ~host_mask ) | ( rd() & host_mask & ( rd() % 2 ? 0xff : UINT32_MAX ) );
+}
+
+// the table agrees with a linear scan, whatever order the routes are added in, and one by one or in bulk
+void routing_table()
+{
+  default_random_engine rd { 144 };
+  for ( const size_t count : { 1, 10, 200, 1000 } ) {
+    const auto routes = random_routes( rd, count );
+
+    RoutingTable one_by_one;
+    for ( const auto& route : routes ) {
+      one_by_one.insert( route.prefix, route.prefix_length, route.target );
+    }
+    RoutingTable bulk;
+    bulk.insert( routes );
+
+    vector<uint32_t> addresses;
+    for ( size_t i = 0; i < 5000; ++i ) {
+      addresses.push_back( random_address( rd, routes ) );
+    }
+    vector<uint32_t> batch( addresses.size() );
+    bulk.lookup( addresses, batch );
+
+    for ( size_t i = 0; i < addresses.size(); ++i ) {
+      const uint32_t expected = reference_lookup( routes, addresses[i] );
+      const string address = Address::from_ipv4_numeric( addresses[i] ).ip();
+      expect( one_by_one.lookup( addresses[i] ) == expected, "wrong route for " + address );
+      expect( bulk.lookup( addresses[i] ) == expected, "wrong route (after bulk insert) for " + address );
+      expect( batch[i] == expected, "wrong route (in a batch) for " + address );
+    }
+  }
+}
+
+// a few routes by hand: nesting, replacement, and the edges of the table
+void routing_table_edges()
+{
+  RoutingTable table;
+  expect( table.lookup( 0 ) == RoutingTable::NO_ROUTE, "an empty table should have no routes" );
+
+  table.insert( 0x0a000000, 8, 1 );  // 10.0.0.0/8
+  table.insert( 0x0a010203, 32, 2 ); // 10.1.2.3/32
+  table.insert( 0x0a010200, 24, 3 ); // 10.1.2.0/24 (added after, and shorter than, the /32 inside it)
+  table.insert( 0x0a010280, 25, 4 ); // 10.1.2.128/25
+  table.insert( 0x0a0102ff, 16, 5 ); // 10.1.0.0/16 (the host bits are ignored)
+  expect( table.lookup( 0x0a010203 ) == 2, "a /32 should win over the shorter prefixes around it" );
+  expect( table.lookup( 0x0a010204 ) == 3, "the /24 should fill in around the /32" );
+  expect( table.lookup( 0x0a0102fe ) == 4, "the /25 should win in its half of the /24" );
+  expect( table.lookup( 0x0a010303 ) == 5, "the /16 should cover the rest of 10.1" );
+  expect( table.lookup( 0x0a020304 ) == 1, "the /8 should cover the rest of 10" );
+  expect( table.lookup( 0x0b000000 ) == RoutingTable::NO_ROUTE, "11.0.0.0 should have no route" );
+  expect( table.tbl8_groups() == 1, "only 10.1.2.0/24 should need a second-level group" );
+
+  table.insert( 0x0a010200, 24, 6 ); // replace the /24
+  expect( table.lookup( 0x0a010204 ) == 6 and table.lookup( 0x0a010203 ) == 2, "the /24 should be replaced" );
+
+  table.insert( 0, 0, 7 ); // default route
+  expect( table.lookup( 0x0b000000 ) == 7 and table.lookup( UINT32_MAX ) == 7, "default route should match" );
+  expect( table.lookup( 0x0a010203 ) == 2, "the default route shouldn't replace longer prefixes" );
+
+  table.insert( UINT32_MAX, 32, 8 );
+  expect( table.lookup( UINT32_MAX ) == 8 and table.lookup( UINT32_MAX - 1 ) == 7, "255.255.255.255/32" );
+
+  bool threw = false;
+  try {
+    table.insert( 0, 33, 1 );
+  } catch ( const runtime_error& ) {
+    threw = true;
+  }
+  expect( threw, "a /33 should be rejected" );
+}
+
+InternetDatagram make_datagram( const string& src_ip, const string& dst_ip, uint8_t ttl = 64 )
+{
+  InternetDatagram dgram;
+  dgram.header.src = Address( src_ip, 0 ).ipv4_numeric();
+  dgram.header.dst = Address( dst_ip, 0 ).ipv4_numeric();
+  dgram.header.ttl = ttl;
+  dgram.payload.emplace_back( "payload for " + dst_ip );
+  dgram.header.len = static_cast<uint64_t>( dgram.header.hlen ) * 4 + dgram.payload.front().size();
+  dgram.header.compute_checksum();
+  return dgram;
+}
+
+EthernetAddress ethernet_address( uint8_t n )
+{
+  return { 0x02, 0, 0, 0, 0, n };
+}
+
+struct TestNetwork
+{
+  Router router {};
+  vector<shared_ptr<FramesOut>> outputs {};
+
+  // An interface at `ip`, to which `neighbor_ip` (at `neighbor_eth`) has introduced itself
+  void add_interface( uint8_t n, const string& ip, const string& neighbor_ip )
+  {
+    outputs.push_back( make_shared<FramesOut>() );
+    const auto interface = make_shared<NetworkInterface>(
+      "eth" + to_string( n ), outputs.back(), ethernet_address( n ), Address( ip ) );
+    router.add_interface( interface );
+
+    ARPMessage arp;
+    arp.opcode = ARPMessage::OPCODE_REPLY;
+    arp.sender_ethernet_address = ethernet_address( 100 + n );
+    arp.sender_ip_address = Address( neighbor_ip ).ipv4_numeric();
+    arp.target_ethernet_address = ethernet_address( n );
+    arp.target_ip_address = Address( ip ).ipv4_numeric();
+    interface->recv_frame( { { ethernet_address( n ), ethernet_address( 100 + n ), EthernetHeader::TYPE_ARP },
+                             serialize( arp ) } );
+  }
+
+  void arrive( size_t interface_num, const InternetDatagram& dgram )
+  {
+    const EthernetAddress eth = ethernet_address( static_cast<uint8_t>( interface_num ) );
+    router.interface( interface_num )
+      ->recv_frame( { { eth, ethernet_address( 200 ), EthernetHeader::TYPE_IPv4 }, serialize( dgram ) } );
+  }
+
+  // The datagram that `interface_num` sent next (to the Ethernet address `dst`), or none
+  optional<InternetDatagram> sent( size_t interface_num, const EthernetAddress& dst )
+  {
+    auto& frames = outputs.at( interface_num )->frames;
+    if ( frames.empty() ) {
+      return {};
+    }
+    const EthernetFrame frame = frames.front();
+    frames.pop();
+    InternetDatagram dgram;
+    expect( frame.header.dst == dst, "frame sent to the wrong Ethernet address: " + summary( frame ) );
+    expect( frame.header.type == EthernetHeader::TYPE_IPv4 and parse( dgram, frame.payload ),
+            "expected an IPv4 datagram: " + summary( frame ) );
+    return dgram;
+  }
+};
+
+void expect_forwarded( const optional<InternetDatagram>& sent, const InternetDatagram& original )
+{
+  expect( sent.has_value(), "datagram to " + Address::from_ipv4_numeric( original.header.dst ).ip() + " not sent" );
+  expect( sent->header.ttl + 1 == original.header.ttl, "TTL should have been decremented" );
+  expect( concat( sent->payload ) == concat( original.payload ), "payload should be unchanged" );
+  expect( sent->header.src == original.header.src and sent->header.dst == original.header.dst, "wrong addresses" );
+}
+
+// datagrams leave on the interface (and to the next hop) of the longest matching prefix
+void router()
+{
+  TestNetwork net;
+  net.add_interface( 0, "10.0.0.1", "10.0.0.2" );
+  net.add_interface( 1, "172.16.0.1", "172.16.0.2" );
+  net.add_interface( 2, "192.168.0.1", "192.168.0.77" );
+  for ( auto& output : net.outputs ) {
+    expect( output->frames.empty(), "no frames yet" );
+  }
+
+  net.router.add_route( 0, 0, Address( "10.0.0.2" ), 0 ); // default
+  net.router.add_route( Address( "172.16.0.0" ).ipv4_numeric(), 12, Address( "172.16.0.2" ), 1 );
+  net.router.add_route( Address( "192.168.0.0" ).ipv4_numeric(), 24, {}, 2 ); // directly attached
+  net.router.add_route( Address( "172.16.5.0" ).ipv4_numeric(), 24, Address( "10.0.0.2" ), 0 );
+
+  const auto to_internet = make_datagram( "192.168.0.77", "1.2.3.4" );
+  const auto to_corp = make_datagram( "192.168.0.77", "172.20.1.1" );
+  const auto to_corp_exception = make_datagram( "192.168.0.77", "172.16.5.5" );
+  const auto to_lan = make_datagram( "1.2.3.4", "192.168.0.77" );
+  const auto expiring = make_datagram( "1.2.3.4", "192.168.0.77", 1 );
+  net.arrive( 2, to_internet );
+  net.arrive( 2, to_corp );
+  net.arrive( 2, to_corp_exception );
+  net.arrive( 0, to_lan );
+  net.arrive( 0, expiring );
+  net.router.route();
+
+  expect_forwarded( net.sent( 0, ethernet_address( 100 ) ), to_internet );
+  expect_forwarded( net.sent( 0, ethernet_address( 100 ) ), to_corp_exception );
+  expect( not net.sent( 0, ethernet_address( 100 ) ).has_value(), "nothing else should go to the default route" );
+  expect_forwarded( net.sent( 1, ethernet_address( 101 ) ), to_corp );
+  expect( not net.sent( 1, ethernet_address( 101 ) ).has_value(), "nothing else should go out eth1" );
+  expect_forwarded( net.sent( 2, ethernet_address( 102 ) ), to_lan );
+  expect( not net.sent( 2, ethernet_address( 102 ) ).has_value(), "a datagram out of TTL should be dropped" );
+
+  // without a default route, and in a batch of our own
+  Router no_default;
+  no_default.add_interface( net.router.interface( 1 ) );
+  no_default.add_routes( vector<Router::Route> {
+    { Address( "172.16.0.0" ).ipv4_numeric(), 12, Address( "172.16.0.2" ), 0 } } );
+  vector<InternetDatagram> batch { make_datagram( "10.0.0.2", "8.8.8.8" ),
+                                   make_datagram( "10.0.0.2", "172.17.0.1" ) };
+  no_default.route( batch );
+  expect_forwarded( net.sent( 1, ethernet_address( 101 ) ), make_datagram( "10.0.0.2", "172.17.0.1" ) );
+  expect( not net.sent( 1, ethernet_address( 101 ) ).has_value(), "no route: the datagram should be dropped" );
+}
+
+// a datagram with IP options is forwarded without them, as a valid datagram
+void options()
+{
+  TestNetwork net;
+  net.add_interface( 0, "10.0.0.1", "10.0.0.2" );
+  net.router.add_route( 0, 0, Address( "10.0.0.2" ), 0 );
+
+  auto dgram = make_datagram( "1.1.1.1", "2.2.2.2" );
+  dgram.header.hlen = 6;
+  dgram.header.len += 4;
+  dgram.header.compute_checksum();
+  vector<Slice> bytes = serialize( dgram );
+  string raw = concat( bytes );
+  raw.insert( IPv4Header::LENGTH, "\x01\x01\x01\x00"s ); // NOP, NOP, NOP, end of options
+
+  // (fix up the checksum to cover the options)
+  raw[10] = raw[11] = 0;
+  InternetChecksum check;
+  check.add( raw.substr( 0, 24 ) );
+  raw[10] = static_cast<char>( check.value() >> 8 );
+  raw[11] = static_cast<char>( check.value() & 0xff );
+
+  net.router.interface( 0 )->recv_frame(
+    { { ethernet_address( 0 ), ethernet_address( 200 ), EthernetHeader::TYPE_IPv4 }, { Slice { move( raw ) } } } );
+  net.router.route();
+
+  const auto sent = net.sent( 0, ethernet_address( 100 ) );
+  expect( sent.has_value(), "datagram with options should be forwarded" );
+  expect( sent->header.hlen == 5 and sent->header.len == IPv4Header::LENGTH + sent->payload.front().size(),
+          "the forwarded header should describe a datagram without options" );
+  expect( concat( sent->payload ) == concat( dgram.payload ), "payload should be unchanged" );
+}
+
+int main()
+{
+  try {
+    routing_table_edges();
+    routing_table();
+    router();
+    options();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
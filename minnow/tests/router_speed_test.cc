@@ -0,0 +1,112 @@
+#include "routing_table.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+// Roughly the shape of a full BGP table: mostly /24s, then /16–/23, with a few shorter and longer prefixes
+uint8_t random_prefix_length( default_random_engine& rd )
+{
+  const uint32_t p = rd() % 100;
+  if ( p < 58 ) {
+    return 24;
+  }
+  if ( p < 93 ) {
+    return static_cast<uint8_t>( 16 + rd() % 8 );
+  }
+  if ( p < 96 ) {
+    return static_cast<uint8_t>( 8 + rd() % 8 );
+  }
+  return static_cast<uint8_t>( 25 + rd() % 8 );
+}
+
+double seconds_since( steady_clock::time_point start )
+{
+  return duration_cast<duration<double>>( steady_clock::now() - start ).count();
+}
+} // namespace
+
+void speed_test( const size_t num_routes, const size_t num_lookups, const size_t batch_size )
+{
+  default_random_engine rd { 1071 };
+
+  vector<RoutingTable::Route> routes;
+  routes.reserve( num_routes );
+  for ( size_t i = 0; i < num_routes; ++i ) {
+    const auto prefix = static_cast<uint32_t>( rd() );
+    routes.push_back( { prefix, random_prefix_length( rd ), static_cast<uint32_t>( rd() % 64 ) } );
+  }
+
+  // Half of the addresses fall inside a longer-than-/24 prefix (when there is one), to exercise both levels.
+  vector<uint32_t> addresses;
+  addresses.reserve( num_lookups );
+  for ( size_t i = 0; i < num_lookups; ++i ) {
+    const auto& route = routes[rd() % routes.size()];
+    addresses.push_back( ( i % 2 and route.prefix_length > 24 ) ? route.prefix : static_cast<uint32_t>( rd() ) );
+  }
+
+  const auto insert_start = steady_clock::now();
+  RoutingTable table;
+  table.insert( routes );
+  const double insert_time = seconds_since( insert_start );
+
+  uint64_t checksum = 0;
+  const auto single_start = steady_clock::now();
+  for ( const uint32_t address : addresses ) {
+    checksum += table.lookup( address );
+  }
+  const double single_time = seconds_since( single_start );
+
+  vector<uint32_t> targets( batch_size );
+  const auto batch_start = steady_clock::now();
+  for ( size_t i = 0; i < addresses.size(); i += batch_size ) {
+    const size_t n = min( batch_size, addresses.size() - i );
+    table.lookup( span { addresses }.subspan( i, n ), targets );
+    for ( size_t j = 0; j < n; ++j ) {
+      checksum -= targets[j];
+    }
+  }
+  const double batch_time = seconds_since( batch_start );
+
+  if ( checksum != 0 ) {
+    throw runtime_error( "batched lookups disagreed with single lookups" );
+  }
+
+  const double single_rate = static_cast<double>( num_lookups ) / single_time / 1e6;
+  const double batch_rate = static_cast<double>( num_lookups ) / batch_time / 1e6;
+  cout << fixed << setprecision( 2 ) << "RoutingTable with " << num_routes << " routes (" << table.tbl8_groups()
+       << " second-level groups) inserted in " << insert_time << " s.\n"
+       << "  " << num_lookups << " lookups: " << single_rate << " million/s one at a time, " << batch_rate
+       << " million/s in batches of " << batch_size << ".\n";
+
+  if ( min( single_rate, batch_rate ) < 10 ) {
+    throw runtime_error( "RoutingTable did not meet minimum speed of 10 million lookups/s" );
+  }
+}
+
+void program_body()
+{
+  speed_test( 1'000'000, 10'000'000, 64 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#include "random.hh"
+#include "sender_test_harness.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Retransmission skips the segments the receiver has SACKed", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      for ( const auto* data : { "abc", "def", "ghi" } ) {
+        test.execute( Push { data } );
+        test.execute( ExpectMessage {}.with_data( data ) );
+      }
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ).with_sack( isn + 4, isn + 7 ) );
+      test.execute( ExpectSeqnosSacked { 3 } );
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ).with_data( "abc" ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 4 } }.with_win( 1000 ).with_sack( isn + 4, isn + 7 ) );
+      test.execute( ExpectSeqnosSacked { 3 } );
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 7 ).with_data( "ghi" ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( AckReceived { Wrap32 { isn + 7 } }.with_win( 1000 ) );
+      test.execute( ExpectSeqnosSacked { 0 } );
+      test.execute( ExpectSeqnosInFlight { 3 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "SACK blocks that cover only part of a segment don't count", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ) );
+      test.execute( Push { "abcdef" } );
+      test.execute( ExpectMessage {}.with_data( "abcdef" ) );
+      test.execute( Push { "ghi" } );
+      test.execute( ExpectMessage {}.with_data( "ghi" ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ).with_sack( isn + 4, isn + 10 ) );
+      test.execute( ExpectSeqnosSacked { 3 } );
+      test.execute( Tick { cfg.rt_timeout } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ).with_data( "abcdef" ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 1000 ).with_sack( isn + 50, isn + 60 ) );
+      test.execute( ExpectSeqnosSacked { 3 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "Pacing spreads a burst over later ticks", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } }.with_win( 60000 ) );
+      test.execute( SetPacing { 100000, 2000 } );
+      test.execute( Push { string( 5000, 'x' ) } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1 ).with_payload_size( 1000 ) );
+      test.execute( ExpectMessage {}.with_seqno( isn + 1001 ).with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 10 } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 2001 ).with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 5 } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 5 } );
+      test.execute( ExpectMessage {}.with_seqno( isn + 3001 ).with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+      test.execute( SetPacing { 0, 0 } );
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_seqno( isn + 4001 ).with_payload_size( 1000 ) );
+      test.execute( ExpectNoSegment {} );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      cfg.fixed_isn = isn;
+
+      TCPSenderTestHarness test { "RST is sent after an error, and an incoming RST sets the error", cfg };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test.execute( ExpectReset { false } );
+      test.execute( SetError {} );
+      test.execute( ExpectReset { true } );
+
+      TCPSenderTestHarness test2 { "Incoming RST", cfg };
+      test2.execute( Push {} );
+      test2.execute( ExpectMessage {}.with_syn( true ).with_seqno( isn ) );
+      test2.execute( HasError { false } );
+      test2.execute( Receive { { .RST = true } }.without_push() );
+      test2.execute( HasError { true } );
+      test2.execute( ExpectReset { true } );
+    }
+
+    {
+      // The sender's payloads share storage with the bytes that were pushed (no copy on the way out).
+      TCPSender sender { ByteStream { 10000 }, Wrap32 { 0 }, TCPConfig::TIMEOUT_DFLT };
+      vector<TCPSenderMessage> sent;
+      const auto transmit = [&]( const TCPSenderMessage& msg ) { sent.push_back( msg ); };
+
+      sender.push( transmit );
+      sender.receive( { Wrap32 { 1 }, 60000 } );
+
+      string data( 5000, 'z' );
+      const char* const original = data.data();
+      sender.writer().push( move( data ) );
+      sender.push( transmit );
+
+      if ( sent.size() != 6 ) {
+        throw runtime_error( "zero-copy test: expected 6 segments, got " + to_string( sent.size() ) );
+      }
+      for ( size_t i = 1; i < sent.size(); ++i ) {
+        if ( sent[i].payload.data() != original + ( i - 1 ) * TCPConfig::MAX_PAYLOAD_SIZE ) {
+          throw runtime_error( "zero-copy test: segment " + to_string( i ) + " was copied" );
+        }
+      }
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
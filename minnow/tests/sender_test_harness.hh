@@ -0,0 +1,344 @@
+#pragma once
+
+#include "common.hh"
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+
+#include <optional>
+#include <queue>
+#include <sstream>
+#include <utility>
+
+// A TCPSender, and the messages it has transmitted (that the test hasn't checked yet)
+struct SenderAndOutput
+{
+  TCPSender sender;
+  std::queue<TCPSenderMessage> output {};
+
+  TCPSender::TransmitFunction transmit()
+  {
+    return [this]( const TCPSenderMessage& msg ) { output.push( msg ); };
+  }
+};
+
+inline std::string flag_description( const std::optional<bool>& flag, const std::string& name )
+{
+  return flag.has_value() ? ( *flag ? " +" : " -" ) + name : "";
+}
+
+/* actions */
+
+struct Push : public Action<SenderAndOutput>
+{
+  std::string data_;
+  bool close_ {};
+
+  explicit Push( std::string data = {} ) : data_( move( data ) ) {}
+
+  Push& with_close()
+  {
+    close_ = true;
+    return *this;
+  }
+
+  std::string description() const override
+  {
+    if ( data_.empty() ) {
+      return close_ ? "close stream, then push to TCPSender" : "push TCPSender";
+    }
+    return "push \"" + pretty_print( data_ ) + "\" to stream" + ( close_ ? ", close it" : "" )
+           + ", then push to TCPSender";
+  }
+
+  void execute( SenderAndOutput& s ) const override
+  {
+    s.sender.writer().push( data_ );
+    if ( close_ ) {
+      s.sender.writer().close();
+    }
+    s.sender.push( s.transmit() );
+  }
+};
+
+struct Tick : public Action<SenderAndOutput>
+{
+  uint64_t ms_;
+  std::optional<bool> max_retx_exceeded_ {};
+
+  explicit Tick( uint64_t ms ) : ms_( ms ) {}
+
+  Tick& with_max_retx_exceeded( bool val )
+  {
+    max_retx_exceeded_ = val;
+    return *this;
+  }
+
+  std::string description() const override
+  {
+    std::string ret = std::to_string( ms_ ) + " ms pass";
+    if ( max_retx_exceeded_.has_value() ) {
+      ret += std::string { " with max_retx_exceeded = " } + ( *max_retx_exceeded_ ? "true" : "false" );
+    }
+    return ret;
+  }
+
+  void execute( SenderAndOutput& s ) const override
+  {
+    s.sender.tick( ms_, s.transmit() );
+    if ( max_retx_exceeded_.has_value()
+         and *max_retx_exceeded_ != ( s.sender.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS ) ) {
+      throw ExpectationViolation { "after " + std::to_string( ms_ ) + "ms passed the TCP Sender should have had "
+                                   + "max_retx_exceeded = " + ( *max_retx_exceeded_ ? "true" : "false" ) };
+    }
+  }
+};
+
+struct Receive : public Action<SenderAndOutput>
+{
+  TCPReceiverMessage msg_;
+  bool push_ { true };
+
+  explicit Receive( TCPReceiverMessage msg ) : msg_( std::move( msg ) ) {}
+
+  Receive& without_push()
+  {
+    push_ = false;
+    return *this;
+  }
+
+  std::string description() const override
+  {
+    return "receive " + to_string( msg_ ) + ( push_ ? ", then push" : "" );
+  }
+
+  void execute( SenderAndOutput& s ) const override
+  {
+    s.sender.receive( msg_ );
+    if ( push_ ) {
+      s.sender.push( s.transmit() );
+    }
+  }
+};
+
+// An acknowledgment (by default with a window of 137)
+struct AckReceived : public Receive
+{
+  explicit AckReceived( Wrap32 ackno ) : Receive( { ackno, 137 } ) {}
+
+  AckReceived& with_win( uint16_t win )
+  {
+    msg_.window_size = win;
+    return *this;
+  }
+
+  AckReceived& with_sack( Wrap32 begin, Wrap32 end )
+  {
+    msg_.sack_blocks.push_back( { begin, end } );
+    return *this;
+  }
+};
+
+struct Close : public Action<SenderAndOutput>
+{
+  std::string description() const override { return "close stream, then push"; }
+  void execute( SenderAndOutput& s ) const override
+  {
+    s.sender.writer().close();
+    s.sender.push( s.transmit() );
+  }
+};
+
+struct SetError : public Action<SenderAndOutput>
+{
+  std::string description() const override { return "set_error"; }
+  void execute( SenderAndOutput& s ) const override { s.sender.writer().set_error(); }
+};
+
+struct SetPacing : public Action<SenderAndOutput>
+{
+  uint64_t bytes_per_second_;
+  uint64_t burst_bytes_;
+
+  SetPacing( uint64_t bytes_per_second, uint64_t burst_bytes )
+    : bytes_per_second_( bytes_per_second ), burst_bytes_( burst_bytes )
+  {}
+
+  std::string description() const override
+  {
+    return "pace at " + std::to_string( bytes_per_second_ ) + " bytes/s with bursts of "
+           + std::to_string( burst_bytes_ );
+  }
+  void execute( SenderAndOutput& s ) const override { s.sender.set_pacing_rate( bytes_per_second_, burst_bytes_ ); }
+};
+
+/* expectations */
+
+struct ExpectMessage : public Expectation<SenderAndOutput>
+{
+  std::optional<bool> syn {};
+  std::optional<bool> fin {};
+  std::optional<bool> rst {};
+  std::optional<Wrap32> seqno {};
+  std::optional<std::string> data {};
+  std::optional<size_t> payload_size {};
+
+  ExpectMessage& with_syn( bool val )
+  {
+    syn = val;
+    return *this;
+  }
+
+  ExpectMessage& with_fin( bool val )
+  {
+    fin = val;
+    return *this;
+  }
+
+  ExpectMessage& with_rst( bool val )
+  {
+    rst = val;
+    return *this;
+  }
+
+  ExpectMessage& with_no_flags()
+  {
+    syn = fin = rst = false;
+    return *this;
+  }
+
+  ExpectMessage& with_seqno( Wrap32 seqno_ )
+  {
+    seqno = seqno_;
+    return *this;
+  }
+
+  ExpectMessage& with_seqno( uint32_t seqno_ ) { return with_seqno( Wrap32 { seqno_ } ); }
+
+  ExpectMessage& with_payload_size( size_t payload_size_ )
+  {
+    payload_size = payload_size_;
+    return *this;
+  }
+
+  ExpectMessage& with_data( std::string data_ )
+  {
+    data = std::move( data_ );
+    return *this;
+  }
+
+  std::string description() const override
+  {
+    std::string ret = "message sent with";
+    ret += flag_description( syn, "SYN" ) + flag_description( fin, "FIN" ) + flag_description( rst, "RST" );
+    if ( seqno.has_value() ) {
+      ret += " seqno=" + to_string( *seqno );
+    }
+    if ( payload_size.has_value() ) {
+      ret += " payload_size=" + std::to_string( *payload_size );
+    }
+    if ( data.has_value() ) {
+      ret += " payload=\"" + pretty_print( *data ) + "\"";
+    }
+    return ret;
+  }
+
+  // Checking a message takes it from the queue, so this expectation needs the non-const object.
+  void execute( SenderAndOutput& s ) const override
+  {
+    if ( s.output.empty() ) {
+      throw ExpectationViolation( "TCPSender should have sent a message, but it didn't" );
+    }
+    const TCPSenderMessage msg = std::move( s.output.front() );
+    s.output.pop();
+
+    if ( syn.has_value() and msg.SYN != *syn ) {
+      throw ExpectationViolation( "SYN flag", *syn, msg.SYN );
+    }
+    if ( fin.has_value() and msg.FIN != *fin ) {
+      throw ExpectationViolation( "FIN flag", *fin, msg.FIN );
+    }
+    if ( rst.has_value() and msg.RST != *rst ) {
+      throw ExpectationViolation( "RST flag", *rst, msg.RST );
+    }
+    if ( seqno.has_value() and msg.seqno != *seqno ) {
+      throw ExpectationViolation( "sequence number", *seqno, msg.seqno );
+    }
+    if ( payload_size.has_value() and msg.payload.size() != *payload_size ) {
+      throw ExpectationViolation( "payload_size", *payload_size, msg.payload.size() );
+    }
+    if ( data.has_value() and msg.payload.view() != *data ) {
+      throw ExpectationViolation( "payload", *data, std::string { msg.payload.view() } );
+    }
+  }
+
+  void execute( const SenderAndOutput& /* unused */ ) const override
+  {
+    throw std::logic_error( "ExpectMessage must be able to take the message it checks" );
+  }
+};
+
+struct ExpectNoSegment : public Expectation<SenderAndOutput>
+{
+  std::string description() const override { return "no (more) segments sent"; }
+  void execute( const SenderAndOutput& s ) const override
+  {
+    if ( not s.output.empty() ) {
+      throw ExpectationViolation( "TCPSender sent an unexpected segment: " + to_string( s.output.front() ) );
+    }
+  }
+};
+
+struct ExpectSeqno : public ExpectNumber<SenderAndOutput, Wrap32>
+{
+  using ExpectNumber::ExpectNumber;
+  explicit ExpectSeqno( uint32_t seqno ) : ExpectNumber( Wrap32 { seqno } ) {}
+  std::string name() const override { return "make_empty_message().seqno"; }
+  Wrap32 value( const SenderAndOutput& s ) const override { return s.sender.make_empty_message().seqno; }
+};
+
+struct ExpectReset : public ExpectBool<SenderAndOutput>
+{
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "make_empty_message().RST"; }
+  bool value( const SenderAndOutput& s ) const override { return s.sender.make_empty_message().RST; }
+};
+
+struct ExpectSeqnosInFlight : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "sequence_numbers_in_flight"; }
+  uint64_t value( const SenderAndOutput& s ) const override { return s.sender.sequence_numbers_in_flight(); }
+};
+
+struct ExpectSeqnosSacked : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "sequence_numbers_sacked"; }
+  uint64_t value( const SenderAndOutput& s ) const override { return s.sender.sequence_numbers_sacked(); }
+};
+
+struct ExpectConsecutiveRetransmissions : public ExpectNumber<SenderAndOutput, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "consecutive_retransmissions"; }
+  uint64_t value( const SenderAndOutput& s ) const override { return s.sender.consecutive_retransmissions(); }
+};
+
+struct HasError : public ExpectBool<SenderAndOutput>
+{
+  using ExpectBool::ExpectBool;
+  std::string name() const override { return "has_error"; }
+  bool value( const SenderAndOutput& s ) const override { return s.sender.writer().has_error(); }
+};
+
+class TCPSenderTestHarness : public TestHarness<SenderAndOutput>
+{
+public:
+  TCPSenderTestHarness( std::string name, const TCPConfig& config )
+    : TestHarness( move( name ),
+                   "initial_RTO_ms=" + std::to_string( config.rt_timeout ),
+                   { TCPSender { ByteStream { config.send_capacity },
+                                 config.fixed_isn.value_or( Wrap32 { 0 } ),
+                                 config.rt_timeout } } )
+  {}
+};
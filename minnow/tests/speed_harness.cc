@@ -0,0 +1,198 @@
+#include "speed_harness.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+atomic<uint64_t> allocations { 0 };
+
+void* allocate( size_t size, size_t alignment )
+{
+  allocations.fetch_add( 1, memory_order_relaxed );
+  size = max<size_t>( size, 1 );
+  const size_t rounded = ( size + alignment - 1 ) / alignment * alignment; // (aligned_alloc requires this)
+  void* ptr = alignment <= alignof( max_align_t ) ? malloc( size )               // NOLINT(*-no-malloc)
+                                                  : aligned_alloc( alignment, rounded ); // NOLINT(*-no-malloc)
+  if ( not ptr ) {
+    throw bad_alloc();
+  }
+  return ptr;
+}
+
+double percentile( vector<float>& samples, double fraction )
+{
+  if ( samples.empty() ) {
+    return 0;
+  }
+  const auto rank = static_cast<size_t>( fraction * static_cast<double>( samples.size() - 1 ) );
+  nth_element( samples.begin(), samples.begin() + static_cast<ptrdiff_t>( rank ), samples.end() );
+  return samples[rank];
+}
+
+string json_string( string_view str )
+{
+  string out = "\"";
+  for ( const char c : str ) {
+    if ( c == '"' or c == '\\' ) {
+      out += '\\';
+    }
+    out += c;
+  }
+  return out + "\"";
+}
+} // namespace
+
+// (the replaced operator delete stays the standard one, which frees memory from malloc or aligned_alloc)
+void* operator new( size_t size )
+{
+  return allocate( size, alignof( max_align_t ) );
+}
+
+void* operator new( size_t size, align_val_t alignment )
+{
+  return allocate( size, static_cast<size_t>( alignment ) );
+}
+
+uint64_t allocation_count()
+{
+  return allocations.load( memory_order_relaxed );
+}
+
+string BenchmarkResult::parameter_string() const
+{
+  string out;
+  for ( const auto& [key, value] : parameters ) {
+    out += ( out.empty() ? "" : " " ) + key + "=" + value;
+  }
+  return out;
+}
+
+Benchmark::Benchmark( string name, Parameters parameters, uint64_t ops_per_sample )
+  : name_( move( name ) ), parameters_( move( parameters ) ), ops_per_sample_( max<uint64_t>( ops_per_sample, 1 ) )
+{
+  samples_.reserve( max_samples );
+}
+
+void Benchmark::start()
+{
+  samples_.clear();
+  ops_ = bytes_ = ops_in_sample_ = 0;
+  allocations_at_start_ = allocation_count();
+  start_time_ = sample_start_ = steady_clock::now();
+}
+
+void Benchmark::sample()
+{
+  const auto now = steady_clock::now();
+  if ( samples_.size() < max_samples ) {
+    samples_.push_back( static_cast<float>( duration<double, nano>( now - sample_start_ ).count()
+                                            / static_cast<double>( ops_in_sample_ ) ) );
+  }
+  sample_start_ = now;
+  ops_in_sample_ = 0;
+}
+
+BenchmarkResult Benchmark::finish()
+{
+  const auto stop_time = steady_clock::now();
+  const uint64_t allocations_made = allocation_count() - allocations_at_start_;
+  if ( ops_in_sample_ > 0 ) {
+    sample();
+  }
+  if ( ops_ == 0 ) {
+    throw runtime_error( "Benchmark " + name_ + " finished without any operations" );
+  }
+
+  return { .name = name_,
+           .parameters = parameters_,
+           .ops = ops_,
+           .bytes = bytes_,
+           .seconds = duration<double>( stop_time - start_time_ ).count(),
+           .p50_ns = percentile( samples_, 0.50 ),
+           .p99_ns = percentile( samples_, 0.99 ),
+           .allocations = allocations_made };
+}
+
+BenchmarkSuite::BenchmarkSuite( string name, int argc, char* argv[] ) // NOLINT(*-avoid-c-arrays)
+  : name_( move( name ) )
+{
+  for ( int i = 1; i < argc; ++i ) {
+    const string_view arg = argv[i]; // NOLINT(*-pointer-arithmetic)
+    if ( ( arg == "--csv" or arg == "--json" ) and i + 1 < argc ) {
+      ( arg == "--csv" ? csv_path_ : json_path_ ) = argv[++i]; // NOLINT(*-pointer-arithmetic)
+    } else {
+      throw runtime_error( "usage: " + string( argv[0] ) + " [--csv FILE] [--json FILE]" );
+    }
+  }
+
+  if ( const char* dir = getenv( "MINNOW_BENCHMARK_DIR" ); dir and *dir ) { // NOLINT(*-mt-unsafe)
+    filesystem::create_directories( dir );
+    const filesystem::path base = filesystem::path( dir ) / name_;
+    csv_path_ = csv_path_.value_or( base.string() + ".csv" );
+    json_path_ = json_path_.value_or( base.string() + ".json" );
+  }
+}
+
+const BenchmarkResult& BenchmarkSuite::record( BenchmarkResult result )
+{
+  ostringstream line;
+  line << fixed << setprecision( 2 ) << result.name << " [" << result.parameter_string() << "]: ";
+  if ( result.bytes > 0 ) {
+    line << result.gigabits_per_second() << " Gbit/s, ";
+  }
+  line << result.ops_per_second() / 1e6 << " Mop/s, p50 " << setprecision( 0 ) << result.p50_ns << " ns, p99 "
+       << result.p99_ns << " ns, " << setprecision( 2 ) << result.allocations_per_op() << " allocs/op\n";
+  cout << line.str();
+
+  results_.push_back( move( result ) );
+  return results_.back();
+}
+
+void BenchmarkSuite::report() const
+{
+  if ( csv_path_ ) {
+    ofstream csv { *csv_path_ };
+    csv << "suite,benchmark,parameters,ops,bytes,seconds,gbit_per_s,ops_per_s,p50_ns,p99_ns,allocs_per_op\n";
+    for ( const auto& r : results_ ) {
+      csv << name_ << "," << r.name << "," << r.parameter_string() << "," << r.ops << "," << r.bytes << ","
+          << r.seconds << "," << r.gigabits_per_second() << "," << r.ops_per_second() << "," << r.p50_ns << ","
+          << r.p99_ns << "," << r.allocations_per_op() << "\n";
+    }
+    if ( not csv ) {
+      throw runtime_error( "BenchmarkSuite: could not write " + *csv_path_ );
+    }
+  }
+
+  if ( json_path_ ) {
+    ofstream json { *json_path_ };
+    json << "{\"suite\": " << json_string( name_ ) << ", \"results\": [";
+    for ( size_t i = 0; i < results_.size(); ++i ) {
+      const auto& r = results_[i];
+      json << ( i ? ",\n  " : "\n  " ) << "{\"benchmark\": " << json_string( r.name ) << ", \"parameters\": {";
+      for ( size_t j = 0; j < r.parameters.size(); ++j ) {
+        json << ( j ? ", " : "" ) << json_string( r.parameters[j].first ) << ": "
+             << json_string( r.parameters[j].second );
+      }
+      json << "}, \"ops\": " << r.ops << ", \"bytes\": " << r.bytes << ", \"seconds\": " << r.seconds
+           << ", \"gbit_per_s\": " << r.gigabits_per_second() << ", \"ops_per_s\": " << r.ops_per_second()
+           << ", \"p50_ns\": " << r.p50_ns << ", \"p99_ns\": " << r.p99_ns
+           << ", \"allocs_per_op\": " << r.allocations_per_op() << "}";
+    }
+    json << "\n]}\n";
+    if ( not json ) {
+      throw runtime_error( "BenchmarkSuite: could not write " + *json_path_ );
+    }
+  }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * A small harness for the speed tests: a Benchmark times a run of operations (and counts the bytes they
+ * process and the allocations they make), and a BenchmarkSuite prints each result and can save them all
+ * as CSV or JSON for tracking regressions.
+ *
+ * The results are saved if the speed test is run with `--csv FILE` or `--json FILE`, or with the
+ * MINNOW_BENCHMARK_DIR environment variable set (then as DIR/<suite>.csv and DIR/<suite>.json).
+ */
+
+// Calls to operator new so far, in any thread (counted by speed_harness.cc, which replaces operator new)
+uint64_t allocation_count();
+
+struct BenchmarkResult
+{
+  std::string name;
+  std::vector<std::pair<std::string, std::string>> parameters;
+  uint64_t ops;
+  uint64_t bytes;
+  double seconds;
+  double p50_ns; // per-op latency, by percentile
+  double p99_ns;
+  uint64_t allocations;
+
+  double gigabits_per_second() const { return 8 * static_cast<double>( bytes ) / seconds / 1e9; }
+  double ops_per_second() const { return static_cast<double>( ops ) / seconds; }
+  double allocations_per_op() const { return static_cast<double>( allocations ) / static_cast<double>( ops ); }
+
+  std::string parameter_string() const; // e.g. "capacity=4096 write_size=1500"
+};
+
+// Times one run of operations. The benchmark calls start(), then op() after each operation, then finish().
+// Latency is sampled over groups of `ops_per_sample` operations, so that reading the clock doesn't dominate
+// the cost of cheap operations; the percentiles are of the groups' mean per-op latency.
+class Benchmark
+{
+public:
+  using Parameters = std::vector<std::pair<std::string, std::string>>;
+
+  explicit Benchmark( std::string name, Parameters parameters = {}, uint64_t ops_per_sample = 64 );
+
+  void start();
+  void op( uint64_t bytes = 0 )
+  {
+    ops_++;
+    bytes_ += bytes;
+    if ( ++ops_in_sample_ == ops_per_sample_ ) {
+      sample();
+    }
+  }
+  BenchmarkResult finish();
+
+private:
+  static constexpr size_t max_samples = 1 << 20; // (reserved up front, so that sampling doesn't allocate)
+
+  std::string name_;
+  Parameters parameters_;
+  uint64_t ops_per_sample_;
+  std::vector<float> samples_ {};
+  std::chrono::steady_clock::time_point start_time_ {};
+  std::chrono::steady_clock::time_point sample_start_ {};
+  uint64_t ops_ {};
+  uint64_t bytes_ {};
+  uint64_t ops_in_sample_ {};
+  uint64_t allocations_at_start_ {};
+
+  void sample();
+};
+
+class BenchmarkSuite
+{
+public:
+  BenchmarkSuite( std::string name, int argc, char* argv[] ); // NOLINT(*-avoid-c-arrays)
+
+  // Print a result (and keep it for the report)
+  const BenchmarkResult& record( BenchmarkResult result );
+
+  // Save the results, if asked to
+  void report() const;
+
+private:
+  std::string name_;
+  std::optional<std::string> csv_path_ {};
+  std::optional<std::string> json_path_ {};
+  std::vector<BenchmarkResult> results_ {};
+};
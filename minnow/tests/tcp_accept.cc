@@ -0,0 +1,129 @@
+#include "socket.hh"
+
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono_literals;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+TCPSocket make_listener( const TCPSocket::ListenOptions& options )
+{
+  TCPSocket listener;
+  listener.bind( Address { "127.0.0.1", 0 } );
+  listener.listen( options );
+  listener.set_blocking( false );
+  return listener;
+}
+
+TCPSocket connect_to( const TCPSocket& listener )
+{
+  TCPSocket client;
+  client.connect( listener.local_address() );
+  return client;
+}
+
+// Several waiting connections come out of one call (up to its limit), already non-blocking
+void drain_queue()
+{
+  TCPSocket listener = make_listener( {} );
+  vector<TCPSocket> accepted;
+  expect( listener.accept_many( accepted ) == 0 and accepted.empty(), "an empty queue should give nothing" );
+
+  vector<TCPSocket> clients;
+  set<string> client_addresses;
+  for ( int i = 0; i < 5; ++i ) {
+    clients.push_back( connect_to( listener ) );
+    client_addresses.insert( clients.back().local_address().to_string() );
+  }
+
+  expect( listener.accept_many( accepted, 3 ) == 3, "accept_many() should stop at its limit" );
+  expect( listener.accept_many( accepted ) == 2, "accept_many() should take the rest of the queue" );
+  expect( listener.accept_many( accepted ) == 0, "the queue should now be empty" );
+
+  set<string> peer_addresses;
+  for ( auto& socket : accepted ) {
+    expect( socket.non_blocking(), "accepted sockets should be non-blocking" );
+    string buffer;
+    socket.read( buffer );
+    expect( buffer.empty(), "reading an idle accepted socket should not block" );
+    peer_addresses.insert( socket.peer_address().to_string() );
+  }
+  expect( peer_addresses == client_addresses, "every client should have been accepted once" );
+
+  clients.front().write( "hello" );
+  for ( int i = 0; i < 100; ++i ) {
+    for ( auto& socket : accepted ) {
+      string buffer;
+      socket.read( buffer );
+      if ( buffer == "hello" ) {
+        return;
+      }
+    }
+    this_thread::sleep_for( 1ms );
+  }
+  throw runtime_error( "accepted sockets should carry the clients' data" );
+}
+
+// With TCP_DEFER_ACCEPT, a connection is accepted only once the client has sent something
+void deferred_accept()
+{
+  TCPSocket listener = make_listener( { .backlog = 8, .defer_accept_seconds = 5, .fastopen_queue = 16 } );
+  TCPSocket client = connect_to( listener );
+
+  size_t accepted = 0;
+  const auto count = [&accepted]( TCPSocket&& socket ) {
+    expect( socket.non_blocking(), "accepted sockets should be non-blocking" );
+    ++accepted;
+  };
+  this_thread::sleep_for( 10ms );
+  expect( listener.accept_many( count ) == 0, "a connection with no data yet should be deferred" );
+
+  client.write( "GET" );
+  for ( int i = 0; accepted == 0 and i < 1000; ++i ) {
+    listener.accept_many( count );
+    this_thread::sleep_for( 1ms );
+  }
+  expect( accepted == 1, "the connection should be accepted once its data arrives" );
+}
+
+void blocking_listener()
+{
+  TCPSocket listener;
+  listener.bind( Address { "127.0.0.1", 0 } );
+  listener.listen();
+
+  bool threw = false;
+  try {
+    vector<TCPSocket> accepted;
+    listener.accept_many( accepted );
+  } catch ( const runtime_error& ) {
+    threw = true;
+  }
+  expect( threw, "accept_many() should refuse a blocking listener (its last accept would block)" );
+}
+
+int main()
+{
+  try {
+    drain_queue();
+    deferred_accept();
+    blocking_listener();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
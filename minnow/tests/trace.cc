@@ -0,0 +1,149 @@
+#include "trace.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( what );
+  }
+}
+
+vector<TraceRecord> drain_all()
+{
+  vector<TraceRecord> records;
+  Trace::drain( [&records]( const TraceRecord& record ) { records.push_back( record ); } );
+  return records;
+}
+
+// Records are only logged at (or above) the runtime level, and only if compiled in
+void levels()
+{
+  const uint16_t category = Trace::category( "levels" );
+  expect( Trace::category( "levels" ) == category, "a category's name should always give the same id" );
+  expect( Trace::category_name( category ) == "levels", "wrong category name" );
+
+  Trace::record<TraceLevel::Warning>( category, 1 );
+  expect( drain_all().empty(), "tracing starts off" );
+
+  Trace::set_level( TraceLevel::Info );
+  Trace::record<TraceLevel::Info>( category, 2, 3U, uint8_t { 4 } );
+  Trace::record<TraceLevel::Warning>( category );
+  Trace::record<TraceLevel::Debug>( category, 5 );
+  Trace::set_level( TraceLevel::Off );
+  Trace::record<TraceLevel::Warning>( category, 6 );
+
+  const auto records = drain_all();
+  expect( records.size() == 2, "expected an Info and a Warning record, got " + to_string( records.size() ) );
+  expect( records[0].category == category and records[0].level == TraceLevel::Info, "wrong first record" );
+  expect( records[0].arg_count == 3 and records[0].args[0] == 2 and records[0].args[1] == 3
+            and records[0].args[2] == 4,
+          "wrong arguments" );
+  expect( records[1].level == TraceLevel::Warning and records[1].arg_count == 0, "wrong second record" );
+  expect( records[0].timestamp_ns <= records[1].timestamp_ns, "records should be in order" );
+  expect( drain_all().empty(), "draining should remove the records" );
+}
+
+// Each thread logs into its own ring; the records survive the thread, and a full ring drops (and counts)
+void threads()
+{
+  const uint16_t category = Trace::category( "threads" );
+  Trace::set_level( TraceLevel::Debug );
+  const uint64_t dropped_before = Trace::dropped();
+
+  constexpr uint64_t per_thread = 1000;
+  vector<thread> workers;
+  for ( uint64_t t = 0; t < 4; ++t ) {
+    workers.emplace_back( [category, t] {
+      for ( uint64_t i = 0; i < per_thread; ++i ) {
+        Trace::record<TraceLevel::Warning>( category, t, i );
+      }
+    } );
+  }
+  for ( auto& worker : workers ) {
+    worker.join();
+  }
+
+  const auto records = drain_all();
+  expect( records.size() == 4 * per_thread, "expected every thread's records" );
+  vector<uint64_t> next( 4 );
+  for ( const auto& record : records ) {
+    const uint64_t t = record.args[0];
+    expect( record.args[1] == next.at( t )++, "each thread's records should be in order" );
+  }
+
+  for ( size_t i = 0; i < Trace::ring_records + 10; ++i ) {
+    Trace::record<TraceLevel::Warning>( category, i );
+  }
+  expect( Trace::dropped() == dropped_before + 10, "a full ring should drop the newest records" );
+  expect( Trace::drain( []( const TraceRecord& ) {} ) == Trace::ring_records, "the ring should have been full" );
+
+  // records written while another thread drains are neither lost nor duplicated
+  constexpr uint64_t concurrent = 100'000;
+  const uint64_t dropped_so_far = Trace::dropped();
+  atomic<bool> done = false;
+  thread writer { [category, &done] {
+    for ( uint64_t i = 0; i < concurrent; ++i ) {
+      Trace::record<TraceLevel::Warning>( category, i );
+    }
+    done = true;
+  } };
+
+  uint64_t drained = 0;
+  uint64_t expected = 0;
+  bool in_order = true;
+  const auto check = [&]( const TraceRecord& record ) {
+    in_order &= record.args[0] >= expected;
+    expected = record.args[0] + 1;
+    drained++;
+  };
+  while ( not done ) {
+    Trace::drain( check );
+  }
+  writer.join();
+  Trace::drain( check );
+  expect( in_order, "concurrently drained records should be in order" );
+  expect( drained + ( Trace::dropped() - dropped_so_far ) == concurrent, "records lost or duplicated" );
+  Trace::set_level( TraceLevel::Off );
+}
+
+// dump() writes text, and the flusher dumps in the background
+void dump()
+{
+  const uint16_t category = Trace::category( "dump" );
+  Trace::set_level( TraceLevel::Info );
+
+  ostringstream out;
+  Trace::start_flusher( out, chrono::milliseconds { 1 } );
+  Trace::record<TraceLevel::Info>( category, 42, 43 );
+  Trace::stop_flusher();
+  Trace::set_level( TraceLevel::Off );
+
+  expect( out.str().find( " thread " ) != string::npos, "dump should name the thread" );
+  expect( out.str().find( "info dump: 42 43\n" ) != string::npos, "unexpected dump: " + out.str() );
+}
+
+int main()
+{
+  try {
+    levels();
+    threads();
+    dump();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,14 @@
+#!/bin/bash
+
+# Every request to a host that refuses connections should fail (and promptly), rather than reconnect forever.
+URLS=40
+OUTPUT=`for i in $(seq ${URLS}); do echo "http://127.0.0.1:1/${i}"; done | timeout 10 ${1}/apps/webget --batch`
+STATUS=$?
+FAILED=`echo "${OUTPUT}" | grep -c "ERROR.*refused"`
+
+if [ ${STATUS} -ne 0 ] || [ "${FAILED}" != "${URLS}" ]; then
+    echo "${OUTPUT}"
+    echo ERROR: webget should have failed all ${URLS} requests to a refused port \(exit status ${STATUS}, ${FAILED} failed\)
+    exit 1
+fi
+exit 0
@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# Every request to a server that accepts connections but never responds should time out, rather than hang forever.
+URLS=10
+coproc SERVER { exec python3 -c '
+import socket, sys, time
+listener = socket.socket()
+listener.bind(("127.0.0.1", 0))
+listener.listen(64)
+print(listener.getsockname()[1], flush=True)
+connections = []
+while True:
+    connections.append(listener.accept()[0])
+'; }
+read -r PORT <&"${SERVER[0]}"
+
+START=`date +%s`
+OUTPUT=`for i in $(seq ${URLS}); do echo "http://127.0.0.1:${PORT}/${i}"; done | timeout 10 ${1}/apps/webget --batch 4 8 1`
+STATUS=$?
+ELAPSED=$(( `date +%s` - START ))
+kill ${SERVER_PID}
+FAILED=`echo "${OUTPUT}" | grep -c "ERROR.*timed out"`
+
+if [ ${STATUS} -ne 0 ] || [ "${FAILED}" != "${URLS}" ] || [ ${ELAPSED} -gt 5 ]; then
+    echo "${OUTPUT}"
+    echo ERROR: webget should have timed out all ${URLS} requests to a silent server \(exit status ${STATUS}, ${FAILED} failed, ${ELAPSED}s\)
+    exit 1
+fi
+exit 0
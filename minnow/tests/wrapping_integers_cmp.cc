@@ -0,0 +1,41 @@
+#include "random.hh"
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    // Comparing low-number adjacent seqnos
+    test_should_be( Wrap32( 3 ) != Wrap32( 1 ), true );
+    test_should_be( Wrap32( 3 ) == Wrap32( 1 ), false );
+
+    size_t N_REPS = 32768;
+
+    auto rd = get_random_engine();
+
+    for ( size_t i = 0; i < N_REPS; i++ ) {
+      const uint32_t n = rd();
+      const uint8_t diff = rd();
+      const uint32_t m = n + diff;
+      test_should_be( Wrap32( n ) == Wrap32( m ), n == m );
+      test_should_be( Wrap32( n ) != Wrap32( m ), n != m );
+      test_should_be( Wrap32( n ) + diff == Wrap32( m ), true );
+    }
+
+    // everything is usable at compile time
+    static_assert( Wrap32 { UINT32_MAX } + 2 == Wrap32 { 1 } );
+    static_assert( Wrap32::wrap( 5, Wrap32 { 7 } ) == Wrap32 { 12 } );
+    static_assert( Wrap32 { 12 }.unwrap( Wrap32 { 7 }, 1UL << 40 ) == ( 1UL << 40 ) + 5 );
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
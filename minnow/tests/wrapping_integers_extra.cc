@@ -0,0 +1,51 @@
+#include "random.hh"
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    uniform_int_distribution<uint32_t> dist32 { 0, UINT32_MAX };
+    uniform_int_distribution<uint64_t> dist64 { 0, UINT64_MAX };
+
+    // unwrap gives the candidate closest to the checkpoint, compared against a search over the neighbours
+    for ( size_t i = 0; i < 100000; ++i ) {
+      const Wrap32 isn { dist32( rd ) };
+      const Wrap32 seqno { dist32( rd ) };
+      const uint64_t checkpoint = i % 2 ? dist64( rd ) : dist32( rd );
+
+      const uint64_t answer = seqno.unwrap( isn, checkpoint );
+      test_should_be( Wrap32::wrap( answer, isn ), seqno );
+
+      // neither neighbouring candidate (2^32 below or above) is any closer
+      const auto distance_to = [&]( uint64_t x ) { return x > checkpoint ? x - checkpoint : checkpoint - x; };
+      const uint64_t distance = distance_to( answer );
+      if ( answer >= ( 1UL << 32 ) ) {
+        test_should_be( distance_to( answer - ( 1UL << 32 ) ) >= distance, true );
+      }
+      if ( answer <= UINT64_MAX - ( 1UL << 32 ) ) {
+        test_should_be( distance_to( answer + ( 1UL << 32 ) ) > distance, true );
+      }
+    }
+
+    // the magnitudes around each wrap
+    for ( uint64_t wraps = 0; wraps < 4; ++wraps ) {
+      const uint64_t base = wraps << 32;
+      test_should_be( Wrap32 { 0 }.unwrap( Wrap32 { 0 }, base ), base );
+      test_should_be( Wrap32 { 1 }.unwrap( Wrap32 { 0 }, base + UINT32_MAX ), base + ( 1UL << 32 ) + 1 );
+      test_should_be( Wrap32 { 7 }.unwrap( Wrap32 { 7 }, base + ( 1UL << 31 ) ), base );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
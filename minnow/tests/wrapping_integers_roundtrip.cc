@@ -0,0 +1,45 @@
+#include "random.hh"
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+void check_roundtrip( const Wrap32 isn, const uint64_t value, const uint64_t checkpoint )
+{
+  test_should_be( Wrap32::wrap( value, isn ).unwrap( isn, checkpoint ), value );
+}
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    uniform_int_distribution<uint32_t> dist31minus1 { 0, ( 1UL << 31 ) - 1 };
+    uniform_int_distribution<uint32_t> dist32 { 0, UINT32_MAX };
+    uniform_int_distribution<uint64_t> dist63 { 0, 1UL << 63 };
+
+    const uint64_t big_offset = ( 1UL << 31 ) - 1;
+
+    for ( unsigned int i = 0; i < 1000000; i++ ) {
+      const Wrap32 isn { dist32( rd ) };
+      const uint64_t val { dist63( rd ) };
+      const uint64_t offset { dist31minus1( rd ) };
+
+      check_roundtrip( isn, val, val );
+      check_roundtrip( isn, val + 1, val );
+      check_roundtrip( isn, val - 1, val );
+      check_roundtrip( isn, val + offset, val );
+      check_roundtrip( isn, val - offset, val );
+      check_roundtrip( isn, val + big_offset, val );
+      check_roundtrip( isn, val - big_offset, val );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
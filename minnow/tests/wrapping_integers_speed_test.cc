@@ -0,0 +1,65 @@
+#include "wrapping_integers.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+void speed_test( const size_t num_seqnos, const size_t repetitions, const size_t random_seed )
+{
+  default_random_engine rd { random_seed };
+  const Wrap32 isn { static_cast<uint32_t>( rd() ) };
+
+  // A stream's worth of sequence numbers, each near (within a window of) the previous one's absolute value
+  vector<Wrap32> seqnos;
+  uint64_t absolute = ( uint64_t { rd() } << 20 );
+  for ( size_t i = 0; i < num_seqnos; ++i ) {
+    absolute += rd() % 3000;
+    seqnos.push_back( Wrap32::wrap( absolute - rd() % 65536, isn ) );
+  }
+
+  uint64_t checkpoint = absolute / 2;
+  uint64_t checksum = 0;
+
+  const auto start_time = steady_clock::now();
+  for ( size_t rep = 0; rep < repetitions; ++rep ) {
+    for ( const Wrap32 seqno : seqnos ) {
+      const uint64_t unwrapped = seqno.unwrap( isn, checkpoint );
+      checksum += unwrapped;
+      checkpoint = unwrapped; // each unwrap depends on the last, as a receiver's checkpoint does
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  const auto test_duration = duration_cast<duration<double>>( stop_time - start_time );
+  const auto unwraps_per_second = static_cast<double>( num_seqnos * repetitions ) / test_duration.count();
+
+  cout << "Wrap32::unwrap reached " << fixed << setprecision( 2 ) << unwraps_per_second / 1e6
+       << " million unwraps/s (checksum " << checksum % 1000 << ").\n";
+
+  if ( unwraps_per_second < 1e7 ) {
+    throw runtime_error( "Wrap32::unwrap did not meet minimum speed of 10 million unwraps/s" );
+  }
+}
+
+void program_body()
+{
+  speed_test( 1 << 16, 1000, 1234 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
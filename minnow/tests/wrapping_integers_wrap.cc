@@ -0,0 +1,25 @@
+#include "test_should_be.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main()
+{
+  try {
+    test_should_be( Wrap32::wrap( 3 * ( 1LL << 32 ), Wrap32( 0 ) ), Wrap32( 0 ) );
+    test_should_be( Wrap32::wrap( 3 * ( 1LL << 32 ) + 17, Wrap32( 15 ) ), Wrap32( 32 ) );
+    test_should_be( Wrap32::wrap( 7 * ( 1LL << 32 ) - 2, Wrap32( 15 ) ), Wrap32( 13 ) );
+    test_should_be( Wrap32::wrap( 0, Wrap32( UINT32_MAX ) ), Wrap32( UINT32_MAX ) );
+    test_should_be( Wrap32::wrap( 1, Wrap32( UINT32_MAX ) ), Wrap32( 0 ) );
+    test_should_be( Wrap32::wrap( UINT64_MAX, Wrap32( 1 ) ), Wrap32( 0 ) );
+  } catch ( const exception& e ) {
+    cerr << e.what() << "\n";
+    return 1;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+#include "arp_message.hh"
+#include "address.hh"
+
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+bool ARPMessage::supported() const
+{
+  return hardware_type == TYPE_ETHERNET and protocol_type == EthernetHeader::TYPE_IPv4
+         and hardware_address_size == sizeof( EthernetHeader::src )
+         and protocol_address_size == sizeof( uint32_t ) and ( opcode == OPCODE_REQUEST or opcode == OPCODE_REPLY );
+}
+
+string ARPMessage::to_string() const
+{
+  stringstream ss {};
+  string opcode_str = "(unknown type)";
+  if ( opcode == OPCODE_REQUEST ) {
+    opcode_str = "REQUEST";
+  }
+  if ( opcode == OPCODE_REPLY ) {
+    opcode_str = "REPLY";
+  }
+  ss << "opcode=" << opcode_str << ", sender=" << ::to_string( sender_ethernet_address ) << "/"
+     << Address::from_ipv4_numeric( sender_ip_address ).ip()
+     << ", target=" << ::to_string( target_ethernet_address ) << "/"
+     << Address::from_ipv4_numeric( target_ip_address ).ip();
+  return ss.str();
+}
+
+void ARPMessage::parse( Parser& parser )
+{
+  parser.integers( hardware_type, protocol_type, hardware_address_size, protocol_address_size, opcode );
+  if ( parser.has_error() or not supported() ) {
+    parser.set_error();
+    return;
+  }
+
+  parse_address( parser, sender_ethernet_address );
+  parser.integer( sender_ip_address );
+  parse_address( parser, target_ethernet_address );
+  parser.integer( target_ip_address );
+}
+
+void ARPMessage::serialize( Serializer& serializer ) const
+{
+  if ( not supported() ) {
+    throw runtime_error( "ARPMessage::serialize(): unsupported field combination (must be Ethernet/IP, and "
+                         "request or reply)" );
+  }
+
+  serializer.integer( hardware_type );
+  serializer.integer( protocol_type );
+  serializer.integer( hardware_address_size );
+  serializer.integer( protocol_address_size );
+  serializer.integer( opcode );
+  serialize_address( serializer, sender_ethernet_address );
+  serializer.integer( sender_ip_address );
+  serialize_address( serializer, target_ethernet_address );
+  serializer.integer( target_ip_address );
+}
@@ -0,0 +1,72 @@
+#include "async_connect.hh"
+#include "exception.hh"
+
+#include <memory>
+#include <optional>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+// A connection in progress, shared by the rule's callbacks (and freed along with the rule)
+struct PendingConnect
+{
+  reference_wrapper<EventLoop> loop;
+  TCPSocket socket {};
+  ConnectCallbackT on_connected;
+  ConnectErrorCallbackT on_error;
+  optional<EventLoop::RuleHandle> rule {};
+  bool done {};
+
+  PendingConnect( EventLoop& s_loop, ConnectCallbackT s_on_connected, ConnectErrorCallbackT s_on_error )
+    : loop( s_loop ), on_connected( move( s_on_connected ) ), on_error( move( s_on_error ) )
+  {}
+
+  // The socket became writable (or `failed`, with an error or hangup): report the connection's result, once
+  void finish( bool failed )
+  {
+    if ( done ) {
+      return;
+    }
+    done = true;
+    rule->cancel();
+
+    try {
+      socket.throw_if_error();
+      if ( failed ) {
+        // the EventLoop has already consumed SO_ERROR (to report it), but kept it for the error callback
+        const int error = loop.get().last_socket_error();
+        if ( error != 0 ) {
+          throw unix_error { "connect", error };
+        }
+        throw runtime_error( "connect failed" );
+      }
+    } catch ( ... ) {
+      on_error( current_exception() );
+      return;
+    }
+
+    on_connected( move( socket ) );
+  }
+};
+} // namespace
+
+void async_connect( EventLoop& loop,
+                    size_t category_id,
+                    const Address& address,
+                    ConnectCallbackT on_connected,
+                    ConnectErrorCallbackT on_error )
+{
+  auto pending = make_shared<PendingConnect>( loop, move( on_connected ), move( on_error ) );
+  pending->socket.set_blocking( false );
+  pending->socket.start_connect( address ); // if already connected, the socket is writable right away
+
+  pending->rule = loop.add_rule(
+    category_id,
+    pending->socket,
+    EventLoop::Direction::Out,
+    [p = pending] { p->finish( false ); },
+    [p = pending] { return not p->done; },
+    [p = pending] { p->finish( true ); },
+    [p = pending] { p->finish( true ); } );
+}
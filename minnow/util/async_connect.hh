@@ -0,0 +1,21 @@
+#pragma once
+
+#include "eventloop.hh"
+#include "socket.hh"
+
+#include <exception>
+#include <functional>
+
+using ConnectCallbackT = std::function<void( TCPSocket&& socket )>;
+using ConnectErrorCallbackT = std::function<void( std::exception_ptr error )>;
+
+//! Connects a new (non-blocking) TCPSocket to `address` without blocking the EventLoop.
+//! \details The connection is started right away, and the loop waits for the socket to become writable,
+//! when Socket::throw_if_error() tells whether it succeeded. Then exactly one of the callbacks is called
+//! (from the loop): `on_connected` with the connected socket, or `on_error` with the reason it failed.
+//! A connect() that fails at once (e.g. with no route to the host) throws from async_connect itself.
+void async_connect( EventLoop& loop,
+                    size_t category_id,
+                    const Address& address,
+                    ConnectCallbackT on_connected,
+                    ConnectErrorCallbackT on_error );
@@ -0,0 +1,55 @@
+#include "buffer_pool.hh"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+thread_local vector<string> free_list; // NOLINT(*-avoid-non-const-global-variables)
+}
+
+string BufferPool::take( size_t size )
+{
+  size = min( size, slab_size );
+
+  string buffer;
+  if ( free_list.empty() ) {
+    buffer.reserve( slab_size );
+  } else {
+    buffer = move( free_list.back() );
+    free_list.pop_back();
+  }
+
+  buffer.resize( size ); // zero-fills only what's beyond the slab's previous size
+  return buffer;
+}
+
+void BufferPool::give_back( string buffer )
+{
+  if ( buffer.capacity() < slab_size or buffer.capacity() >= 2 * slab_size
+       or free_list.size() >= max_free_slabs ) {
+    return;
+  }
+
+  if ( free_list.capacity() == 0 ) {
+    free_list.reserve( max_free_slabs );
+  }
+  free_list.push_back( move( buffer ) );
+}
+
+void BufferPool::trim( string& buffer, size_t size )
+{
+  size = min( size, buffer.size() );
+  if ( size >= copy_below or buffer.capacity() < slab_size ) {
+    buffer.resize( size );
+    return;
+  }
+  give_back( exchange( buffer, buffer.substr( 0, size ) ) );
+}
+
+size_t BufferPool::free_slabs()
+{
+  return free_list.size();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/*
+ * A per-thread pool of read buffers ("slabs") with a fixed capacity of `slab_size` bytes.
+ *
+ * Resizing a fresh std::string to read into it zero-fills the whole buffer. A buffer taken
+ * from the pool reuses a slab that was given back earlier, keeping its contents, so only the
+ * bytes beyond the size it had when it was given back are zero-filled again. Each thread has
+ * its own free list, so neither take() nor give_back() locks.
+ */
+class BufferPool
+{
+public:
+  static constexpr size_t slab_size = 65536;
+  static constexpr size_t max_free_slabs = 64; // per thread
+  static constexpr size_t copy_below = slab_size / 4; // see trim()
+
+  // A buffer of `size` bytes (at most slab_size) with capacity for slab_size. The contents are unspecified.
+  static std::string take( size_t size = slab_size );
+
+  // Return a buffer to this thread's pool. Buffers that aren't slabs (or don't fit) are just freed.
+  static void give_back( std::string buffer );
+
+  // Shrink a buffer that was read into to the `size` bytes read. A slab is kept only for a read of at least
+  // copy_below bytes: a shorter read is copied into a right-sized string and the slab given back, so that buffered
+  // short reads (an eventfd's 8 bytes, a 1-byte write to a pipe) don't each pin a whole slab.
+  static void trim( std::string& buffer, size_t size );
+
+  // Number of slabs on this thread's free list
+  static size_t free_slabs();
+};
@@ -0,0 +1,211 @@
+#include "checksum.hh"
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#if defined( __x86_64__ )
+#include <immintrin.h>
+#elif defined( __aarch64__ )
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+
+/*
+ * Each kernel returns a (not yet folded) sum of the data's 16-bit words as loaded in host byte order.
+ * Summing wider words is equivalent, since 2^16 = 1 in ones' complement arithmetic, so the kernels add
+ * 32-bit words into 64-bit accumulators (which can't overflow). Byte order doesn't matter either, as long as
+ * the folded sum is swapped into network byte order at the end (RFC 1071, section 2(B)).
+ */
+namespace {
+uint64_t sum_tail( const char* data, size_t len )
+{
+  uint64_t sum = 0;
+  for ( ; len >= 4; data += 4, len -= 4 ) {
+    uint32_t word {};
+    memcpy( &word, data, 4 );
+    sum += word;
+  }
+  if ( len > 0 ) {
+    array<char, 4> last {}; // zero-padded, as the checksum pads an odd byte
+    memcpy( last.data(), data, len );
+    uint32_t word {};
+    memcpy( &word, last.data(), 4 );
+    sum += word;
+  }
+  return sum;
+}
+
+uint64_t sum_scalar( const char* data, size_t len )
+{
+  uint64_t sum = 0;
+  for ( ; len >= 8; data += 8, len -= 8 ) {
+    uint64_t word {};
+    memcpy( &word, data, 8 );
+    sum += ( word & 0xffff'ffff ) + ( word >> 32 );
+  }
+  return sum + sum_tail( data, len );
+}
+
+#if defined( __x86_64__ )
+uint64_t sum_sse2( const char* data, size_t len )
+{
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sum = zero;
+  for ( ; len >= 16; data += 16, len -= 16 ) {
+    const __m128i words = _mm_loadu_si128( reinterpret_cast<const __m128i*>( data ) ); // NOLINT
+    sum = _mm_add_epi64( sum, _mm_unpacklo_epi32( words, zero ) );
+    sum = _mm_add_epi64( sum, _mm_unpackhi_epi32( words, zero ) );
+  }
+
+  array<uint64_t, 2> lanes {};
+  _mm_storeu_si128( reinterpret_cast<__m128i*>( lanes.data() ), sum ); // NOLINT
+  return lanes[0] + lanes[1] + sum_scalar( data, len );
+}
+
+__attribute__( ( target( "avx2" ) ) ) uint64_t sum_avx2( const char* data, size_t len )
+{
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i sum0 = zero;
+  __m256i sum1 = zero;
+  for ( ; len >= 32; data += 32, len -= 32 ) {
+    const __m256i words = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( data ) ); // NOLINT
+    sum0 = _mm256_add_epi64( sum0, _mm256_unpacklo_epi32( words, zero ) );
+    sum1 = _mm256_add_epi64( sum1, _mm256_unpackhi_epi32( words, zero ) );
+  }
+
+  array<uint64_t, 4> lanes {};
+  _mm256_storeu_si256( reinterpret_cast<__m256i*>( lanes.data() ), _mm256_add_epi64( sum0, sum1 ) ); // NOLINT
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sum_sse2( data, len );
+}
+#endif
+
+#if defined( __aarch64__ )
+uint64_t sum_neon( const char* data, size_t len )
+{
+  uint64x2_t sum = vdupq_n_u64( 0 );
+  for ( ; len >= 16; data += 16, len -= 16 ) {
+    const uint32x4_t words = vreinterpretq_u32_u8( vld1q_u8( reinterpret_cast<const uint8_t*>( data ) ) ); // NOLINT
+    sum = vpadalq_u32( sum, words );
+  }
+  return vgetq_lane_u64( sum, 0 ) + vgetq_lane_u64( sum, 1 ) + sum_scalar( data, len );
+}
+#endif
+
+uint64_t sum_with( InternetChecksum::Kernel kernel, string_view data )
+{
+  switch ( kernel ) {
+#if defined( __x86_64__ )
+    case InternetChecksum::Kernel::SSE2:
+      return sum_sse2( data.data(), data.size() );
+    case InternetChecksum::Kernel::AVX2:
+      return sum_avx2( data.data(), data.size() );
+#elif defined( __aarch64__ )
+    case InternetChecksum::Kernel::NEON:
+      return sum_neon( data.data(), data.size() );
+#endif
+    default:
+      return sum_scalar( data.data(), data.size() );
+  }
+}
+
+uint16_t fold( uint64_t sum )
+{
+  while ( sum >> 16 ) {
+    sum = ( sum & 0xffff ) + ( sum >> 16 );
+  }
+  return static_cast<uint16_t>( sum );
+}
+
+uint16_t swap_bytes( uint16_t x )
+{
+  return static_cast<uint16_t>( ( x << 8 ) | ( x >> 8 ) );
+}
+} // namespace
+
+bool InternetChecksum::supported( Kernel kernel )
+{
+  switch ( kernel ) {
+    case Kernel::Scalar:
+      return true;
+#if defined( __x86_64__ )
+    case Kernel::SSE2:
+      return true;
+    case Kernel::AVX2:
+      return __builtin_cpu_supports( "avx2" );
+#elif defined( __aarch64__ )
+    case Kernel::NEON:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+InternetChecksum::Kernel InternetChecksum::best_kernel()
+{
+  static const Kernel best = [] {
+    for ( const Kernel k : { Kernel::AVX2, Kernel::SSE2, Kernel::NEON } ) {
+      if ( supported( k ) ) {
+        return k;
+      }
+    }
+    return Kernel::Scalar;
+  }();
+  return best;
+}
+
+InternetChecksum::InternetChecksum( uint32_t initial_sum, Kernel kernel ) : sum_( initial_sum ), kernel_( kernel )
+{
+  if ( not supported( kernel ) ) {
+    throw runtime_error( "InternetChecksum: kernel not supported on this CPU" );
+  }
+}
+
+void InternetChecksum::add( string_view data )
+{
+  uint16_t partial = fold( sum_with( kernel_, data ) );
+  if constexpr ( endian::native == endian::little ) {
+    partial = swap_bytes( partial );
+  }
+  if ( odd_ ) {
+    partial = swap_bytes( partial ); // every byte of this piece is in the other half of its word
+  }
+
+  sum_ += partial;
+  odd_ ^= data.size() % 2 == 1;
+}
+
+void InternetChecksum::add( const vector<string_view>& buffers )
+{
+  for ( const auto buffer : buffers ) {
+    add( buffer );
+  }
+}
+
+void InternetChecksum::add( const vector<Ref<string>>& buffers )
+{
+  for ( const auto& buffer : buffers ) {
+    add( buffer.get() );
+  }
+}
+
+uint16_t InternetChecksum::value() const
+{
+  return ~fold( sum_ );
+}
+
+uint16_t InternetChecksum::update( uint16_t checksum, uint16_t old_value, uint16_t new_value )
+{
+  // HC' = ~( ~HC + ~m + m' )
+  const uint32_t sum = uint16_t( ~checksum ) + uint32_t { uint16_t( ~old_value ) } + new_value;
+  return ~fold( sum );
+}
+
+uint16_t InternetChecksum::update( uint16_t checksum, uint32_t old_value, uint32_t new_value )
+{
+  checksum = update( checksum, static_cast<uint16_t>( old_value >> 16 ), static_cast<uint16_t>( new_value >> 16 ) );
+  return update( checksum, static_cast<uint16_t>( old_value ), static_cast<uint16_t>( new_value ) );
+}
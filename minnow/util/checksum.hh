@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ref.hh"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//! The Internet checksum (RFC 1071): the ones' complement of the ones' complement sum of 16-bit big-endian words.
+//! \details Data can be added in any number of pieces, of any lengths (a piece that starts at an odd offset
+//! is accounted for). The sum is computed with the widest vector kernel the CPU supports, chosen at runtime.
+class InternetChecksum
+{
+public:
+  //! The ways of summing a buffer. Each gives the same result.
+  enum class Kernel : uint8_t
+  {
+    Scalar, //!< 64-bit words, portable
+    SSE2,   //!< 128-bit vectors (x86-64)
+    AVX2,   //!< 256-bit vectors (x86-64, if the CPU supports it)
+    NEON,   //!< 128-bit vectors (AArch64)
+  };
+
+  //! `initial_sum` is a sum to start from, e.g. of a pseudo-header that isn't in the data
+  explicit InternetChecksum( uint32_t initial_sum = 0, Kernel kernel = best_kernel() );
+
+  void add( std::string_view data );
+  void add( const std::vector<std::string_view>& buffers );
+  void add( const std::vector<Ref<std::string>>& buffers );
+
+  //! The checksum of everything added so far (in host byte order)
+  uint16_t value() const;
+
+  //! Incrementally update `checksum` after a 16-bit field changed from `old_value` to `new_value`
+  //! (RFC 1624, eqn. 3), e.g. to decrement a TTL without summing the rest of the header again.
+  static uint16_t update( uint16_t checksum, uint16_t old_value, uint16_t new_value );
+  //! The same, for a 32-bit field (e.g. an address)
+  static uint16_t update( uint16_t checksum, uint32_t old_value, uint32_t new_value );
+
+  static bool supported( Kernel kernel ); //!< Can this CPU run `kernel`?
+  static Kernel best_kernel();            //!< The fastest supported kernel
+
+private:
+  uint64_t sum_;
+  Kernel kernel_;
+  bool odd_ {}; //!< Has an odd number of bytes been added (so the next piece starts at an odd offset)?
+};
@@ -0,0 +1,367 @@
+#include "coroutine.hh"
+
+#include "async_connect.hh"
+#include "buffer_pool.hh"
+
+#include <array>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace {
+constexpr size_t size_classes = FramePool::max_pooled_size / FramePool::granularity;
+
+// This thread's free frames, by size class (a class holds frames of up to (class + 1) * granularity bytes)
+struct FreeFrames
+{
+  array<vector<void*>, size_classes> lists {};
+
+  FreeFrames() = default;
+  FreeFrames( const FreeFrames& other ) = delete;
+  FreeFrames& operator=( const FreeFrames& other ) = delete;
+
+  ~FreeFrames()
+  {
+    for ( auto& list : lists ) {
+      for ( void* frame : list ) {
+        ::operator delete( frame );
+      }
+    }
+  }
+};
+
+// The rule for one fd and direction, and the awaiter (if any) that it will resume
+struct FDRuleState
+{
+  optional<EventLoop::RuleHandle> rule {};
+  coroutine_detail::FDWait* awaiter {};
+};
+
+thread_local FreeFrames frame_lists;        // NOLINT(*-avoid-non-const-global-variables)
+thread_local exception_ptr spawned_failure; // NOLINT(*-avoid-non-const-global-variables)
+// NOLINTNEXTLINE(*-avoid-non-const-global-variables)
+thread_local map<coroutine_detail::FDRuleKey, FDRuleState> fd_rules;
+
+size_t size_class( size_t size )
+{
+  return ( size + FramePool::granularity - 1 ) / FramePool::granularity - 1;
+}
+
+void rethrow_spawned_failure()
+{
+  if ( spawned_failure ) {
+    rethrow_exception( exchange( spawned_failure, nullptr ) );
+  }
+}
+
+// The coroutine that runs a spawned Task: it starts at once, frees itself when done, and leaves what the Task
+// threw for the caller of spawn() or coroutine_detail::resume() to rethrow.
+struct Detached
+{
+  struct promise_type
+  {
+    static void* operator new( size_t size ) { return FramePool::allocate( size ); }
+    static void operator delete( void* frame, size_t size ) { FramePool::deallocate( frame, size ); }
+
+    Detached get_return_object() const { return {}; }
+    suspend_never initial_suspend() const noexcept { return {}; }
+    suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const {}
+    void unhandled_exception() const { spawned_failure = current_exception(); }
+  };
+};
+
+Detached run_detached( Task<> task )
+{
+  co_await move( task );
+}
+} // namespace
+
+void* FramePool::allocate( size_t size )
+{
+  if ( size == 0 or size > max_pooled_size ) {
+    return ::operator new( size );
+  }
+
+  auto& list = frame_lists.lists.at( size_class( size ) );
+  if ( list.empty() ) {
+    return ::operator new( ( size_class( size ) + 1 ) * granularity );
+  }
+
+  void* frame = list.back();
+  list.pop_back();
+  return frame;
+}
+
+void FramePool::deallocate( void* frame, size_t size )
+{
+  if ( size == 0 or size > max_pooled_size ) {
+    ::operator delete( frame );
+    return;
+  }
+
+  auto& list = frame_lists.lists.at( size_class( size ) );
+  if ( list.size() >= max_free_frames ) {
+    ::operator delete( frame );
+    return;
+  }
+
+  if ( list.capacity() == 0 ) {
+    list.reserve( max_free_frames );
+  }
+  list.push_back( frame );
+}
+
+size_t FramePool::free_frames()
+{
+  size_t count = 0;
+  for ( const auto& list : frame_lists.lists ) {
+    count += list.size();
+  }
+  return count;
+}
+
+void coroutine_detail::resume( coroutine_handle<> handle )
+{
+  handle.resume();
+  rethrow_spawned_failure();
+}
+
+void spawn( Task<> task )
+{
+  run_detached( move( task ) );
+  rethrow_spawned_failure();
+}
+
+namespace coroutine_detail {
+
+FDWait::FDWait( EventLoop& loop, FileDescriptor& fd, EventLoop::Direction direction, const char* category )
+  : fd_( fd ), loop_( loop ), direction_( direction ), category_( category )
+{}
+
+// A coroutine destroyed while it waits stops waiting
+FDWait::~FDWait()
+{
+  const auto it = fd_rules.find( key_ );
+  if ( it != fd_rules.end() and it->second.awaiter == this ) {
+    it->second.rule->cancel();
+    fd_rules.erase( it );
+  }
+}
+
+void FDWait::await_suspend( coroutine_handle<> awaiting )
+{
+  awaiting_ = awaiting;
+  EventLoop& loop = loop_;
+  key_ = { &loop, fd_.get().fd_num(), direction_ };
+
+  auto [it, added] = fd_rules.try_emplace( key_ );
+  FDRuleState& state = it->second;
+  if ( state.awaiter ) {
+    throw runtime_error( string { category_ } + ": another coroutine is already waiting for this fd" );
+  }
+  state.awaiter = this;
+
+  if ( added ) {
+    state.rule = loop.add_rule(
+      loop.category( category_ ),
+      fd_,
+      direction_,
+      [key = key_] { rule_fired( key, false ); },
+      [&state] { return state.awaiter != nullptr; },
+      [key = key_] { rule_fired( key, true ); } );
+  }
+}
+
+// Called from the rule: complete the await that's waiting on it, and cancel the rule unless the coroutine that was
+// resumed has awaited the fd again (or the loop has cancelled it already: the fd hung up)
+void FDWait::rule_fired( const FDRuleKey& key, bool rule_hung_up )
+{
+  const auto it = fd_rules.find( key );
+  if ( it == fd_rules.end() ) {
+    return;
+  }
+  FDWait* awaiter = exchange( it->second.awaiter, nullptr );
+  if ( rule_hung_up ) {
+    fd_rules.erase( it ); // a later await on the fd gets a new rule
+  }
+
+  const auto cancel_unless_awaited = [&key] {
+    const auto again = fd_rules.find( key );
+    if ( again != fd_rules.end() and not again->second.awaiter ) {
+      again->second.rule->cancel();
+      fd_rules.erase( again );
+    }
+  };
+
+  if ( awaiter ) {
+    try {
+      awaiter->complete( rule_hung_up );
+    } catch ( ... ) {
+      cancel_unless_awaited(); // (what a spawned coroutine threw, on its way out of the loop)
+      throw;
+    }
+  }
+  cancel_unless_awaited();
+}
+
+// Do the I/O (or note the hangup), then resume the awaiting coroutine, unless perform() is to keep waiting
+void FDWait::complete( bool rule_hung_up )
+{
+  try {
+    if ( rule_hung_up ) {
+      hung_up();
+    } else if ( not perform() ) {
+      fd_rules.at( key_ ).awaiter = this;
+      return;
+    }
+  } catch ( ... ) {
+    error_ = current_exception();
+  }
+
+  resume( awaiting_ ); // the awaiter is gone once the coroutine carries on, so this must come last
+}
+
+void FDWait::rethrow_if_failed() const
+{
+  if ( error_ ) {
+    rethrow_exception( error_ );
+  }
+}
+
+ReadAwaiter::ReadAwaiter( EventLoop& loop, FileDescriptor& fd, string& buffer )
+  : FDWait( loop, fd, EventLoop::Direction::In, "async_read" ), buffer_( buffer )
+{}
+
+bool ReadAwaiter::perform()
+{
+  string& buffer = buffer_;
+  BufferPool::give_back( move( buffer ) ); // so that the read below takes the same slab back
+  buffer.clear();
+  fd_.get().read( buffer );
+  return true;
+}
+
+size_t ReadAwaiter::await_resume()
+{
+  rethrow_if_failed();
+  return buffer_.get().size();
+}
+
+WriteAwaiter::WriteAwaiter( EventLoop& loop, FileDescriptor& fd, string_view data )
+  : FDWait( loop, fd, EventLoop::Direction::Out, "async_write" ), data_( data )
+{}
+
+bool WriteAwaiter::perform()
+{
+  written_ = fd_.get().write( data_ );
+  return true;
+}
+
+void WriteAwaiter::hung_up()
+{
+  throw runtime_error( "async_write: the file descriptor hung up (or was closed) before it was writable" );
+}
+
+size_t WriteAwaiter::await_resume()
+{
+  rethrow_if_failed();
+  return written_;
+}
+
+AcceptAwaiter::AcceptAwaiter( EventLoop& loop, TCPSocket& listener )
+  : FDWait( loop, listener, EventLoop::Direction::In, "async_accept" )
+{}
+
+bool AcceptAwaiter::perform()
+{
+  auto& listener = static_cast<TCPSocket&>( fd_.get() ); // NOLINT(*-static-cast-downcast)
+  if ( listener.non_blocking() ) {
+    // (none if another process took the connection first)
+    listener.accept_many( [this]( TCPSocket&& socket ) { accepted_.emplace( move( socket ) ); }, 1 );
+  } else {
+    accepted_.emplace( listener.accept() );
+    accepted_->set_blocking( false );
+  }
+  return accepted_.has_value();
+}
+
+void AcceptAwaiter::hung_up()
+{
+  throw runtime_error( "async_accept: the listening socket failed (or was closed)" );
+}
+
+TCPSocket AcceptAwaiter::await_resume()
+{
+  rethrow_if_failed();
+  return move( *accepted_ );
+}
+
+ConnectAwaiter::ConnectAwaiter( EventLoop& loop, Address address ) : loop_( loop ), address_( move( address ) ) {}
+
+void ConnectAwaiter::await_suspend( coroutine_handle<> awaiting )
+{
+  EventLoop& loop = loop_;
+  ::async_connect(
+    loop,
+    loop.category( "async_connect" ),
+    address_,
+    [this, awaiting]( TCPSocket&& socket ) {
+      connected_.emplace( move( socket ) );
+      resume( awaiting );
+    },
+    [this, awaiting]( exception_ptr error ) {
+      error_ = move( error );
+      resume( awaiting );
+    } );
+}
+
+TCPSocket ConnectAwaiter::await_resume()
+{
+  if ( error_ ) {
+    rethrow_exception( error_ );
+  }
+  return move( *connected_ );
+}
+
+void SleepAwaiter::await_suspend( coroutine_handle<> awaiting )
+{
+  EventLoop& loop = loop_;
+  loop.add_timer( loop.category( "sleep_for" ), delay_, [awaiting] { resume( awaiting ); } );
+}
+
+} // namespace coroutine_detail
+
+coroutine_detail::ReadAwaiter async_read( EventLoop& loop, FileDescriptor& fd, string& buffer )
+{
+  return { loop, fd, buffer };
+}
+
+coroutine_detail::WriteAwaiter async_write( EventLoop& loop, FileDescriptor& fd, string_view data )
+{
+  return { loop, fd, data };
+}
+
+Task<> async_write_all( EventLoop& loop, FileDescriptor& fd, string_view data )
+{
+  while ( not data.empty() ) {
+    data.remove_prefix( co_await async_write( loop, fd, data ) );
+  }
+}
+
+coroutine_detail::AcceptAwaiter async_accept( EventLoop& loop, TCPSocket& listener )
+{
+  return { loop, listener };
+}
+
+coroutine_detail::ConnectAwaiter async_connect( EventLoop& loop, const Address& address )
+{
+  return { loop, address };
+}
+
+coroutine_detail::SleepAwaiter sleep_for( EventLoop& loop, chrono::milliseconds delay )
+{
+  return { loop, delay };
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+#include "eventloop.hh"
+#include "socket.hh"
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+/*
+ * Coroutines over the EventLoop, so that a multi-step exchange (connect, write a request, read the reply...)
+ * can be written as straight-line code instead of a chain of callbacks, and many of them can run at once on
+ * one thread:
+ *
+ *   Task<> fetch( EventLoop& loop, Address server ) {
+ *     TCPSocket socket = co_await async_connect( loop, server );
+ *     co_await async_write_all( loop, socket, request );
+ *     std::string reply;
+ *     while ( co_await async_read( loop, socket, reply ) ) { ... }
+ *   }
+ *   spawn( fetch( loop, server ) );
+ *   while ( loop.wait_next_event( -1 ) != EventLoop::Result::Exit ) {}
+ *
+ * Each awaitable waits with a rule (or timer) on the loop, and the loop resumes the coroutine from that rule's
+ * callback, once the fd is ready and the read or write has been done. The fds should be non-blocking (as
+ * async_accept's and async_connect's sockets are), so that a write to a slow peer writes what fits instead of
+ * blocking the loop. An exception thrown by a spawned coroutine (and not caught by it) propagates out of the call
+ * that resumed it: spawn() or EventLoop::wait_next_event(). A coroutine that is waiting must not outlive its loop.
+ *
+ * The awaitables' rules are in the categories "async_read", "async_write", "async_accept", "async_connect" and
+ * "sleep_for", so the loop's stats count them like any other rules.
+ */
+
+/*
+ * Coroutine frames come from a per-thread pool of free frames, in size classes of `granularity` bytes, so a
+ * warmed-up program that starts a coroutine per connection or per request doesn't allocate. Frames bigger than
+ * `max_pooled_size` are just allocated and freed.
+ */
+class FramePool
+{
+public:
+  static constexpr size_t granularity = 64;
+  static constexpr size_t max_pooled_size = 2048;
+  static constexpr size_t max_free_frames = 64; // per size class, per thread
+
+  static void* allocate( size_t size );
+  static void deallocate( void* frame, size_t size );
+
+  // Number of frames on this thread's free lists
+  static size_t free_frames();
+};
+
+namespace coroutine_detail {
+
+// Resume a coroutine, and rethrow whatever a spawned coroutine threw (and didn't catch) while it ran.
+void resume( std::coroutine_handle<> handle );
+
+struct PromiseBase
+{
+  std::coroutine_handle<> continuation_ { std::noop_coroutine() }; // who co_awaits this one (if anyone)
+  std::exception_ptr exception_ {};
+
+  static void* operator new( size_t size ) { return FramePool::allocate( size ); }
+  static void operator delete( void* frame, size_t size ) { FramePool::deallocate( frame, size ); }
+
+  // At the end, carry on with the awaiting coroutine (by symmetric transfer, so deep chains don't grow the stack).
+  struct FinalAwaiter
+  {
+    bool await_ready() const noexcept { return false; }
+    template<typename Promise>
+    std::coroutine_handle<> await_suspend( std::coroutine_handle<Promise> handle ) noexcept
+    {
+      return handle.promise().continuation_;
+    }
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() { exception_ = std::current_exception(); }
+
+  void rethrow_if_failed() const
+  {
+    if ( exception_ ) {
+      std::rethrow_exception( exception_ );
+    }
+  }
+};
+
+template<typename T>
+struct Promise : PromiseBase
+{
+  std::optional<T> value_ {};
+
+  template<typename U>
+  void return_value( U&& value )
+  {
+    value_.emplace( std::forward<U>( value ) );
+  }
+
+  T result()
+  {
+    rethrow_if_failed();
+    return std::move( *value_ );
+  }
+};
+
+template<>
+struct Promise<void> : PromiseBase
+{
+  void return_void() const {}
+  void result() const { rethrow_if_failed(); }
+};
+
+} // namespace coroutine_detail
+
+/*
+ * A Task<T> is a coroutine that produces a T. It starts when it is co_awaited (or spawned), and the awaiting
+ * coroutine carries on once it has finished. Destroying a Task that hasn't finished destroys its coroutine.
+ */
+template<typename T = void>
+class [[nodiscard]] Task
+{
+public:
+  struct promise_type : coroutine_detail::Promise<T>
+  {
+    Task get_return_object() { return Task { std::coroutine_handle<promise_type>::from_promise( *this ) }; }
+  };
+
+  Task( Task&& other ) noexcept : handle_( std::exchange( other.handle_, nullptr ) ) {}
+  Task& operator=( Task&& other ) noexcept
+  {
+    if ( this != &other ) {
+      destroy();
+      handle_ = std::exchange( other.handle_, nullptr );
+    }
+    return *this;
+  }
+  Task( const Task& other ) = delete;
+  Task& operator=( const Task& other ) = delete;
+  ~Task() { destroy(); }
+
+  bool await_ready() const noexcept { return not handle_ or handle_.done(); }
+  std::coroutine_handle<> await_suspend( std::coroutine_handle<> awaiting ) noexcept
+  {
+    handle_.promise().continuation_ = awaiting;
+    return handle_;
+  }
+  T await_resume() { return handle_.promise().result(); }
+
+private:
+  std::coroutine_handle<promise_type> handle_;
+
+  explicit Task( std::coroutine_handle<promise_type> handle ) : handle_( handle ) {}
+
+  void destroy()
+  {
+    if ( handle_ ) {
+      handle_.destroy();
+      handle_ = nullptr;
+    }
+  }
+};
+
+// Start `task` now, running it until it first suspends. From then on, it is resumed by the EventLoop, and its
+// frame is freed when it finishes.
+void spawn( Task<> task );
+
+namespace coroutine_detail {
+
+// The loop, fd number and direction of an FDWait's rule
+using FDRuleKey = std::tuple<const EventLoop*, int, EventLoop::Direction>;
+
+// Waits for `fd` to be ready in `direction` with a rule that, once it is, calls perform() (which must read or
+// write the fd, as the EventLoop requires of its rules) and resumes the awaiting coroutine, unless perform()
+// returns false to keep waiting. If the loop cancels the rule instead (the fd hung up, or had an error, or was
+// closed), it calls hung_up().
+//
+// There is one rule for each fd and direction that a coroutine on the loop awaits, and only one coroutine may
+// wait on it at a time. The rule stays as long as each coroutine it resumes awaits the same fd and direction again
+// before returning to the loop (reading until EOF, writing all of a buffer, accepting connection after
+// connection), and is then cancelled, so a run of awaits costs one rule (and one epoll registration).
+class FDWait
+{
+public:
+  FDWait( EventLoop& loop, FileDescriptor& fd, EventLoop::Direction direction, const char* category );
+  virtual ~FDWait();
+  FDWait( const FDWait& other ) = delete;
+  FDWait& operator=( const FDWait& other ) = delete;
+  FDWait( FDWait&& other ) = delete;
+  FDWait& operator=( FDWait&& other ) = delete;
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend( std::coroutine_handle<> awaiting );
+
+protected:
+  std::reference_wrapper<FileDescriptor> fd_;
+  std::exception_ptr error_ {};
+
+  virtual bool perform() = 0; // returns false to keep waiting
+  virtual void hung_up() = 0;
+  void rethrow_if_failed() const;
+
+private:
+  std::reference_wrapper<EventLoop> loop_;
+  EventLoop::Direction direction_;
+  const char* category_;
+  FDRuleKey key_ {};
+  std::coroutine_handle<> awaiting_ {};
+
+  static void rule_fired( const FDRuleKey& key, bool rule_hung_up );
+  void complete( bool rule_hung_up );
+};
+
+class ReadAwaiter : public FDWait
+{
+  std::reference_wrapper<std::string> buffer_;
+
+  bool perform() override;
+  void hung_up() override { perform(); } // reading a hung-up fd doesn't block: it gives EOF, or the error
+
+public:
+  ReadAwaiter( EventLoop& loop, FileDescriptor& fd, std::string& buffer );
+  size_t await_resume();
+};
+
+class WriteAwaiter : public FDWait
+{
+  std::string_view data_;
+  size_t written_ {};
+
+  bool perform() override;
+  void hung_up() override;
+
+public:
+  WriteAwaiter( EventLoop& loop, FileDescriptor& fd, std::string_view data );
+  size_t await_resume();
+};
+
+class AcceptAwaiter : public FDWait
+{
+  std::optional<TCPSocket> accepted_ {};
+
+  bool perform() override;
+  void hung_up() override;
+
+public:
+  AcceptAwaiter( EventLoop& loop, TCPSocket& listener );
+  TCPSocket await_resume();
+};
+
+class ConnectAwaiter
+{
+  std::reference_wrapper<EventLoop> loop_;
+  Address address_;
+  std::optional<TCPSocket> connected_ {};
+  std::exception_ptr error_ {};
+
+public:
+  ConnectAwaiter( EventLoop& loop, Address address );
+  bool await_ready() const noexcept { return false; }
+  void await_suspend( std::coroutine_handle<> awaiting );
+  TCPSocket await_resume();
+};
+
+class SleepAwaiter
+{
+  std::reference_wrapper<EventLoop> loop_;
+  std::chrono::milliseconds delay_;
+
+public:
+  SleepAwaiter( EventLoop& loop, std::chrono::milliseconds delay ) : loop_( loop ), delay_( delay ) {}
+  bool await_ready() const noexcept { return false; }
+  void await_suspend( std::coroutine_handle<> awaiting );
+  void await_resume() const noexcept {}
+};
+
+} // namespace coroutine_detail
+
+// Read from `fd` into `buffer` (as FileDescriptor::read does) once it is readable. Returns the number of bytes
+// read, which is 0 only at EOF.
+coroutine_detail::ReadAwaiter async_read( EventLoop& loop, FileDescriptor& fd, std::string& buffer );
+
+// Write (some of) `data` to `fd` once it is writable: as much as fits, if `fd` is non-blocking. Returns the number
+// of bytes written.
+// Throws if the fd hangs up first. `data` must stay valid until the write is done.
+coroutine_detail::WriteAwaiter async_write( EventLoop& loop, FileDescriptor& fd, std::string_view data );
+
+// Write all of `data`, as many writes as it takes (waiting for `fd` to be writable again after each).
+Task<> async_write_all( EventLoop& loop, FileDescriptor& fd, std::string_view data );
+
+// Accept a connection on a listening socket once one is waiting. The connection's socket is non-blocking.
+coroutine_detail::AcceptAwaiter async_accept( EventLoop& loop, TCPSocket& listener );
+
+// Connect a new (non-blocking) TCPSocket to `address` (with async_connect() from async_connect.hh).
+// Throws if the connection fails.
+coroutine_detail::ConnectAwaiter async_connect( EventLoop& loop, const Address& address );
+
+// Resume after `delay` (with a one-shot timer).
+coroutine_detail::SleepAwaiter sleep_for( EventLoop& loop, std::chrono::milliseconds delay );
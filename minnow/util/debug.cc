@@ -14,12 +14,6 @@ static void ( *debug_handler )( void*, std::string_view ) = default_debug_handle
 static void* debug_arg = nullptr;
 // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
 
-std::string debug_format(const std::string& message) {
-  std::ostringstream ss;
-  ss << message;
-  return ss.str();
-}
-
 void debug_str( string_view message )
 {
   debug_handler( debug_arg, message );
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <iostream>
 #include <sstream>
 #include <string_view>
@@ -11,13 +12,52 @@
 // as part of the "unsuccessful test" output. Otherwise, debug outputs go to stderr.
 void debug_str( std::string_view message );
 
+// Debug output can be turned off at runtime (e.g. in an app's hot path): then debug() costs
+// one branch, and formats nothing. In an NDEBUG build, it compiles to nothing.
+inline std::atomic<bool> debug_output_enabled { true }; // NOLINT(*-avoid-non-const-global-variables)
+inline void set_debug_enabled( bool enabled )
+{
+  debug_output_enabled.store( enabled, std::memory_order_relaxed );
+}
+inline bool debug_enabled()
+{
+  return debug_output_enabled.load( std::memory_order_relaxed );
+}
+
+// Write `fmt` to `out`, replacing each "{}" with the next argument
+inline void debug_format( std::ostream& out, std::string_view fmt )
+{
+  out << fmt;
+}
+
+template<typename Arg, typename... Args>
+void debug_format( std::ostream& out, std::string_view fmt, Arg&& arg, Args&&... args )
+{
+  const size_t placeholder = fmt.find( "{}" );
+  if ( placeholder == std::string_view::npos ) {
+    out << fmt << std::forward<Arg>( arg ); // (extra arguments are appended)
+    debug_format( out, {}, std::forward<Args>( args )... );
+    return;
+  }
+  out << fmt.substr( 0, placeholder ) << std::forward<Arg>( arg );
+  debug_format( out, fmt.substr( placeholder + 2 ), std::forward<Args>( args )... );
+}
+
 template<typename... Args>
 void debug( std::string_view fmt, Args&&... args )
 {
 #ifndef NDEBUG
-  std::ostringstream ss;
-  (ss << ... << args);
-  debug_str( ss.str() );
+  if ( not debug_enabled() ) {
+    return;
+  }
+
+  if constexpr ( sizeof...( Args ) == 0 ) {
+    debug_str( fmt ); // nothing to format (and nothing to allocate)
+  } else {
+    std::ostringstream ss;
+    debug_format( ss, fmt, std::forward<Args>( args )... );
+    debug_str( ss.str() );
+  }
 #endif
 }
 
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "ethernet_header.hh"
+#include "parser.hh"
+#include "slice.hh"
+
+#include <vector>
+
+// An Ethernet frame: a header and a payload, which parses and serializes as views of the same bytes
+struct EthernetFrame
+{
+  EthernetHeader header {};
+  std::vector<Slice> payload {};
+
+  void parse( Parser& parser )
+  {
+    header.parse( parser );
+    parser.all_remaining( payload );
+  }
+
+  void serialize( Serializer& serializer ) const
+  {
+    header.serialize( serializer );
+    serializer.buffer( payload );
+  }
+
+  // Bytes that serialize() copies: the header's (the payload is kept as segments)
+  static constexpr uint64_t copied_length() { return EthernetHeader::copied_length(); }
+};
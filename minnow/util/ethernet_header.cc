@@ -0,0 +1,64 @@
+#include "ethernet_header.hh"
+
+#include <iomanip>
+#include <sstream>
+#include <tuple>
+
+using namespace std;
+
+string to_string( const EthernetAddress& address )
+{
+  stringstream ss {};
+  for ( size_t index = 0; index < address.size(); index++ ) {
+    ss.width( 2 );
+    ss << setfill( '0' ) << hex << static_cast<int>( address.at( index ) );
+    if ( index != address.size() - 1 ) {
+      ss << ":";
+    }
+  }
+  return ss.str();
+}
+
+void parse_address( Parser& parser, EthernetAddress& address )
+{
+  apply( [&parser]( auto&... bytes ) { parser.integers( bytes... ); }, address );
+}
+
+void serialize_address( Serializer& serializer, const EthernetAddress& address )
+{
+  for ( const uint8_t byte : address ) {
+    serializer.integer( byte );
+  }
+}
+
+string EthernetHeader::to_string() const
+{
+  stringstream ss {};
+  ss << "dst=" << ::to_string( dst ) << ", src=" << ::to_string( src ) << ", type=";
+  switch ( type ) {
+    case TYPE_IPv4:
+      ss << "IPv4";
+      break;
+    case TYPE_ARP:
+      ss << "ARP";
+      break;
+    default:
+      ss << "[unknown type " << hex << type << "!]";
+      break;
+  }
+  return ss.str();
+}
+
+void EthernetHeader::parse( Parser& parser )
+{
+  parse_address( parser, dst );
+  parse_address( parser, src );
+  parser.integer( type );
+}
+
+void EthernetHeader::serialize( Serializer& serializer ) const
+{
+  serialize_address( serializer, dst );
+  serialize_address( serializer, src );
+  serializer.integer( type );
+}
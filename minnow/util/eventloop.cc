@@ -1,8 +1,16 @@
 #include "eventloop.hh"
 #include "exception.hh"
+#include "trace.hh"
 
+#include <algorithm>
+#include <array>
+#include <climits>
 #include <cstring>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <span>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 
 using namespace std;
@@ -12,16 +20,44 @@ unsigned int EventLoop::FDRule::service_count() const
   return direction == Direction::In ? fd.read_count() : fd.write_count();
 }
 
+// poll(2) and epoll(7) use the same bit values for the events that EventLoop cares about
+static_assert( POLLIN == EPOLLIN and POLLOUT == EPOLLOUT and POLLERR == EPOLLERR and POLLHUP == EPOLLHUP );
+
+namespace {
+const uint16_t trace_callbacks = Trace::category( "EventLoop callback (rule category, ns)" );
+} // namespace
+
+//! \param[in] backend selects the kernel interface; Backend::Epoll falls back to Backend::Poll if unavailable
+EventLoop::EventLoop( const Backend backend ) : _backend( backend )
+{
+  _rule_categories.reserve( 64 );
+
+  if ( _backend == Backend::Epoll ) {
+    const int epoll_fd = epoll_create1( EPOLL_CLOEXEC );
+    if ( epoll_fd < 0 ) {
+      _backend = Backend::Poll;
+    } else {
+      _epoll_fd.emplace( epoll_fd );
+    }
+  }
+}
+
 size_t EventLoop::add_category( const string& name )
 {
   if ( _rule_categories.size() >= _rule_categories.capacity() ) {
     throw runtime_error( "maximum categories reached" );
   }
 
-  _rule_categories.push_back( { name } );
+  _rule_categories.push_back( { .name = name } );
   return _rule_categories.size() - 1;
 }
 
+size_t EventLoop::category( const string& name )
+{
+  const auto existing = ranges::find( _rule_categories, name, &CategoryStats::name );
+  return existing == _rule_categories.end() ? add_category( name ) : existing - _rule_categories.begin();
+}
+
 EventLoop::BasicRule::BasicRule( size_t s_category_id, InterestT s_interest, CallbackT s_callback )
   : category_id( s_category_id ), interest( move( s_interest ) ), callback( move( s_callback ) )
 {}
@@ -50,10 +86,10 @@ EventLoop::RuleHandle EventLoop::add_rule( size_t category_id,
     throw out_of_range( "bad category_id" );
   }
 
-  _fd_rules.emplace_back( make_shared<FDRule>(
-    BasicRule { category_id, interest, callback }, fd.duplicate(), direction, cancel, error ) );
+  const uint32_t index
+    = _fd_rules.emplace( BasicRule { category_id, interest, callback }, fd.duplicate(), direction, cancel, error );
 
-  return RuleHandle { _fd_rules.back() };
+  return RuleHandle { *this, RuleKind::FD, index, _fd_rules.generation( index ) };
 }
 
 EventLoop::RuleHandle EventLoop::add_rule( const size_t category_id,
@@ -64,164 +100,554 @@ EventLoop::RuleHandle EventLoop::add_rule( const size_t category_id,
     throw out_of_range( "bad category_id" );
   }
 
-  _non_fd_rules.emplace_back( make_shared<BasicRule>( category_id, interest, callback ) );
+  const uint32_t index = _non_fd_rules.emplace( category_id, interest, callback );
 
-  return RuleHandle { _non_fd_rules.back() };
+  return RuleHandle { *this, RuleKind::NonFD, index, _non_fd_rules.generation( index ) };
+}
+
+EventLoop::TimerRule::TimerRule( BasicRule&& base, ClockT::duration s_period )
+  : BasicRule( move( base ) ), period( s_period )
+{}
+
+EventLoop::RuleHandle EventLoop::add_timer( const size_t category_id,
+                                            const chrono::milliseconds delay,
+                                            const CallbackT& callback,
+                                            const bool periodic )
+{
+  if ( category_id >= _rule_categories.size() ) {
+    throw out_of_range( "bad category_id" );
+  }
+
+  if ( periodic and delay <= chrono::milliseconds::zero() ) {
+    throw runtime_error( "EventLoop: periodic timer needs a positive interval" );
+  }
+
+  const uint32_t index
+    = _timer_rules.emplace( BasicRule { category_id, [] { return true; }, callback },
+                            periodic ? ClockT::duration { delay } : ClockT::duration::zero() );
+  _timers.push( { ClockT::now() + delay, _timers_scheduled++, index } );
+
+  return RuleHandle { *this, RuleKind::Timer, index, _timer_rules.generation( index ) };
 }
 
 void EventLoop::RuleHandle::cancel()
 {
-  const shared_ptr<BasicRule> rule_shared_ptr = rule_weak_ptr_.lock();
-  if ( rule_shared_ptr ) {
-    rule_shared_ptr->cancel_requested = true;
+  if ( not loop_alive_.expired() ) {
+    loop_.get().cancel_rule( kind_, index_, generation_ );
   }
 }
 
-// NOLINTBEGIN(*-cognitive-complexity)
-// NOLINTBEGIN(*-signed-bitwise)
-EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
+// Mark a rule to be removed, unless it's already gone (and its slot perhaps reused)
+void EventLoop::cancel_rule( const RuleKind kind, const uint32_t index, const uint32_t generation )
 {
-  // first, handle the non-file-descriptor-related rules
-  {
-    for ( auto it = _non_fd_rules.begin(); it != _non_fd_rules.end(); ) {
-      auto& this_rule = **it;
-      bool rule_fired = false;
+  BasicRule* rule = nullptr;
+  switch ( kind ) {
+    case RuleKind::FD:
+      rule = _fd_rules.get( index, generation );
+      break;
+    case RuleKind::NonFD:
+      rule = _non_fd_rules.get( index, generation );
+      break;
+    case RuleKind::Timer:
+      rule = _timer_rules.get( index, generation );
+      break;
+  }
 
-      if ( this_rule.cancel_requested ) {
-        it = _non_fd_rules.erase( it );
-        continue;
-      }
+  if ( rule ) {
+    rule->cancel_requested = true;
+  }
+}
 
-      uint8_t iterations = 0;
-      while ( this_rule.interest() ) {
-        if ( iterations++ >= 128 ) {
-          throw runtime_error( "EventLoop: busy wait detected: rule \""
-                               + _rule_categories.at( this_rule.category_id ).name + "\" is still interested after "
-                               + to_string( iterations ) + " iterations" );
-        }
+// Call a rule's callback, and count it (and its duration) for the rule's category
+void EventLoop::run_callback( const BasicRule& rule )
+{
+  const auto start = ClockT::now();
+  rule.callback();
+  const auto elapsed = chrono::duration_cast<chrono::nanoseconds>( ClockT::now() - start );
 
-        rule_fired = true;
-        this_rule.callback();
-      }
+  Trace::record<TraceLevel::Debug>( trace_callbacks, rule.category_id, elapsed.count() );
 
-      if ( rule_fired ) {
-        return Result::Success; /* only serve one rule on each iteration */
+  auto& stats = _rule_categories.at( rule.category_id );
+  ++stats.callbacks;
+  stats.callback_time += elapsed;
+  stats.max_callback_time = max( stats.max_callback_time, elapsed );
+}
+
+// Call poll (or epoll_wait), and count the time spent blocked in it
+template<typename WaitT>
+int EventLoop::timed_wait( WaitT&& wait )
+{
+  const auto start = ClockT::now();
+  const int ret = wait();
+  _wait_time += chrono::duration_cast<chrono::nanoseconds>( ClockT::now() - start );
+  ++_waits;
+  return ret;
+}
+
+EventLoop::Stats EventLoop::stats() const
+{
+  return { _rule_categories, _waits, _wait_time };
+}
+
+void EventLoop::reset_stats()
+{
+  for ( auto& category : _rule_categories ) {
+    category = { .name = category.name };
+  }
+  _waits = 0;
+  _wait_time = {};
+}
+
+void EventLoop::dump_stats_every( const chrono::milliseconds interval, StatsCallbackT callback )
+{
+  _stats_interval = interval;
+  _next_stats_dump = ClockT::now() + interval;
+  _stats_callback = callback ? move( callback ) : []( const Stats& stats ) { cerr << stats.to_string(); };
+}
+
+void EventLoop::maybe_dump_stats()
+{
+  if ( _stats_interval <= ClockT::duration::zero() ) {
+    return;
+  }
+
+  const auto now = ClockT::now();
+  if ( now < _next_stats_dump ) {
+    return;
+  }
+
+  _next_stats_dump = now + _stats_interval;
+  _stats_callback( stats() );
+}
+
+string EventLoop::Stats::to_string() const
+{
+  vector<const CategoryStats*> busiest;
+  busiest.reserve( categories.size() );
+  for ( const auto& category : categories ) {
+    busiest.push_back( &category );
+  }
+  ranges::stable_sort( busiest, greater {}, []( const CategoryStats* c ) { return c->callback_time; } );
+
+  const auto ms = []( chrono::nanoseconds t ) { return static_cast<double>( t.count() ) / 1e6; };
+
+  ostringstream out;
+  out << fixed << setprecision( 3 );
+  out << "EventLoop: " << waits << " waits, " << ms( wait_time ) << " ms blocked\n";
+  out << "  " << left << setw( 32 ) << "category" << right << setw( 12 ) << "callbacks" << setw( 12 ) << "spurious"
+      << setw( 14 ) << "total ms" << setw( 12 ) << "max ms" << "\n";
+  for ( const auto* category : busiest ) {
+    out << "  " << left << setw( 32 ) << category->name << right << setw( 12 ) << category->callbacks << setw( 12 )
+        << category->spurious_wakeups << setw( 14 ) << ms( category->callback_time ) << setw( 12 )
+        << ms( category->max_callback_time ) << "\n";
+  }
+  return out.str();
+}
+
+// Cancelled timers stay in the heap (and the timer table) until they reach the top.
+void EventLoop::drop_cancelled_timers()
+{
+  while ( not _timers.empty() and _timer_rules.get( _timers.top().index )->cancel_requested ) {
+    _timer_rules.erase( _timers.top().index );
+    _timers.pop();
+  }
+}
+
+// Shorten the poll timeout (in milliseconds, or -1 to wait forever) so that it ends when the next timer is due.
+int EventLoop::timeout_until_next_timer( const int timeout_ms )
+{
+  drop_cancelled_timers();
+  if ( _timers.empty() ) {
+    return timeout_ms;
+  }
+
+  const auto until_due = chrono::ceil<chrono::milliseconds>( _timers.top().deadline - ClockT::now() );
+  const int timer_ms = static_cast<int>( clamp<chrono::milliseconds::rep>( until_due.count(), 0, INT_MAX ) );
+  return timeout_ms < 0 ? timer_ms : min( timeout_ms, timer_ms );
+}
+
+// Call back each timer that is due, rescheduling the periodic ones. Returns true if any timer fired.
+bool EventLoop::fire_due_timers()
+{
+  drop_cancelled_timers();
+  if ( _timers.empty() ) {
+    return false;
+  }
+
+  const auto now = ClockT::now();
+  const uint64_t sequence_limit = _timers_scheduled; // timers (re)scheduled by these callbacks wait for next time
+  bool fired = false;
+
+  while ( not _timers.empty() and _timers.top().deadline <= now and _timers.top().sequence < sequence_limit ) {
+    TimerEntry entry = _timers.top();
+    _timers.pop();
+    TimerRule& timer = *_timer_rules.get( entry.index );
+    if ( timer.cancel_requested ) {
+      _timer_rules.erase( entry.index );
+      continue;
+    }
+
+    const bool periodic = timer.period > ClockT::duration::zero();
+    if ( periodic ) {
+      // keep to the original schedule, unless the loop has fallen a whole period behind
+      entry.deadline += timer.period;
+      if ( entry.deadline <= now ) {
+        entry.deadline = now + timer.period;
       }
+      entry.sequence = _timers_scheduled++;
+      _timers.push( entry );
+    }
 
-      ++it;
+    fired = true;
+    run_callback( timer );
+
+    if ( not periodic ) {
+      _timer_rules.erase( entry.index );
     }
   }
 
-  // now the file-descriptor-related rules. poll any "interested" file descriptors
-  vector<pollfd> pollfds {};
-  pollfds.reserve( _fd_rules.size() );
+  return fired;
+}
+
+// Remove the fd rules that are finished, and record each remaining rule's interest for this iteration.
+// Returns true if any rule is interested.
+bool EventLoop::prepare_fd_rules()
+{
   bool something_to_poll = false;
 
-  // set up the pollfd for each rule
-  for ( auto it = _fd_rules.begin(); it != _fd_rules.end(); ) { // NOTE: it gets erased or incremented in loop body
-    auto& this_rule = **it;
+  for ( uint32_t index = 0; index < _fd_rules.end_index(); ++index ) {
+    FDRule* rule = _fd_rules.get( index );
+    if ( not rule ) {
+      continue;
+    }
+    auto& this_rule = *rule;
 
     if ( this_rule.cancel_requested ) {
       //      this_rule.cancel();
       //      if rule is cancelled externally, no need to call the cancellation callback
       //      this makes it easier to cancel rules and delete captured objects right away
-      it = _fd_rules.erase( it );
+      remove_fd_rule( index );
       continue;
     }
 
     if ( this_rule.direction == Direction::In && this_rule.fd.eof() ) {
       // no more reading on this rule, it's reached eof
       this_rule.cancel();
-      it = _fd_rules.erase( it );
+      remove_fd_rule( index );
       continue;
     }
 
     if ( this_rule.fd.closed() ) {
       this_rule.cancel();
-      it = _fd_rules.erase( it );
+      remove_fd_rule( index );
       continue;
     }
 
     if ( this_rule.interest() ) {
-      pollfds.push_back( { this_rule.fd.fd_num(),
-                           static_cast<int16_t>( this_rule.direction == Direction::In ? POLLIN : POLLOUT ),
-                           0 } );
+      this_rule.events = static_cast<int16_t>( this_rule.direction == Direction::In ? POLLIN : POLLOUT );
       something_to_poll = true;
     } else {
-      pollfds.push_back( { this_rule.fd.fd_num(), 0, 0 } ); // placeholder --- we still want errors
+      this_rule.events = 0; // placeholder --- we still want errors
+    }
+
+    if ( _backend == Backend::Epoll ) {
+      want_epoll_events( index, this_rule );
     }
-    ++it;
   }
 
-  // quit if there is nothing left to poll
-  if ( not something_to_poll ) {
-    return Result::Exit;
+  return something_to_poll;
+}
+
+// Erase an fd rule. With Backend::Epoll, detach it from its fd's entry (unregistering the fd after its last rule).
+void EventLoop::remove_fd_rule( const uint32_t index )
+{
+  FDRule& rule = *_fd_rules.get( index );
+  if ( rule.in_epoll ) {
+    auto& entry = _epoll_entries.at( rule.fd.fd_num() );
+    erase( entry.rules, index );
+    if ( rule.fd.closed() ) {
+      // the fd has left the epoll set, and its number may already belong to the entry's other rules
+      entry.registered = false;
+    }
+    if ( entry.rules.empty() ) {
+      if ( entry.registered ) {
+        CheckSystemCall( "epoll_ctl", epoll_ctl( _epoll_fd->fd_num(), EPOLL_CTL_DEL, rule.fd.fd_num(), nullptr ) );
+      }
+      entry = { .rules = move( entry.rules ) }; // keep the (empty) vector's capacity for the fd's next rules
+    }
   }
 
-  // call poll -- wait until one of the fds satisfies one of the rules (writeable/readable)
-  if ( 0 == CheckSystemCall( "poll", ::poll( pollfds.data(), pollfds.size(), timeout_ms ) ) ) {
-    return Result::Timeout;
+  _fd_rules.erase( index );
+}
+
+// Add a rule's events to the set wanted for its fd on this iteration (creating the fd's entry if needed)
+void EventLoop::want_epoll_events( const uint32_t index, FDRule& rule )
+{
+  const int fd_num = rule.fd.fd_num();
+  if ( static_cast<size_t>( fd_num ) >= _epoll_entries.size() ) {
+    _epoll_entries.resize( max( static_cast<size_t>( fd_num ) + 1, 2 * _epoll_entries.size() ) );
   }
 
-  // go through the poll results
-  for ( auto [it, idx] = make_pair( _fd_rules.begin(), static_cast<size_t>( 0 ) ); it != _fd_rules.end(); ++idx ) {
-    const auto& this_pollfd = pollfds.at( idx );
-    auto& this_rule = **it;
-
-    const auto poll_error = static_cast<bool>( this_pollfd.revents & ( POLLERR | POLLNVAL ) );
-    if ( poll_error ) {
-      /* see if fd is a socket */
-      int socket_error = 0;
-      socklen_t optlen = sizeof( socket_error );
-      const int ret = getsockopt( this_rule.fd.fd_num(), SOL_SOCKET, SO_ERROR, &socket_error, &optlen );
-      if ( ret == -1 and errno == ENOTSOCK ) {
-        cerr << "error on polled file descriptor for rule \"" << _rule_categories.at( this_rule.category_id ).name
-             << "\"\n";
-      } else if ( ret == -1 ) {
-        throw unix_error( "getsockopt" );
-      } else if ( optlen != sizeof( socket_error ) ) {
-        throw runtime_error( "unexpected length from getsockopt: " + to_string( optlen ) );
-      } else if ( socket_error ) {
-        cerr << "error on polled socket for rule \"" << _rule_categories.at( this_rule.category_id ).name
-             << "\": " << strerror( socket_error ) << "\n";
-      }
+  auto& entry = _epoll_entries[fd_num];
+  if ( not rule.in_epoll ) {
+    rule.in_epoll = true;
+    entry.rules.push_back( index );
+  }
 
-      this_rule.error();
-      this_rule.cancel();
-      it = _fd_rules.erase( it );
+  if ( not entry.pending ) {
+    entry.pending = true;
+    entry.wanted_events = 0;
+    _epoll_pending.push_back( fd_num );
+  }
+  entry.wanted_events |= static_cast<uint16_t>( rule.events );
+}
+
+// Tell the kernel about any fd whose wanted events differ from its registration
+void EventLoop::update_epoll_registrations()
+{
+  _epoll_always_ready.clear();
+
+  for ( const int fd_num : _epoll_pending ) {
+    auto& entry = _epoll_entries[fd_num];
+    entry.pending = false;
+    if ( entry.unpollable ) {
+      if ( entry.wanted_events ) {
+        _epoll_always_ready.push_back( fd_num );
+      }
       continue;
     }
 
-    const auto poll_ready = static_cast<bool>( this_pollfd.revents & this_pollfd.events );
-    const auto poll_hup = static_cast<bool>( this_pollfd.revents & POLLHUP );
-    if ( poll_hup && ( ( this_pollfd.events && !poll_ready ) or ( this_rule.direction == Direction::Out ) ) ) {
-      // if we asked for the status, and the _only_ condition was a hangup, this FD is defunct:
-      //   - if it was POLLIN and nothing is readable, no more will ever be readable
-      //   - if it was POLLOUT, it will not be writable again
-      // additionally, consider FD defunct if rule will only query for Direction::Out
-      this_rule.cancel();
-      it = _fd_rules.erase( it );
+    if ( entry.registered and entry.wanted_events == entry.registered_events ) {
       continue;
     }
 
-    if ( poll_ready ) {
-      // we only want to call callback if revents includes the event we asked for
-      const auto count_before = this_rule.service_count();
-      this_rule.callback();
+    epoll_event event { entry.wanted_events, { .fd = fd_num } };
+    int ret = epoll_ctl( _epoll_fd->fd_num(), entry.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd_num, &event );
+    if ( ret < 0 and errno == EEXIST ) {
+      // a closed fd's registration outlives it if the file is still open elsewhere (e.g. by a dup)
+      ret = epoll_ctl( _epoll_fd->fd_num(), EPOLL_CTL_MOD, fd_num, &event );
+    }
+    if ( ret < 0 ) {
+      if ( errno == EPERM ) {
+        // epoll does not support this kind of fd; poll(2) would always report it ready, so do the same
+        entry.unpollable = true;
+        if ( entry.wanted_events ) {
+          _epoll_always_ready.push_back( fd_num );
+        }
+        continue;
+      }
+      throw unix_error( "epoll_ctl" );
+    }
+    entry.registered = true;
+    entry.registered_events = entry.wanted_events;
+  }
+  _epoll_pending.clear();
+}
+
+// NOLINTBEGIN(*-signed-bitwise)
+EventLoop::RuleOutcome EventLoop::handle_poll_result( FDRule& this_rule, const int16_t revents )
+{
+  const auto poll_error = static_cast<bool>( revents & ( POLLERR | POLLNVAL ) );
+  if ( poll_error ) {
+    /* see if fd is a socket */
+    int socket_error = 0;
+    socklen_t optlen = sizeof( socket_error );
+    const int ret = getsockopt( this_rule.fd.fd_num(), SOL_SOCKET, SO_ERROR, &socket_error, &optlen );
+    if ( ret == -1 and errno == ENOTSOCK ) {
+      cerr << "error on polled file descriptor for rule \"" << _rule_categories.at( this_rule.category_id ).name
+           << "\"\n";
+    } else if ( ret == -1 ) {
+      throw unix_error( "getsockopt" );
+    } else if ( optlen != sizeof( socket_error ) ) {
+      throw runtime_error( "unexpected length from getsockopt: " + to_string( optlen ) );
+    } else if ( socket_error ) {
+      cerr << "error on polled socket for rule \"" << _rule_categories.at( this_rule.category_id ).name
+           << "\": " << strerror( socket_error ) << "\n";
+    }
+
+    _socket_error = ret == 0 ? socket_error : 0;
+    this_rule.error();
+    _socket_error = 0;
+    this_rule.cancel();
+    return RuleOutcome::Defunct;
+  }
+
+  const auto poll_ready = static_cast<bool>( revents & this_rule.events );
+  const auto poll_hup = static_cast<bool>( revents & POLLHUP );
+  if ( poll_hup && ( ( this_rule.events && !poll_ready ) or ( this_rule.direction == Direction::Out ) ) ) {
+    // if we asked for the status, and the _only_ condition was a hangup, this FD is defunct:
+    //   - if it was POLLIN and nothing is readable, no more will ever be readable
+    //   - if it was POLLOUT, it will not be writable again
+    // additionally, consider FD defunct if rule will only query for Direction::Out
+    this_rule.cancel();
+    return RuleOutcome::Defunct;
+  }
+
+  if ( poll_ready ) {
+    // we only want to call callback if revents includes the event we asked for
+    const auto count_before = this_rule.service_count();
+    run_callback( this_rule );
 
-      if ( count_before == this_rule.service_count() and ( not this_rule.fd.closed() ) and this_rule.interest() ) {
+    if ( count_before == this_rule.service_count() ) {
+      // (a rule that cancelled itself isn't waiting any more, whatever its interest says)
+      if ( ( not this_rule.fd.closed() ) and ( not this_rule.cancel_requested ) and this_rule.interest() ) {
         throw runtime_error( "EventLoop: busy wait detected: rule \""
                              + _rule_categories.at( this_rule.category_id ).name
                              + "\" did not read/write fd and is still interested" );
       }
+      ++_rule_categories.at( this_rule.category_id ).spurious_wakeups;
+    }
+
+    return RuleOutcome::Serviced;
+  }
+
+  return RuleOutcome::Idle;
+}
+// NOLINTEND(*-signed-bitwise)
 
-      return Result::Success; /* only serve one rule on each iteration */
+EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
+{
+  maybe_dump_stats();
+
+  // first, handle the non-file-descriptor-related rules
+  {
+    for ( uint32_t index = 0; index < _non_fd_rules.end_index(); ++index ) {
+      BasicRule* rule = _non_fd_rules.get( index );
+      if ( not rule ) {
+        continue;
+      }
+      auto& this_rule = *rule;
+      bool rule_fired = false;
+
+      if ( this_rule.cancel_requested ) {
+        _non_fd_rules.erase( index );
+        continue;
+      }
+
+      uint8_t iterations = 0;
+      while ( this_rule.interest() ) {
+        if ( iterations++ >= 128 ) {
+          throw runtime_error( "EventLoop: busy wait detected: rule \""
+                               + _rule_categories.at( this_rule.category_id ).name + "\" is still interested after "
+                               + to_string( iterations ) + " iterations" );
+        }
+
+        rule_fired = true;
+        run_callback( this_rule );
+      }
+
+      if ( rule_fired ) {
+        return Result::Success; /* only serve one rule on each iteration */
+      }
     }
+  }
 
-    ++it; // if we got here, it means we didn't call _fd_rules.erase()
+  // next, any timers that are due
+  if ( fire_due_timers() ) {
+    return Result::Success;
+  }
+
+  // now the file-descriptor-related rules, waiting no longer than until the next timer is due
+  const int wait_ms = timeout_until_next_timer( timeout_ms );
+  const Result result = _backend == Backend::Epoll ? wait_epoll( wait_ms ) : wait_poll( wait_ms );
+
+  if ( result == Result::Timeout and fire_due_timers() ) {
+    return Result::Success;
+  }
+
+  return result;
+}
+
+EventLoop::Result EventLoop::wait_poll( const int timeout_ms )
+{
+  // quit if there is nothing left to poll, and no timer left to wait for
+  if ( not prepare_fd_rules() and _timers.empty() ) {
+    return Result::Exit;
+  }
+
+  // set up the pollfd for each rule (reusing last iteration's vectors)
+  _pollfds.clear();
+  _pollfd_rules.clear();
+  for ( uint32_t index = 0; index < _fd_rules.end_index(); ++index ) {
+    if ( const FDRule* rule = _fd_rules.get( index ) ) {
+      _pollfds.push_back( { rule->fd.fd_num(), rule->events, 0 } );
+      _pollfd_rules.push_back( index );
+    }
+  }
+
+  // call poll -- wait until one of the fds satisfies one of the rules (writeable/readable)
+  const int ready_count = timed_wait(
+    [&] { return CheckSystemCall( "poll", ::poll( _pollfds.data(), _pollfds.size(), timeout_ms ) ); } );
+  if ( ready_count == 0 ) {
+    return Result::Timeout;
+  }
+
+  // go through the poll results
+  for ( size_t idx = 0; idx < _pollfds.size(); ++idx ) {
+    const uint32_t index = _pollfd_rules[idx];
+    switch ( handle_poll_result( *_fd_rules.get( index ), _pollfds[idx].revents ) ) {
+      case RuleOutcome::Defunct:
+        _fd_rules.erase( index );
+        break;
+      case RuleOutcome::Serviced:
+        return Result::Success; /* only serve one rule on each iteration */
+      case RuleOutcome::Idle:
+        break;
+    }
+  }
+
+  return Result::Success;
+}
+
+EventLoop::Result EventLoop::wait_epoll( const int timeout_ms )
+{
+  // quit if there is nothing left to poll, and no timer left to wait for
+  if ( not prepare_fd_rules() and _timers.empty() ) {
+    return Result::Exit;
+  }
+
+  update_epoll_registrations();
+
+  array<epoll_event, 64> events {};
+  size_t ready_count = 0;
+  for ( const int fd_num : _epoll_always_ready ) {
+    if ( ready_count < events.size() ) {
+      events.at( ready_count++ ) = { _epoll_entries[fd_num].wanted_events, { .fd = fd_num } };
+    }
+  }
+
+  // don't block if an unpollable fd is already ready
+  ready_count += timed_wait( [&] {
+    return CheckSystemCall( "epoll_wait",
+                            epoll_wait( _epoll_fd->fd_num(),
+                                        events.data() + ready_count,
+                                        static_cast<int>( events.size() - ready_count ),
+                                        ready_count ? 0 : timeout_ms ) );
+  } );
+  if ( ready_count == 0 ) {
+    return Result::Timeout;
+  }
+
+  // go through the ready fds, and the rules on each
+  for ( const auto& event : span { events.data(), ready_count } ) {
+    for ( const uint32_t index : _epoll_entries[event.data.fd].rules ) {
+      FDRule* rule = _fd_rules.get( index );
+      if ( rule->cancel_requested ) {
+        continue;
+      }
+
+      switch ( handle_poll_result( *rule, static_cast<int16_t>( event.events ) ) ) {
+        case RuleOutcome::Defunct:
+          // already cancelled; erase it (without cancelling again) on the next iteration
+          rule->cancel_requested = true;
+          break;
+        case RuleOutcome::Serviced:
+          return Result::Success; /* only serve one rule on each iteration */
+        case RuleOutcome::Idle:
+          break;
+      }
+    }
   }
 
   return Result::Success;
 }
-// NOLINTEND(*-signed-bitwise)
-// NOLINTEND(*-cognitive-complexity)
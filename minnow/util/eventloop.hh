@@ -1,11 +1,15 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
-#include <list>
 #include <memory>
+#include <optional>
 #include <poll.h>
+#include <queue>
+#include <vector>
 
 #include "file_descriptor.hh"
+#include "inplace_function.hh"
 
 //! Waits for events on file descriptors and executes corresponding callbacks.
 class EventLoop
@@ -18,15 +22,51 @@ public:
     Out // Callback will be triggered when Rule::fd is writable.
   };
 
-private:
-  using CallbackT = std::function<void( void )>;
-  using InterestT = std::function<bool( void )>;
+  //! Returned by each call to EventLoop::wait_next_event.
+  enum class Result : uint8_t
+  {
+    Success, //!< At least one Rule was triggered.
+    Timeout, //!< No rules were triggered before timeout.
+    Exit     //!< All rules have been canceled or were uninterested; make no further calls to
+             //!< EventLoop::wait_next_event.
+  };
 
-  struct RuleCategory
+  //! The kernel interface used to wait for file descriptors.
+  enum class Backend : uint8_t
+  {
+    Poll, //!< Rebuild the pollfd set and call [poll(2)](\ref man2::poll) on each iteration.
+    Epoll //!< Register each fd once with [epoll(7)](\ref man7::epoll) (level-triggered), and
+          //!< only update the registration when the rules' interest changes.
+  };
+
+  //! Counters for the rules in one category, kept since the loop was constructed (or EventLoop::reset_stats).
+  struct CategoryStats
   {
     std::string name;
+    uint64_t callbacks {};                         //!< Calls to the rules' callbacks
+    uint64_t spurious_wakeups {};                  //!< Calls for a ready fd that neither read nor wrote it
+    std::chrono::nanoseconds callback_time {};     //!< Total time spent in the callbacks
+    std::chrono::nanoseconds max_callback_time {}; //!< Longest single call
   };
 
+  //! A snapshot of the loop's counters.
+  struct Stats
+  {
+    std::vector<CategoryStats> categories; //!< Indexed by category id
+    uint64_t waits;                        //!< Calls to poll (or epoll_wait)
+    std::chrono::nanoseconds wait_time;    //!< Total time blocked in those calls
+
+    //! A table of the counters, one line per category, busiest first
+    std::string to_string() const;
+  };
+
+  using StatsCallbackT = std::function<void( const Stats& )>;
+
+private:
+  using CallbackT = InplaceFunction<void( void )>;
+  using InterestT = InplaceFunction<bool( void )>;
+  using ClockT = std::chrono::steady_clock;
+
   struct BasicRule
   {
     size_t category_id;
@@ -37,12 +77,35 @@ private:
     BasicRule( size_t s_category_id, InterestT s_interest, CallbackT s_callback );
   };
 
+  struct TimerRule : public BasicRule
+  {
+    ClockT::duration period; //!< The interval between calls of a periodic timer, or zero for a one-shot timer
+
+    TimerRule( BasicRule&& base, ClockT::duration s_period );
+  };
+
+  //! A timer's place in the timer heap (each timer has one entry at a time)
+  struct TimerEntry
+  {
+    ClockT::time_point deadline; //!< When the callback is next due
+    uint64_t sequence;           //!< Order of scheduling, so that timers with the same deadline fire in order
+    uint32_t index;              //!< The timer's index in EventLoop::_timer_rules
+
+    //! Orders the heap so that the earliest deadline is on top
+    bool operator>( const TimerEntry& other ) const
+    {
+      return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+    }
+  };
+
   struct FDRule : public BasicRule
   {
     FileDescriptor fd;   //!< FileDescriptor to monitor for activity.
     Direction direction; //!< Direction::In for reading from fd, Direction::Out for writing to fd.
     CallbackT cancel;    //!< A callback that is called when the rule is cancelled (e.g. on EOF or hangup)
     CallbackT error;     //!< A callback that is called when the fd has an error before cancellation
+    int16_t events {};   //!< The events polled for on this iteration (POLLIN, POLLOUT, or 0 if uninterested)
+    bool in_epoll {};    //!< With Backend::Epoll, is the rule listed in its fd's EpollEntry?
 
     FDRule( BasicRule&& base, FileDescriptor&& s_fd, Direction s_direction, CallbackT s_cancel, CallbackT s_error );
 
@@ -51,31 +114,168 @@ private:
     unsigned int service_count() const;
   };
 
-  std::vector<RuleCategory> _rule_categories {};
-  std::list<std::shared_ptr<FDRule>> _fd_rules {};
-  std::list<std::shared_ptr<BasicRule>> _non_fd_rules {};
+  //! A slab of rules, allocated a chunk at a time and reused through a free list.
+  //! A rule keeps its index (and address) for as long as it lives. Removing it bumps its slot's generation,
+  //! so a RuleHandle to it can't reach whichever rule reuses the slot.
+  template<class RuleT>
+  class RuleTable
+  {
+    static constexpr uint32_t chunk_size = 32;
+
+    struct Slot
+    {
+      std::optional<RuleT> rule {};
+      uint32_t generation {};
+    };
 
-public:
-  EventLoop() { _rule_categories.reserve( 64 ); }
+    std::vector<std::unique_ptr<Slot[]>> chunks_ {}; // NOLINT(*-avoid-c-arrays)
+    std::vector<uint32_t> free_ {};
+    uint32_t end_index_ {};
+    size_t size_ {};
 
-  //! Returned by each call to EventLoop::wait_next_event.
-  enum class Result : uint8_t
+    Slot& slot( uint32_t index ) { return chunks_[index / chunk_size][index % chunk_size]; }
+    const Slot& slot( uint32_t index ) const { return chunks_[index / chunk_size][index % chunk_size]; }
+
+  public:
+    //! Constructs a rule in a free slot, and returns its index
+    template<typename... Targs>
+    uint32_t emplace( Targs&&... args )
+    {
+      uint32_t index = end_index_;
+      if ( free_.empty() ) {
+        if ( end_index_ % chunk_size == 0 ) {
+          chunks_.push_back( std::make_unique<Slot[]>( chunk_size ) ); // NOLINT(*-avoid-c-arrays)
+        }
+        ++end_index_;
+      } else {
+        index = free_.back();
+        free_.pop_back();
+      }
+
+      slot( index ).rule.emplace( std::forward<Targs>( args )... );
+      ++size_;
+      return index;
+    }
+
+    void erase( uint32_t index )
+    {
+      auto& s = slot( index );
+      s.rule.reset();
+      ++s.generation;
+      free_.push_back( index );
+      --size_;
+    }
+
+    //! The rule at `index`, or nullptr if the slot is free
+    RuleT* get( uint32_t index ) { return slot( index ).rule ? &*slot( index ).rule : nullptr; }
+
+    //! The rule at `index`, or nullptr if it has been removed since the slot had this `generation`
+    RuleT* get( uint32_t index, uint32_t generation )
+    {
+      return index < end_index_ and slot( index ).generation == generation ? get( index ) : nullptr;
+    }
+
+    uint32_t generation( uint32_t index ) const { return slot( index ).generation; }
+    uint32_t end_index() const { return end_index_; } //!< Every index in use is less than this
+    size_t size() const { return size_; }
+  };
+
+  //! With Backend::Epoll, the kernel registration shared by all rules on one fd (indexed by fd number).
+  struct EpollEntry
   {
-    Success, //!< At least one Rule was triggered.
-    Timeout, //!< No rules were triggered before timeout.
-    Exit     //!< All rules have been canceled or were uninterested; make no further calls to
-             //!< EventLoop::wait_next_event.
+    bool registered {};             //!< Has the fd been added to the epoll set?
+    bool unpollable {};             //!< Did epoll refuse the fd (e.g. a regular file, which is always ready)?
+    bool pending {};                //!< Is the entry in _epoll_pending?
+    uint32_t registered_events {};  //!< The events the fd is currently registered for
+    uint32_t wanted_events {};      //!< The union of its rules' events on this iteration
+    std::vector<uint32_t> rules {}; //!< The indices of the rules on this fd
+  };
+
+  enum class RuleKind : uint8_t
+  {
+    FD,
+    NonFD,
+    Timer,
+  };
+
+  Backend _backend;
+  std::shared_ptr<const bool> _alive { std::make_shared<const bool>( true ) }; //!< Watched by each RuleHandle
+  std::vector<CategoryStats> _rule_categories {};
+  RuleTable<FDRule> _fd_rules {};
+  RuleTable<BasicRule> _non_fd_rules {};
+  RuleTable<TimerRule> _timer_rules {};
+  std::priority_queue<TimerEntry, std::vector<TimerEntry>, std::greater<>> _timers {};
+  uint64_t _timers_scheduled {};
+
+  uint64_t _waits {};
+  std::chrono::nanoseconds _wait_time {};
+  ClockT::duration _stats_interval {};
+  ClockT::time_point _next_stats_dump {};
+  StatsCallbackT _stats_callback {};
+  int _socket_error {}; //!< While a rule's error callback runs, the SO_ERROR read for its socket
+
+  std::vector<pollfd> _pollfds {};        //!< With Backend::Poll, the set polled on this iteration
+  std::vector<uint32_t> _pollfd_rules {}; //!< The index of the rule for each entry in _pollfds
+
+  std::optional<FileDescriptor> _epoll_fd {};
+  std::vector<EpollEntry> _epoll_entries {};
+  std::vector<int> _epoll_pending {};      //!< The fds with rules on this iteration
+  std::vector<int> _epoll_always_ready {}; //!< The unpollable fds with interested rules
+
+  //! What happened when a rule's poll result was handled
+  enum class RuleOutcome : uint8_t
+  {
+    Idle,     //!< Nothing to do for this rule
+    Defunct,  //!< The rule was cancelled (after an error or hangup) and should be removed
+    Serviced, //!< The rule's callback was called
   };
 
+  void cancel_rule( RuleKind kind, uint32_t index, uint32_t generation );
+
+  void run_callback( const BasicRule& rule );
+  template<typename WaitT>
+  int timed_wait( WaitT&& wait );
+  void maybe_dump_stats();
+
+  void drop_cancelled_timers();
+  int timeout_until_next_timer( int timeout_ms );
+  bool fire_due_timers();
+
+  bool prepare_fd_rules();
+  void remove_fd_rule( uint32_t index );
+  void want_epoll_events( uint32_t index, FDRule& rule );
+  void update_epoll_registrations();
+  RuleOutcome handle_poll_result( FDRule& rule, int16_t revents );
+
+  Result wait_poll( int timeout_ms );
+  Result wait_epoll( int timeout_ms );
+
+public:
+  explicit EventLoop( Backend backend = Backend::Epoll );
+
+  // Rules (and their RuleHandles) refer to the loop where it is, so it stays put
+  EventLoop( const EventLoop& other ) = delete;
+  EventLoop& operator=( const EventLoop& other ) = delete;
+  ~EventLoop() = default;
+
   size_t add_category( const std::string& name );
 
+  //! The id of the category called `name`, which is added if there isn't one yet (so callers can share it).
+  size_t category( const std::string& name );
+
+  //! Refers to a rule, so that it can be cancelled. It holds a weak reference to its EventLoop's liveness, so
+  //! cancelling a rule whose EventLoop has been destroyed does nothing (as with a rule that is already gone).
   class RuleHandle
   {
-    std::weak_ptr<BasicRule> rule_weak_ptr_;
+    std::reference_wrapper<EventLoop> loop_;
+    std::weak_ptr<const bool> loop_alive_;
+    RuleKind kind_;
+    uint32_t index_;
+    uint32_t generation_;
 
   public:
-    template<class RuleType>
-    explicit RuleHandle( const std::shared_ptr<RuleType> x ) : rule_weak_ptr_( x )
+    RuleHandle( EventLoop& loop, RuleKind kind, uint32_t index, uint32_t generation )
+      : loop_( loop ), loop_alive_( loop._alive ), kind_( kind ), index_( index ), generation_( generation )
     {}
 
     void cancel();
@@ -93,15 +293,45 @@ public:
   RuleHandle
   add_rule( size_t category_id, const CallbackT& callback, const InterestT& interest = [] { return true; } );
 
-  //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
+  //! Adds a timer rule: the callback is called once, `delay` from now, or if `periodic`, every `delay` from now on.
+  RuleHandle add_timer( size_t category_id,
+                        std::chrono::milliseconds delay,
+                        const CallbackT& callback,
+                        bool periodic = false );
+
+  //! Runs any due timers, or else waits for the interested rules' fds (with the loop's Backend)
+  //! and then executes callback for a ready fd.
+  //! \details The wait ends early when the next timer is due (so that it can run on the following call).
   Result wait_next_event( int timeout_ms );
 
+  Backend backend() const { return _backend; }
+
+  //! In an fd rule's error callback: the error (an errno value) that the loop read from the socket's SO_ERROR,
+  //! or 0 if there was none. Reading SO_ERROR clears it, so the callback can't get it from the socket itself.
+  int last_socket_error() const { return _socket_error; }
+
+  //! The counters for each rule category, and for the time spent waiting.
+  Stats stats() const;
+  void reset_stats();
+
+  //! Every `interval`, pass the loop's Stats to `callback` (by default, print them to stderr).
+  //! \details The interval is checked on each call to wait_next_event, so a dump can be late (but never early).
+  //! A zero interval stops the dumps.
+  void dump_stats_every( std::chrono::milliseconds interval, StatsCallbackT callback = {} );
+
   // convenience function to add category and rule at the same time
   template<typename... Targs>
   auto add_rule( const std::string& name, Targs&&... Fargs )
   {
     return add_rule( add_category( name ), std::forward<Targs>( Fargs )... );
   }
+
+  // convenience function to add category and timer at the same time
+  template<typename... Targs>
+  auto add_timer( const std::string& name, Targs&&... Fargs )
+  {
+    return add_timer( add_category( name ), std::forward<Targs>( Fargs )... );
+  }
 };
 
 using Direction = EventLoop::Direction;
@@ -0,0 +1,117 @@
+#include "eventloop_group.hh"
+#include "exception.hh"
+
+#include <exception>
+#include <mutex>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+// The CPUs this process may run on
+vector<int> allowed_cpus()
+{
+  cpu_set_t set;
+  CPU_ZERO( &set );
+  CheckSystemCall( "sched_getaffinity", sched_getaffinity( 0, sizeof( set ), &set ) );
+
+  vector<int> cpus;
+  for ( int cpu = 0; cpu < CPU_SETSIZE; ++cpu ) {
+    if ( CPU_ISSET( cpu, &set ) ) {
+      cpus.push_back( cpu );
+    }
+  }
+  return cpus;
+}
+
+void pin_thread( thread& t, int cpu )
+{
+  cpu_set_t set;
+  CPU_ZERO( &set );
+  CPU_SET( cpu, &set );
+  const int err = pthread_setaffinity_np( t.native_handle(), sizeof( set ), &set );
+  if ( err ) {
+    throw unix_error( "pthread_setaffinity_np", err );
+  }
+}
+} // namespace
+
+EventLoopGroup::EventLoopGroup( const size_t size, const EventLoop::Backend backend )
+{
+  if ( size == 0 ) {
+    throw runtime_error( "EventLoopGroup: needs at least one loop" );
+  }
+
+  _loops.reserve( size );
+  _stop_events.reserve( size ); // the stop rules refer to these
+  for ( size_t i = 0; i < size; ++i ) {
+    auto& loop = *_loops.emplace_back( make_unique<EventLoop>( backend ) );
+    auto& stop_event = _stop_events.emplace_back(
+      CheckSystemCall( "eventfd", eventfd( 0, EFD_CLOEXEC ) ) );
+    stop_event.set_blocking( false );
+
+    // the loop only needs to wake up; run() notices _stopping after each event
+    loop.add_rule( "EventLoopGroup stop", stop_event, Direction::In, [&stop_event] { stop_event.read_eventfd(); } );
+  }
+}
+
+void EventLoopGroup::run( const bool pin_threads )
+{
+  _stopping = false;
+
+  exception_ptr first_exception;
+  mutex exception_mutex;
+  const vector<int> cpus = pin_threads ? allowed_cpus() : vector<int> {};
+
+  const auto record_exception = [&] {
+    {
+      const lock_guard lock { exception_mutex };
+      if ( not first_exception ) {
+        first_exception = current_exception();
+      }
+    }
+    stop();
+  };
+
+  vector<thread> threads;
+  threads.reserve( _loops.size() );
+  try {
+    for ( auto& loop : _loops ) {
+      threads.emplace_back( [&] {
+        try {
+          while ( not _stopping and loop->wait_next_event( -1 ) != EventLoop::Result::Exit ) {}
+        } catch ( ... ) {
+          record_exception();
+        }
+      } );
+
+      if ( not cpus.empty() ) {
+        pin_thread( threads.back(), cpus.at( ( threads.size() - 1 ) % cpus.size() ) );
+      }
+    }
+  } catch ( ... ) {
+    record_exception(); // (failing to start or pin a thread): stop and join the threads already running first
+  }
+
+  for ( auto& t : threads ) {
+    t.join();
+  }
+
+  if ( first_exception ) {
+    rethrow_exception( first_exception );
+  }
+}
+
+void EventLoopGroup::stop()
+{
+  _stopping = true;
+  for ( const auto& stop_event : _stop_events ) {
+    const uint64_t one = 1;
+    // write directly, since FileDescriptor's counters belong to the loop's thread
+    CheckSystemCall( "write", static_cast<int>( ::write( stop_event.fd_num(), &one, sizeof( one ) ) ) );
+  }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "eventloop.hh"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//! Runs several EventLoops, each on its own thread, e.g. one per core with a SO_REUSEPORT listener in each.
+//! \details Each loop stays single-threaded: add rules to a loop before run(), or from that loop's own callbacks.
+//! Objects that a loop's rules refer to (such as its listener) must outlive run().
+class EventLoopGroup
+{
+  std::vector<std::unique_ptr<EventLoop>> _loops {};
+  std::vector<FileDescriptor> _stop_events {}; //!< An eventfd for each loop, to wake it up on stop()
+  std::atomic<bool> _stopping {};
+
+public:
+  explicit EventLoopGroup( size_t size, EventLoop::Backend backend = EventLoop::Backend::Epoll );
+
+  size_t size() const { return _loops.size(); }
+  EventLoop& loop( size_t index ) { return *_loops.at( index ); }
+
+  //! Runs each loop on its own thread (pinned to one of the process's CPUs, if `pin_threads`),
+  //! until stop() is called. If a loop throws (or a thread can't be started or pinned), the others are stopped
+  //! and joined, and then the exception is rethrown.
+  void run( bool pin_threads = true );
+
+  //! Asks every loop to return after its current event. Safe to call from any thread (including a loop's callback).
+  void stop();
+};
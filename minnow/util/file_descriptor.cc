@@ -1,10 +1,17 @@
 #include "file_descriptor.hh"
 
+#include "buffer_pool.hh"
 #include "exception.hh"
 
+#include <algorithm>
+#include <array>
+#include <climits>
 #include <fcntl.h>
 #include <iostream>
+#include <ranges>
 #include <stdexcept>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <unistd.h>
@@ -45,6 +52,14 @@ FileDescriptor::FDWrapper::FDWrapper( int fd ) : fd_( fd )
   non_blocking_ = flags & O_NONBLOCK;                                 // NOLINT(*-bitwise)
 }
 
+// Construct from a file descriptor whose blocking mode is already known (so no fcntl is needed)
+FileDescriptor::FDWrapper::FDWrapper( int fd, bool non_blocking ) : fd_( fd ), non_blocking_( non_blocking )
+{
+  if ( fd < 0 ) {
+    throw runtime_error( "invalid fd number:" + to_string( fd ) );
+  }
+}
+
 void FileDescriptor::FDWrapper::close()
 {
   CheckSystemCall( "close", ::close( fd_ ) );
@@ -67,6 +82,11 @@ FileDescriptor::FDWrapper::~FDWrapper()
 // fd is the file descriptor number returned by [open(2)](\ref man2::open) or similar
 FileDescriptor::FileDescriptor( int fd ) : internal_fd_( make_shared<FDWrapper>( fd ) ) {}
 
+// Construct from a file descriptor whose blocking mode is already known, e.g. one from accept4(SOCK_NONBLOCK)
+FileDescriptor::FileDescriptor( int fd, KnownBlocking state )
+  : internal_fd_( make_shared<FDWrapper>( fd, state.non_blocking ) )
+{}
+
 // Private constructor used by duplicate()
 FileDescriptor::FileDescriptor( shared_ptr<FDWrapper> other_shared_ptr ) : internal_fd_( move( other_shared_ptr ) )
 {}
@@ -81,13 +101,13 @@ FileDescriptor FileDescriptor::duplicate() const
 void FileDescriptor::read( string& buffer )
 {
   if ( buffer.empty() ) {
-    buffer.resize( kReadBufferSize );
+    buffer = BufferPool::take( kReadBufferSize );
   }
 
   const ssize_t bytes_read = ::read( fd_num(), buffer.data(), buffer.size() );
   if ( bytes_read < 0 ) {
     if ( internal_fd_->non_blocking_ and ( errno == EAGAIN or errno == EINPROGRESS ) ) {
-      buffer.clear();
+      BufferPool::trim( buffer, 0 );
       return;
     }
     throw unix_error { "read" };
@@ -103,42 +123,91 @@ void FileDescriptor::read( string& buffer )
     throw runtime_error( "read() read more than requested" );
   }
 
-  buffer.resize( bytes_read );
+  BufferPool::trim( buffer, bytes_read );
 }
 
-void FileDescriptor::read( vector<string>& buffers )
+namespace {
+// The iovecs of one readv() or writev() call live on the stack (more than IOV_MAX would fail with EINVAL)
+using IovecArray = array<iovec, IOV_MAX>;
+
+// Fill `iovecs` with the views in `buffers` (up to IOV_MAX of them), returning the ones filled in
+span<const iovec> to_iovecs( const auto& buffers, IovecArray& iovecs )
 {
-  if ( buffers.empty() ) {
-    return;
+  size_t count = 0;
+  for ( const string_view x : buffers ) {
+    if ( count == iovecs.size() ) {
+      break;
+    }
+    iovecs[count++] = { const_cast<char*>( x.data() ), x.size() }; // NOLINT(*-const-cast)
   }
+  return { iovecs.data(), count };
+}
 
-  buffers.back().clear();
-  buffers.back().resize( kReadBufferSize );
-
-  vector<iovec> iovecs;
-  iovecs.reserve( buffers.size() );
-  size_t total_size = 0;
+size_t total_size( span<const iovec> buffers )
+{
+  size_t total = 0;
   for ( const auto& x : buffers ) {
-    iovecs.push_back( { const_cast<char*>( x.data() ), x.size() } ); // NOLINT(*-const-cast)
-    total_size += x.size();
+    total += x.iov_len;
   }
+  return total;
+}
+} // namespace
 
-  const ssize_t bytes_read = ::readv( fd_num(), iovecs.data(), static_cast<int>( iovecs.size() ) );
+optional<size_t> FileDescriptor::read_vectored( span<const iovec> buffers )
+{
+  buffers = buffers.first( min<size_t>( buffers.size(), IOV_MAX ) );
+
+  const ssize_t bytes_read = ::readv( fd_num(), buffers.data(), static_cast<int>( buffers.size() ) );
   if ( bytes_read < 0 ) {
     if ( internal_fd_->non_blocking_ and ( errno == EAGAIN or errno == EINPROGRESS ) ) {
-      buffers.clear();
-      return;
+      return nullopt;
     }
     throw unix_error { "read" };
   }
 
   register_read();
 
-  if ( bytes_read > static_cast<ssize_t>( total_size ) ) {
+  const size_t requested = total_size( buffers );
+  if ( bytes_read == 0 and requested != 0 ) {
+    internal_fd_->eof_ = true;
+  }
+
+  if ( bytes_read > static_cast<ssize_t>( requested ) ) {
     throw runtime_error( "read() read more than requested" );
   }
 
-  size_t remaining_size = bytes_read;
+  return bytes_read;
+}
+
+size_t FileDescriptor::read( span<iovec> buffers )
+{
+  return read_vectored( buffers ).value_or( 0 );
+}
+
+uint64_t FileDescriptor::read_eventfd()
+{
+  uint64_t count {};
+  iovec buffer { &count, sizeof( count ) };
+  return read( span { &buffer, 1 } ) == sizeof( count ) ? count : 0;
+}
+
+void FileDescriptor::read( vector<string>& buffers )
+{
+  if ( buffers.empty() ) {
+    return;
+  }
+
+  buffers.back().clear();
+  buffers.back().resize( kReadBufferSize );
+
+  IovecArray iovecs; // NOLINT(*-member-init)
+  const auto bytes_read = read_vectored( to_iovecs( buffers, iovecs ) );
+  if ( not bytes_read ) {
+    buffers.clear();
+    return;
+  }
+
+  size_t remaining_size = *bytes_read;
   for ( auto& buf : buffers ) {
     if ( remaining_size >= buf.size() ) {
       remaining_size -= buf.size();
@@ -149,48 +218,136 @@ void FileDescriptor::read( vector<string>& buffers )
   }
 }
 
+size_t FileDescriptor::write_vectored( span<const iovec> buffers )
+{
+  buffers = buffers.first( min<size_t>( buffers.size(), IOV_MAX ) );
+  const size_t requested = total_size( buffers );
+
+  const ssize_t bytes_written
+    = CheckSystemCall( "writev", ::writev( fd_num(), buffers.data(), static_cast<int>( buffers.size() ) ) );
+  register_write();
+
+  if ( bytes_written == 0 and requested != 0 ) {
+    throw runtime_error( "write returned 0 given non-empty input buffer" );
+  }
+
+  if ( bytes_written > static_cast<ssize_t>( requested ) ) {
+    throw runtime_error( "write wrote more than length of input buffer" );
+  }
+
+  return bytes_written;
+}
+
 size_t FileDescriptor::write( string_view buffer )
 {
-  return write( vector<string_view> { buffer } );
+  return write( span { &buffer, 1 } );
 }
 
 size_t FileDescriptor::write( const vector<Ref<string>>& buffers )
 {
-  vector<string_view> views;
-  views.reserve( buffers.size() );
-  for ( const auto& x : buffers ) {
-    views.emplace_back( x.get() );
-  }
-  return write( views );
+  const auto strings = buffers | views::transform( []( const Ref<string>& x ) -> const string& { return x; } );
+  IovecArray iovecs; // NOLINT(*-member-init)
+  return write_vectored( to_iovecs( strings, iovecs ) );
 }
 
 size_t FileDescriptor::write( const vector<string_view>& buffers )
 {
-  vector<iovec> iovecs;
-  iovecs.reserve( buffers.size() );
-  size_t total_size = 0;
-  for ( const auto x : buffers ) {
-    iovecs.push_back( { const_cast<char*>( x.data() ), x.size() } ); // NOLINT(*-const-cast)
-    total_size += x.size();
+  return write( span { buffers } );
+}
+
+size_t FileDescriptor::write( span<const string_view> buffers )
+{
+  IovecArray iovecs; // NOLINT(*-member-init)
+  return write_vectored( to_iovecs( buffers, iovecs ) );
+}
+
+namespace {
+struct stat stat_of( int fd )
+{
+  struct stat info {};
+  CheckSystemCall( "fstat", fstat( fd, &info ) );
+  return info;
+}
+} // namespace
+
+off_t FileDescriptor::size() const
+{
+  return stat_of( fd_num() ).st_size;
+}
+
+bool FileDescriptor::is_regular_file() const
+{
+  return S_ISREG( stat_of( fd_num() ).st_mode ); // NOLINT(*-signed-bitwise)
+}
+
+bool FileDescriptor::is_pipe() const
+{
+  return S_ISFIFO( stat_of( fd_num() ).st_mode ); // NOLINT(*-signed-bitwise)
+}
+
+// Account for an in-kernel transfer of `moved` bytes (or -1) from this fd to `out`
+size_t FileDescriptor::finish_transfer( string_view s_attempt, FileDescriptor& out, size_t len, ssize_t moved )
+{
+  if ( moved < 0 ) {
+    if ( errno == EAGAIN ) { // one side (a non-blocking fd, or a pipe with SPLICE_F_NONBLOCK) would block
+      return 0;
+    }
+    throw unix_error { s_attempt };
   }
 
-  const ssize_t bytes_written
-    = CheckSystemCall( "writev", ::writev( fd_num(), iovecs.data(), static_cast<int>( iovecs.size() ) ) );
-  register_write();
+  register_read();
+  out.register_write();
 
-  if ( bytes_written == 0 and total_size != 0 ) {
-    throw runtime_error( "write returned 0 given non-empty input buffer" );
+  if ( moved == 0 and len != 0 ) {
+    set_eof();
   }
 
-  if ( bytes_written > static_cast<ssize_t>( total_size ) ) {
-    throw runtime_error( "write wrote more than length of input buffer" );
+  if ( moved > static_cast<ssize_t>( len ) ) {
+    throw runtime_error( string( s_attempt ) + " moved more than requested" );
   }
 
-  return bytes_written;
+  return moved;
+}
+
+// len is the most bytes to move; neither fd's position is given, so each uses (and advances) its own file offset
+size_t FileDescriptor::splice( FileDescriptor& out, const size_t len )
+{
+  const unsigned int flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK; // NOLINT(*-signed-bitwise)
+  const ssize_t moved = ::splice( fd_num(), nullptr, out.fd_num(), nullptr, len, flags );
+  return finish_transfer( "splice", out, len, moved );
+}
+
+size_t FileDescriptor::send_file( FileDescriptor& out, const size_t len )
+{
+  if ( out.is_regular_file() ) {
+    return finish_transfer(
+      "copy_file_range", out, len, ::copy_file_range( fd_num(), nullptr, out.fd_num(), nullptr, len, 0 ) );
+  }
+  return finish_transfer( "sendfile", out, len, ::sendfile( out.fd_num(), fd_num(), nullptr, len ) );
+}
+
+pair<FileDescriptor, FileDescriptor> FileDescriptor::make_pipe()
+{
+  array<int, 2> fds {};
+  ::CheckSystemCall( "pipe2", ::pipe2( fds.data(), O_CLOEXEC ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+size_t FileDescriptor::set_pipe_size( const size_t size )
+{
+  // NOLINTNEXTLINE(*-vararg)
+  if ( fcntl( fd_num(), F_SETPIPE_SZ, static_cast<int>( min<size_t>( size, INT_MAX ) ) ) < 0 and errno != EPERM ) {
+    throw unix_error { "fcntl(F_SETPIPE_SZ)" };
+  }
+  return CheckSystemCall( "fcntl", fcntl( fd_num(), F_GETPIPE_SZ ) ); // NOLINT(*-vararg)
 }
 
 void FileDescriptor::set_blocking( bool blocking )
 {
+  if ( internal_fd_->non_blocking_ == not blocking ) {
+    return; // already in that mode (as every change of mode goes through here)
+  }
+
   int flags = CheckSystemCall( "fcntl", fcntl( fd_num(), F_GETFL ) ); // NOLINT(*-vararg)
   if ( blocking ) {
     flags ^= ( flags & O_NONBLOCK ); // NOLINT(*-bitwise)
@@ -3,6 +3,11 @@
 #include "ref.hh"
 #include <cstddef>
 #include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <sys/uio.h>
+#include <utility>
 #include <vector>
 
 // FileDescriptor 类：封装 Unix 文件描述符，采用 RAII 设计模式管理资源。
@@ -24,6 +29,8 @@ class FileDescriptor
 
     // 构造函数：以内核返回的文件描述符初始化
     explicit FDWrapper( int fd );
+    // 已知阻塞状态时使用，省去构造时的 fcntl(F_GETFL)
+    FDWrapper( int fd, bool non_blocking );
     // 析构函数：在对象销毁时调用 close() 系统调用关闭文件描述符.
     //用于在对象生命周期结束时关闭文件描述符并释放资源。
     ~FDWrapper();
@@ -62,6 +69,20 @@ protected:
   template<typename T>
   T CheckSystemCall( std::string_view s_attempt, T return_value ) const;
 
+  // 记录一次在内核中从本描述符到 out 的传输（splice、sendfile 等），返回传输的字节数
+  size_t finish_transfer( std::string_view s_attempt, FileDescriptor& out, size_t len, ssize_t moved );
+
+  // 用 readv(2) / writev(2) 处理最多 IOV_MAX 个缓冲区（多出的被忽略）；读取时若非阻塞描述符会阻塞，则返回 nullopt
+  std::optional<size_t> read_vectored( std::span<const iovec> buffers );
+  size_t write_vectored( std::span<const iovec> buffers );
+
+  // 已知描述符阻塞状态时的构造函数（例如 accept4(2) 以 SOCK_NONBLOCK 返回的描述符），省去 fcntl(F_GETFL)
+  struct KnownBlocking
+  {
+    bool non_blocking;
+  };
+  FileDescriptor( int fd, KnownBlocking state );
+
 public:
   // 构造函数：使用内核返回的文件描述符创建对象，内部封装在 shared_ptr 中
   explicit FileDescriptor( int fd );
@@ -73,11 +94,17 @@ public:
   void read( std::string& buffer );
   // 从文件描述符读取数据块，存储到 std::vector<std::string> 中
   void read( std::vector<std::string>& buffers );
+  // 直接读入调用者提供的内存（一次 readv，不分配），返回读取的字节数：若会阻塞或已到达 EOF（此时设置 eof）则返回 0
+  size_t read( std::span<iovec> buffers );
+  // 读取 eventfd 的计数（读入一个 uint64_t，不占用读缓冲区），返回该计数：若会阻塞则返回 0
+  uint64_t read_eventfd();
 
   // 将数据写入文件描述符，返回实际写入的字节数
   size_t write( std::string_view buffer );
   // 写入多个数据块（std::string_view 类型），返回总写入字节数
   size_t write( const std::vector<std::string_view>& buffers );
+  // 同上，但 iovec 数组放在栈上，写入时不分配内存（一次最多写 IOV_MAX 个数据块）
+  size_t write( std::span<const std::string_view> buffers );
   // 写入多个引用包装（Ref<std::string>）的数据，返回写入的字节数
   size_t write( const std::vector<Ref<std::string>>& buffers );
 
@@ -87,16 +114,35 @@ public:
   // 显式复制 file descriptor，增加内部 FDWrapper 引用计数
   FileDescriptor duplicate() const;
 
-  // 设置文件描述符的阻塞或非阻塞状态，参数 true 表示阻塞模式
+  // 设置文件描述符的阻塞或非阻塞状态，参数 true 表示阻塞模式（已处于该模式时不调用 fcntl）
   void set_blocking( bool blocking );
 
   // 获取文件大小，通常通过 fstat 系统调用得到
   off_t size() const;
 
+  // 检查文件描述符的类型（同样通过 fstat 系统调用）
+  bool is_regular_file() const;
+  bool is_pipe() const;
+
+  // 使用 splice(2) 在内核中把最多 len 字节从本描述符移到 out（两者至少有一个是管道），数据不经过用户空间。
+  // 返回移动的字节数：若会阻塞则返回 0；若本描述符已到达 EOF，也返回 0 并设置 eof。
+  size_t splice( FileDescriptor& out, size_t len );
+
+  // 从本常规文件的当前偏移处复制最多 len 字节到 out：out 也是常规文件时用 copy_file_range(2)，否则用 sendfile(2)。
+  // 返回值的约定与 splice() 相同。
+  size_t send_file( FileDescriptor& out, size_t len );
+
+  // 创建一个管道，返回 { 读端, 写端 }
+  static std::pair<FileDescriptor, FileDescriptor> make_pipe();
+
+  // 调整管道的缓冲区大小（F_SETPIPE_SZ），返回实际大小（超出系统限制时保持原大小）
+  size_t set_pipe_size( size_t size );
+
   // 以下是访问封装的底层状态信息接口
   int fd_num() const { return internal_fd_->fd_; }                        // 获取实际文件描述符编号
   bool eof() const { return internal_fd_->eof_; }                           // 检查是否到达 EOF
   bool closed() const { return internal_fd_->closed_; }                     // 检查是否已关闭
+  bool non_blocking() const { return internal_fd_->non_blocking_; }         // 检查是否为非阻塞模式
   unsigned int read_count() const { return internal_fd_->read_count_; }      // 获取读取操作计数
   unsigned int write_count() const { return internal_fd_->write_count_; }    // 获取写入操作计数
 
@@ -2,22 +2,57 @@
 
 #include "parser.hh"
 #include "ref.hh"
+#include "slice.hh"
 
 #include <numeric>
 #include <ranges>
+#include <span>
 #include <string>
 #include <vector>
 
+// Number of bytes an object serializes to (found by serializing it with a Serializer that only counts)
+template<class T>
+uint64_t serialized_length( const T& obj )
+{
+  Serializer s { Serializer::CountOnly {} };
+  obj.serialize( s );
+  return s.length();
+}
+
+// How many bytes to reserve for what serializing `obj` copies (its integers, as opposed to the buffers that are
+// kept as segments): the type's own copied_length() if it has one (as the headers do), or else a bound that covers
+// the headers here (past which the Serializer's string just grows).
+template<class T>
+uint64_t copied_length_hint( const T& obj )
+{
+  if constexpr ( requires { obj.copied_length(); } ) {
+    return obj.copied_length();
+  } else {
+    return 64;
+  }
+}
+
 // Helper to serialize any object (without constructing a Serializer of the caller's own)
 // example: ```ethernet_frame.payload = serialize( internet_datagram );```
+// The bytes that are copied (rather than kept as segments) are reserved for once, given copied_length_hint().
 template<class T>
-std::vector<Ref<std::string>> serialize( const T& obj )
+std::vector<Slice> serialize( const T& obj )
 {
-  Serializer s;
+  Serializer s { copied_length_hint( obj ) };
   obj.serialize( s );
   return s.finish();
 }
 
+// Serialize an object into caller-provided memory (which must be large enough; see serialized_length).
+// Returns the number of bytes written.
+template<class T>
+uint64_t serialize_into( const T& obj, std::span<char> out )
+{
+  Serializer s { out };
+  obj.serialize( s );
+  return s.length();
+}
+
 // Helper to parse any object (without constructing a Parser of the caller's own). Returns true if successful.
 // example:
 //   ```
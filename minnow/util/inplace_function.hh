@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/*
+ * An InplaceFunction<R( Args... ), Capacity> holds a copyable callable, like std::function,
+ * but always stores it inline in `Capacity` bytes, so constructing or copying one never allocates.
+ * A callable that doesn't fit (e.g. a lambda with too many captures) is rejected at compile time.
+ */
+template<typename Signature, size_t Capacity = 64>
+class InplaceFunction;
+
+template<typename R, typename... Args, size_t Capacity>
+class InplaceFunction<R( Args... ), Capacity>
+{
+  // The operations on the type-erased callable
+  struct Ops
+  {
+    R ( *invoke )( void* obj, Args&&... args );
+    void ( *copy )( void* dst, const void* src );
+    void ( *move )( void* dst, void* src );
+    void ( *destroy )( void* obj );
+  };
+
+  template<typename F>
+  static constexpr Ops ops_for {
+    []( void* obj, Args&&... args ) -> R {
+      return std::invoke( *static_cast<F*>( obj ), std::forward<Args>( args )... );
+    },
+    []( void* dst, const void* src ) { new ( dst ) F( *static_cast<const F*>( src ) ); },
+    []( void* dst, void* src ) { new ( dst ) F( std::move( *static_cast<F*>( src ) ) ); },
+    []( void* obj ) { static_cast<F*>( obj )->~F(); } };
+
+  alignas( std::max_align_t ) mutable std::array<std::byte, Capacity> storage_ {};
+  const Ops* ops_ {};
+
+  void reset()
+  {
+    if ( ops_ ) {
+      ops_->destroy( storage_.data() );
+      ops_ = nullptr;
+    }
+  }
+
+  void copy_from( const InplaceFunction& other )
+  {
+    if ( other.ops_ ) {
+      other.ops_->copy( storage_.data(), other.storage_.data() );
+      ops_ = other.ops_;
+    }
+  }
+
+  void move_from( InplaceFunction& other )
+  {
+    if ( other.ops_ ) {
+      other.ops_->move( storage_.data(), other.storage_.data() );
+      ops_ = other.ops_;
+      other.reset();
+    }
+  }
+
+public:
+  InplaceFunction() = default;
+
+  // construct from any callable with a compatible signature (implicitly, as with std::function)
+  template<typename F>
+    requires( not std::same_as<std::decay_t<F>, InplaceFunction>
+              and std::is_invocable_r_v<R, std::decay_t<F>&, Args...> )
+  InplaceFunction( F&& f ) // NOLINT(*-explicit-*)
+  {
+    using Stored = std::decay_t<F>;
+    static_assert( sizeof( Stored ) <= Capacity, "callable is too large for InplaceFunction (capture less)" );
+    static_assert( alignof( Stored ) <= alignof( std::max_align_t ), "callable is over-aligned" );
+    static_assert( std::is_copy_constructible_v<Stored>, "InplaceFunction needs a copyable callable" );
+
+    new ( storage_.data() ) Stored( std::forward<F>( f ) );
+    ops_ = &ops_for<Stored>;
+  }
+
+  InplaceFunction( const InplaceFunction& other ) : InplaceFunction() { copy_from( other ); }
+
+  // moving moves the callable (it lives inline either way), and leaves the original empty
+  InplaceFunction( InplaceFunction&& other ) : InplaceFunction() // NOLINT(*-noexcept-*)
+  {
+    move_from( other );
+  }
+
+  InplaceFunction& operator=( const InplaceFunction& other )
+  {
+    if ( this != &other ) {
+      reset();
+      copy_from( other );
+    }
+    return *this;
+  }
+
+  InplaceFunction& operator=( InplaceFunction&& other ) // NOLINT(*-noexcept-*)
+  {
+    if ( this != &other ) {
+      reset();
+      move_from( other );
+    }
+    return *this;
+  }
+
+  ~InplaceFunction() { reset(); }
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  R operator()( Args... args ) const
+  {
+    if ( not ops_ ) {
+      throw std::bad_function_call();
+    }
+    return ops_->invoke( storage_.data(), std::forward<Args>( args )... );
+  }
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "ipv4_header.hh"
+#include "parser.hh"
+#include "slice.hh"
+
+#include <vector>
+
+// An IPv4 datagram: a header and a payload, which parses and serializes as views of the same bytes
+struct IPv4Datagram
+{
+  IPv4Header header {};
+  std::vector<Slice> payload {};
+
+  void parse( Parser& parser )
+  {
+    header.parse( parser );
+    if ( parser.has_error() ) {
+      return;
+    }
+    parser.truncate( header.payload_length() ); // drop any link-layer padding
+    parser.all_remaining( payload );
+  }
+
+  void serialize( Serializer& serializer ) const
+  {
+    header.serialize( serializer );
+    serializer.buffer( payload );
+  }
+
+  // Bytes that serialize() copies: the header's (the payload is kept as segments)
+  static constexpr uint64_t copied_length() { return IPv4Header::copied_length(); }
+};
+
+using InternetDatagram = IPv4Datagram;
@@ -0,0 +1,121 @@
+#include "ipv4_header.hh"
+#include "address.hh"
+#include "checksum.hh"
+
+#include <array>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+uint16_t IPv4Header::payload_length() const
+{
+  return len - 4 * hlen;
+}
+
+uint32_t IPv4Header::pseudo_checksum() const
+{
+  uint32_t pcksum = ( src >> 16 ) + ( src & 0xffff );
+  pcksum += ( dst >> 16 ) + ( dst & 0xffff );
+  pcksum += proto;
+  pcksum += payload_length();
+  return pcksum;
+}
+
+void IPv4Header::decrement_ttl()
+{
+  // The TTL shares its 16-bit word with the protocol
+  const auto old_word = static_cast<uint16_t>( ( ttl << 8 ) | proto );
+  --ttl;
+  const auto new_word = static_cast<uint16_t>( ( ttl << 8 ) | proto );
+  cksum = InternetChecksum::update( cksum, old_word, new_word );
+}
+
+void IPv4Header::compute_checksum()
+{
+  cksum = 0;
+  array<char, LENGTH> bytes {};
+  Serializer s { bytes };
+  serialize( s );
+
+  InternetChecksum check;
+  check.add( { bytes.data(), bytes.size() } );
+  cksum = check.value();
+}
+
+string IPv4Header::to_string() const
+{
+  stringstream ss {};
+  ss << hex << boolalpha << "IPv" << +ver << ", "
+     << "len=" << +len << ", "
+     << "protocol=" << +proto << ", " << ( ttl >= 10 ? "" : "ttl=" + ::to_string( ttl ) + ", " )
+     << "src=" << Address::from_ipv4_numeric( src ).ip() << ", "
+     << "dst=" << Address::from_ipv4_numeric( dst ).ip();
+  return ss.str();
+}
+
+void IPv4Header::parse( Parser& parser )
+{
+  uint8_t first_byte {};
+  uint16_t fo_val {};
+  parser.integers( first_byte, tos, len, id, fo_val, ttl, proto, cksum, src, dst );
+
+  ver = first_byte >> 4;
+  hlen = first_byte & 0x0f;
+  df = static_cast<bool>( fo_val & 0x4000 );
+  mf = static_cast<bool>( fo_val & 0x2000 );
+  offset = fo_val & 0x1fff;
+
+  if ( parser.has_error() or ver != 4 or hlen < LENGTH / 4 or 4 * hlen > len ) {
+    parser.set_error();
+    return;
+  }
+
+  // The checksum covers any options too, so they are read (into the stack) rather than skipped.
+  array<char, 4 * 0xf - LENGTH> options {};
+  const span<char> options_read { options.data(), 4 * hlen - LENGTH };
+  parser.string( options_read );
+  if ( parser.has_error() ) {
+    return;
+  }
+
+  // A header with a correct checksum sums (with its checksum field) to zero.
+  array<char, LENGTH> fields {};
+  Serializer fields_out { fields };
+  serialize( fields_out );
+  InternetChecksum check;
+  check.add( { fields.data(), fields.size() } );
+  check.add( { options_read.data(), options_read.size() } );
+  if ( check.value() != 0 ) {
+    parser.set_error();
+    return;
+  }
+
+  if ( not options_read.empty() ) {
+    len = static_cast<uint16_t>( len - options_read.size() );
+    hlen = LENGTH / 4;
+    compute_checksum();
+  }
+}
+
+void IPv4Header::serialize( Serializer& serializer ) const
+{
+  // consistency checks
+  if ( ver != 4 ) {
+    throw runtime_error( "wrong IP version" );
+  }
+
+  const uint8_t first_byte = ( static_cast<uint32_t>( ver ) << 4 ) | ( hlen & 0xfU );
+  const uint16_t fo_val = ( df ? 0x4000U : 0 ) | ( mf ? 0x2000U : 0 ) | ( offset & 0x1fffU );
+  serializer.integer( first_byte );
+  serializer.integer( tos );
+  serializer.integer( len );
+  serializer.integer( id );
+  serializer.integer( fo_val );
+  serializer.integer( ttl );
+  serializer.integer( proto );
+  serializer.integer( cksum );
+  serializer.integer( src );
+  serializer.integer( dst );
+}
@@ -0,0 +1,119 @@
+#include "mapped_file.hh"
+
+#include "exception.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+using namespace std;
+
+MappedFile::MappedFile( const FileDescriptor& file ) : MappedFile( file, file.size(), false ) {}
+
+MappedFile::MappedFile( FileDescriptor& file, size_t size ) : MappedFile( file, size, true ) {}
+
+MappedFile::MappedFile( const FileDescriptor& file, size_t size, bool writable )
+  : data_( nullptr ), size_( size ), writable_( writable )
+{
+  if ( not file.is_regular_file() ) {
+    throw runtime_error( "MappedFile: only a regular file can be mapped" );
+  }
+
+  if ( writable_ ) {
+    CheckSystemCall( "ftruncate", ::ftruncate( file.fd_num(), static_cast<off_t>( size_ ) ) );
+  }
+
+  if ( size_ == 0 ) {
+    return; // mmap() can't map zero bytes, and there is nothing to map
+  }
+
+  const int protection = writable_ ? PROT_READ | PROT_WRITE : PROT_READ; // NOLINT(*-signed-bitwise)
+  void* const mapping = ::mmap( nullptr, size_, protection, MAP_SHARED, file.fd_num(), 0 );
+  if ( mapping == MAP_FAILED ) { // NOLINT(*-cstyle-cast, *-int-to-ptr)
+    throw unix_error { "mmap" };
+  }
+  data_ = static_cast<char*>( mapping );
+}
+
+span<char> MappedFile::mutable_data()
+{
+  if ( not writable_ ) {
+    throw runtime_error( "MappedFile: mapping is read-only" );
+  }
+  return { data_, size_ };
+}
+
+Slice MappedFile::borrow( size_t pos, size_t len ) const
+{
+  if ( pos > size_ ) {
+    throw out_of_range( "MappedFile::borrow(): position is past the end of the file" );
+  }
+  return Slice::borrow( view().substr( pos, len ) );
+}
+
+// madvise() needs a page-aligned start, so the range is widened to the pages that hold [pos, pos + len)
+void MappedFile::advise( string_view s_attempt, size_t pos, size_t len, int advice ) const
+{
+  pos = min( pos, size_ );
+  len = min( len, size_ - pos );
+  if ( len == 0 ) {
+    return;
+  }
+
+  static const size_t page_size = ::sysconf( _SC_PAGESIZE );
+  const size_t start = pos - pos % page_size;
+  CheckSystemCall( s_attempt, ::madvise( data_ + start, pos + len - start, advice ) );
+}
+
+void MappedFile::advise_sequential() const
+{
+  advise( "madvise(MADV_SEQUENTIAL)", 0, size_, MADV_SEQUENTIAL );
+}
+
+void MappedFile::will_need( size_t pos, size_t len ) const
+{
+  advise( "madvise(MADV_WILLNEED)", pos, len, MADV_WILLNEED );
+}
+
+void MappedFile::dont_need( size_t pos, size_t len ) const
+{
+  advise( "madvise(MADV_DONTNEED)", pos, len, MADV_DONTNEED );
+}
+
+void MappedFile::sync()
+{
+  if ( writable_ and size_ > 0 ) {
+    CheckSystemCall( "msync", ::msync( data_, size_, MS_SYNC ) );
+  }
+}
+
+void MappedFile::unmap()
+{
+  if ( data_ ) {
+    ::munmap( data_, size_ ); // only fails for an invalid range, which a mapping we made can't be
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+MappedFile::~MappedFile()
+{
+  unmap();
+}
+
+MappedFile::MappedFile( MappedFile&& other ) noexcept
+  : data_( exchange( other.data_, nullptr ) ), size_( exchange( other.size_, 0 ) ), writable_( other.writable_ )
+{}
+
+MappedFile& MappedFile::operator=( MappedFile&& other ) noexcept
+{
+  if ( this != &other ) {
+    unmap();
+    data_ = exchange( other.data_, nullptr );
+    size_ = exchange( other.size_, 0 );
+    writable_ = other.writable_;
+  }
+  return *this;
+}
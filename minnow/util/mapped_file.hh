@@ -0,0 +1,61 @@
+#pragma once
+
+#include "file_descriptor.hh"
+#include "slice.hh"
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+/*
+ * A MappedFile is a regular file mapped into memory with mmap(2), so its bytes can be streamed through a
+ * ByteStream as borrowed Slices (a source), or stored straight into the file's pages (a sink), with no read()
+ * or write() copies. The mapping outlives the FileDescriptor it was made from, and is unmapped on destruction.
+ *
+ * Slices borrowed from a MappedFile are only valid while it is alive (and, for a source, while nobody
+ * truncates the file underneath it: touching a page past the end of a truncated file raises SIGBUS).
+ */
+class MappedFile
+{
+public:
+  // Map all of `file` read-only.
+  explicit MappedFile( const FileDescriptor& file );
+
+  // Resize `file` to `size` bytes and map it read-write and shared, so bytes stored in the mapping reach the file.
+  MappedFile( FileDescriptor& file, size_t size );
+
+  size_t size() const { return size_; }
+  bool writable() const { return writable_; }
+
+  std::string_view view() const { return { data_, size_ }; }
+  std::span<char> mutable_data(); // the mapping's bytes (only if writable())
+
+  // The bytes in [pos, pos + len), as a Slice that borrows the mapping
+  Slice borrow( size_t pos, size_t len = std::string_view::npos ) const;
+
+  // Hints to the kernel (madvise(2)): the mapping will be read in order (so read ahead aggressively and drop
+  // pages behind), these bytes will be needed soon (start reading them in now), and these bytes won't be
+  // needed again (drop their pages; a read-only mapping reloads them from the file if they are touched).
+  void advise_sequential() const;
+  void will_need( size_t pos, size_t len ) const;
+  void dont_need( size_t pos, size_t len ) const;
+
+  // Write the mapping's dirty pages back to the file (msync(2)), and wait until they have been written.
+  void sync();
+
+  ~MappedFile();
+  MappedFile( const MappedFile& other ) = delete;
+  MappedFile& operator=( const MappedFile& other ) = delete;
+  MappedFile( MappedFile&& other ) noexcept;
+  MappedFile& operator=( MappedFile&& other ) noexcept;
+
+private:
+  char* data_ {};
+  size_t size_ {};
+  bool writable_ {};
+
+  MappedFile( const FileDescriptor& file, size_t size, bool writable );
+
+  void advise( std::string_view s_attempt, size_t pos, size_t len, int advice ) const;
+  void unmap();
+};
@@ -0,0 +1,147 @@
+#include "parser.hh"
+
+#include <algorithm>
+
+using namespace std;
+
+string_view Parser::BufferList::peek() const
+{
+  if ( head_ == buffer_.size() ) {
+    return {};
+  }
+  return buffer_[head_];
+}
+
+void Parser::BufferList::remove_prefix( uint64_t len )
+{
+  if ( len > size_ ) {
+    throw runtime_error( "Parser::BufferList::remove_prefix: not enough data" );
+  }
+
+  size_ -= len;
+  while ( len > 0 ) {
+    Slice& front = buffer_[head_];
+    if ( len < front.size() ) {
+      front.remove_prefix( len );
+      return;
+    }
+
+    len -= front.size();
+    front = {}; // release the segment's string now, in case this was its last Slice
+    ++head_;
+  }
+}
+
+void Parser::BufferList::truncate( size_t len )
+{
+  if ( len >= size_ ) {
+    return;
+  }
+
+  uint64_t kept = 0;
+  for ( size_t i = head_; i < buffer_.size(); ++i ) {
+    if ( kept + buffer_[i].size() >= len ) {
+      buffer_[i].remove_suffix( kept + buffer_[i].size() - len );
+      buffer_.resize( buffer_[i].empty() ? i : i + 1 );
+      break;
+    }
+    kept += buffer_[i].size();
+  }
+  size_ = len;
+}
+
+void Parser::BufferList::dump_all( vector<Slice>& out )
+{
+  out.assign( make_move_iterator( buffer_.begin() + head_ ), make_move_iterator( buffer_.end() ) );
+  buffer_.clear();
+  head_ = 0;
+  size_ = 0;
+}
+
+void Parser::BufferList::dump_all( vector<Ref<std::string>>& out )
+{
+  out.clear();
+  out.reserve( buffer_segment_count() );
+  for ( auto it = buffer_.begin() + head_; it != buffer_.end(); ++it ) {
+    out.emplace_back( move( *it ).release() );
+  }
+  buffer_.clear();
+  head_ = 0;
+  size_ = 0;
+}
+
+vector<string_view> Parser::BufferList::buffer() const
+{
+  return { slices().begin(), slices().end() };
+}
+
+void Parser::string( span<char> out )
+{
+  check_size( out.size() );
+  if ( has_error() ) {
+    return;
+  }
+
+  auto next = out.begin();
+  while ( next != out.end() ) {
+    const string_view segment = input_.peek().substr( 0, out.end() - next );
+    next = ranges::copy( segment, next ).out;
+    input_.remove_prefix( segment.size() );
+  }
+}
+
+void Parser::concatenate_all_remaining( std::string& out )
+{
+  out.clear();
+  out.reserve( input_.size() );
+  for ( const auto& segment : input_.slices() ) {
+    out.append( segment );
+  }
+  input_.remove_prefix( input_.size() );
+}
+
+void Serializer::flush()
+{
+  if ( not buffer_.empty() ) {
+    output_.emplace_back( move( buffer_ ) );
+    buffer_.clear();
+  }
+}
+
+void Serializer::buffer( Slice buf )
+{
+  if ( mode_ == Mode::Span ) {
+    copy( buf );
+    return;
+  }
+  if ( mode_ == Mode::Count ) {
+    length_ += buf.size();
+    return;
+  }
+
+  flush();
+  length_ += buf.size();
+  if ( not buf.empty() ) {
+    output_.push_back( move( buf ) );
+  }
+}
+
+void Serializer::buffer( const vector<Slice>& bufs )
+{
+  for ( const auto& buf : bufs ) {
+    buffer( buf );
+  }
+}
+
+void Serializer::buffer( const vector<Ref<std::string>>& bufs )
+{
+  for ( const auto& buf : bufs ) {
+    buffer( buf.borrow() );
+  }
+}
+
+vector<Slice> Serializer::finish()
+{
+  flush();
+  return move( output_ );
+}
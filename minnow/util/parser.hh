@@ -1,10 +1,13 @@
 #pragma once
 
 #include "ref.hh"
+#include "slice.hh"
 
+#include <array>
+#include <bit>
 #include <concepts>
 #include <cstdint>
-#include <deque>
+#include <cstring>
 #include <ranges>
 #include <span>
 #include <stdexcept>
@@ -12,36 +15,58 @@
 #include <string_view>
 #include <vector>
 
+// Convert an integer between host byte order and network (big-endian) byte order
+template<std::unsigned_integral T>
+constexpr T network_byte_order( const T value )
+{
+  if constexpr ( sizeof( T ) == 1 or std::endian::native == std::endian::big ) {
+    return value;
+  } else if constexpr ( sizeof( T ) == 2 ) {
+    return __builtin_bswap16( value );
+  } else if constexpr ( sizeof( T ) == 4 ) {
+    return __builtin_bswap32( value );
+  } else {
+    static_assert( sizeof( T ) == 8 );
+    return __builtin_bswap64( value );
+  }
+}
+
 class Parser
 {
+  // The input, as a rope of Slices: consuming or truncating it adjusts views and never copies bytes
   class BufferList
   {
     uint64_t size_ {};
-    std::deque<Ref<std::string>> buffer_ {};
-    uint64_t skip_ {};
+    std::vector<Slice> buffer_ {};
+    size_t head_ {}; // index of the current segment (the ones before it have been consumed)
 
   public:
     explicit BufferList( std::ranges::range auto&& buffers )
-      requires std::is_convertible_v<decltype( std::move( *buffers.begin() ) ), Ref<std::string>>
+      requires std::is_convertible_v<decltype( std::move( *buffers.begin() ) ), Slice>
     {
+      if constexpr ( std::ranges::sized_range<decltype( buffers )> ) {
+        buffer_.reserve( std::ranges::size( buffers ) );
+      }
       for ( auto&& x : buffers ) {
-        buffer_.emplace_back( std::move( x ) );
-        if ( buffer_.back().is_borrowed() ) {
-          throw std::runtime_error( "cannot parse borrowed string" );
+        Slice segment { std::move( x ) };
+        size_ += segment.size();
+        if ( not segment.empty() ) { // so that peek() is never empty while bytes remain
+          buffer_.push_back( std::move( segment ) );
         }
-        size_ += buffer_.back()->size();
       }
     }
 
     uint64_t size() const { return size_; }
     uint64_t serialized_length() const { return size(); }
     bool empty() const { return size_ == 0; }
-    size_t buffer_segment_count() const { return buffer_.size(); }
+    size_t buffer_segment_count() const { return buffer_.size() - head_; }
 
-    std::string_view peek() const;
+    std::string_view peek() const; // the rest of the current segment
     void remove_prefix( uint64_t len );
     void truncate( size_t len );
+    void dump_all( std::vector<Slice>& out );
     void dump_all( std::vector<Ref<std::string>>& out );
+    std::span<const Slice> slices() const { return { buffer_.begin() + head_, buffer_.end() }; }
     std::vector<std::string_view> buffer() const;
   };
 
@@ -56,63 +81,149 @@ class Parser
   }
 
 public:
+  // The input may be any range of Slices, or of anything that converts to one (strings and Refs to strings)
   explicit Parser( std::ranges::range auto&& input ) : input_( std::forward<decltype( input )>( input ) ) {}
+  explicit Parser( Slice input ) : input_( std::array { std::move( input ) } ) {}
 
   bool has_error() const { return error_; }
   void set_error() { error_ = true; }
   void remove_prefix( size_t n ) { input_.remove_prefix( n ); }
   void truncate( size_t len ) { input_.truncate( len ); }
 
+  // The rest of the input, e.g. a payload: as views of the same strings, or (if need be, copied) as strings
+  void all_remaining( std::vector<Slice>& out ) { input_.dump_all( out ); }
   void all_remaining( std::vector<Ref<std::string>>& out ) { input_.dump_all( out ); }
+  std::span<const Slice> slices() const { return input_.slices(); }
   std::vector<std::string_view> buffer() const { return input_.buffer(); }
 
   void string( std::span<char> out );
   void concatenate_all_remaining( std::string& out );
 
+  // Parse a big-endian integer. If the input is too short, `out` is left alone and the parser has an error.
   template<std::unsigned_integral T>
   void integer( T& out )
   {
-    check_size( sizeof( T ) );
+    integers( out );
+  }
+
+  // Parse several big-endian integers in order (e.g. each field of a fixed-size header) with one bounds check:
+  // either all of them are parsed, or (if the input is too short) none are and the parser has an error.
+  template<std::unsigned_integral... Ts>
+  void integers( Ts&... outs )
+  {
+    constexpr size_t total_size = ( sizeof( Ts ) + ... );
+    check_size( total_size );
     if ( has_error() ) {
       return;
     }
 
-    if constexpr ( sizeof( T ) == 1 ) {
-      out = static_cast<uint8_t>( input_.peek().front() );
-      input_.remove_prefix( 1 );
-      return;
+    const std::string_view segment = input_.peek();
+    if ( segment.size() >= total_size ) {
+      // fast path: the integers are all in the current segment, so load each one with a single copy
+      const char* next = segment.data();
+      ( ( outs = load<Ts>( next ), next += sizeof( Ts ) ), ... );
+      input_.remove_prefix( total_size );
     } else {
-      out = static_cast<T>( 0 );
-      for ( size_t i = 0; i < sizeof( T ); i++ ) {
+      ( integer_across_segments( outs ), ... );
+    }
+  }
+
+private:
+  template<std::unsigned_integral T>
+  static T load( const char* bytes )
+  {
+    T value;
+    memcpy( &value, bytes, sizeof( T ) );
+    return network_byte_order( value );
+  }
+
+  // The slow path, for an integer that may straddle a segment boundary (the size has already been checked)
+  template<std::unsigned_integral T>
+  void integer_across_segments( T& out )
+  {
+    out = static_cast<T>( 0 );
+    for ( size_t i = 0; i < sizeof( T ); i++ ) {
+      if constexpr ( sizeof( T ) > 1 ) {
         out <<= 8;
-        out |= static_cast<uint8_t>( input_.peek().front() );
-        input_.remove_prefix( 1 );
       }
+      out |= static_cast<uint8_t>( input_.peek().front() );
+      input_.remove_prefix( 1 );
     }
   }
 };
 
+/*
+ * A Serializer writes big-endian integers and buffers, in one of three ways:
+ *  - into segments (the default): integers are appended to a string (reserved once, given a size hint or a
+ *    reused buffer), and buffers are kept as their own segments (Slices of the same strings) without copying;
+ *  - into a caller-provided span: everything is copied in, and overflowing the span throws;
+ *  - counting only: nothing is written, but length() and copied_length() add up what would be,
+ *    so the exact size is known before allocating (see serialized_length() in helpers.hh).
+ */
 class Serializer
 {
-  std::vector<Ref<std::string>> output_ {};
-  std::string buffer_ {};
+public:
+  struct CountOnly
+  {};
 
-  void flush();
+  Serializer() = default;
+  explicit Serializer( size_t size_hint ) { buffer_.reserve( size_hint ); }
+  explicit Serializer( std::string&& storage ) : buffer_( std::move( storage ) ) { buffer_.clear(); }
+  explicit Serializer( std::span<char> out ) : mode_( Mode::Span ), span_( out ) {}
+  explicit Serializer( CountOnly /* unused */ ) : mode_( Mode::Count ) {}
 
-public:
   template<std::unsigned_integral T>
   void integer( const T val )
   {
-    constexpr uint64_t len = sizeof( T );
-
-    for ( uint64_t i = 0; i < len; ++i ) {
-      const uint8_t byte_val = val >> ( ( len - i - 1 ) * 8 );
-      buffer_.push_back( byte_val );
-    }
+    const T big_endian = network_byte_order( val );
+    copy( { reinterpret_cast<const char*>( &big_endian ), sizeof( T ) } ); // NOLINT(*-reinterpret-cast)
   }
 
-  void buffer( std::string buf );
-  void buffer( Ref<std::string> buf );
+  void buffer( Slice buf );
+  void buffer( std::string buf ) { buffer( Slice { std::move( buf ) } ); }
+  void buffer( Ref<std::string> buf ) { buffer( Slice { std::move( buf ) } ); }
+  void buffer( const std::vector<Slice>& bufs );
   void buffer( const std::vector<Ref<std::string>>& bufs );
-  std::vector<Ref<std::string>> finish();
+
+  uint64_t length() const { return length_; }               // Bytes serialized so far
+  uint64_t copied_length() const { return copied_length_; } // ... of which were copied (not kept as segments)
+
+  // The serialized segments (with a span or counting only, there are none: see length())
+  std::vector<Slice> finish();
+
+private:
+  enum class Mode : uint8_t
+  {
+    Segments,
+    Span,
+    Count,
+  };
+
+  Mode mode_ { Mode::Segments };
+  std::vector<Slice> output_ {};
+  std::string buffer_ {};
+  std::span<char> span_ {};
+  uint64_t length_ {};
+  uint64_t copied_length_ {};
+
+  void flush();
+
+  void copy( std::string_view bytes )
+  {
+    switch ( mode_ ) {
+      case Mode::Segments:
+        buffer_.append( bytes );
+        break;
+      case Mode::Span:
+        if ( bytes.size() > span_.size() - length_ ) {
+          throw std::runtime_error( "Serializer: output span is too small" );
+        }
+        memcpy( span_.data() + length_, bytes.data(), bytes.size() );
+        break;
+      case Mode::Count:
+        break;
+    }
+    length_ += bytes.size();
+    copied_length_ += bytes.size();
+  }
 };
@@ -0,0 +1,173 @@
+#include "resolver.hh"
+#include "exception.hh"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+Resolver::Resolver( EventLoop& loop, chrono::milliseconds ttl, chrono::milliseconds negative_ttl )
+  : _ttl( ttl )
+  , _negative_ttl( negative_ttl )
+  , _answered_event( CheckSystemCall( "eventfd", eventfd( 0, EFD_CLOEXEC ) ) )
+{
+  _answered_event.set_blocking( false );
+  _rule = loop.add_rule(
+    "resolver",
+    _answered_event,
+    EventLoop::Direction::In,
+    [this] { deliver_answered(); },
+    [this] { return not _waiting.empty(); } );
+
+  _worker = thread { [this] { work(); } };
+}
+
+Resolver::~Resolver()
+{
+  {
+    const lock_guard lock { _mutex };
+    _stopping = true;
+  }
+  _wakeup.notify_one();
+  _worker.join(); // (after any lookup it is in the middle of)
+  _rule->cancel();
+}
+
+string Resolver::key_of( const string& hostname, const string& service )
+{
+  return hostname + '\n' + service;
+}
+
+Resolver::Answer Resolver::look_up( const string& hostname, const string& service )
+{
+  Answer answer;
+  try {
+    answer.address.emplace( hostname, service );
+  } catch ( ... ) {
+    answer.error = current_exception();
+  }
+  return answer;
+}
+
+Address Resolver::address_of( const Answer& answer )
+{
+  if ( not answer.address ) {
+    rethrow_exception( answer.error );
+  }
+  return *answer.address;
+}
+
+void Resolver::deliver( const Answer& answer, const Waiter& waiter )
+{
+  if ( answer.address ) {
+    waiter.on_resolved( *answer.address );
+  } else {
+    waiter.on_error( answer.error );
+  }
+}
+
+const Resolver::Answer* Resolver::cached( const string& key )
+{
+  auto it = _cache.find( key );
+  if ( it == _cache.end() ) {
+    return nullptr;
+  }
+  if ( it->second.expires <= ClockT::now() ) {
+    _cache.erase( it );
+    return nullptr;
+  }
+  return &it->second.answer;
+}
+
+void Resolver::store( const string& key, const Answer& answer )
+{
+  _cache.insert_or_assign( key, CacheEntry { answer, ClockT::now() + ( answer.address ? _ttl : _negative_ttl ) } );
+}
+
+Address Resolver::resolve( const string& hostname, const string& service )
+{
+  const string key = key_of( hostname, service );
+  if ( const Answer* answer = cached( key ) ) {
+    return address_of( *answer );
+  }
+
+  ++_lookups;
+  const Answer answer = look_up( hostname, service );
+  store( key, answer );
+  return address_of( answer );
+}
+
+void Resolver::resolve_async( const string& hostname,
+                              const string& service,
+                              ResolvedCallbackT on_resolved,
+                              ErrorCallbackT on_error )
+{
+  string key = key_of( hostname, service );
+  if ( const Answer* answer = cached( key ) ) {
+    deliver( *answer, { move( on_resolved ), move( on_error ) } );
+    return;
+  }
+
+  auto [waiting, first] = _waiting.try_emplace( key );
+  waiting->second.push_back( { move( on_resolved ), move( on_error ) } );
+  if ( not first ) {
+    return; // the worker is already looking up this name
+  }
+
+  ++_lookups;
+  {
+    const lock_guard lock { _mutex };
+    _requests.push_back( { move( key ), hostname, service } );
+  }
+  _wakeup.notify_one();
+}
+
+// The worker thread: look up each requested name, and wake up the loop with the answer
+void Resolver::work()
+{
+  unique_lock lock { _mutex };
+  while ( true ) {
+    _wakeup.wait( lock, [this] { return _stopping or not _requests.empty(); } );
+    if ( _stopping ) {
+      return;
+    }
+
+    Lookup lookup = move( _requests.front() );
+    _requests.pop_front();
+
+    lock.unlock();
+    lookup.answer = look_up( lookup.hostname, lookup.service );
+    lock.lock();
+
+    _answered.push_back( move( lookup ) );
+    const uint64_t one = 1;
+    CheckSystemCall( "write", static_cast<int>( ::write( _answered_event.fd_num(), &one, sizeof( one ) ) ) );
+  }
+}
+
+// Cache the worker's answers, and call back everyone waiting for them
+void Resolver::deliver_answered()
+{
+  _answered_event.read_eventfd();
+
+  vector<Lookup> answered;
+  {
+    const lock_guard lock { _mutex };
+    answered.swap( _answered );
+  }
+
+  for ( const auto& lookup : answered ) {
+    store( lookup.key, lookup.answer );
+
+    auto it = _waiting.find( lookup.key );
+    if ( it == _waiting.end() ) {
+      continue;
+    }
+    const vector<Waiter> waiters = move( it->second );
+    _waiting.erase( it );
+
+    for ( const auto& waiter : waiters ) {
+      deliver( lookup.answer, waiter );
+    }
+  }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "address.hh"
+#include "eventloop.hh"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//! A cache in front of Address( hostname, service ), which calls getaddrinfo(3) on every construction.
+//! \details Successful lookups are kept for `ttl`, and failed ones (with the exception they threw) for
+//! `negative_ttl`. resolve_async() never blocks the loop: a name that isn't cached is looked up on the
+//! resolver's worker thread, and the callbacks run from the EventLoop once the answer arrives. Lookups of
+//! a name that is already being looked up wait for the same answer. A Resolver must be used from its loop's
+//! thread, and destroyed before the loop.
+class Resolver
+{
+public:
+  using ResolvedCallbackT = std::function<void( const Address& address )>;
+  using ErrorCallbackT = std::function<void( std::exception_ptr error )>;
+
+  explicit Resolver( EventLoop& loop,
+                     std::chrono::milliseconds ttl = std::chrono::seconds { 60 },
+                     std::chrono::milliseconds negative_ttl = std::chrono::seconds { 5 } );
+
+  //! Returns the cached answer (or rethrows the cached error), or else looks up the name on this thread.
+  Address resolve( const std::string& hostname, const std::string& service );
+
+  //! Calls `on_resolved` with the answer or `on_error` with the error: right away if it is cached,
+  //! or else from the loop once the worker thread has looked up the name.
+  void resolve_async( const std::string& hostname,
+                      const std::string& service,
+                      ResolvedCallbackT on_resolved,
+                      ErrorCallbackT on_error );
+
+  uint64_t lookups() const { return _lookups; } //!< Number of calls to getaddrinfo (i.e., cache misses)
+
+  Resolver( const Resolver& other ) = delete;
+  Resolver& operator=( const Resolver& other ) = delete;
+  ~Resolver();
+
+private:
+  using ClockT = std::chrono::steady_clock;
+
+  struct Answer
+  {
+    std::optional<Address> address {};
+    std::exception_ptr error {};
+  };
+
+  struct CacheEntry
+  {
+    Answer answer;
+    ClockT::time_point expires;
+  };
+
+  struct Waiter
+  {
+    ResolvedCallbackT on_resolved;
+    ErrorCallbackT on_error;
+  };
+
+  struct Lookup
+  {
+    std::string key;
+    std::string hostname;
+    std::string service;
+    Answer answer {};
+  };
+
+  ClockT::duration _ttl;
+  ClockT::duration _negative_ttl;
+  uint64_t _lookups {};
+  std::unordered_map<std::string, CacheEntry> _cache {};
+  std::unordered_map<std::string, std::vector<Waiter>> _waiting {}; //!< Names that the worker is looking up
+
+  // Shared with the worker thread (under _mutex)
+  std::mutex _mutex {};
+  std::condition_variable _wakeup {};
+  std::deque<Lookup> _requests {};
+  std::vector<Lookup> _answered {};
+  bool _stopping {};
+
+  FileDescriptor _answered_event; //!< An eventfd that the worker writes when it adds to _answered
+  std::optional<EventLoop::RuleHandle> _rule {};
+  std::thread _worker {};
+
+  static std::string key_of( const std::string& hostname, const std::string& service );
+  static Answer look_up( const std::string& hostname, const std::string& service );
+  static Address address_of( const Answer& answer ); //!< The answer's address, or else rethrows its error
+  static void deliver( const Answer& answer, const Waiter& waiter );
+
+  //! The cached answer for `key`, or nullptr if there is none (or it has expired)
+  const Answer* cached( const std::string& key );
+  void store( const std::string& key, const Answer& answer );
+  void work();
+  void deliver_answered();
+};
@@ -0,0 +1,73 @@
+#include "slice.hh"
+
+#include <stdexcept>
+
+using namespace std;
+
+Slice::Slice( string&& data ) : storage_( make_shared<string>( move( data ) ) ), view_( *storage_ ) {}
+
+Slice::Slice( Ref<string>&& data )
+{
+  if ( data.is_borrowed() ) {
+    view_ = data.get();
+  } else {
+    storage_ = make_shared<string>( data.release() );
+    view_ = *storage_;
+  }
+}
+
+Slice Slice::borrow( string_view data )
+{
+  Slice ret;
+  ret.view_ = data;
+  return ret;
+}
+
+Slice Slice::substr( size_t pos, size_t len ) const
+{
+  Slice ret;
+  ret.storage_ = storage_;
+  ret.view_ = view_.substr( pos, len );
+  return ret;
+}
+
+void Slice::remove_prefix( size_t len )
+{
+  if ( len > size() ) {
+    throw out_of_range( "Slice::remove_prefix: not enough data" );
+  }
+  view_.remove_prefix( len );
+}
+
+void Slice::remove_suffix( size_t len )
+{
+  if ( len > size() ) {
+    throw out_of_range( "Slice::remove_suffix: not enough data" );
+  }
+  view_.remove_suffix( len );
+}
+
+Slice Slice::split_prefix( size_t len )
+{
+  Slice prefix = substr( 0, len );
+  remove_prefix( prefix.size() );
+  return prefix;
+}
+
+string Slice::release() &&
+{
+  if ( storage_ == nullptr or storage_.use_count() > 1 ) {
+    string copy { view_ };
+    *this = {};
+    return copy;
+  }
+
+  // this is the only view of the string, so it can be cut down to the view in place
+  string& data = *storage_;
+  const size_t start = view_.data() - data.data();
+  data.resize( start + view_.size() );
+  data.erase( 0, start );
+  string ret = move( data );
+  *this = {};
+  return ret;
+}
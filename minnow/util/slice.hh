@@ -0,0 +1,51 @@
+#pragma once
+
+#include "ref.hh"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+/*
+ * A Slice is a view of (part of) a string that it either shares or borrows.
+ *
+ * A shared Slice holds a reference count on its string, so copying a Slice, or splitting it, or taking a
+ * substr() of it, never copies bytes, and the string lives as long as any Slice of it does. This lets nested
+ * payloads (a TCP segment inside an IP datagram inside an Ethernet frame) be views of the original bytes.
+ *
+ * A borrowed Slice (like a borrowed Ref) refers to a string that someone else keeps alive and unmodified.
+ */
+class Slice
+{
+public:
+  Slice() = default;
+
+  Slice( std::string&& data );      // NOLINT(*-explicit-*) share a string (taking ownership of it)
+  Slice( Ref<std::string>&& data ); // NOLINT(*-explicit-*) an owned Ref is shared, a borrowed one borrowed
+
+  static Slice borrow( std::string_view data );
+
+  std::string_view view() const { return view_; }
+  operator std::string_view() const { return view_; } // NOLINT(*-explicit-*)
+
+  const char* data() const { return view_.data(); }
+  size_t size() const { return view_.size(); }
+  bool empty() const { return view_.empty(); }
+  bool is_borrowed() const { return storage_ == nullptr; }
+
+  // The bytes in [pos, pos + len), sharing this Slice's string
+  Slice substr( size_t pos, size_t len = std::string_view::npos ) const;
+
+  void remove_prefix( size_t len );
+  void remove_suffix( size_t len );
+
+  // Remove the first `len` bytes and return them as their own Slice (of the same string)
+  Slice split_prefix( size_t len );
+
+  // The bytes as a string of their own: moved out if this is the only Slice of its string, otherwise copied
+  std::string release() &&;
+
+private:
+  std::shared_ptr<std::string> storage_ {};
+  std::string_view view_ {};
+};
@@ -2,7 +2,10 @@
 
 #include "exception.hh"
 
+#include <cstring>
 #include <linux/if_packet.h>
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
 #include <stdexcept>
 
 using namespace std;
@@ -90,6 +93,20 @@ void Socket::connect( const Address& address )
   CheckSystemCall( "connect", ::connect( fd_num(), address.raw(), address.size() ) );
 }
 
+// start connecting without waiting for the connection to complete
+//! \returns true if the socket is already connected, or false if the connection is in progress
+//! \note A blocking socket waits for the connection, as with connect(), and so always returns true
+bool Socket::start_connect( const Address& address )
+{
+  if ( ::connect( fd_num(), address.raw(), address.size() ) == 0 ) {
+    return true;
+  }
+  if ( errno != EINPROGRESS ) {
+    throw unix_error { "connect" };
+  }
+  return false;
+}
+
 // shut down a socket in the specified way
 //! \param[in] how can be `SHUT_RD`, `SHUT_WR`, or `SHUT_RDWR`; see [shutdown(2)](\ref man2::shutdown)
 void Socket::shutdown( const int how )
@@ -118,8 +135,7 @@ void DatagramSocket::recv( Address& source_address, string& payload )
   Address::Raw datagram_source_address;
   socklen_t fromlen = sizeof( datagram_source_address );
 
-  payload.clear();
-  payload.resize( kReadBufferSize );
+  payload.resize( kReadBufferSize ); // (only what's beyond the payload's current size is zero-filled)
 
   const ssize_t recv_len = CheckSystemCall(
     "recvfrom",
@@ -147,6 +163,146 @@ void DatagramSocket::send( const string_view payload )
   register_write();
 }
 
+DatagramBatch::DatagramBatch( size_t capacity, size_t buffer_size )
+  : buffer_size_( buffer_size )
+  , buffers_( make_unique_for_overwrite<char[]>( capacity * buffer_size ) )
+  , headers_( capacity )
+  , iovecs_( capacity )
+  , addresses_( capacity )
+  , controls_( capacity )
+  , segment_sizes_( capacity )
+{}
+
+// fill in the next header to send `payload`, with a UDP_SEGMENT control message if `segment_size` is nonzero
+mmsghdr& DatagramBatch::emplace_header( string_view payload, uint16_t segment_size )
+{
+  if ( size_ == capacity() ) {
+    throw runtime_error( "DatagramBatch::push (batch is full)" );
+  }
+  if ( payload.size() > buffer_size_ ) {
+    throw runtime_error( "DatagramBatch::push (oversized datagram)" );
+  }
+
+  const size_t i = size_++;
+  memcpy( buffer( i ), payload.data(), payload.size() );
+  iovecs_[i] = { buffer( i ), payload.size() };
+  segment_sizes_[i] = segment_size;
+
+  mmsghdr& header = headers_[i];
+  header = {};
+  header.msg_hdr.msg_iov = &iovecs_[i];
+  header.msg_hdr.msg_iovlen = 1;
+
+  if ( segment_size ) {
+    header.msg_hdr.msg_control = controls_[i].data.data();
+    header.msg_hdr.msg_controllen = CMSG_SPACE( sizeof( segment_size ) );
+    cmsghdr* cmsg = CMSG_FIRSTHDR( &header.msg_hdr );
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN( sizeof( segment_size ) );
+    memcpy( CMSG_DATA( cmsg ), &segment_size, sizeof( segment_size ) );
+  }
+
+  return header;
+}
+
+void DatagramBatch::push( const Address& destination, string_view payload, uint16_t segment_size )
+{
+  mmsghdr& header = emplace_header( payload, segment_size );
+  const size_t i = size_ - 1;
+  memcpy( &addresses_[i].storage, destination.raw(), destination.size() );
+  header.msg_hdr.msg_name = &addresses_[i].storage;
+  header.msg_hdr.msg_namelen = destination.size();
+}
+
+void DatagramBatch::push( string_view payload, uint16_t segment_size )
+{
+  emplace_header( payload, segment_size );
+}
+
+Address DatagramBatch::address( size_t i ) const
+{
+  return { addresses_.at( i ), headers_.at( i ).msg_hdr.msg_namelen };
+}
+
+string_view DatagramBatch::payload( size_t i ) const
+{
+  const iovec& iov = iovecs_.at( i );
+  return { static_cast<const char*>( iov.iov_base ), iov.iov_len };
+}
+
+void DatagramBatch::prepare_recv()
+{
+  size_ = 0;
+  for ( size_t i = 0; i < capacity(); ++i ) {
+    iovecs_[i] = { buffer( i ), buffer_size_ };
+    mmsghdr& header = headers_[i];
+    header = {};
+    header.msg_hdr.msg_name = &addresses_[i].storage;
+    header.msg_hdr.msg_namelen = sizeof( addresses_[i].storage );
+    header.msg_hdr.msg_iov = &iovecs_[i];
+    header.msg_hdr.msg_iovlen = 1;
+    header.msg_hdr.msg_control = controls_[i].data.data();
+    header.msg_hdr.msg_controllen = sizeof( controls_[i].data );
+  }
+}
+
+void DatagramBatch::finish_recv( size_t count )
+{
+  for ( size_t i = 0; i < count; ++i ) {
+    msghdr& msg = headers_[i].msg_hdr;
+    if ( msg.msg_flags & MSG_TRUNC ) { // NOLINT(*-signed-bitwise)
+      throw runtime_error( "recvmmsg (oversized datagram)" );
+    }
+    iovecs_[i].iov_len = headers_[i].msg_len;
+
+    segment_sizes_[i] = 0;
+    for ( cmsghdr* cmsg = CMSG_FIRSTHDR( &msg ); cmsg; cmsg = CMSG_NXTHDR( &msg, cmsg ) ) {
+      if ( cmsg->cmsg_level == SOL_UDP and cmsg->cmsg_type == UDP_GRO ) {
+        int gso_size {};
+        memcpy( &gso_size, CMSG_DATA( cmsg ), sizeof( gso_size ) );
+        segment_sizes_[i] = static_cast<uint16_t>( gso_size );
+      }
+    }
+  }
+  size_ = count;
+}
+
+//! \note If a datagram is too large for the batch's buffers, this method throws a std::runtime_error
+size_t DatagramSocket::recv_batch( DatagramBatch& batch )
+{
+  batch.prepare_recv();
+  const int count = CheckSystemCall(
+    "recvmmsg",
+    ::recvmmsg( fd_num(), batch.headers_.data(), batch.capacity(), MSG_WAITFORONE, nullptr ) );
+
+  register_read();
+  batch.finish_recv( count );
+  return count;
+}
+
+size_t DatagramSocket::send_batch( DatagramBatch& batch, size_t first )
+{
+  if ( first >= batch.size() ) {
+    return 0;
+  }
+
+  const int count = CheckSystemCall(
+    "sendmmsg", ::sendmmsg( fd_num(), batch.headers_.data() + first, batch.size() - first, 0 ) );
+  register_write();
+  return count;
+}
+
+void UDPSocket::set_gro()
+{
+  setsockopt( SOL_UDP, UDP_GRO, int { true } );
+}
+
+void UDPSocket::set_gso_segment_size( uint16_t segment_size )
+{
+  setsockopt( SOL_UDP, UDP_SEGMENT, int { segment_size } );
+}
+
 // mark the socket as listening for incoming connections
 //! \param[in] backlog is the number of waiting connections to queue (see [listen(2)](\ref man2::listen))
 void TCPSocket::listen( const int backlog )
@@ -163,6 +319,50 @@ TCPSocket TCPSocket::accept()
   return TCPSocket( FileDescriptor( CheckSystemCall( "accept", ::accept( fd_num(), nullptr, nullptr ) ) ) );
 }
 
+// set TCP_DEFER_ACCEPT and TCP_FASTOPEN as requested, then listen
+//! \param[in] options are the listen queue's length and the listening options (see [tcp(7)](\ref man7::tcp))
+void TCPSocket::listen( const ListenOptions& options )
+{
+  if ( options.defer_accept_seconds > 0 ) {
+    setsockopt( IPPROTO_TCP, TCP_DEFER_ACCEPT, options.defer_accept_seconds );
+  }
+  if ( options.fastopen_queue > 0 ) {
+    setsockopt( IPPROTO_TCP, TCP_FASTOPEN, options.fastopen_queue );
+  }
+  listen( options.backlog );
+}
+
+// accept a waiting connection, if there is one, without blocking
+//! \returns the new (non-blocking, close-on-exec) TCPSocket, or nullopt if no connection is waiting
+//! \note Connections that were reset while waiting are skipped, as accept(2) suggests.
+optional<TCPSocket> TCPSocket::try_accept()
+{
+  if ( not non_blocking() ) {
+    throw runtime_error( "accept_many() needs a non-blocking listening socket" );
+  }
+
+  while ( true ) {
+    register_read();
+    const int fd = ::accept4( fd_num(), nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC ); // NOLINT(*-bitwise)
+    if ( fd >= 0 ) {
+      return TCPSocket { fd, KnownBlocking { true } };
+    }
+    if ( errno == EAGAIN or errno == EWOULDBLOCK ) {
+      return nullopt;
+    }
+    if ( errno != ECONNABORTED and errno != EPROTO and errno != EINTR ) {
+      throw unix_error { "accept4" };
+    }
+  }
+}
+
+// accept the waiting connections (up to `max_count`), appending them to `accepted`
+//! \returns the number of connections accepted
+size_t TCPSocket::accept_many( vector<TCPSocket>& accepted, const size_t max_count )
+{
+  return accept_many( [&accepted]( TCPSocket&& socket ) { accepted.push_back( move( socket ) ); }, max_count );
+}
+
 // get socket option
 template<typename option_type>
 socklen_t Socket::getsockopt( const int level, const int option, option_type& option_value ) const
@@ -196,6 +396,12 @@ void Socket::set_reuseaddr()
   setsockopt( SOL_SOCKET, SO_REUSEADDR, int { true } );
 }
 
+// allow several sockets to bind the same address, with the kernel spreading incoming connections across them
+void Socket::set_reuseport()
+{
+  setsockopt( SOL_SOCKET, SO_REUSEPORT, int { true } );
+}
+
 void Socket::throw_if_error() const
 {
   int socket_error = 0;
@@ -3,8 +3,14 @@
 #include "address.hh"
 #include "file_descriptor.hh"
 
+#include <array>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
 #include <sys/socket.h>
+#include <vector>
 
 // Socket 类：网络套接字的基类，封装了常见的套接字操作。
 // 提供对本地地址、对端地址获取以及绑定、连接、关闭等功能，通常由派生类（如 TCPSocket、UDPSocket）进行扩展。
@@ -27,6 +33,9 @@ protected:
   // 利用已有的文件描述符构造套接字对象，用于接受连接后包装描述符。
   Socket( FileDescriptor&& fd, int domain, int type, int protocol = 0 );
 
+  // 包装一个已知类型正确的描述符（例如同类监听套接字 accept 得到的连接），不再用 getsockopt 逐项检查。
+  Socket( int fd, KnownBlocking state ) : FileDescriptor( fd, state ) {}
+
   // 封装 getsockopt(2) 系统调用，模板参数 option_type 表示选项值的类型。
   template<typename option_type>
   socklen_t getsockopt( int level, int option, option_type& option_value ) const;
@@ -48,6 +57,10 @@ public:
   // 连接到对端地址（使用 connect(2) 系统调用），通常用于客户端连接服务器。
   void connect( const Address& address );
 
+  // 发起连接但不等待其完成（用于非阻塞套接字）。立即连接成功时返回 true；返回 false 表示连接正在进行，
+  // 此时应等待套接字可写，再调用 throw_if_error() 检查连接结果（参见 async_connect.hh）。
+  bool start_connect( const Address& address );
+
   // 关闭套接字连接（使用 shutdown(2)），参数 how 指定关闭方式（如只关闭读、写或两者）。
   void shutdown( int how );
 
@@ -60,10 +73,68 @@ public:
   // 设置 SO_REUSEADDR 选项，允许地址快速重用，通常用于服务器重启时。
   void set_reuseaddr();
 
+  // 设置 SO_REUSEPORT 选项，允许多个套接字绑定同一地址，由内核在它们之间分配传入连接（如每线程一个监听套接字）。
+  void set_reuseport();
+
   // 检查非阻塞套接字操作中的错误，并抛出异常。
   void throw_if_error() const;
 };
 
+// DatagramBatch 类：一批数据报及其缓冲区，供 DatagramSocket::recv_batch() 和 send_batch() 重复使用。
+// 每个数据报有自己的地址和固定大小的缓冲区；缓冲区和 recvmmsg(2)/sendmmsg(2) 所需的数组只在构造时分配一次，
+// 之后的收发既不分配内存，也不清零缓冲区。
+class DatagramBatch
+{
+public:
+  // capacity: 一批最多容纳的数据报数量；buffer_size: 每个数据报的最大长度（启用 GRO/GSO 时为合并后的长度）。
+  explicit DatagramBatch( size_t capacity, size_t buffer_size = 65536 );
+
+  size_t capacity() const { return headers_.size(); } // 一批最多容纳的数据报数量
+  size_t size() const { return size_; }               // 当前批次中的数据报数量
+  void clear() { size_ = 0; }                         // 清空批次（例如在加入新一批待发送数据报之前）
+
+  // 加入一个待发送的数据报，payload 被复制到批次的缓冲区中。
+  // 若 segment_size 非零，则内核按该大小把 payload 切分为多个 UDP 数据报发送（GSO，即 UDP_SEGMENT）。
+  void push( const Address& destination, std::string_view payload, uint16_t segment_size = 0 );
+  // 同上，发送到已连接的默认地址（必须先调用 connect()）。
+  void push( std::string_view payload, uint16_t segment_size = 0 );
+
+  // 第 i 个数据报的地址和内容。
+  Address address( size_t i ) const;
+  std::string_view payload( size_t i ) const;
+  // 第 i 个数据报的分段大小：接收时若内核合并了多个数据报（GRO），payload 由这些大小的分段依次组成；否则为 0。
+  uint16_t segment_size( size_t i ) const { return segment_sizes_.at( i ); }
+
+  DatagramBatch( const DatagramBatch& other ) = delete;
+  DatagramBatch& operator=( const DatagramBatch& other ) = delete;
+  DatagramBatch( DatagramBatch&& other ) = default;
+  DatagramBatch& operator=( DatagramBatch&& other ) = default;
+  ~DatagramBatch() = default;
+
+private:
+  friend class DatagramSocket;
+
+  // 每个数据报的控制消息（cmsg）缓冲区，用于 UDP_SEGMENT 和 UDP_GRO。
+  struct alignas( cmsghdr ) Control
+  {
+    std::array<char, CMSG_SPACE( sizeof( int ) )> data;
+  };
+
+  size_t buffer_size_;
+  std::unique_ptr<char[]> buffers_;
+  std::vector<mmsghdr> headers_;
+  std::vector<iovec> iovecs_;
+  std::vector<Address::Raw> addresses_;
+  std::vector<Control> controls_;
+  std::vector<uint16_t> segment_sizes_;
+  size_t size_ {};
+
+  char* buffer( size_t i ) { return buffers_.get() + i * buffer_size_; }
+  mmsghdr& emplace_header( std::string_view payload, uint16_t segment_size );
+  void prepare_recv(); // 重置所有消息头，以接收至多 capacity() 个数据报
+  void finish_recv( size_t count );
+};
+
 // DatagramSocket 类：数据报套接字基类，专用于无连接的数据传输，如 UDP。
 // 提供接收、发送数据报的基本接口。
 class DatagramSocket : public Socket
@@ -78,6 +149,14 @@ public:
   // 发送数据报到已连接的默认地址（必须先调用 connect()）。
   void send( std::string_view payload );
 
+  // 批量接收：用一次 recvmmsg(2) 调用接收至多 batch.capacity() 个数据报（至少等待一个），替换批次原有的内容。
+  // 返回接收到的数量（非阻塞套接字上没有数据时为 0）；超过缓冲区大小的数据报会引发 std::runtime_error。
+  size_t recv_batch( DatagramBatch& batch );
+
+  // 批量发送：用一次 sendmmsg(2) 调用发送批次中从 first 开始的数据报。
+  // 返回实际发送的数量，可能少于剩余的数量（例如非阻塞套接字的发送缓冲区已满）。
+  size_t send_batch( DatagramBatch& batch, size_t first = 0 );
+
 protected:
   // 利用指定参数构造数据报套接字。
   DatagramSocket( int domain, int type, int protocol = 0 ) : Socket( domain, type, protocol ) {}
@@ -97,6 +176,12 @@ class UDPSocket : public DatagramSocket
 public:
   // 默认构造函数：创建一个未绑定且未连接的 UDP 套接字。
   UDPSocket() : DatagramSocket( AF_INET, SOCK_DGRAM ) {}
+
+  // 启用 UDP_GRO：内核可以把同一来源的多个数据报合并后一次交付，分段大小见 DatagramBatch::segment_size()。
+  void set_gro();
+
+  // 设置 UDP_SEGMENT：此后发送的每个数据报都按 segment_size 切分（GSO）；0 表示关闭。
+  void set_gso_segment_size( uint16_t segment_size );
 };
 
 // TCPSocket 类：TCP 套接字的封装，用于建立可靠的面向连接通信。
@@ -107,17 +192,62 @@ private:
   // 通过文件描述符构造 TCP 套接字，通常由 accept() 返回的新连接使用。
   explicit TCPSocket( FileDescriptor&& fd ) : Socket( std::move( fd ), AF_INET, SOCK_STREAM, IPPROTO_TCP ) {}
 
+  // 包装 accept4(2) 从本（TCP）监听套接字取出的连接。
+  TCPSocket( int fd, KnownBlocking state ) : Socket( fd, state ) {}
+
+  // 用 accept4(2)（SOCK_NONBLOCK | SOCK_CLOEXEC）取出一个等待中的连接；队列为空时返回 nullopt。
+  std::optional<TCPSocket> try_accept();
+
 public:
   // 默认构造函数：创建一个未绑定且未连接的 TCP 套接字。
   TCPSocket() : Socket( AF_INET, SOCK_STREAM ) {}
 
-  // 将套接字切换为监听模式，backlog 参数指定等待连接队列的长度。
-  void listen( int backlog = 16 );
+  // 将套接字切换为监听模式，backlog 参数指定等待连接队列的长度（内核会截断到 net.core.somaxconn）。
+  void listen( int backlog = SOMAXCONN );
+
+  // 监听选项，供 listen( const ListenOptions& ) 使用。
+  struct ListenOptions
+  {
+    int backlog { SOMAXCONN }; // 等待连接队列的长度
+    // 若非 0，设置 TCP_DEFER_ACCEPT：连接要等到收到客户端的首个数据（或约这么多秒后）才可 accept，
+    // 适用于客户端先发言的协议（如 HTTP），让服务器不必为尚无数据的连接醒来。
+    int defer_accept_seconds {};
+    // 若非 0，启用 TCP_FASTOPEN：客户端可在 SYN 中携带数据，此值为尚未完成握手的此类连接的队列长度。
+    int fastopen_queue {};
+  };
+
+  // 先按 options 设置 TCP_DEFER_ACCEPT / TCP_FASTOPEN，再切换为监听模式。
+  void listen( const ListenOptions& options );
 
   // 接受传入连接，返回一个新的 TCP 套接字对象。
   TCPSocket accept();
+
+  // 批量接受：在一次可读事件中取出等待队列里的连接（最多 max_count 个），对每个新连接调用 on_accepted，
+  // 返回接受的连接数（队列为空时为 0）。新连接用 accept4(2) 取出，已是非阻塞的并设置了 close-on-exec，
+  // 构造时不再调用 fcntl 或 getsockopt。监听套接字必须是非阻塞的（否则抛出 std::runtime_error）。
+  // max_count 限制一次取出的数量，让事件循环中的其他规则也有机会运行；剩下的连接在下一次事件中取出。
+  template<typename Callback>
+  size_t accept_many( Callback&& on_accepted, size_t max_count = 64 );
+
+  // 同上，把新连接追加到 accepted 中。
+  size_t accept_many( std::vector<TCPSocket>& accepted, size_t max_count = 64 );
 };
 
+template<typename Callback>
+size_t TCPSocket::accept_many( Callback&& on_accepted, const size_t max_count )
+{
+  size_t count = 0;
+  while ( count < max_count ) {
+    std::optional<TCPSocket> accepted = try_accept();
+    if ( not accepted ) {
+      break;
+    }
+    ++count;
+    on_accepted( std::move( *accepted ) );
+  }
+  return count;
+}
+
 // PacketSocket 类：原始数据包套接字，用于低级网络通信和捕获数据包。
 // 在网络调试和监控中有较多应用。
 class PacketSocket : public DatagramSocket
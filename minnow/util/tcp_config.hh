@@ -0,0 +1,23 @@
+#pragma once
+
+#include "wrapping_integers.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+//! Config for TCP sender and receiver
+class TCPConfig
+{
+public:
+  static constexpr uint64_t DEFAULT_CAPACITY = 64000; //!< Default capacity
+  static constexpr uint64_t MAX_PAYLOAD_SIZE = 1000;  //!< Conservative max payload size for real Internet
+  static constexpr uint16_t TIMEOUT_DFLT = 1000;      //!< Default re-transmit timeout is 1 second
+  static constexpr uint64_t MAX_RETX_ATTEMPTS = 8;    //!< Maximum re-transmit attempts before giving up
+
+  uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
+  uint64_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
+  uint64_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
+  uint64_t recv_max_capacity = 0;            //!< Receive capacity auto-tuning limit, in bytes (zero for none)
+  std::optional<Wrap32> fixed_isn {};
+};
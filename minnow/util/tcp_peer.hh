@@ -0,0 +1,149 @@
+#pragma once
+
+#include "random.hh"
+#include "tcp_config.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+/*
+ * A TCP endpoint: a TCPSender for the outbound stream and a TCPReceiver for the inbound one.
+ * Each segment it transmits carries both halves (the sender's message and the receiver's reply);
+ * the ports and options are left for whoever puts the segments on the wire.
+ *
+ * An active peer opens the connection with connect(); a passive one sends nothing until the peer's SYN arrives.
+ * Once both streams have finished, a peer whose inbound stream ended last lingers (for ten
+ * retransmission timeouts after the last segment it received) in case its final ACK was lost.
+ */
+class TCPPeer
+{
+public:
+  using TransmitFunction = std::function<void( const TCPSegment& )>;
+
+private:
+  // Send the sender's message, with the receiver's reply
+  void send( TCPSenderMessage message, const TransmitFunction& transmit )
+  {
+    // While the peer's window is closed, it only accepts a segment at exactly its ackno (RFC 9293 3.10.7.4),
+    // which a bare ACK sent after a zero-window probe wouldn't be: send that at the peer's ackno instead.
+    if ( message.sequence_length() == 0 and peer_window_closed_ and peer_ackno_.has_value() ) {
+      message.seqno = *peer_ackno_;
+    }
+    const TCPReceiverMessage reply = receiver_.send();
+    window_advertised_closed_ = reply.ackno.has_value() and reply.window_size == 0;
+    transmit( { .message = std::move( message ), .reply = reply } );
+    need_send_ = false;
+  }
+
+  auto make_send( const TransmitFunction& transmit )
+  {
+    return [this, &transmit]( const TCPSenderMessage& message ) { send( message, transmit ); };
+  }
+
+public:
+  explicit TCPPeer( const TCPConfig& cfg ) : cfg_( cfg )
+  {
+    receiver_.set_window_autotuning( cfg_.recv_max_capacity );
+  }
+
+  Writer& outbound_writer() { return sender_.writer(); }
+  const Writer& outbound_writer() const { return sender_.writer(); }
+  Reader& inbound_reader() { return receiver_.reader(); }
+  const Reader& inbound_reader() const { return receiver_.reader(); }
+
+  const TCPSender& sender() const { return sender_; }
+  const TCPReceiver& receiver() const { return receiver_; }
+  TCPSender& sender() { return sender_; }
+  TCPReceiver& receiver() { return receiver_; }
+
+  // Active open: send the SYN
+  void connect( const TransmitFunction& transmit )
+  {
+    opened_ = true;
+    push( transmit );
+  }
+
+  // Send what the outbound stream and the window allow (once the connection has been opened), plus an ACK if
+  // one is owed: for a segment that arrived, or to tell the peer that a window we had advertised closed reopened.
+  void push( const TransmitFunction& transmit )
+  {
+    need_send_ |= window_advertised_closed_ and receiver_.send().window_size > 0;
+    if ( opened_ ) {
+      sender_.push( make_send( transmit ) );
+    }
+    if ( need_send_ ) {
+      send( sender_.make_empty_message(), transmit );
+    }
+  }
+
+  void receive( TCPSegment segment, const TransmitFunction& transmit )
+  {
+    if ( not active() ) {
+      return;
+    }
+
+    time_of_last_receipt_ = time_;
+
+    // A segment that occupies sequence numbers must be acknowledged, even if there is nothing else to send, and
+    // so must a keep-alive or zero-window probe (an empty segment one before our ackno).
+    const std::optional<Wrap32> ackno = receiver_.send().ackno;
+    need_send_ |= segment.message.sequence_length() > 0
+                  or ( ackno.has_value() and segment.message.seqno + 1 == *ackno );
+    opened_ |= segment.message.SYN;
+
+    if ( segment.reply.ackno.has_value() ) {
+      peer_ackno_ = segment.reply.ackno;
+      peer_window_closed_ = segment.reply.window_size == 0;
+    }
+
+    receiver_.receive( std::move( segment.message ) );
+    sender_.receive( segment.reply );
+
+    // If the inbound stream ends before the outbound one has, the peer will hear the final ACK: don't linger.
+    if ( receiver_.writer().is_closed() and not sender_.reader().is_finished() ) {
+      linger_after_streams_finish_ = false;
+    }
+
+    push( transmit );
+  }
+
+  void tick( uint64_t ms_since_last_tick, const TransmitFunction& transmit )
+  {
+    time_ += ms_since_last_tick;
+    sender_.tick( ms_since_last_tick, make_send( transmit ) );
+  }
+
+  // Is the connection still alive (no error, and still sending, receiving or lingering)?
+  bool active() const
+  {
+    const bool any_errors = receiver_.reader().has_error() or sender_.writer().has_error();
+    const bool sender_active = sender_.sequence_numbers_in_flight() > 0 or not sender_.reader().is_finished();
+    const bool receiver_active = not receiver_.writer().is_closed();
+    const bool lingering
+      = linger_after_streams_finish_ and time_ < time_of_last_receipt_ + 10ULL * cfg_.rt_timeout;
+    return not any_errors and ( sender_active or receiver_active or lingering );
+  }
+
+  // Has the peer's SYN arrived?
+  bool has_ackno() const { return receiver_.send().ackno.has_value(); }
+
+private:
+  TCPConfig cfg_;
+  TCPSender sender_ { ByteStream { cfg_.send_capacity },
+                      cfg_.fixed_isn.value_or( Wrap32 { static_cast<uint32_t>( get_random_engine()() ) } ),
+                      cfg_.rt_timeout };
+  TCPReceiver receiver_ { Reassembler { ByteStream { cfg_.recv_capacity } } };
+
+  bool opened_ {};
+  bool need_send_ {};
+  bool linger_after_streams_finish_ { true };
+  std::optional<Wrap32> peer_ackno_ {}; // the latest ackno from the peer
+  bool peer_window_closed_ {};
+  bool window_advertised_closed_ {}; // did the latest ACK we sent advertise a zero window?
+  uint64_t time_ {};
+  uint64_t time_of_last_receipt_ {};
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/*
+ * The TCPReceiverMessage structure contains the information sent from a TCP receiver to its sender.
+ *
+ * It contains four fields:
+ *
+ * 1) The acknowledgment number (ackno): the *next* sequence number needed by the TCP Receiver.
+ *    This is an optional field that is empty if the TCPReceiver hasn't yet received the Initial Sequence Number.
+ *
+ * 2) The window size. This is the number of sequence numbers that the TCP receiver is interested
+ *    to receive, starting from the ackno if present. The maximum value is MAX_WINDOW_SIZE: on the wire,
+ *    the window is a 16-bit field, scaled by the shift the connection's SYNs negotiated (RFC 7323; see
+ *    TCPSegment), and a window too large for it is advertised as the largest that fits.
+ *
+ * 3) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ *
+ * 4) Selective acknowledgments (RFC 2018, optional): ranges of sequence numbers beyond the ackno that
+ *    the receiver already has, so the sender need not retransmit them.
+ */
+
+struct TCPReceiverMessage
+{
+  //! A range [begin, end) of sequence numbers that the receiver holds
+  struct SackBlock
+  {
+    Wrap32 begin { 0 };
+    Wrap32 end { 0 };
+  };
+
+  static constexpr size_t MAX_SACK_BLOCKS = 4; //!< as many as fit in a TCP header's options
+  static constexpr uint32_t MAX_WINDOW_SIZE = uint32_t { UINT16_MAX } << 14; //!< with the largest window scale
+
+  std::optional<Wrap32> ackno {};
+  uint32_t window_size {};
+  bool RST {};
+  std::vector<SackBlock> sack_blocks {};
+};
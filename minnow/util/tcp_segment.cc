@@ -0,0 +1,216 @@
+#include "tcp_segment.hh"
+#include "checksum.hh"
+#include "helpers.hh"
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+constexpr size_t TCP_HEADER_LENGTH = 20; // without options
+
+// option kinds (RFC 9293, RFC 7323 and RFC 2018)
+constexpr uint8_t OPTION_END = 0;
+constexpr uint8_t OPTION_NOP = 1;
+constexpr uint8_t OPTION_MSS = 2;
+constexpr uint8_t OPTION_WINDOW_SCALE = 3;
+constexpr uint8_t OPTION_SACK_PERMITTED = 4;
+constexpr uint8_t OPTION_SACK = 5;
+
+// flag bits
+constexpr uint8_t FLAG_FIN = 0x01;
+constexpr uint8_t FLAG_SYN = 0x02;
+constexpr uint8_t FLAG_RST = 0x04;
+constexpr uint8_t FLAG_ACK = 0x10;
+
+uint64_t sendable_sack_blocks( const TCPSegment& segment )
+{
+  return segment.message.SYN ? 0 : min( segment.reply.sack_blocks.size(), TCPReceiverMessage::MAX_SACK_BLOCKS );
+}
+
+// The window as sent: scaled (except on a SYN), and saturated at what the 16-bit field can carry
+uint16_t wire_window( const TCPSegment& segment )
+{
+  const uint8_t shift = segment.message.SYN ? 0 : segment.window_shift;
+  return static_cast<uint16_t>( min<uint32_t>( segment.reply.window_size >> shift, UINT16_MAX ) );
+}
+} // namespace
+
+uint8_t TCPSegment::window_scale_for( uint64_t max_window )
+{
+  uint8_t scale = 0;
+  while ( scale < MAX_WINDOW_SCALE and ( max_window >> scale ) > UINT16_MAX ) {
+    ++scale;
+  }
+  return scale;
+}
+
+uint64_t TCPSegment::header_length() const
+{
+  uint64_t options = 0;
+  options += mss ? 4 : 0;
+  options += window_scale.has_value() ? 4 : 0; // (padded with a NOP)
+  options += sack_permitted ? 4 : 0; // (padded with two NOPs)
+  const uint64_t blocks = sendable_sack_blocks( *this );
+  options += blocks ? 4 + 8 * blocks : 0; // (likewise)
+  return TCP_HEADER_LENGTH + options;
+}
+
+void TCPSegment::serialize( Serializer& serializer ) const
+{
+  const uint8_t flags = ( message.FIN ? FLAG_FIN : 0 ) | ( message.SYN ? FLAG_SYN : 0 )
+                        | ( message.RST or reply.RST ? FLAG_RST : 0 ) | ( reply.ackno.has_value() ? FLAG_ACK : 0 );
+  const uint8_t data_offset = static_cast<uint8_t>( header_length() / 4 ) << 4;
+
+  serializer.integer( source_port );
+  serializer.integer( destination_port );
+  serializer.integer( message.seqno.raw() );
+  serializer.integer( reply.ackno.has_value() ? reply.ackno->raw() : uint32_t {} );
+  serializer.integer( data_offset );
+  serializer.integer( flags );
+  serializer.integer( wire_window( *this ) );
+  serializer.integer( checksum );
+  serializer.integer( uint16_t {} ); // urgent pointer
+
+  if ( mss ) {
+    serializer.integer( OPTION_MSS );
+    serializer.integer( uint8_t { 4 } );
+    serializer.integer( mss );
+  }
+  if ( window_scale.has_value() ) {
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_WINDOW_SCALE );
+    serializer.integer( uint8_t { 3 } );
+    serializer.integer( *window_scale );
+  }
+  if ( sack_permitted ) {
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_SACK_PERMITTED );
+    serializer.integer( uint8_t { 2 } );
+  }
+  if ( const uint64_t blocks = sendable_sack_blocks( *this ) ) {
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_NOP );
+    serializer.integer( OPTION_SACK );
+    serializer.integer( static_cast<uint8_t>( 2 + 8 * blocks ) );
+    for ( uint64_t i = 0; i < blocks; ++i ) {
+      serializer.integer( reply.sack_blocks[i].begin.raw() );
+      serializer.integer( reply.sack_blocks[i].end.raw() );
+    }
+  }
+
+  serializer.buffer( message.payload );
+}
+
+void TCPSegment::compute_checksum( uint32_t pseudo_checksum )
+{
+  checksum = 0;
+  const vector<Slice> bytes = ::serialize( *this );
+  InternetChecksum check { pseudo_checksum };
+  for ( const Slice& slice : bytes ) {
+    check.add( slice.view() );
+  }
+  checksum = check.value();
+}
+
+void TCPSegment::parse( Parser& parser, uint32_t pseudo_checksum )
+{
+  InternetChecksum check { pseudo_checksum };
+  for ( const Slice& slice : parser.slices() ) {
+    check.add( slice.view() );
+  }
+  if ( check.value() != 0 ) {
+    parser.set_error();
+    return;
+  }
+
+  uint32_t seqno {};
+  uint32_t ackno {};
+  uint8_t data_offset {};
+  uint8_t flags {};
+  uint16_t window {};
+  uint16_t urgent {};
+  parser.integers( source_port, destination_port, seqno, ackno, data_offset, flags );
+  parser.integers( window, checksum, urgent );
+
+  const uint64_t header_len = 4 * ( data_offset >> 4 );
+  if ( parser.has_error() or header_len < TCP_HEADER_LENGTH ) {
+    parser.set_error();
+    return;
+  }
+
+  message.seqno = Wrap32 { seqno };
+  message.SYN = flags & FLAG_SYN;
+  message.FIN = flags & FLAG_FIN;
+  message.RST = flags & FLAG_RST;
+  reply.RST = message.RST;
+  const uint8_t shift = message.SYN ? 0 : min( window_shift, MAX_WINDOW_SCALE );
+  reply.window_size = static_cast<uint32_t>( window ) << shift;
+  reply.ackno = ( flags & FLAG_ACK ) ? optional { Wrap32 { ackno } } : nullopt;
+
+  // The options are read (into the stack) and parsed on their own, so a malformed one can't overrun the header.
+  array<char, 4 * 0xf - TCP_HEADER_LENGTH> option_bytes {};
+  const span<char> options_read { option_bytes.data(), header_len - TCP_HEADER_LENGTH };
+  parser.string( options_read );
+  Parser options { Slice::borrow( { options_read.data(), options_read.size() } ) };
+
+  for ( uint64_t remaining = options_read.size(); remaining > 0 and not options.has_error(); ) {
+    uint8_t kind {};
+    options.integer( kind );
+    --remaining;
+    if ( kind == OPTION_END ) {
+      break;
+    }
+    if ( kind == OPTION_NOP ) {
+      continue;
+    }
+
+    uint8_t length {};
+    options.integer( length );
+    if ( length < 2 or length - 1U > remaining ) {
+      options.set_error();
+      break;
+    }
+    remaining -= length - 1;
+
+    if ( kind == OPTION_MSS and length == 4 ) {
+      options.integer( mss );
+    } else if ( kind == OPTION_WINDOW_SCALE and length == 3 ) {
+      window_scale.emplace();
+      options.integer( *window_scale );
+    } else if ( kind == OPTION_SACK_PERMITTED and length == 2 ) {
+      sack_permitted = true;
+    } else if ( kind == OPTION_SACK and ( length - 2 ) % 8 == 0 ) {
+      for ( uint8_t i = 0; i < ( length - 2 ) / 8; ++i ) {
+        uint32_t begin {};
+        uint32_t end {};
+        options.integers( begin, end );
+        reply.sack_blocks.push_back( { Wrap32 { begin }, Wrap32 { end } } );
+      }
+    } else {
+      options.remove_prefix( length - 2 ); // an option we don't use
+    }
+  }
+  if ( parser.has_error() or options.has_error() ) {
+    parser.set_error();
+    return;
+  }
+
+  // The payload: a view of the parsed bytes (copied only if they span several buffers)
+  vector<Slice> payload;
+  parser.all_remaining( payload );
+  if ( payload.size() == 1 ) {
+    message.payload = std::move( payload.front() );
+  } else if ( payload.size() > 1 ) {
+    string joined;
+    for ( const Slice& slice : payload ) {
+      joined.append( slice.view() );
+    }
+    message.payload = std::move( joined );
+  }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "parser.hh"
+#include "tcp_receiver_message.hh"
+#include "tcp_sender_message.hh"
+
+#include <cstdint>
+#include <optional>
+
+/*
+ * A TCP segment as it appears on the wire: the sender's message and the receiver's reply (the two
+ * halves of one peer's output), plus the ports and options that only matter on the wire.
+ *
+ * The options understood are MSS, SACK-permitted and window scale (on a SYN) and SACK blocks (the
+ * receiver's sack_blocks); others are skipped when parsing.
+ *
+ * Window scaling (RFC 7323) is in effect once both SYNs have carried the window scale option. From then on,
+ * each side's windows are sent right-shifted by the scale it offered; whoever puts the segments on the wire
+ * sets `window_shift` (before serializing or parsing) to the scale in effect for the windows in that direction.
+ * A SYN's own window is never scaled.
+ */
+struct TCPSegment
+{
+  TCPSenderMessage message {};
+  TCPReceiverMessage reply {};
+
+  uint16_t source_port {};
+  uint16_t destination_port {};
+  uint16_t mss {};            // maximum segment size option (on a SYN), or zero for none
+  bool sack_permitted {};     // SACK-permitted option (on a SYN)
+  std::optional<uint8_t> window_scale {}; // window scale option (on a SYN): the shift its sender's windows will use
+  uint8_t window_shift {};    // the shift of reply.window_size on the wire (for a segment without SYN)
+  uint16_t checksum {};
+
+  static constexpr uint8_t MAX_WINDOW_SCALE = 14;
+
+  // The smallest window scale that can advertise a window of `max_window` bytes (up to MAX_WINDOW_SCALE)
+  static uint8_t window_scale_for( uint64_t max_window );
+
+  // Parse a segment (the payload of an IPv4 datagram, whose pseudo-header sums to `pseudo_checksum`):
+  // a bad checksum or a malformed header is a parse error. The payload is a view of the parsed bytes.
+  void parse( Parser& parser, uint32_t pseudo_checksum );
+  void serialize( Serializer& serializer ) const;
+
+  // Set the checksum to the correct value, given the datagram's pseudo-header sum
+  void compute_checksum( uint32_t pseudo_checksum );
+
+  // Length of the header (with its options) on the wire
+  uint64_t header_length() const;
+  // Bytes that serialize() copies: the header's (the payload is kept as a segment)
+  uint64_t copied_length() const { return header_length(); }
+};
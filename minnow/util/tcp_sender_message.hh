@@ -0,0 +1,39 @@
+#pragma once
+
+#include "slice.hh"
+#include "wrapping_integers.hh"
+
+#include <cstddef>
+
+/*
+ * The TCPSenderMessage structure contains the information sent from a TCP sender to its receiver.
+ *
+ * It contains five fields:
+ *
+ * 1) The sequence number (seqno) of the beginning of the segment. If the SYN flag is set, this is the
+ *    sequence number of the SYN flag. Otherwise, it's the sequence number of the beginning of the payload.
+ *
+ * 2) The SYN flag. If set, it means this segment is the beginning of the byte stream, and that
+ *    the seqno field contains the Initial Sequence Number (ISN) -- the zero point.
+ *
+ * 3) The payload: a substring (possibly empty) of the byte stream. It is a Slice, so that a segment
+ *    (and each retransmission of it) shares the bytes the application pushed, rather than copying them.
+ *
+ * 4) The FIN flag. If set, it means the payload represents the ending of the byte stream.
+ *
+ * 5) The RST (reset) flag. If set, the stream has suffered an error and the connection should be aborted.
+ */
+
+struct TCPSenderMessage
+{
+  Wrap32 seqno { 0 };
+
+  bool SYN {};
+  Slice payload {};
+  bool FIN {};
+
+  bool RST {};
+
+  // How many sequence numbers does this segment use?
+  size_t sequence_length() const { return SYN + payload.size() + FIN; }
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * A hashed timer wheel: a deadline (in ms) is filed in the slot for its granule of `Granularity` ms, and
+ * advancing the clock visits only the slots whose granules have passed, so scheduling is O(1) and
+ * expiring costs O(expired timers + slots visited) no matter how many timers are pending.
+ *
+ * A deadline more than one turn of the wheel away just stays in its slot when visited, until it is due.
+ * Timers can't be cancelled: the owner should check, when one fires, whether the deadline still matters
+ * (e.g. by comparing it with the deadline it has on record for the key), and ignore it if not.
+ */
+template<typename Key, uint64_t Granularity = 128, size_t Slots = 512>
+class TimerWheel
+{
+  static_assert( Granularity > 0 and Slots > 0 );
+
+  struct Timer
+  {
+    Key key;
+    uint64_t deadline;
+  };
+
+  std::array<std::vector<Timer>, Slots> slots_ {};
+  uint64_t now_ {};
+  size_t size_ {};
+
+  static size_t slot_of( uint64_t time ) { return ( time / Granularity ) % Slots; }
+
+public:
+  uint64_t now() const { return now_; }
+  size_t size() const { return size_; }
+
+  // Fire `key` (in some call to advance()) once the clock reaches `deadline`
+  void schedule( const Key& key, uint64_t deadline )
+  {
+    slots_[slot_of( std::max( deadline, now_ ) )].push_back( { key, deadline } );
+    ++size_;
+  }
+
+  // Move the clock forward to `now`, and call `fire( key, deadline )` for each timer that has come due
+  template<std::invocable<const Key&, uint64_t> F>
+  void advance( uint64_t now, F&& fire )
+  {
+    if ( now < now_ ) {
+      return;
+    }
+
+    const uint64_t granules = std::min<uint64_t>( now / Granularity - now_ / Granularity, Slots - 1 );
+    now_ = now;
+    for ( uint64_t i = 0; i <= granules; ++i ) {
+      std::vector<Timer>& slot = slots_[slot_of( now - i * Granularity )];
+      // fire() may schedule more timers (even into this slot), so the due ones are taken out first
+      const auto due = std::partition( slot.begin(), slot.end(), [now]( const Timer& t ) {
+        return t.deadline > now;
+      } );
+      std::vector<Timer> fired { std::make_move_iterator( due ), std::make_move_iterator( slot.end() ) };
+      slot.erase( due, slot.end() );
+      size_ -= fired.size();
+      for ( const Timer& t : fired ) {
+        fire( t.key, t.deadline );
+      }
+    }
+  }
+};
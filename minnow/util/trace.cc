@@ -0,0 +1,237 @@
+#include "trace.hh"
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+// One thread's records. The thread is the only writer (of `head`), and drain() the only reader (of `tail`).
+struct TraceRing
+{
+  static constexpr size_t cache_line_size = 64;
+
+  explicit TraceRing( uint32_t id ) : thread( id ) {}
+
+  uint32_t thread;
+  unique_ptr<TraceRecord[]> records { make_unique_for_overwrite<TraceRecord[]>( Trace::ring_records ) };
+  alignas( cache_line_size ) atomic<uint64_t> head {};
+  alignas( cache_line_size ) atomic<uint64_t> tail {};
+  atomic<uint64_t> dropped {};
+  atomic<bool> retired {}; // has the thread exited?
+};
+
+static_assert( ( Trace::ring_records & ( Trace::ring_records - 1 ) ) == 0, "ring_records must be a power of 2" );
+
+// The rings of all the threads that have traced (a ring outlives its thread until it has been drained)
+struct Registry
+{
+  mutex rings_mutex {}; // also serializes the drains
+  vector<shared_ptr<TraceRing>> rings {};
+  uint32_t next_thread {};
+  uint64_t dropped_by_retired {};
+
+  mutex categories_mutex {};
+  vector<string> categories {};
+};
+
+Registry& registry()
+{
+  static Registry instance;
+  return instance;
+}
+
+// Each thread's ring, created on its first record
+struct RingHolder
+{
+  shared_ptr<TraceRing> ring {};
+
+  RingHolder() = default;
+  RingHolder( const RingHolder& other ) = delete;
+  RingHolder& operator=( const RingHolder& other ) = delete;
+  ~RingHolder()
+  {
+    if ( ring ) {
+      ring->retired.store( true, memory_order_release );
+    }
+  }
+};
+
+thread_local RingHolder this_thread; // NOLINT(*-avoid-non-const-global-variables)
+
+TraceRing& this_thread_ring()
+{
+  if ( not this_thread.ring ) {
+    Registry& reg = registry();
+    const lock_guard lock( reg.rings_mutex );
+    this_thread.ring = make_shared<TraceRing>( reg.next_thread++ );
+    reg.rings.push_back( this_thread.ring );
+  }
+  return *this_thread.ring;
+}
+
+string_view level_name( TraceLevel level )
+{
+  switch ( level ) {
+    case TraceLevel::Debug:
+      return "debug";
+    case TraceLevel::Info:
+      return "info";
+    case TraceLevel::Warning:
+      return "warning";
+    case TraceLevel::Off:
+      break;
+  }
+  return "unknown";
+}
+
+// The background flusher
+struct Flusher
+{
+  mutex stop_mutex {};
+  condition_variable stop_requested {};
+  bool stopping {};
+  thread worker {};
+};
+
+Flusher& flusher()
+{
+  static Flusher instance;
+  return instance;
+}
+} // namespace
+
+uint16_t Trace::category( string_view name )
+{
+  Registry& reg = registry();
+  const lock_guard lock( reg.categories_mutex );
+  const auto it = ranges::find( reg.categories, name );
+  if ( it != reg.categories.end() ) {
+    return static_cast<uint16_t>( it - reg.categories.begin() );
+  }
+  if ( reg.categories.size() > UINT16_MAX ) {
+    throw runtime_error( "Trace: too many categories" );
+  }
+  reg.categories.emplace_back( name );
+  return static_cast<uint16_t>( reg.categories.size() - 1 );
+}
+
+string Trace::category_name( uint16_t category )
+{
+  Registry& reg = registry();
+  const lock_guard lock( reg.categories_mutex );
+  return category < reg.categories.size() ? reg.categories[category] : "category " + to_string( category );
+}
+
+void Trace::write( uint16_t category, TraceLevel level, span<const uint64_t> args )
+{
+  TraceRing& ring = this_thread_ring();
+  const uint64_t head = ring.head.load( memory_order_relaxed );
+  if ( head - ring.tail.load( memory_order_acquire ) == ring_records ) {
+    ring.dropped.fetch_add( 1, memory_order_relaxed );
+    return;
+  }
+
+  TraceRecord& record = ring.records[head & ( ring_records - 1 )];
+  record.timestamp_ns = duration_cast<nanoseconds>( steady_clock::now().time_since_epoch() ).count();
+  record.thread = ring.thread;
+  record.category = category;
+  record.level = level;
+  record.arg_count = static_cast<uint8_t>( args.size() );
+  ranges::copy( args, record.args.begin() );
+  ring.head.store( head + 1, memory_order_release );
+}
+
+size_t Trace::drain( const function<void( const TraceRecord& )>& sink )
+{
+  Registry& reg = registry();
+  const lock_guard lock( reg.rings_mutex );
+
+  size_t count = 0;
+  erase_if( reg.rings, [&]( const shared_ptr<TraceRing>& ring ) {
+    const bool retired = ring->retired.load( memory_order_acquire ); // (before reading its final records)
+    const uint64_t head = ring->head.load( memory_order_acquire );
+    for ( uint64_t tail = ring->tail.load( memory_order_relaxed ); tail != head; ++tail, ++count ) {
+      sink( ring->records[tail & ( ring_records - 1 )] );
+      ring->tail.store( tail + 1, memory_order_release );
+    }
+
+    // the ring of an exited thread is finished with once drained
+    if ( retired ) {
+      reg.dropped_by_retired += ring->dropped.load( memory_order_relaxed );
+    }
+    return retired;
+  } );
+  return count;
+}
+
+size_t Trace::dump( ostream& out )
+{
+  vector<TraceRecord> records;
+  drain( [&records]( const TraceRecord& record ) { records.push_back( record ); } );
+  ranges::stable_sort( records, {}, &TraceRecord::timestamp_ns );
+
+  for ( const auto& record : records ) {
+    out << record.timestamp_ns << " thread " << record.thread << " " << level_name( record.level ) << " "
+        << category_name( record.category ) << ":";
+    for ( size_t i = 0; i < record.arg_count; ++i ) {
+      out << " " << record.args.at( i );
+    }
+    out << "\n";
+  }
+  out.flush();
+  return records.size();
+}
+
+uint64_t Trace::dropped()
+{
+  Registry& reg = registry();
+  const lock_guard lock( reg.rings_mutex );
+  uint64_t total = reg.dropped_by_retired;
+  for ( const auto& ring : reg.rings ) {
+    total += ring->dropped.load( memory_order_relaxed );
+  }
+  return total;
+}
+
+void Trace::start_flusher( ostream& out, milliseconds interval )
+{
+  Flusher& f = flusher();
+  if ( f.worker.joinable() ) {
+    throw runtime_error( "Trace: the flusher is already running" );
+  }
+
+  f.stopping = false;
+  f.worker = thread { [&f, &out, interval] {
+    unique_lock lock( f.stop_mutex );
+    while ( not f.stop_requested.wait_for( lock, interval, [&f] { return f.stopping; } ) ) {
+      lock.unlock();
+      dump( out );
+      lock.lock();
+    }
+    lock.unlock();
+    dump( out );
+  } };
+}
+
+void Trace::stop_flusher()
+{
+  Flusher& f = flusher();
+  if ( not f.worker.joinable() ) {
+    return;
+  }
+
+  {
+    const lock_guard lock( f.stop_mutex );
+    f.stopping = true;
+  }
+  f.stop_requested.notify_one();
+  f.worker.join();
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Trace points below this level are compiled out (0: Debug, 1: Info, 2: Warning, 3: none); see etc/cflags.cmake
+#ifndef MINNOW_TRACE_LEVEL
+#define MINNOW_TRACE_LEVEL 1
+#endif
+
+enum class TraceLevel : uint8_t
+{
+  Debug,
+  Info,
+  Warning,
+  Off,
+};
+
+// One trace event, as logged: fixed-size and binary (the arguments are integers, interpreted by the category)
+struct TraceRecord
+{
+  static constexpr size_t max_args = 6;
+
+  uint64_t timestamp_ns; // steady_clock
+  uint32_t thread;       // numbered in the order that threads first traced
+  uint16_t category;
+  TraceLevel level;
+  uint8_t arg_count;
+  std::array<uint64_t, max_args> args;
+};
+
+/*
+ * Structured tracing, cheap enough for the hot path.
+ *
+ * A trace point logs a TraceRecord into its thread's own ring, without locking or allocating (a full ring
+ * drops the new record, and counts it). The records are read out on demand with drain() or dump(), or
+ * periodically by a background flusher.
+ *
+ * A trace point below MINNOW_TRACE_LEVEL compiles to nothing. One at or above it costs a single branch
+ * (on the runtime level, which starts at Off) unless tracing has been turned on with set_level().
+ *
+ *   static const uint16_t retransmits = Trace::category( "TCP retransmission" );
+ *   Trace::record<TraceLevel::Info>( retransmits, seqno, rto_ms );
+ */
+class Trace
+{
+public:
+  static constexpr TraceLevel compiled_level = static_cast<TraceLevel>( MINNOW_TRACE_LEVEL );
+  static constexpr size_t ring_records = 4096; // per thread
+
+  // The id of the category with this name (registering it the first time)
+  static uint16_t category( std::string_view name );
+  static std::string category_name( uint16_t category );
+
+  // Log records at `level` and above (of those compiled in)
+  static void set_level( TraceLevel level ) { level_.store( static_cast<uint8_t>( level ) ); }
+  static bool enabled( TraceLevel level )
+  {
+    return static_cast<uint8_t>( level ) >= level_.load( std::memory_order_relaxed );
+  }
+
+  template<TraceLevel Level, typename... Args>
+    requires( sizeof...( Args ) <= TraceRecord::max_args
+              and ( ( std::integral<Args> or std::is_enum_v<Args> ) and ... ) )
+  static void record( uint16_t category, Args... args )
+  {
+    if constexpr ( Level >= compiled_level ) {
+      if ( enabled( Level ) ) {
+        const std::array<uint64_t, sizeof...( Args )> values { static_cast<uint64_t>( args )... };
+        write( category, Level, values );
+      }
+    }
+  }
+
+  // Pass every buffered record to `sink` (each thread's in order), and remove them. Returns the count.
+  static size_t drain( const std::function<void( const TraceRecord& )>& sink );
+
+  // Drain the records as text, one per line, merged into timestamp order. Returns the count.
+  static size_t dump( std::ostream& out );
+
+  // Records dropped (on any thread) because the ring was full
+  static uint64_t dropped();
+
+  // Dump to `out` every `interval` from a background thread, until stop_flusher() (which dumps once more).
+  // `out` must outlive the flusher, and not be written by anyone else meanwhile.
+  static void start_flusher( std::ostream& out, std::chrono::milliseconds interval );
+  static void stop_flusher();
+
+private:
+  static inline std::atomic<uint8_t> level_ { static_cast<uint8_t>( TraceLevel::Off ) };
+
+  static void write( uint16_t category, TraceLevel level, std::span<const uint64_t> args );
+};
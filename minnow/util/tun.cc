@@ -0,0 +1,28 @@
+#include "tun.hh"
+
+#include "exception.hh"
+
+#include <cstring>
+#include <fcntl.h>
+#include <linux/if_tun.h>
+#include <net/if.h>
+#include <stdexcept>
+#include <sys/ioctl.h>
+
+using namespace std;
+
+static constexpr const char* CLONEDEV = "/dev/net/tun";
+
+TunFD::TunFD( const string& devname )
+  : FileDescriptor( ::CheckSystemCall( "open", open( CLONEDEV, O_RDWR | O_CLOEXEC ) ) ) // NOLINT(*-vararg)
+{
+  if ( devname.size() >= IFNAMSIZ ) {
+    throw runtime_error( "TUN device name too long" );
+  }
+
+  ifreq tun_req {};
+  tun_req.ifr_flags = static_cast<int16_t>( IFF_TUN | IFF_NO_PI ); // IP datagrams, without packet info
+  strncpy( tun_req.ifr_name, devname.data(), IFNAMSIZ - 1 );
+
+  ::CheckSystemCall( "ioctl", ioctl( fd_num(), TUNSETIFF, static_cast<void*>( &tun_req ) ) ); // NOLINT(*-vararg)
+}
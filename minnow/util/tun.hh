@@ -0,0 +1,13 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+#include <string>
+
+//! A FileDescriptor for a TUN device, which reads and writes one IP datagram per call.
+//! The device (e.g. "tun144") must already exist and belong to the user: see scripts/tun.sh.
+class TunFD : public FileDescriptor
+{
+public:
+  explicit TunFD( const std::string& devname );
+};